@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Merge per-variant JMH JSON reports into one Markdown table.
+
+usage: compare.py <report-dir> [--baseline <file.json>]
+
+With --baseline, each score is also shown as a ratio to the same benchmark
+in the baseline report (e.g. a report kept from the last release), so a
+regression shows up as a ratio moving the wrong way.
+"""
+import json
+import os
+import sys
+
+VARIANTS = ["x", "leb", "v2", "classic"]
+
+
+def load(path):
+    with open(path) as f:
+        rows = json.load(f)
+    out = {}
+    for r in rows:
+        name = r["benchmark"].rsplit(".", 2)
+        name = ".".join(name[-2:])
+        params = r.get("params") or {}
+        if params:
+            name += "(" + ",".join(f"{k}={v}" for k, v in sorted(params.items())) + ")"
+        m = r["primaryMetric"]
+        out[name] = (m["score"], m.get("scoreError", 0.0), m["scoreUnit"])
+    return out
+
+
+def main(argv):
+    if not argv:
+        print(__doc__)
+        return 2
+    report_dir = argv[0]
+    baseline = None
+    if "--baseline" in argv:
+        baseline = load(argv[argv.index("--baseline") + 1])
+
+    reports = {}
+    for v in VARIANTS:
+        path = os.path.join(report_dir, f"{v}.json")
+        if os.path.exists(path):
+            reports[v] = load(path)
+    if not reports:
+        print(f"no reports in {report_dir}")
+        return 1
+
+    names = sorted({n for r in reports.values() for n in r})
+    cols = list(reports)
+    print("| benchmark | unit | " + " | ".join(cols) + " |")
+    print("|---|---|" + "---|" * len(cols))
+    for n in names:
+        unit = next(r[n][2] for r in reports.values() if n in r)
+        cells = []
+        for v in cols:
+            if n not in reports[v]:
+                cells.append("-")
+                continue
+            score, err, _ = reports[v][n]
+            cell = f"{score:.3f} ± {err:.3f}"
+            if baseline and n in baseline and baseline[n][0]:
+                cell += f" ({score / baseline[n][0]:.2f}x)"
+            cells.append(cell)
+        print(f"| {n} | {unit} | " + " | ".join(cells) + " |")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,10 @@
+#!/usr/bin/env sh
+# Run the JMH suite for every LiveEventBus variant and print a comparison.
+# Extra JMH options can be passed through, e.g. ./run-all.sh -f 1 -wi 1 -i 3
+set -e
+cd "$(dirname "$0")"
+GRADLE="${GRADLE:-gradle}"
+for v in x leb v2 classic; do
+  "$GRADLE" -q jmh -PlebVariant="$v" -PjmhArgs="$*"
+done
+python3 compare.py build/reports/jmh
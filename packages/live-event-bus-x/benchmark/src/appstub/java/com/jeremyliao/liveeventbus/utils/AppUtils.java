@@ -0,0 +1,25 @@
+package com.jeremyliao.liveeventbus.utils;
+
+import android.app.Application;
+import android.content.Context;
+
+/**
+ * Benchmark replacement for the variants' AppUtils, which looks up the
+ * Application through ActivityThread and throws when there is none. With no
+ * Application the bus simply skips registering its IPC receiver.
+ */
+public final class AppUtils {
+
+    private AppUtils() {
+    }
+
+    public static void init(final Context context) {
+    }
+
+    public static void init(final Application app) {
+    }
+
+    public static Application getApp() {
+        return null;
+    }
+}
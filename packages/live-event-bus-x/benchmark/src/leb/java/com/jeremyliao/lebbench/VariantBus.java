@@ -0,0 +1,58 @@
+package com.jeremyliao.lebbench;
+
+import android.arch.lifecycle.Observer;
+
+import com.jeremyliao.liveeventbus.LiveEventBus;
+import com.jeremyliao.liveeventbus.core.Observable;
+
+/**
+ * live-event-bus (support library, live-event-bus/).
+ */
+public final class VariantBus implements Bus {
+
+    static {
+        LiveEventBus.config().enableLogger(false);
+    }
+
+    @SuppressWarnings("unchecked")
+    private static Observable<Object> of(Object channel) {
+        return (Observable<Object>) channel;
+    }
+
+    @Override
+    public Object channel(String key) {
+        return LiveEventBus.get(key, Object.class);
+    }
+
+    @Override
+    public void post(Object channel, Object value) {
+        of(channel).post(value);
+    }
+
+    @Override
+    public void postDelay(Object channel, Object value, long delayMs) {
+        of(channel).postDelay(value, delayMs);
+    }
+
+    @Override
+    public Object observeForever(Object channel, final Sink sink, boolean sticky) {
+        Observer<Object> observer = new Observer<Object>() {
+            @Override
+            public void onChanged(Object value) {
+                sink.onValue(value);
+            }
+        };
+        if (sticky) {
+            of(channel).observeStickyForever(observer);
+        } else {
+            of(channel).observeForever(observer);
+        }
+        return observer;
+    }
+
+    @Override
+    @SuppressWarnings("unchecked")
+    public void removeObserver(Object channel, Object handle) {
+        of(channel).removeObserver((Observer<Object>) handle);
+    }
+}
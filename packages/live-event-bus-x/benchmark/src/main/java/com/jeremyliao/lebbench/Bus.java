@@ -0,0 +1,33 @@
+package com.jeremyliao.lebbench;
+
+/**
+ * The operations the benchmarks need, implemented once per variant by
+ * {@code VariantBus} (src/&lt;variant&gt;/java).
+ */
+public interface Bus {
+
+    interface Sink {
+        void onValue(Object value);
+    }
+
+    /**
+     * Channel lookup; goes through the variant's with()/get().
+     */
+    Object channel(String key);
+
+    void post(Object channel, Object value);
+
+    void postDelay(Object channel, Object value, long delayMs);
+
+    /**
+     * Must be called on the main looper.
+     *
+     * @return handle for {@link #removeObserver}
+     */
+    Object observeForever(Object channel, Sink sink, boolean sticky);
+
+    /**
+     * Must be called on the main looper.
+     */
+    void removeObserver(Object channel, Object handle);
+}
@@ -0,0 +1,70 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Threads;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * 8 threads posting the way the BLE SDK does: look the channel up by key on
+ * every post, then post. Measures the sender side only; the main-thread
+ * queue is cleared after each iteration.
+ */
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@Threads(8)
+@State(Scope.Benchmark)
+public class ContendedPostBenchmark {
+
+    private static final String[] KEYS = {
+            "bench_contended_rt", "bench_contended_progress",
+            "bench_contended_info", "bench_contended_file"};
+    private static final Integer VALUE = 1;
+
+    private final Bus bus = new VariantBus();
+    private Object cached;
+
+    @Setup
+    public void setUp() {
+        for (String key : KEYS) {
+            bus.channel(key);
+        }
+        cached = bus.channel(KEYS[0]);
+    }
+
+    @TearDown(Level.Iteration)
+    public void clearQueue() {
+        MainThread.clearQueue();
+    }
+
+    @State(Scope.Thread)
+    public static class Cursor {
+        int next;
+    }
+
+    @Benchmark
+    public void lookupAndPost(Cursor cursor) {
+        int i = cursor.next;
+        cursor.next = (i + 1) & (KEYS.length - 1);
+        bus.post(bus.channel(KEYS[i]), VALUE);
+    }
+
+    @Benchmark
+    public void cachedHandlePost() {
+        bus.post(cached, VALUE);
+    }
+}
@@ -0,0 +1,77 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * 10k delayed posts spread over 1..DELAY_SPREAD_MS, from scheduling the
+ * first one until the observer has received all of them. The spread is a
+ * fixed floor for every variant; the rest is queue and dispatch overhead.
+ */
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 5)
+@Measurement(iterations = 10)
+@Fork(1)
+@State(Scope.Benchmark)
+public class DelayedFireBenchmark {
+
+    private static final int POSTS = 10_000;
+    private static final int DELAY_SPREAD_MS = 20;
+    private static final Integer VALUE = 1;
+
+    private final Bus bus = new VariantBus();
+    private Object channel;
+    private Object handle;
+    private volatile CountDownLatch latch;
+
+    @Setup
+    public void setUp() {
+        channel = bus.channel("bench_delayed_fire");
+        MainThread.runSync(new Runnable() {
+            @Override
+            public void run() {
+                handle = bus.observeForever(channel, new Bus.Sink() {
+                    @Override
+                    public void onValue(Object value) {
+                        latch.countDown();
+                    }
+                }, false);
+            }
+        });
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() {
+        MainThread.runSync(new Runnable() {
+            @Override
+            public void run() {
+                bus.removeObserver(channel, handle);
+            }
+        });
+    }
+
+    @Benchmark
+    public void scheduleAndFire() throws InterruptedException {
+        latch = new CountDownLatch(POSTS);
+        for (int i = 0; i < POSTS; i++) {
+            bus.postDelay(channel, VALUE, 1 + i % DELAY_SPREAD_MS);
+        }
+        if (!latch.await(30, TimeUnit.SECONDS)) {
+            throw new IllegalStateException("delayed posts did not fire");
+        }
+    }
+}
@@ -0,0 +1,63 @@
+package com.jeremyliao.lebbench;
+
+import android.os.Handler;
+import android.os.Looper;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.atomic.AtomicReference;
+
+/**
+ * Helpers for running setup code on the stub main looper.
+ */
+public final class MainThread {
+
+    private static final Handler HANDLER = new Handler(Looper.getMainLooper());
+
+    private MainThread() {
+    }
+
+    public static void runSync(final Runnable r) {
+        if (Looper.myLooper() == Looper.getMainLooper()) {
+            r.run();
+            return;
+        }
+        final CountDownLatch done = new CountDownLatch(1);
+        final AtomicReference<Throwable> error = new AtomicReference<>();
+        HANDLER.post(new Runnable() {
+            @Override
+            public void run() {
+                try {
+                    r.run();
+                } catch (Throwable t) {
+                    error.set(t);
+                } finally {
+                    done.countDown();
+                }
+            }
+        });
+        try {
+            done.await();
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new IllegalStateException(e);
+        }
+        if (error.get() != null) {
+            throw new IllegalStateException(error.get());
+        }
+    }
+
+    /**
+     * Wait until everything posted so far has run.
+     */
+    public static void drain() {
+        runSync(new Runnable() {
+            @Override
+            public void run() {
+            }
+        });
+    }
+
+    public static void clearQueue() {
+        Looper.getMainLooper().clearQueue();
+    }
+}
@@ -0,0 +1,58 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Cost of scheduling a delayed post, with {@code pending} delayed posts
+ * already queued. The delay is long enough that nothing fires during the
+ * run; each iteration schedules a fixed batch so the queue stays bounded.
+ */
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.NANOSECONDS)
+@Warmup(iterations = 5, batchSize = PostDelayBenchmark.BATCH)
+@Measurement(iterations = 10, batchSize = PostDelayBenchmark.BATCH)
+@Fork(1)
+@State(Scope.Benchmark)
+public class PostDelayBenchmark {
+
+    static final int BATCH = 10_000;
+    private static final Integer VALUE = 1;
+
+    @Param({"0", "10000"})
+    public int pending;
+
+    private final Bus bus = new VariantBus();
+    private Object channel;
+
+    @Setup
+    public void setUp() {
+        channel = bus.channel("bench_post_delay");
+        for (int i = 0; i < pending; i++) {
+            bus.postDelay(channel, VALUE, 600_000L + i);
+        }
+    }
+
+    @TearDown(Level.Trial)
+    public void clearQueue() {
+        MainThread.clearQueue();
+    }
+
+    @Benchmark
+    public void postDelay() {
+        bus.postDelay(channel, VALUE, 60_000L);
+    }
+}
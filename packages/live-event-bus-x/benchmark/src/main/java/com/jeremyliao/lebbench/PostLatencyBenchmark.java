@@ -0,0 +1,71 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * Time from post() on a background thread until the observer runs on the
+ * main looper.
+ */
+@BenchmarkMode(Mode.SampleTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Benchmark)
+public class PostLatencyBenchmark {
+
+    private final Bus bus = new VariantBus();
+    private final AtomicLong received = new AtomicLong();
+    private Object channel;
+    private Object handle;
+    private long seq;
+
+    @Setup
+    public void setUp() {
+        channel = bus.channel("bench_post_latency");
+        MainThread.runSync(new Runnable() {
+            @Override
+            public void run() {
+                handle = bus.observeForever(channel, new Bus.Sink() {
+                    @Override
+                    public void onValue(Object value) {
+                        received.set((Long) value);
+                    }
+                }, false);
+            }
+        });
+    }
+
+    @TearDown
+    public void tearDown() {
+        MainThread.runSync(new Runnable() {
+            @Override
+            public void run() {
+                bus.removeObserver(channel, handle);
+            }
+        });
+    }
+
+    @Benchmark
+    public long postToObserver() {
+        long value = ++seq;
+        bus.post(channel, value);
+        while (received.get() != value) {
+            Thread.yield();
+        }
+        return value;
+    }
+}
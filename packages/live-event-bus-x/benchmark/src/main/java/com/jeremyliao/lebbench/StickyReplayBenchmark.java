@@ -0,0 +1,65 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+import org.openjdk.jmh.infra.Blackhole;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Registering N sticky observers on a channel that already holds a value
+ * (each one gets the replay), then removing them again.
+ */
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Benchmark)
+public class StickyReplayBenchmark {
+
+    @Param({"10", "100", "1000"})
+    public int observers;
+
+    private final Bus bus = new VariantBus();
+    private Object channel;
+    private Object[] handles;
+
+    @Setup
+    public void setUp() {
+        channel = bus.channel("bench_sticky_replay");
+        handles = new Object[observers];
+        bus.post(channel, "sticky");
+        MainThread.drain();
+    }
+
+    @Benchmark
+    public void registerAndReplay(final Blackhole bh) {
+        MainThread.runSync(new Runnable() {
+            @Override
+            public void run() {
+                Bus.Sink sink = new Bus.Sink() {
+                    @Override
+                    public void onValue(Object value) {
+                        bh.consume(value);
+                    }
+                };
+                for (int i = 0; i < observers; i++) {
+                    handles[i] = bus.observeForever(channel, sink, true);
+                }
+                for (int i = 0; i < observers; i++) {
+                    bus.removeObserver(channel, handles[i]);
+                }
+            }
+        });
+    }
+}
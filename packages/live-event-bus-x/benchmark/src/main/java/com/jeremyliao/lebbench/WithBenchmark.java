@@ -0,0 +1,53 @@
+package com.jeremyliao.lebbench;
+
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Threads;
+import org.openjdk.jmh.annotations.Warmup;
+
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Channel lookup by key from 8 threads at once (the path every SDK post takes).
+ */
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 3, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@Threads(8)
+@State(Scope.Benchmark)
+public class WithBenchmark {
+
+    private static final int KEYS = 64;
+
+    private final Bus bus = new VariantBus();
+    private final String[] keys = new String[KEYS];
+
+    @Setup
+    public void setUp() {
+        for (int i = 0; i < KEYS; i++) {
+            keys[i] = "bench_with_" + i;
+            bus.channel(keys[i]);
+        }
+    }
+
+    @State(Scope.Thread)
+    public static class Cursor {
+        int next;
+    }
+
+    @Benchmark
+    public Object with(Cursor cursor) {
+        int i = cursor.next;
+        cursor.next = (i + 1) & (KEYS - 1);
+        return bus.channel(keys[i]);
+    }
+}
@@ -0,0 +1,13 @@
+package android.content;
+
+/**
+ * LiveEventBusCore constructs its IPC receiver eagerly; the platform class
+ * only throws on the JVM, so this keeps construction side-effect free.
+ */
+public abstract class BroadcastReceiver {
+
+    public BroadcastReceiver() {
+    }
+
+    public abstract void onReceive(Context context, Intent intent);
+}
@@ -0,0 +1,29 @@
+package android.os;
+
+/**
+ * Posts to the stub {@link Looper}. Only the calls LiveEventBus makes are provided.
+ */
+public class Handler {
+
+    private final Looper looper;
+
+    public Handler(Looper looper) {
+        this.looper = looper;
+    }
+
+    public final Looper getLooper() {
+        return looper;
+    }
+
+    public final boolean post(Runnable r) {
+        return looper.enqueue(r, 0);
+    }
+
+    public final boolean postDelayed(Runnable r, long delayMillis) {
+        return looper.enqueue(r, delayMillis);
+    }
+
+    public static Handler createAsync(Looper looper) {
+        return new Handler(looper);
+    }
+}
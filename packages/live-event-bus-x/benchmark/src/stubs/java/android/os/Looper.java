@@ -0,0 +1,59 @@
+package android.os;
+
+import java.util.concurrent.ScheduledThreadPoolExecutor;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * JVM stand-in for the Android main looper: one daemon thread draining a
+ * time-ordered queue. Tasks with the same due time run in posting order.
+ */
+public final class Looper {
+
+    private static final Looper MAIN = new Looper("main");
+
+    private final ScheduledThreadPoolExecutor queue;
+    private volatile Thread thread;
+
+    private Looper(final String name) {
+        queue = new ScheduledThreadPoolExecutor(1, new ThreadFactory() {
+            @Override
+            public Thread newThread(Runnable r) {
+                Thread t = new Thread(r, name);
+                t.setDaemon(true);
+                thread = t;
+                return t;
+            }
+        });
+        queue.setRemoveOnCancelPolicy(true);
+        queue.prestartAllCoreThreads();
+    }
+
+    public static Looper getMainLooper() {
+        return MAIN;
+    }
+
+    public static Looper myLooper() {
+        return Thread.currentThread() == MAIN.thread ? MAIN : null;
+    }
+
+    public Thread getThread() {
+        return thread;
+    }
+
+    boolean enqueue(Runnable r, long delayMillis) {
+        queue.schedule(r, Math.max(0, delayMillis), TimeUnit.MILLISECONDS);
+        return true;
+    }
+
+    /**
+     * Drop everything still queued; used between benchmark iterations.
+     */
+    public void clearQueue() {
+        queue.getQueue().clear();
+    }
+
+    public int queueSize() {
+        return queue.getQueue().size();
+    }
+}
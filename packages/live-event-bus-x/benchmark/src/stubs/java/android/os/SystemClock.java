@@ -0,0 +1,20 @@
+package android.os;
+
+/**
+ * JVM stand-in for the monotonic clocks; android.jar only has throwing stubs.
+ */
+public final class SystemClock {
+
+    private static final long ORIGIN_NS = System.nanoTime();
+
+    private SystemClock() {
+    }
+
+    public static long uptimeMillis() {
+        return (System.nanoTime() - ORIGIN_NS) / 1_000_000L;
+    }
+
+    public static long elapsedRealtime() {
+        return uptimeMillis();
+    }
+}
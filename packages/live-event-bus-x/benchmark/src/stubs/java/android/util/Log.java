@@ -0,0 +1,50 @@
+package android.util;
+
+/**
+ * Silent replacement for android.util.Log; benchmarks run with logging disabled.
+ */
+public final class Log {
+
+    private Log() {
+    }
+
+    public static int v(String tag, String msg) {
+        return 0;
+    }
+
+    public static int v(String tag, String msg, Throwable tr) {
+        return 0;
+    }
+
+    public static int d(String tag, String msg) {
+        return 0;
+    }
+
+    public static int d(String tag, String msg, Throwable tr) {
+        return 0;
+    }
+
+    public static int i(String tag, String msg) {
+        return 0;
+    }
+
+    public static int i(String tag, String msg, Throwable tr) {
+        return 0;
+    }
+
+    public static int w(String tag, String msg) {
+        return 0;
+    }
+
+    public static int w(String tag, String msg, Throwable tr) {
+        return 0;
+    }
+
+    public static int e(String tag, String msg) {
+        return 0;
+    }
+
+    public static int e(String tag, String msg, Throwable tr) {
+        return 0;
+    }
+}
@@ -0,0 +1,53 @@
+package com.jeremyliao.lebbench;
+
+import android.arch.lifecycle.Observer;
+
+import com.jeremyliao.liveeventbus.LiveEventBus;
+
+/**
+ * live-event-bus-v2 (branchs/live-event-bus-v2).
+ */
+public final class VariantBus implements Bus {
+
+    @SuppressWarnings("unchecked")
+    private static LiveEventBus.Observable<Object> of(Object channel) {
+        return (LiveEventBus.Observable<Object>) channel;
+    }
+
+    @Override
+    public Object channel(String key) {
+        return LiveEventBus.get().with(key, Object.class);
+    }
+
+    @Override
+    public void post(Object channel, Object value) {
+        of(channel).postValue(value);
+    }
+
+    @Override
+    public void postDelay(Object channel, Object value, long delayMs) {
+        of(channel).postValueDelay(value, delayMs);
+    }
+
+    @Override
+    public Object observeForever(Object channel, final Sink sink, boolean sticky) {
+        Observer<Object> observer = new Observer<Object>() {
+            @Override
+            public void onChanged(Object value) {
+                sink.onValue(value);
+            }
+        };
+        if (sticky) {
+            of(channel).observeStickyForever(observer);
+        } else {
+            of(channel).observeForever(observer);
+        }
+        return observer;
+    }
+
+    @Override
+    @SuppressWarnings("unchecked")
+    public void removeObserver(Object channel, Object handle) {
+        of(channel).removeObserver((Observer<Object>) handle);
+    }
+}
@@ -0,0 +1,113 @@
+package com.jeremyliao.lebapp;
+
+import android.os.Looper;
+import android.os.SystemClock;
+import android.util.Log;
+import android.util.Printer;
+
+import androidx.annotation.Nullable;
+import androidx.lifecycle.Observer;
+import androidx.test.InstrumentationRegistry;
+import androidx.test.runner.AndroidJUnit4;
+
+import com.jeremyliao.liveeventbus.LiveEventBus;
+import com.jeremyliao.liveeventbus.core.Observable;
+
+import org.junit.Assert;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Main-looper message count for a 200 Hz background producer, with and
+ * without the per-key conflate / batch options.
+ * Results are written to logcat under the HighRateBenchmark tag.
+ */
+@RunWith(AndroidJUnit4.class)
+public class HighRateBenchmarkTest {
+
+    private static final String TAG = "HighRateBenchmark";
+    private static final int RATE_HZ = 200;
+    private static final int SECONDS = 2;
+
+    @Test
+    public void benchDefault() throws Exception {
+        int[] r = run("key_bench_rate_default");
+        Assert.assertEquals(RATE_HZ * SECONDS, r[1]);
+    }
+
+    @Test
+    public void benchConflate() throws Exception {
+        String key = "key_bench_rate_conflate";
+        LiveEventBus.config(key).conflate(true);
+        int[] r = run(key);
+        Assert.assertTrue(r[1] > 0 && r[1] <= RATE_HZ * SECONDS);
+    }
+
+    @Test
+    public void benchBatch() throws Exception {
+        String key = "key_bench_rate_batch";
+        LiveEventBus.config(key).batch(50);
+        int[] r = run(key);
+        Assert.assertEquals(RATE_HZ * SECONDS, r[1]);
+        // one flush per 50 ms, plus slack for the tail and unrelated messages
+        Assert.assertTrue(r[0] < RATE_HZ * SECONDS / 4);
+    }
+
+    /**
+     * @return {main looper messages, observer deliveries}
+     */
+    private int[] run(String key) throws Exception {
+        LiveEventBus.config().enableLogger(false);
+        final Observable<Integer> observable = LiveEventBus.get(key, Integer.class);
+        final AtomicInteger delivered = new AtomicInteger();
+        final AtomicInteger messages = new AtomicInteger();
+        final Observer<Integer> observer = new Observer<Integer>() {
+            @Override
+            public void onChanged(@Nullable Integer integer) {
+                delivered.incrementAndGet();
+            }
+        };
+        final Printer printer = new Printer() {
+            @Override
+            public void println(String x) {
+                if (x.startsWith(">>>>> Dispatching")) {
+                    messages.incrementAndGet();
+                }
+            }
+        };
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                observable.observeForever(observer);
+                Looper.getMainLooper().setMessageLogging(printer);
+            }
+        });
+
+        long periodNs = 1_000_000_000L / RATE_HZ;
+        long next = System.nanoTime();
+        for (int i = 0; i < RATE_HZ * SECONDS; i++) {
+            observable.post(i);
+            next += periodNs;
+            long sleepMs = (next - System.nanoTime()) / 1_000_000L;
+            if (sleepMs > 0) {
+                SystemClock.sleep(sleepMs);
+            }
+        }
+        Thread.sleep(500);
+
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                Looper.getMainLooper().setMessageLogging(null);
+                observable.removeObserver(observer);
+            }
+        });
+        LiveEventBus.config().enableLogger(true);
+
+        Log.i(TAG, key + ": posts=" + RATE_HZ * SECONDS + " mainMessages=" + messages.get()
+                + " delivered=" + delivered.get());
+        return new int[]{messages.get(), delivered.get()};
+    }
+}
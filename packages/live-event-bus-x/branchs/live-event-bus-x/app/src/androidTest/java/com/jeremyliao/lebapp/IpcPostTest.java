@@ -11,6 +11,9 @@ import com.jeremyliao.lebapp.bean.TestBean1;
 import com.jeremyliao.lebapp.bean.TestBean2;
 import com.jeremyliao.lebapp.bean.TestBean3;
 import com.jeremyliao.liveeventbus.LiveEventBus;
+import com.jeremyliao.liveeventbus.ipc.consts.IpcConst;
+import com.jeremyliao.liveeventbus.ipc.core.BinaryProcessor;
+import com.jeremyliao.liveeventbus.ipc.core.ProcessorManager;
 
 import org.junit.After;
 import org.junit.Assert;
@@ -124,4 +127,16 @@ public class IpcPostTest {
         Thread.sleep(500);
         Assert.assertEquals(rule.getActivity().strResult, "hello world");
     }
+
+    @Test
+    public void testCompactEncodingRoundTrip() throws Exception {
+        Object[] values = {"hello world", 100, 100L, 1.5f, 2.5d, true};
+        for (Object value : values) {
+            Intent intent = new Intent();
+            Assert.assertTrue(ProcessorManager.getManager().writeTo(intent, value, true));
+            Assert.assertEquals(BinaryProcessor.class.getName(),
+                    intent.getStringExtra(IpcConst.KEY_PROCESSOR_NAME));
+            Assert.assertEquals(value, ProcessorManager.getManager().createFrom(intent));
+        }
+    }
 }
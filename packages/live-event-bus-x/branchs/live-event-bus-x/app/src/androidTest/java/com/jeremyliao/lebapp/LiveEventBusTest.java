@@ -1,6 +1,7 @@
 package com.jeremyliao.lebapp;
 
 import android.os.Bundle;
+import android.os.Looper;
 import android.util.Log;
 
 import androidx.annotation.Nullable;
@@ -15,6 +16,7 @@ import com.jeremyliao.lebapp.obj.GoodBean;
 import com.jeremyliao.lebapp.obj.SerializableObject;
 import com.jeremyliao.lebapp.wrapper.Wrapper;
 import com.jeremyliao.liveeventbus.LiveEventBus;
+import com.jeremyliao.liveeventbus.core.Delivery;
 import com.jeremyliao.liveeventbus.core.Observable;
 
 import org.junit.After;
@@ -25,6 +27,7 @@ import org.junit.Test;
 import org.junit.runner.RunWith;
 
 import java.util.ArrayList;
+import java.util.Collections;
 import java.util.List;
 import java.util.Map;
 import java.util.Random;
@@ -844,6 +847,40 @@ public class LiveEventBusTest {
         }
     }
 
+    @Test
+    public void testObserveForeverOnBackgroundExecutor() throws Exception {
+        final String key = "key_test_observe_forever_background";
+        final List<Integer> result = Collections.synchronizedList(new ArrayList<Integer>());
+        final Wrapper<Boolean> onMain = new Wrapper<>(false);
+        final Observer<Integer> observer = new Observer<Integer>() {
+            @Override
+            public void onChanged(@Nullable Integer integer) {
+                if (Looper.myLooper() == Looper.getMainLooper()) {
+                    onMain.setTarget(true);
+                }
+                result.add(integer);
+            }
+        };
+        LiveEventBus
+                .get(key, Integer.class)
+                .observeForever(observer, Delivery.background());
+        Thread.sleep(500);
+        for (int i = 0; i < 100; i++) {
+            LiveEventBus
+                    .get(key, Integer.class)
+                    .postOrderly(i);
+        }
+        Thread.sleep(500);
+        Assert.assertFalse(onMain.getTarget());
+        Assert.assertEquals(result.size(), 100);
+        for (int i = 0; i < 100; i++) {
+            Assert.assertEquals(result.get(i).intValue(), i);
+        }
+        LiveEventBus
+                .get(key, Integer.class)
+                .removeObserver(observer);
+    }
+
     @Test
     public void testExceptionOnReceiveMsg() throws Exception {
         final String key = "key_test_exception_on_receive";
@@ -0,0 +1,167 @@
+package com.jeremyliao.lebapp;
+
+import android.os.Debug;
+import android.os.Looper;
+import android.util.Log;
+import android.util.Printer;
+
+import androidx.lifecycle.Observer;
+import androidx.test.InstrumentationRegistry;
+import androidx.test.runner.AndroidJUnit4;
+
+import com.jeremyliao.liveeventbus.LiveEventBus;
+import com.jeremyliao.liveeventbus.core.Observable;
+
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Throughput and allocation of the post -> observer path, logger disabled.
+ * Results are written to logcat under the PostBenchmark tag.
+ */
+@RunWith(AndroidJUnit4.class)
+public class PostBenchmarkTest {
+
+    private static final String TAG = "PostBenchmark";
+    private static final String KEY_BENCH_POST = "key_bench_post";
+    private static final int WARMUP = 2_000;
+    private static final int POSTS = 20_000;
+    private static final int DELAYED = 10_000;
+    private static final int DELAY_SPREAD_MS = 50;
+
+    private final Observable<Integer> observable = LiveEventBus.get(KEY_BENCH_POST, Integer.class);
+    private volatile CountDownLatch latch;
+    private final Observer<Integer> observer = new Observer<Integer>() {
+        @Override
+        public void onChanged(Integer value) {
+            CountDownLatch l = latch;
+            if (l != null) {
+                l.countDown();
+            }
+        }
+    };
+
+    @Before
+    public void setUp() throws Exception {
+        LiveEventBus.config().enableLogger(false);
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                observable.observeForever(observer);
+            }
+        });
+    }
+
+    @After
+    public void tearDown() throws Exception {
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                observable.removeObserver(observer);
+            }
+        });
+        LiveEventBus.config().enableLogger(true);
+    }
+
+    @Test
+    public void benchPostOnMainThread() throws Exception {
+        final long[] result = new long[2];
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                Integer value = 1;
+                latch = null;
+                for (int i = 0; i < WARMUP; i++) {
+                    observable.post(value);
+                }
+                latch = new CountDownLatch(POSTS);
+                Debug.startAllocCounting();
+                Debug.resetThreadAllocCount();
+                long start = System.nanoTime();
+                for (int i = 0; i < POSTS; i++) {
+                    observable.post(value);
+                }
+                result[0] = System.nanoTime() - start;
+                result[1] = Debug.getThreadAllocCount();
+                Debug.stopAllocCounting();
+            }
+        });
+        Assert.assertEquals(0, latch.getCount());
+        report("main", result[0], result[1]);
+    }
+
+    @Test
+    public void benchPostFromBackgroundThread() throws Exception {
+        Integer value = 1;
+        latch = new CountDownLatch(WARMUP);
+        for (int i = 0; i < WARMUP; i++) {
+            observable.post(value);
+        }
+        Assert.assertTrue(latch.await(10, TimeUnit.SECONDS));
+
+        latch = new CountDownLatch(POSTS);
+        Debug.startAllocCounting();
+        Debug.resetThreadAllocCount();
+        long start = System.nanoTime();
+        for (int i = 0; i < POSTS; i++) {
+            observable.post(value);
+        }
+        long allocs = Debug.getThreadAllocCount();
+        Debug.stopAllocCounting();
+        Assert.assertTrue(latch.await(30, TimeUnit.SECONDS));
+        // Includes delivery on the main looper, which runs concurrently.
+        report("background", System.nanoTime() - start, allocs);
+    }
+
+    @Test
+    public void benchPostDelayTenThousandPending() throws Exception {
+        final AtomicInteger messages = new AtomicInteger();
+        final Printer printer = new Printer() {
+            @Override
+            public void println(String x) {
+                if (x.startsWith(">>>>> Dispatching")) {
+                    messages.incrementAndGet();
+                }
+            }
+        };
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                Looper.getMainLooper().setMessageLogging(printer);
+            }
+        });
+        Integer value = 1;
+        latch = new CountDownLatch(DELAYED);
+        long start = System.nanoTime();
+        for (int i = 0; i < DELAYED; i++) {
+            observable.postDelay(value, 1 + i % DELAY_SPREAD_MS);
+        }
+        long scheduleNs = System.nanoTime() - start;
+        Assert.assertTrue(latch.await(30, TimeUnit.SECONDS));
+        long totalNs = System.nanoTime() - start;
+        InstrumentationRegistry.getInstrumentation().runOnMainSync(new Runnable() {
+            @Override
+            public void run() {
+                Looper.getMainLooper().setMessageLogging(null);
+            }
+        });
+        Log.i(TAG, String.format("postDelay x%d: %.0f ns/schedule, %d ms until all fired, %d main messages",
+                DELAYED, (double) scheduleNs / DELAYED, totalNs / 1_000_000L, messages.get()));
+        // due posts are fired in batches by the timer wheel, not one message each
+        Assert.assertTrue(messages.get() < DELAYED / 10);
+    }
+
+    private static void report(String name, long elapsedNs, long allocs) {
+        double postsPerSecond = POSTS * 1e9 / elapsedNs;
+        double allocsPerPost = (double) allocs / POSTS;
+        Log.i(TAG, String.format("%s: %.0f posts/s, %.2f allocations/post (posting thread)",
+                name, postsPerSecond, allocsPerPost));
+    }
+}
@@ -0,0 +1,121 @@
+package com.jeremyliao.lebapp;
+
+import android.os.Handler;
+import android.os.Looper;
+import android.os.SystemClock;
+import android.util.Printer;
+
+import androidx.test.runner.AndroidJUnit4;
+
+import com.jeremyliao.liveeventbus.core.TimerWheel;
+
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * TimerWheel on its own looper thread: at most one queued wake message,
+ * and a throwing task does not drop the rest of its batch.
+ */
+@RunWith(AndroidJUnit4.class)
+public class TimerWheelTest {
+
+    private Looper looper;
+    private final AtomicInteger errors = new AtomicInteger();
+
+    @Before
+    public void setUp() throws Exception {
+        final CountDownLatch ready = new CountDownLatch(1);
+        new Thread(new Runnable() {
+            @Override
+            public void run() {
+                Looper.prepare();
+                looper = Looper.myLooper();
+                ready.countDown();
+                // 任务抛出的异常不让线程退出，记下来继续loop
+                while (true) {
+                    try {
+                        Looper.loop();
+                        return;
+                    } catch (RuntimeException e) {
+                        errors.incrementAndGet();
+                    }
+                }
+            }
+        }, "TimerWheelTest").start();
+        ready.await();
+    }
+
+    @After
+    public void tearDown() {
+        looper.quit();
+    }
+
+    @Test
+    public void testOneWakeForInterleavedSchedules() throws Exception {
+        TimerWheel wheel = new TimerWheel(looper);
+        Runnable noop = new Runnable() {
+            @Override
+            public void run() {
+            }
+        };
+        // 每个短延迟都比上一个更早，都会提前唤醒时间
+        for (int i = 0; i < 50; i++) {
+            wheel.schedule(noop, 60_000);
+            wheel.schedule(noop, 5_000 - i * 20);
+        }
+        Assert.assertEquals(100, wheel.pendingCount());
+        Assert.assertEquals(1, queuedWakes());
+    }
+
+    @Test
+    public void testThrowingTaskKeepsBatch() throws Exception {
+        TimerWheel wheel = new TimerWheel(looper);
+        final CountDownLatch ran = new CountDownLatch(3);
+        Runnable count = new Runnable() {
+            @Override
+            public void run() {
+                ran.countDown();
+            }
+        };
+        // 先占住looper线程，让下面三个任务在同一次唤醒里到期
+        new Handler(looper).post(new Runnable() {
+            @Override
+            public void run() {
+                SystemClock.sleep(100);
+            }
+        });
+        wheel.schedule(count, 10);
+        wheel.schedule(new Runnable() {
+            @Override
+            public void run() {
+                throw new IllegalStateException("task failed");
+            }
+        }, 10);
+        wheel.schedule(count, 10);
+        wheel.schedule(count, 300);
+        Assert.assertTrue(ran.await(2, TimeUnit.SECONDS));
+        Assert.assertEquals(1, errors.get());
+        Assert.assertEquals(0, wheel.pendingCount());
+        Assert.assertEquals(0, queuedWakes());
+    }
+
+    private int queuedWakes() {
+        final int[] count = {0};
+        looper.dump(new Printer() {
+            @Override
+            public void println(String x) {
+                if (x.contains(TimerWheel.class.getName())) {
+                    count[0]++;
+                }
+            }
+        }, "");
+        return count[0];
+    }
+}
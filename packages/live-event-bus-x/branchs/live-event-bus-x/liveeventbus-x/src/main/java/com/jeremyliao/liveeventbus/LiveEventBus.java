@@ -25,6 +25,8 @@ public final class LiveEventBus {
 
     /**
      * get observable by key with type
+     * lock-free once the key exists; the returned observable can be cached
+     * and reused until the key is auto-cleared
      *
      * @param key String
      * @param type Class
@@ -0,0 +1,86 @@
+package com.jeremyliao.liveeventbus.core;
+
+import androidx.annotation.NonNull;
+
+import java.util.concurrent.Executor;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * 消息分发线程
+ * 配合observeForever(observer, executor)使用，决定observer在哪个线程收到消息
+ * 同一个observer收到消息的顺序始终和发送顺序一致
+ */
+public final class Delivery {
+
+    private Delivery() {
+    }
+
+    private static final Executor MAIN = new Executor() {
+        @Override
+        public void execute(@NonNull Runnable command) {
+            command.run();
+        }
+    };
+
+    private static class BackgroundHolder {
+        private static final ExecutorService BACKGROUND =
+                Executors.newSingleThreadExecutor(new NamedThreadFactory("LiveEventBus-bg"));
+    }
+
+    private static class PoolHolder {
+        private static final ExecutorService POOL = Executors.newFixedThreadPool(
+                Math.max(2, Math.min(4, Runtime.getRuntime().availableProcessors() - 1)),
+                new NamedThreadFactory("LiveEventBus-pool"));
+    }
+
+    /**
+     * 主线程分发（默认行为）
+     *
+     * @return Executor
+     */
+    public static Executor main() {
+        return MAIN;
+    }
+
+    /**
+     * 单个后台串行线程，所有使用它的observer共享同一个顺序
+     *
+     * @return Executor
+     */
+    public static Executor background() {
+        return BackgroundHolder.BACKGROUND;
+    }
+
+    /**
+     * 共享线程池，不同observer可并行，单个observer仍然串行
+     *
+     * @return Executor
+     */
+    public static Executor pool() {
+        return PoolHolder.POOL;
+    }
+
+    static boolean isMain(Executor executor) {
+        return executor == null || executor == MAIN;
+    }
+
+    private static class NamedThreadFactory implements ThreadFactory {
+
+        private final String prefix;
+        private final AtomicInteger count = new AtomicInteger(0);
+
+        NamedThreadFactory(String prefix) {
+            this.prefix = prefix;
+        }
+
+        @Override
+        public Thread newThread(@NonNull Runnable r) {
+            Thread thread = new Thread(r, prefix + "-" + count.incrementAndGet());
+            thread.setDaemon(true);
+            return thread;
+        }
+    }
+}
@@ -17,6 +17,7 @@ import androidx.lifecycle.LifecycleOwner;
 import androidx.lifecycle.LiveData;
 import androidx.lifecycle.Observer;
 import androidx.core.content.ContextCompat;
+import androidx.core.util.Pools;
 
 import com.jeremyliao.liveeventbus.ipc.consts.IpcConst;
 import com.jeremyliao.liveeventbus.ipc.core.ProcessorManager;
@@ -29,8 +30,14 @@ import com.jeremyliao.liveeventbus.utils.ThreadUtils;
 
 import java.lang.reflect.Field;
 import java.lang.reflect.Method;
+import java.util.ArrayDeque;
 import java.util.HashMap;
 import java.util.Map;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.Executor;
+import java.util.concurrent.atomic.AtomicReference;
 import java.util.logging.Level;
 
 /**
@@ -52,8 +59,9 @@ public final class LiveEventBusCore {
 
     /**
      * 存放LiveEvent
+     * 并发Map，查找通道不加锁
      */
-    private final Map<String, LiveEvent<Object>> bus;
+    private final ConcurrentHashMap<String, LiveEvent<Object>> bus;
 
     /**
      * 可配置的项
@@ -64,6 +72,21 @@ public final class LiveEventBusCore {
     private LoggerManager logger;
     private final Map<String, ObservableConfig> observableConfigs;
 
+    /**
+     * 每个LiveEvent缓存的PostValueTask数量
+     */
+    private static final int TASK_POOL_SIZE = 16;
+
+    /**
+     * 分发队列中代替null值的占位
+     */
+    private static final Object NULL_VALUE = new Object();
+
+    /**
+     * conflate槽位为空的标记
+     */
+    private static final Object NO_VALUE = new Object();
+
     /**
      * 跨进程通信
      */
@@ -76,8 +99,8 @@ public final class LiveEventBusCore {
     final InnerConsole console = new InnerConsole();
 
     private LiveEventBusCore() {
-        bus = new HashMap<>();
-        observableConfigs = new HashMap<>();
+        bus = new ConcurrentHashMap<>();
+        observableConfigs = new ConcurrentHashMap<>();
         lifecycleObserverAlwaysActive = true;
         autoClear = false;
         logger = new LoggerManager(new DefaultLogger());
@@ -85,11 +108,20 @@ public final class LiveEventBusCore {
         registerReceiver();
     }
 
-    public synchronized <T> Observable<T> with(String key, Class<T> type) {
-        if (!bus.containsKey(key)) {
-            bus.put(key, new LiveEvent<>(key));
+    /**
+     * 获取key对应的通道，稳定状态下只是一次无锁的Map读取
+     * 返回的Observable在key被清除（autoClear）之前一直有效，高频发送方可以缓存它
+     */
+    public <T> Observable<T> with(String key, Class<T> type) {
+        LiveEvent<Object> event = bus.get(key);
+        if (event == null) {
+            LiveEvent<Object> created = new LiveEvent<>(key);
+            event = bus.putIfAbsent(key, created);
+            if (event == null) {
+                event = created;
+            }
         }
-        return (Observable<T>) bus.get(key);
+        return (Observable<T>) event;
     }
 
     /**
@@ -104,9 +136,22 @@ public final class LiveEventBusCore {
     }
 
     public ObservableConfig config(String key) {
-        if (!observableConfigs.containsKey(key)) {
-            observableConfigs.put(key, new ObservableConfig());
+        ObservableConfig config = observableConfigs.get(key);
+        if (config == null) {
+            config = new ObservableConfig();
+            ObservableConfig existing = observableConfigs.putIfAbsent(key, config);
+            if (existing != null) {
+                config = existing;
+            }
         }
+        return config;
+    }
+
+    /**
+     * 读取key的配置，不存在时不创建
+     */
+    @Nullable
+    ObservableConfig findConfig(String key) {
         return observableConfigs.get(key);
     }
 
@@ -152,6 +197,45 @@ public final class LiveEventBusCore {
         private final LifecycleLiveData<T> liveData;
         private final Map<Observer, ObserverWrapper<T>> observerMap = new HashMap<>();
         private final Handler mainHandler = new Handler(Looper.getMainLooper());
+        private final Pools.SynchronizedPool<PostValueTask> taskPool =
+                new Pools.SynchronizedPool<>(TASK_POOL_SIZE);
+
+        /**
+         * conflate模式下等待分发的最新值，NO_VALUE表示没有待分发的消息
+         */
+        private final AtomicReference<Object> conflated = new AtomicReference<>(NO_VALUE);
+        private final Runnable conflateTask = new Runnable() {
+            @Override
+            public void run() {
+                Object value = conflated.getAndSet(NO_VALUE);
+                if (value != NO_VALUE) {
+                    postInternal((T) value);
+                }
+            }
+        };
+
+        /**
+         * batch模式下收集的消息
+         */
+        private final List<Object> batch = new ArrayList<>();
+        private final List<Object> batchSpare = new ArrayList<>();
+        private boolean batchScheduled = false;
+        private final Runnable batchTask = new Runnable() {
+            @Override
+            public void run() {
+                List<Object> values;
+                synchronized (batch) {
+                    values = batchSpare;
+                    values.addAll(batch);
+                    batch.clear();
+                    batchScheduled = false;
+                }
+                for (int i = 0; i < values.size(); i++) {
+                    postInternal((T) values.get(i));
+                }
+                values.clear();
+            }
+        };
 
         LiveEvent(@NonNull String key) {
             this.key = key;
@@ -167,8 +251,29 @@ public final class LiveEventBusCore {
         public void post(T value) {
             if (ThreadUtils.isMainThread()) {
                 postInternal(value);
+                return;
+            }
+            ObservableConfig config = findConfig(key);
+            if (config != null && config.batchIntervalMs > 0) {
+                postBatched(value, config.batchIntervalMs);
+            } else if (config != null && config.conflate) {
+                if (conflated.getAndSet(value) == NO_VALUE) {
+                    mainHandler.post(conflateTask);
+                }
             } else {
-                mainHandler.post(new PostValueTask(value));
+                mainHandler.post(obtainTask(value));
+            }
+        }
+
+        private void postBatched(T value, long intervalMs) {
+            boolean schedule;
+            synchronized (batch) {
+                batch.add(value);
+                schedule = !batchScheduled;
+                batchScheduled = true;
+            }
+            if (schedule) {
+                mainHandler.postDelayed(batchTask, intervalMs);
             }
         }
 
@@ -194,13 +299,18 @@ public final class LiveEventBusCore {
 
         /**
          * 进程内发送消息，延迟发送
+         * 延迟消息统一挂在主线程时间轮上，不再每条占一个Handler消息
          *
          * @param value 发送的消息
          * @param delay 延迟毫秒数
          */
         @Override
         public void postDelay(T value, long delay) {
-            mainHandler.postDelayed(new PostValueTask(value), delay);
+            if (delay <= 0) {
+                mainHandler.post(obtainTask(value));
+            } else {
+                TimerWheel.main().schedule(obtainTask(value), delay);
+            }
         }
 
         /**
@@ -213,7 +323,11 @@ public final class LiveEventBusCore {
          */
         @Override
         public void postDelay(LifecycleOwner owner, final T value, long delay) {
-            mainHandler.postDelayed(new PostLifeValueTask(value, owner), delay);
+            if (delay <= 0) {
+                mainHandler.post(new PostLifeValueTask(value, owner));
+            } else {
+                TimerWheel.main().schedule(new PostLifeValueTask(value, owner), delay);
+            }
         }
 
         /**
@@ -224,7 +338,7 @@ public final class LiveEventBusCore {
          */
         @Override
         public void postOrderly(T value) {
-            mainHandler.post(new PostValueTask(value));
+            mainHandler.post(obtainTask(value));
         }
 
         /**
@@ -344,6 +458,47 @@ public final class LiveEventBusCore {
             }
         }
 
+        /**
+         * 注册一个Observer，需手动解除绑定，消息在executor上分发
+         *
+         * @param observer 观察者
+         * @param executor 分发线程
+         */
+        @Override
+        public void observeForever(@NonNull final Observer<T> observer, @NonNull final Executor executor) {
+            if (ThreadUtils.isMainThread()) {
+                observeForeverInternal(observer, executor);
+            } else {
+                mainHandler.post(new Runnable() {
+                    @Override
+                    public void run() {
+                        observeForeverInternal(observer, executor);
+                    }
+                });
+            }
+        }
+
+        /**
+         * 注册一个Observer，需手动解除绑定，消息在executor上分发
+         * 如果之前有消息发送，可以在注册时收到消息（消息同步）
+         *
+         * @param observer 观察者
+         * @param executor 分发线程
+         */
+        @Override
+        public void observeStickyForever(@NonNull final Observer<T> observer, @NonNull final Executor executor) {
+            if (ThreadUtils.isMainThread()) {
+                observeStickyForeverInternal(observer, executor);
+            } else {
+                mainHandler.post(new Runnable() {
+                    @Override
+                    public void run() {
+                        observeStickyForeverInternal(observer, executor);
+                    }
+                });
+            }
+        }
+
         /**
          * 通过observeForever或observeStickyForever注册的，需要调用该方法取消订阅
          *
@@ -365,14 +520,30 @@ public final class LiveEventBusCore {
 
         @MainThread
         private void postInternal(T value) {
-            logger.log(Level.INFO, "post: " + value + " with key: " + key);
+            if (logger.isEnable()) {
+                logger.log(Level.INFO, "post: " + value + " with key: " + key);
+            }
             liveData.setValue(value);
         }
 
+        /**
+         * 从池中取一个PostValueTask，避免每次跨线程post都分配新对象
+         */
+        private PostValueTask obtainTask(Object value) {
+            PostValueTask task = taskPool.acquire();
+            if (task == null) {
+                task = new PostValueTask();
+            }
+            task.newValue = value;
+            return task;
+        }
+
         @MainThread
         private void broadcastInternal(T value, boolean foreground, boolean onlyInApp) {
-            logger.log(Level.INFO, "broadcast: " + value + " foreground: " + foreground +
-                    " with key: " + key);
+            if (logger.isEnable()) {
+                logger.log(Level.INFO, "broadcast: " + value + " foreground: " + foreground +
+                        " with key: " + key);
+            }
             Application application = AppUtils.getApp();
             if (application == null) {
                 logger.log(Level.WARNING, "application is null, you can try setContext() when config");
@@ -386,7 +557,8 @@ public final class LiveEventBusCore {
                 intent.setPackage(application.getPackageName());
             }
             intent.putExtra(IpcConst.KEY, key);
-            boolean handle = ProcessorManager.getManager().writeTo(intent, value);
+            // 只在APP内时收发双方是同一个APK，可以使用紧凑的二进制编码
+            boolean handle = ProcessorManager.getManager().writeTo(intent, value, onlyInApp);
             try {
                 if (handle) {
                     application.sendBroadcast(intent);
@@ -415,7 +587,12 @@ public final class LiveEventBusCore {
 
         @MainThread
         private void observeForeverInternal(@NonNull Observer<T> observer) {
-            ObserverWrapper<T> observerWrapper = new ObserverWrapper<>(observer);
+            observeForeverInternal(observer, null);
+        }
+
+        @MainThread
+        private void observeForeverInternal(@NonNull Observer<T> observer, @Nullable Executor executor) {
+            ObserverWrapper<T> observerWrapper = new ObserverWrapper<>(observer, executor, key);
             observerWrapper.preventNextEvent = liveData.getVersion() > ExternalLiveData.START_VERSION;
             observerMap.put(observer, observerWrapper);
             liveData.observeForever(observerWrapper);
@@ -425,7 +602,12 @@ public final class LiveEventBusCore {
 
         @MainThread
         private void observeStickyForeverInternal(@NonNull Observer<T> observer) {
-            ObserverWrapper<T> observerWrapper = new ObserverWrapper<>(observer);
+            observeStickyForeverInternal(observer, null);
+        }
+
+        @MainThread
+        private void observeStickyForeverInternal(@NonNull Observer<T> observer, @Nullable Executor executor) {
+            ObserverWrapper<T> observerWrapper = new ObserverWrapper<>(observer, executor, key);
             observerMap.put(observer, observerWrapper);
             liveData.observeForever(observerWrapper);
             logger.log(Level.INFO, "observe sticky forever observer: " + observerWrapper + "(" + observer + ")"
@@ -436,7 +618,9 @@ public final class LiveEventBusCore {
         private void removeObserverInternal(@NonNull Observer<T> observer) {
             Observer<T> realObserver;
             if (observerMap.containsKey(observer)) {
-                realObserver = observerMap.remove(observer);
+                ObserverWrapper<T> wrapper = observerMap.remove(observer);
+                wrapper.cancel();
+                realObserver = wrapper;
             } else {
                 realObserver = observer;
             }
@@ -460,9 +644,12 @@ public final class LiveEventBusCore {
             public void removeObserver(@NonNull Observer<? super T> observer) {
                 super.removeObserver(observer);
                 if (autoClear() && !liveData.hasObservers()) {
-                    LiveEventBusCore.get().bus.remove(key);
+                    // 只移除自己，避免误删同一个key下新建的通道
+                    LiveEventBusCore.get().bus.remove(key, LiveEvent.this);
+                }
+                if (logger.isEnable()) {
+                    logger.log(Level.INFO, "observer removed: " + observer);
                 }
-                logger.log(Level.INFO, "observer removed: " + observer);
             }
 
             private boolean lifecycleObserverAlwaysActive() {
@@ -489,13 +676,12 @@ public final class LiveEventBusCore {
         private class PostValueTask implements Runnable {
             private Object newValue;
 
-            public PostValueTask(@NonNull Object newValue) {
-                this.newValue = newValue;
-            }
-
             @Override
             public void run() {
-                postInternal((T) newValue);
+                Object value = newValue;
+                newValue = null;
+                taskPool.release(this);
+                postInternal((T) value);
             }
         }
 
@@ -525,8 +711,32 @@ public final class LiveEventBusCore {
         private final Observer<T> observer;
         private boolean preventNextEvent = false;
 
+        /**
+         * 非主线程分发时使用：消息先入队，再由executor按顺序逐个分发
+         */
+        @Nullable
+        private final Executor executor;
+        @Nullable
+        private final String key;
+        private final ArrayDeque<Object> pending;
+        private boolean draining = false;
+        private volatile boolean cancelled = false;
+        private final Runnable drainTask = new Runnable() {
+            @Override
+            public void run() {
+                drain();
+            }
+        };
+
         ObserverWrapper(@NonNull Observer<T> observer) {
+            this(observer, null, null);
+        }
+
+        ObserverWrapper(@NonNull Observer<T> observer, @Nullable Executor executor, @Nullable String key) {
             this.observer = observer;
+            this.key = key;
+            this.executor = Delivery.isMain(executor) ? null : executor;
+            this.pending = this.executor == null ? null : new ArrayDeque<>();
         }
 
         @Override
@@ -535,7 +745,55 @@ public final class LiveEventBusCore {
                 preventNextEvent = false;
                 return;
             }
-            logger.log(Level.INFO, "message received: " + t);
+            if (executor == null) {
+                deliver(t);
+                return;
+            }
+            boolean schedule;
+            ObservableConfig config = key == null ? null : findConfig(key);
+            synchronized (pending) {
+                if (config != null && config.conflate) {
+                    pending.clear();
+                }
+                pending.addLast(t == null ? NULL_VALUE : t);
+                schedule = !draining;
+                draining = true;
+            }
+            if (schedule) {
+                executor.execute(drainTask);
+            }
+        }
+
+        void cancel() {
+            cancelled = true;
+            if (pending != null) {
+                synchronized (pending) {
+                    pending.clear();
+                }
+            }
+        }
+
+        private void drain() {
+            while (true) {
+                Object value;
+                synchronized (pending) {
+                    value = pending.pollFirst();
+                    if (value == null) {
+                        draining = false;
+                        return;
+                    }
+                }
+                if (cancelled) {
+                    continue;
+                }
+                deliver(value == NULL_VALUE ? null : (T) value);
+            }
+        }
+
+        private void deliver(@Nullable T t) {
+            if (logger.isEnable()) {
+                logger.log(Level.INFO, "message received: " + t);
+            }
             try {
                 observer.onChanged(t);
             } catch (ClassCastException e) {
@@ -570,9 +828,9 @@ public final class LiveEventBusCore {
 
         String getBusInfo() {
             StringBuilder sb = new StringBuilder();
-            for (String key : bus.keySet()) {
-                sb.append("Event name: " + key).append("\n");
-                ExternalLiveData liveData = bus.get(key).liveData;
+            for (Map.Entry<String, LiveEvent<Object>> entry : bus.entrySet()) {
+                sb.append("Event name: " + entry.getKey()).append("\n");
+                ExternalLiveData liveData = entry.getValue().liveData;
                 sb.append("\tversion: " + liveData.getVersion()).append("\n");
                 sb.append("\thasActiveObservers: " + liveData.hasActiveObservers()).append("\n");
                 sb.append("\thasObservers: " + liveData.hasObservers()).append("\n");
@@ -5,6 +5,8 @@ import androidx.annotation.NonNull;
 import androidx.lifecycle.LifecycleOwner;
 import androidx.lifecycle.Observer;
 
+import java.util.concurrent.Executor;
+
 /**
  * Created by liaohailiang on 2019-08-28.
  */
@@ -109,6 +111,25 @@ public interface Observable<T> {
      */
     void observeStickyForever(@NonNull Observer<T> observer);
 
+    /**
+     * 注册一个Observer，需手动解除绑定
+     * 消息在executor上分发，同一个observer收到消息的顺序和发送顺序一致
+     *
+     * @param observer 观察者
+     * @param executor 分发线程，见{@link Delivery}
+     */
+    void observeForever(@NonNull Observer<T> observer, @NonNull Executor executor);
+
+    /**
+     * 注册一个Observer，需手动解除绑定
+     * 如果之前有消息发送，可以在注册时收到消息（消息同步）
+     * 消息在executor上分发，同一个observer收到消息的顺序和发送顺序一致
+     *
+     * @param observer 观察者
+     * @param executor 分发线程，见{@link Delivery}
+     */
+    void observeStickyForever(@NonNull Observer<T> observer, @NonNull Executor executor);
+
     /**
      * 通过observeForever或observeStickyForever注册的，需要调用该方法取消订阅
      *
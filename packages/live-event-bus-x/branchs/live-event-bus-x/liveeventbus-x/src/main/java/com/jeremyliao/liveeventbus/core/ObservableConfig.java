@@ -7,6 +7,8 @@ public class ObservableConfig {
 
     Boolean lifecycleObserverAlwaysActive = null;
     Boolean autoClear = null;
+    volatile boolean conflate = false;
+    volatile long batchIntervalMs = 0;
 
     /**
      * lifecycleObserverAlwaysActive
@@ -31,4 +33,31 @@ public class ObservableConfig {
         autoClear = clear;
         return this;
     }
+
+    /**
+     * conflate
+     * only the latest pending value is delivered, intermediate values are dropped
+     * applies to posts from non-main threads and to observers on a non-main executor
+     *
+     * @param conflate boolean
+     * @return ObservableConfig
+     */
+    public ObservableConfig conflate(boolean conflate) {
+        this.conflate = conflate;
+        return this;
+    }
+
+    /**
+     * batch
+     * values posted from non-main threads are collected and delivered together,
+     * in posting order, by one main-thread message at most every intervalMs
+     * 0 disables batching
+     *
+     * @param intervalMs long
+     * @return ObservableConfig
+     */
+    public ObservableConfig batch(long intervalMs) {
+        this.batchIntervalMs = Math.max(0, intervalMs);
+        return this;
+    }
 }
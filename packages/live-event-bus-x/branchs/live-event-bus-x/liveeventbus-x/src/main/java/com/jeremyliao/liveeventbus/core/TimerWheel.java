@@ -0,0 +1,303 @@
+package com.jeremyliao.liveeventbus.core;
+
+import android.os.Handler;
+import android.os.Looper;
+import android.os.SystemClock;
+
+import androidx.annotation.NonNull;
+
+import java.util.ArrayList;
+
+/**
+ * 分层时间轮，用于postDelay
+ * 插入和取消都是O(1)，同一时刻到期的任务在一个主线程消息里按插入顺序执行
+ * 主线程上最多只有一个等待中的唤醒消息，不再是每个延迟消息一个Handler消息
+ * <p>
+ * 三层：第0层256格 x 4ms，第1层64格 x 1.024s，第2层64格 x 65.5s（约70分钟），
+ * 更远的任务放在第2层最远的格子里，级联时重新计算位置
+ */
+public final class TimerWheel {
+
+    private static final long TICK_MS = 4;
+
+    private static final int L0_BITS = 8;
+    private static final int L1_BITS = 6;
+    private static final int L2_BITS = 6;
+    private static final int L0_SIZE = 1 << L0_BITS;
+    private static final int L1_SIZE = 1 << L1_BITS;
+    private static final int L2_SIZE = 1 << L2_BITS;
+    private static final long L1_SPAN = L0_SIZE;
+    private static final long L2_SPAN = L1_SPAN * L1_SIZE;
+    private static final long MAX_SPAN = L2_SPAN * L2_SIZE;
+
+    private static class Holder {
+        private static final TimerWheel MAIN = new TimerWheel(Looper.getMainLooper());
+    }
+
+    /**
+     * 主线程时间轮
+     *
+     * @return TimerWheel
+     */
+    public static TimerWheel main() {
+        return Holder.MAIN;
+    }
+
+    /**
+     * 已调度的任务，可用于取消
+     */
+    public static final class Timeout {
+        private final Runnable task;
+        private long deadline;
+        private Timeout prev;
+        private Timeout next;
+        private Slot slot;
+
+        private Timeout(Runnable task, long deadline) {
+            this.task = task;
+            this.deadline = deadline;
+        }
+    }
+
+    private static final class Slot {
+        private Timeout head;
+        private Timeout tail;
+
+        void add(Timeout t) {
+            t.slot = this;
+            t.prev = tail;
+            t.next = null;
+            if (tail == null) {
+                head = t;
+            } else {
+                tail.next = t;
+            }
+            tail = t;
+        }
+
+        void remove(Timeout t) {
+            if (t.prev == null) {
+                head = t.next;
+            } else {
+                t.prev.next = t.next;
+            }
+            if (t.next == null) {
+                tail = t.prev;
+            } else {
+                t.next.prev = t.prev;
+            }
+            t.prev = null;
+            t.next = null;
+            t.slot = null;
+        }
+
+        Timeout takeAll() {
+            Timeout first = head;
+            head = null;
+            tail = null;
+            return first;
+        }
+    }
+
+    private final Handler handler;
+    private final long originMs;
+    private final Slot[] level0 = newSlots(L0_SIZE);
+    private final Slot[] level1 = newSlots(L1_SIZE);
+    private final Slot[] level2 = newSlots(L2_SIZE);
+
+    // guarded by this
+    private long currentTick;
+    private int pending;
+    private long wakeTick = Long.MAX_VALUE;
+    // 已post的唤醒消息对应的tick，Long.MAX_VALUE表示没有
+    private long postedTick = Long.MAX_VALUE;
+
+    private final ArrayList<Runnable> due = new ArrayList<>();
+    private final Runnable wake = new Runnable() {
+        @Override
+        public void run() {
+            fire();
+        }
+    };
+
+    public TimerWheel(@NonNull Looper looper) {
+        handler = new Handler(looper);
+        originMs = SystemClock.uptimeMillis();
+    }
+
+    private static Slot[] newSlots(int n) {
+        Slot[] slots = new Slot[n];
+        for (int i = 0; i < n; i++) {
+            slots[i] = new Slot();
+        }
+        return slots;
+    }
+
+    private long nowTick() {
+        return (SystemClock.uptimeMillis() - originMs) / TICK_MS;
+    }
+
+    /**
+     * 在delayMs之后于looper线程执行task
+     *
+     * @param task    任务
+     * @param delayMs 延迟毫秒数
+     * @return Timeout，可传给cancel
+     */
+    public Timeout schedule(@NonNull Runnable task, long delayMs) {
+        // 向上取整，保证不会早于请求的延迟执行
+        long ticks = (Math.max(0, delayMs) + TICK_MS - 1) / TICK_MS;
+        long deadline;
+        Timeout timeout;
+        synchronized (this) {
+            // 空闲时时间轮不走，先追上当前时间
+            if (pending == 0) {
+                currentTick = Math.max(currentTick, nowTick());
+            }
+            deadline = nowTick() + Math.max(1, ticks);
+            timeout = new Timeout(task, deadline);
+            place(timeout);
+            pending++;
+            if (deadline < wakeTick) {
+                wakeTick = deadline;
+                postWake();
+            }
+        }
+        return timeout;
+    }
+
+    /**
+     * 取消尚未执行的任务
+     *
+     * @param timeout schedule返回的Timeout
+     * @return true:取消成功，false:已执行或已取消
+     */
+    public boolean cancel(@NonNull Timeout timeout) {
+        synchronized (this) {
+            if (timeout.slot == null) {
+                return false;
+            }
+            timeout.slot.remove(timeout);
+            pending--;
+            return true;
+        }
+    }
+
+    /**
+     * 等待执行的任务数
+     */
+    public synchronized int pendingCount() {
+        return pending;
+    }
+
+    private void place(Timeout t) {
+        long delta = t.deadline - currentTick;
+        if (delta < L1_SPAN) {
+            level0[(int) (t.deadline & (L0_SIZE - 1))].add(t);
+        } else if (delta < L2_SPAN) {
+            level1[(int) ((t.deadline >>> L0_BITS) & (L1_SIZE - 1))].add(t);
+        } else if (delta < MAX_SPAN) {
+            level2[(int) ((t.deadline >>> (L0_BITS + L1_BITS)) & (L2_SIZE - 1))].add(t);
+        } else {
+            // 超出范围：放在最远的格子，级联到这里时再按剩余时间重新放置
+            long far = currentTick + MAX_SPAN - L2_SPAN;
+            level2[(int) ((far >>> (L0_BITS + L1_BITS)) & (L2_SIZE - 1))].add(t);
+        }
+    }
+
+    private void cascade(Slot slot) {
+        Timeout t = slot.takeAll();
+        while (t != null) {
+            Timeout next = t.next;
+            t.prev = null;
+            t.next = null;
+            t.slot = null;
+            place(t);
+            t = next;
+        }
+    }
+
+    private void fire() {
+        synchronized (this) {
+            // 正在执行的就是已post的唤醒消息
+            postedTick = Long.MAX_VALUE;
+            wakeTick = Long.MAX_VALUE;
+            long now = nowTick();
+            while (currentTick < now && pending > 0) {
+                currentTick++;
+                int i0 = (int) (currentTick & (L0_SIZE - 1));
+                if (i0 == 0) {
+                    int i1 = (int) ((currentTick >>> L0_BITS) & (L1_SIZE - 1));
+                    if (i1 == 0) {
+                        cascade(level2[(int) ((currentTick >>> (L0_BITS + L1_BITS)) & (L2_SIZE - 1))]);
+                    }
+                    cascade(level1[i1]);
+                }
+                Slot slot = level0[i0];
+                Timeout t = slot.head;
+                while (t != null) {
+                    Timeout after = t.next;
+                    if (t.deadline <= currentTick) {
+                        slot.remove(t);
+                        pending--;
+                        due.add(t.task);
+                    }
+                    t = after;
+                }
+            }
+            if (pending == 0) {
+                currentTick = now;
+            }
+            wakeTick = pending > 0 ? nextWakeTick() : Long.MAX_VALUE;
+        }
+        // 锁外执行，任务里可以再次schedule；一个任务抛异常不影响同批的其他任务
+        RuntimeException error = null;
+        for (int i = 0; i < due.size(); i++) {
+            try {
+                due.get(i).run();
+            } catch (RuntimeException e) {
+                if (error == null) {
+                    error = e;
+                }
+            }
+        }
+        due.clear();
+        // 任务里的schedule可能已经把wakeTick提前，按最新的wakeTick唤醒
+        synchronized (this) {
+            postWake();
+        }
+        if (error != null) {
+            throw error;
+        }
+    }
+
+    /**
+     * 第0层中下一个非空格子；没有的话在下一次级联时醒来
+     */
+    private long nextWakeTick() {
+        for (long tick = currentTick + 1; ; tick++) {
+            int i0 = (int) (tick & (L0_SIZE - 1));
+            if (i0 == 0) {
+                return tick;
+            }
+            if (level0[i0].head != null) {
+                return tick;
+            }
+        }
+    }
+
+    /**
+     * 按wakeTick重新post唤醒消息，保证队列里最多只有一个，需持有锁
+     */
+    private void postWake() {
+        if (postedTick == wakeTick) {
+            return;
+        }
+        handler.removeCallbacks(wake);
+        postedTick = wakeTick;
+        if (wakeTick != Long.MAX_VALUE) {
+            long delay = (wakeTick * TICK_MS + originMs) - SystemClock.uptimeMillis();
+            handler.postDelayed(wake, Math.max(0, delay));
+        }
+    }
+}
@@ -0,0 +1,99 @@
+package com.jeremyliao.liveeventbus.ipc.core;
+
+import android.os.Bundle;
+import android.os.Parcel;
+import android.os.Parcelable;
+
+import com.jeremyliao.liveeventbus.ipc.consts.IpcConst;
+
+/**
+ * 紧凑二进制编码：一个类型标记字节 + 值，整体作为一个byte[]放入Bundle
+ * 支持基本类型、String和Parcelable
+ * 只用于进程间（同一个APK），跨APP时对方不一定有这个Processor
+ */
+public class BinaryProcessor implements Processor {
+
+    private static final byte TYPE_INT = 1;
+    private static final byte TYPE_LONG = 2;
+    private static final byte TYPE_FLOAT = 3;
+    private static final byte TYPE_DOUBLE = 4;
+    private static final byte TYPE_BOOLEAN = 5;
+    private static final byte TYPE_STRING = 6;
+    private static final byte TYPE_PARCELABLE = 7;
+
+    static boolean supports(Class<?> type) {
+        return type == Integer.class || type == Long.class || type == Float.class
+                || type == Double.class || type == Boolean.class || type == String.class
+                || Parcelable.class.isAssignableFrom(type);
+    }
+
+    @Override
+    public boolean writeToBundle(Bundle bundle, Object value) {
+        if (value == null || !supports(value.getClass())) {
+            return false;
+        }
+        Parcel parcel = Parcel.obtain();
+        try {
+            if (value instanceof Integer) {
+                parcel.writeByte(TYPE_INT);
+                parcel.writeInt((Integer) value);
+            } else if (value instanceof Long) {
+                parcel.writeByte(TYPE_LONG);
+                parcel.writeLong((Long) value);
+            } else if (value instanceof Float) {
+                parcel.writeByte(TYPE_FLOAT);
+                parcel.writeFloat((Float) value);
+            } else if (value instanceof Double) {
+                parcel.writeByte(TYPE_DOUBLE);
+                parcel.writeDouble((Double) value);
+            } else if (value instanceof Boolean) {
+                parcel.writeByte(TYPE_BOOLEAN);
+                parcel.writeByte((byte) ((Boolean) value ? 1 : 0));
+            } else if (value instanceof String) {
+                parcel.writeByte(TYPE_STRING);
+                parcel.writeString((String) value);
+            } else {
+                parcel.writeByte(TYPE_PARCELABLE);
+                parcel.writeParcelable((Parcelable) value, 0);
+            }
+            bundle.putByteArray(IpcConst.KEY_VALUE, parcel.marshall());
+            return true;
+        } finally {
+            parcel.recycle();
+        }
+    }
+
+    @Override
+    public Object createFromBundle(Bundle bundle) {
+        byte[] bytes = bundle.getByteArray(IpcConst.KEY_VALUE);
+        if (bytes == null || bytes.length == 0) {
+            return null;
+        }
+        Parcel parcel = Parcel.obtain();
+        try {
+            parcel.unmarshall(bytes, 0, bytes.length);
+            parcel.setDataPosition(0);
+            byte type = parcel.readByte();
+            switch (type) {
+                case TYPE_INT:
+                    return parcel.readInt();
+                case TYPE_LONG:
+                    return parcel.readLong();
+                case TYPE_FLOAT:
+                    return parcel.readFloat();
+                case TYPE_DOUBLE:
+                    return parcel.readDouble();
+                case TYPE_BOOLEAN:
+                    return parcel.readByte() != 0;
+                case TYPE_STRING:
+                    return parcel.readString();
+                case TYPE_PARCELABLE:
+                    return parcel.readParcelable(BinaryProcessor.class.getClassLoader());
+                default:
+                    return null;
+            }
+        } finally {
+            parcel.recycle();
+        }
+    }
+}
@@ -2,15 +2,17 @@ package com.jeremyliao.liveeventbus.ipc.core;
 
 import android.content.Intent;
 import android.os.Bundle;
+import android.os.Parcelable;
 
 import com.jeremyliao.liveeventbus.ipc.annotation.IpcConfig;
 import com.jeremyliao.liveeventbus.ipc.consts.IpcConst;
 
+import java.io.Serializable;
 import java.util.Arrays;
-import java.util.HashMap;
 import java.util.LinkedList;
 import java.util.List;
 import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
 
 /**
  * Created by liaohailiang on 2019/5/30.
@@ -26,7 +28,25 @@ public class ProcessorManager {
     }
 
     private final List<Processor> baseProcessors;
-    private final Map<String, Processor> processorMap;
+    private final ConcurrentHashMap<String, Processor> processorMap;
+    private final BinaryProcessor binaryProcessor = new BinaryProcessor();
+
+    /**
+     * 按消息类型缓存选中的processor，避免每条消息都查注解、遍历baseProcessors
+     * NONE表示该类型没有可用的processor
+     */
+    private final Map<Class<?>, Processor> typeProcessors = new ConcurrentHashMap<>();
+    private static final Processor NONE = new Processor() {
+        @Override
+        public boolean writeToBundle(Bundle bundle, Object value) {
+            return false;
+        }
+
+        @Override
+        public Object createFromBundle(Bundle bundle) {
+            return null;
+        }
+    };
 
     {
         baseProcessors = new LinkedList<>(Arrays.asList(
@@ -38,65 +58,148 @@ public class ProcessorManager {
                 new LongProcessor(),
                 new SerializableProcessor(),
                 new ParcelableProcessor()));
-        processorMap = new HashMap<>();
+        processorMap = new ConcurrentHashMap<>();
         for (Processor processor : baseProcessors) {
             processorMap.put(processor.getClass().getName(), processor);
         }
+        processorMap.put(BinaryProcessor.class.getName(), binaryProcessor);
     }
 
     private ProcessorManager() {
     }
 
     public boolean writeTo(Intent intent, Object value) {
+        return writeTo(intent, value, false);
+    }
+
+    /**
+     * @param compact true:基本类型和Parcelable使用BinaryProcessor编码，只能用于同一个APK内
+     */
+    public boolean writeTo(Intent intent, Object value, boolean compact) {
         if (intent == null || value == null) {
             return false;
         }
+        Class<?> type = value.getClass();
+        Processor processor = typeProcessors.get(type);
+        if (processor == null) {
+            processor = findProcessor(type);
+            typeProcessors.put(type, processor);
+        }
+        if (compact && !(processor instanceof AnnotatedProcessor) && BinaryProcessor.supports(type)) {
+            processor = binaryProcessor;
+        }
+        if (processor == NONE) {
+            return false;
+        }
         Bundle bundle = new Bundle();
-        boolean processed = false;
-        //用指定的processor处理
-        IpcConfig config = value.getClass().getAnnotation(IpcConfig.class);
-        if (config != null) {
-            Class<? extends Processor> processorType = config.processor();
-            String processorTypeName = processorType.getName();
-            if (!processorMap.containsKey(processorTypeName)) {
-                try {
-                    processorMap.put(processorTypeName, processorType.newInstance());
-                } catch (Exception e) {
-                    e.printStackTrace();
-                }
+        if (processor instanceof AnnotatedProcessor) {
+            //用指定的processor处理，失败时回退到默认的processor
+            Processor annotated = ((AnnotatedProcessor) processor).processor;
+            if (write(intent, bundle, annotated, value)) {
+                return true;
             }
-            Processor processor = processorMap.get(processorTypeName);
-            if (processor != null) {
-                try {
-                    boolean handle = processor.writeToBundle(bundle, value);
-                    if (handle) {
-                        intent.putExtra(IpcConst.KEY_PROCESSOR_NAME, processor.getClass().getName());
-                        intent.putExtra(IpcConst.KEY_BUNDLE, bundle);
-                        processed = true;
-                    }
-                } catch (Exception e) {
-                    e.printStackTrace();
+            for (Processor base : baseProcessors) {
+                if (write(intent, bundle, base, value)) {
+                    return true;
                 }
             }
-            if (processed) {
+            return false;
+        }
+        return write(intent, bundle, processor, value);
+    }
+
+    private boolean write(Intent intent, Bundle bundle, Processor processor, Object value) {
+        try {
+            boolean handle = processor.writeToBundle(bundle, value);
+            if (handle) {
+                intent.putExtra(IpcConst.KEY_PROCESSOR_NAME, processor.getClass().getName());
+                intent.putExtra(IpcConst.KEY_BUNDLE, bundle);
                 return true;
             }
+        } catch (Exception e) {
+            e.printStackTrace();
+        }
+        return false;
+    }
+
+    /**
+     * 为消息类型选择processor：优先@IpcConfig指定的，否则按顺序匹配baseProcessors
+     * 内置processor只按类型判断，所以结果可以按类型缓存
+     */
+    private Processor findProcessor(Class<?> type) {
+        IpcConfig config = type.getAnnotation(IpcConfig.class);
+        if (config != null) {
+            Processor processor = getProcessor(config.processor().getName(), config.processor());
+            if (processor != null) {
+                return new AnnotatedProcessor(processor);
+            }
         }
-        //用默认的processor处理
         for (Processor processor : baseProcessors) {
+            if (accepts(processor, type)) {
+                return processor;
+            }
+        }
+        return NONE;
+    }
+
+    private static boolean accepts(Processor processor, Class<?> type) {
+        if (processor instanceof StringProcessor) {
+            return type == String.class;
+        } else if (processor instanceof IntProcessor) {
+            return type == Integer.class;
+        } else if (processor instanceof BooleanProcessor) {
+            return type == Boolean.class;
+        } else if (processor instanceof DoubleProcessor) {
+            return type == Double.class;
+        } else if (processor instanceof FloatProcessor) {
+            return type == Float.class;
+        } else if (processor instanceof LongProcessor) {
+            return type == Long.class;
+        } else if (processor instanceof SerializableProcessor) {
+            return Serializable.class.isAssignableFrom(type);
+        } else if (processor instanceof ParcelableProcessor) {
+            return Parcelable.class.isAssignableFrom(type);
+        }
+        return false;
+    }
+
+    private Processor getProcessor(String name, Class<?> type) {
+        Processor processor = processorMap.get(name);
+        if (processor == null) {
             try {
-                boolean handle = processor.writeToBundle(bundle, value);
-                if (handle) {
-                    intent.putExtra(IpcConst.KEY_PROCESSOR_NAME, processor.getClass().getName());
-                    intent.putExtra(IpcConst.KEY_BUNDLE, bundle);
-                    processed = true;
-                    break;
+                Class<?> processorType = type != null ? type : Class.forName(name);
+                processor = (Processor) processorType.newInstance();
+                Processor existing = processorMap.putIfAbsent(name, processor);
+                if (existing != null) {
+                    processor = existing;
                 }
             } catch (Exception e) {
                 e.printStackTrace();
             }
         }
-        return processed;
+        return processor;
+    }
+
+    /**
+     * 标记通过@IpcConfig指定的processor
+     */
+    private static class AnnotatedProcessor implements Processor {
+
+        private final Processor processor;
+
+        AnnotatedProcessor(Processor processor) {
+            this.processor = processor;
+        }
+
+        @Override
+        public boolean writeToBundle(Bundle bundle, Object value) throws Exception {
+            return processor.writeToBundle(bundle, value);
+        }
+
+        @Override
+        public Object createFromBundle(Bundle bundle) throws Exception {
+            return processor.createFromBundle(bundle);
+        }
     }
 
     public Object createFrom(Intent intent) {
@@ -108,14 +211,7 @@ public class ProcessorManager {
         if (processorName == null || processorName.length() == 0 || bundle == null) {
             return null;
         }
-        if (!processorMap.containsKey(processorName)) {
-            try {
-                processorMap.put(processorName, (Processor) Class.forName(processorName).newInstance());
-            } catch (Exception e) {
-                e.printStackTrace();
-            }
-        }
-        Processor processor = processorMap.get(processorName);
+        Processor processor = getProcessor(processorName, null);
         if (processor == null) {
             return null;
         }
@@ -8,7 +8,7 @@ import java.util.logging.Level;
 public class LoggerManager implements Logger {
 
     private Logger logger;
-    private boolean enable = true;
+    private volatile boolean enable = true;
 
     public LoggerManager(Logger logger) {
         this.logger = logger;
@@ -0,0 +1,373 @@
+// Plausible O2Ring files for the simulator and benchmarks: a drifting SpO2
+// baseline with desaturations, pulse rate following it, motion bursts and
+// probe-off stretches. `syntheticO2File` is the fixed, cheap fixture the
+// gateway simulator uses; `syntheticNight` takes the interval, length and
+// event / artifact rates. `syntheticPpgFile` / `syntheticBabyFile` stream
+// raw recordings of any length in fixed-size chunks. `syntheticEr3File` and
+// `syntheticVentFile` build whole ER3 origin and ventilator monitor files.
+// Good enough to exercise decode and analysis at realistic sizes; not a
+// physiological model.
+
+import {
+  Er3Cable,
+  er3ChannelCount,
+  er3DataChecksum,
+  ER3_FILE_MAGIC,
+} from "@ios-app/viatom-o2ring/src/Er3Wave";
+import {
+  encodeO2File,
+  encodeOxiFile,
+  O2_FILE_INTERVAL_S,
+  O2Night,
+} from "@ios-app/viatom-o2ring/src/O2Night";
+import {
+  BABY_INTERVAL_S,
+  BABY_RECORD_SIZE,
+  encodeBabyFileHead,
+  encodeBabyFileTail,
+  encodePpgFileHead,
+  PPG_MARKER_IR,
+  PPG_MARKER_MOTION,
+  PPG_MARKER_RED,
+  ppgSampleSize,
+} from "@ios-app/viatom-o2ring/src/RawFiles";
+import {
+  VENT_FILE_HEAD_SIZE,
+  VENT_MONITOR_FIELDS,
+  VENT_MONITOR_POINT_SIZE,
+} from "@ios-app/viatom-o2ring/src/Ventilator";
+
+function xorshift(seed: number) {
+  let x = seed >>> 0 || 1;
+  return () => {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    return (x >>> 0) / 0x100000000;
+  };
+}
+
+export function syntheticO2File(seed: number, hours = 8, startTime = 1767304800): Uint8Array {
+  const n = Math.round((hours * 3600) / O2_FILE_INTERVAL_S);
+  const spo2 = new Uint8Array(n);
+  const pr = new Uint16Array(n);
+  const motion = new Uint8Array(n);
+  const rand = xorshift(seed);
+  const period = 30 + Math.floor(rand() * 60);
+  for (let i = 0; i < n; i++) {
+    const dip = i % period < 6 ? 5 : 0;
+    spo2[i] = Math.round(96 - dip + (rand() - 0.5) * 2);
+    pr[i] = Math.round(62 + dip * 2 + (rand() - 0.5) * 6);
+    motion[i] = rand() < 0.02 ? Math.floor(rand() * 40) : 0;
+  }
+  return encodeO2File({
+    startTime: startTime + seed * 86400,
+    intervalS: O2_FILE_INTERVAL_S,
+    spo2,
+    pr,
+    motion,
+    spo2Mark: new Uint8Array(n),
+    prMark: new Uint8Array(n),
+  });
+}
+
+export type SyntheticNightOptions = {
+  seed?: number;
+  hours?: number;
+  /** 1, 2 or 4 s (`VTMWOxiInfo.interval`). */
+  intervalS?: number;
+  startTime?: number;
+  baselineSpo2?: number;
+  baselinePr?: number;
+  /** Desaturation events per hour (roughly the ODI the night should score). */
+  eventsPerHour?: number;
+  /** Mean drop below baseline, %. */
+  eventDepth?: number;
+  /** Mean event length, s. */
+  eventSeconds?: number;
+  /** Motion bursts per hour; SpO2 reads low and noisy during them. */
+  motionPerHour?: number;
+  /** Probe-off stretches per night (0xFF for SpO2 and PR). */
+  dropouts?: number;
+  /** The ring vibrates (and marks the point) below this SpO2; 0 disables. */
+  spo2Reminder?: number;
+};
+
+/**
+ * One night as columns. Events fall, hold and recover faster, with
+ * the pulse rate rising on recovery; motion bursts and probe-off stretches
+ * are laid over them as the artifacts the validity mask has to catch.
+ * Deterministic for a given seed.
+ */
+export function syntheticNight(options: SyntheticNightOptions = {}): O2Night {
+  const {
+    seed = 1,
+    hours = 8,
+    intervalS = O2_FILE_INTERVAL_S,
+    startTime = 1767304800,
+    baselineSpo2 = 96,
+    baselinePr = 62,
+    eventsPerHour = 8,
+    eventDepth = 5,
+    eventSeconds = 30,
+    motionPerHour = 3,
+    dropouts = 1,
+    spo2Reminder = 88,
+  } = options;
+  const n = Math.round((hours * 3600) / intervalS);
+  const rand = xorshift(seed * 2654435761);
+  const spo2 = new Uint8Array(n);
+  const pr = new Uint16Array(n);
+  const motion = new Uint8Array(n);
+  const spo2Mark = new Uint8Array(n);
+  const prMark = new Uint8Array(n);
+
+  // per-step probabilities of starting an event / burst
+  const pEvent = (eventsPerHour * intervalS) / 3600;
+  const pMotion = (motionPerHour * intervalS) / 3600;
+  let drift = 0;
+  let event = 0; // steps left in the current event
+  let eventLen = 1;
+  let depth = 0;
+  let burst = 0;
+  let wasBelow = false;
+
+  for (let i = 0; i < n; i++) {
+    drift = Math.max(-1.5, Math.min(1.5, drift + (rand() - 0.5) * 0.05 * intervalS));
+    if (event === 0 && rand() < pEvent) {
+      eventLen = Math.max(1, Math.round((eventSeconds * (0.5 + rand())) / intervalS));
+      event = eventLen;
+      depth = eventDepth * (0.6 + rand() * 0.8);
+    }
+    let drop = 0;
+    let prRise = 0;
+    if (event > 0) {
+      // 0..1 through the event: fall over the first third, hold, recover in the last sixth
+      const f = 1 - event / eventLen;
+      drop = depth * (f < 1 / 3 ? f * 3 : f < 5 / 6 ? 1 : (1 - f) * 6);
+      if (f >= 5 / 6) prRise = depth * 1.5;
+      event--;
+    }
+    if (burst === 0 && rand() < pMotion) {
+      burst = Math.max(1, Math.round((5 + rand() * 55) / intervalS));
+    }
+    let s = baselineSpo2 + drift - drop + (rand() - 0.5) * 1.5;
+    let p = baselinePr + prRise + (rand() - 0.5) * 4;
+    if (burst > 0) {
+      motion[i] = 20 + Math.floor(rand() * 44);
+      s -= rand() * 8;
+      p += (rand() - 0.3) * 20;
+      burst--;
+    }
+    spo2[i] = Math.max(50, Math.min(100, Math.round(s)));
+    pr[i] = Math.max(30, Math.min(220, Math.round(p)));
+    const below = spo2Reminder > 0 && spo2[i] < spo2Reminder;
+    if (below && !wasBelow) spo2Mark[i] = 1;
+    wasBelow = below;
+  }
+
+  for (let d = 0; d < dropouts; d++) {
+    const len = Math.round((60 + rand() * 540) / intervalS);
+    const at = Math.floor(rand() * Math.max(1, n - len));
+    spo2.fill(0xff, at, at + len);
+    pr.fill(0xff, at, at + len);
+    motion.fill(0, at, at + len);
+    spo2Mark.fill(0, at, at + len);
+  }
+  return { startTime, intervalS, spo2, pr, motion, spo2Mark, prMark };
+}
+
+/**
+ * The night as the ring would send it: an O2Ring history file (what
+ * VTO2Lib parses into `VTO2Object`) at 4 s, otherwise a VTMProductLib
+ * oximeter file (the only layout with a 1 s / 2 s interval).
+ */
+export function syntheticNightFile(options: SyntheticNightOptions = {}): Uint8Array {
+  const night = syntheticNight(options);
+  return night.intervalS === O2_FILE_INTERVAL_S ? encodeO2File(night) : encodeOxiFile(night);
+}
+
+/**
+ * Yields `size` bytes at a time from one buffer, so a file of any length is
+ * produced in constant memory. Each chunk is only valid until the next.
+ */
+function* chunked(
+  head: Uint8Array,
+  count: number,
+  recordSize: number,
+  size: number,
+  write: (view: DataView, at: number, i: number) => void,
+  tail: Uint8Array = new Uint8Array(0)
+): Generator<Uint8Array> {
+  const buf = new Uint8Array(
+    size + Math.max(recordSize, head.length, tail.length)
+  );
+  const view = new DataView(buf.buffer);
+  buf.set(head);
+  let fill = head.length;
+  for (let i = 0; i < count; i++) {
+    while (fill >= size) {
+      yield buf.subarray(0, size);
+      buf.copyWithin(0, size, fill);
+      fill -= size;
+    }
+    write(view, fill, i);
+    fill += recordSize;
+  }
+  while (fill >= size) {
+    yield buf.subarray(0, size);
+    buf.copyWithin(0, size, fill);
+    fill -= size;
+  }
+  buf.set(tail, fill);
+  fill += tail.length;
+  while (fill >= size) {
+    yield buf.subarray(0, size);
+    buf.copyWithin(0, size, fill);
+    fill -= size;
+  }
+  if (fill > 0) yield buf.subarray(0, fill);
+}
+
+export type SyntheticRawOptions = {
+  seed?: number;
+  hours?: number;
+  /** Chunk size the file is delivered in, like one `woxi_readPPGFile:` read. */
+  chunkBytes?: number;
+};
+
+/** Raw PPG (IR + red + motion unless `marker` says otherwise) at 150 or 200 Hz. */
+export function syntheticPpgFile(
+  options: SyntheticRawOptions & { sampleRateHz?: number; marker?: number } = {}
+) {
+  const {
+    seed = 1,
+    hours = 8,
+    chunkBytes = 4096,
+    sampleRateHz = 200,
+    marker = PPG_MARKER_IR | PPG_MARKER_RED | PPG_MARKER_MOTION,
+  } = options;
+  const rand = xorshift(seed * 2654435761);
+  const size = ppgSampleSize(marker);
+  const redAt = marker & PPG_MARKER_IR ? 4 : 0;
+  const motionAt = redAt + (marker & PPG_MARKER_RED ? 4 : 0);
+  const step = (2 * Math.PI * 1.1) / sampleRateHz; // ~66 bpm
+  let phase = 0;
+  return chunked(
+    encodePpgFileHead(marker, sampleRateHz),
+    Math.round(hours * 3600 * sampleRateHz),
+    size,
+    chunkBytes,
+    (view, at) => {
+      phase += step;
+      const pulse = Math.sin(phase) + 0.3 * Math.sin(2 * phase);
+      if (marker & PPG_MARKER_IR) view.setInt32(at, 120000 + Math.round(3000 * pulse + rand() * 200), true);
+      if (marker & PPG_MARKER_RED) view.setInt32(at + redAt, 90000 + Math.round(1800 * pulse + rand() * 200), true);
+      if (marker & PPG_MARKER_MOTION) view.setUint8(at + motionAt, rand() < 0.01 ? Math.floor(rand() * 64) : 0);
+    }
+  );
+}
+
+/**
+ * BabyO2 S3 file: SpO2 and pulse rate every 4 s with motion, quiet and
+ * sleep state, then the `VTO2SleepFileTail_t`.
+ */
+export function syntheticBabyFile(
+  options: SyntheticRawOptions & { startTime?: number } = {}
+) {
+  const {
+    seed = 1,
+    hours = 8,
+    chunkBytes = 4096,
+    startTime = 1767304800,
+  } = options;
+  const rand = xorshift(seed * 2654435761);
+  const count = Math.round((hours * 3600) / BABY_INTERVAL_S);
+  let spo2 = 97;
+  let pr = 120;
+  let state = 0;
+  return chunked(
+    encodeBabyFileHead(startTime, count),
+    count,
+    BABY_RECORD_SIZE,
+    chunkBytes,
+    (view, at) => {
+      spo2 += Math.round((rand() - 0.5) * 2);
+      spo2 = Math.max(88, Math.min(100, spo2));
+      pr = Math.max(90, Math.min(170, pr + Math.round((rand() - 0.5) * 4)));
+      if (rand() < 0.002) state = Math.floor(rand() * 4);
+      const motion = rand() < 0.02 ? Math.floor(rand() * 64) : 0;
+      view.setUint8(at, spo2);
+      view.setUint8(at + 1, pr);
+      view.setUint8(at + 2, motion);
+      view.setUint8(at + 3, Math.floor(rand() * 16) | (state << 4));
+    },
+    encodeBabyFileTail(count * BABY_INTERVAL_S, 97, 120)
+  );
+}
+
+/**
+ * ER3 origin file: ECG-like samples on every channel of `cable`, compressed
+ * with the multichannel differential scheme (a raw escape frame whenever a
+ * delta does not fit a byte), then the tail with checksum and magic.
+ */
+export function syntheticEr3File(
+  options: { seed?: number; minutes?: number; cable?: Er3Cable } = {}
+) {
+  const { seed = 1, minutes = 10, cable = Er3Cable.Lead10 } = options;
+  const rand = xorshift(seed * 2654435761);
+  const channels = er3ChannelCount(cable);
+  const frames = Math.round(minutes * 60 * 250);
+  // worst case: escape, mask, two bytes per channel
+  const out = new Uint8Array(10 + frames * (2 + channels * 2) + 20);
+  out.set([0x01, 0x00, cable]);
+  const last = new Int16Array(channels);
+  const next = new Int16Array(channels);
+  let o = 10;
+  for (let f = 0; f < frames; f++) {
+    const beat = (f % 200) / 200; // 75 bpm
+    const qrs = beat < 0.04 ? Math.sin(beat * 25 * Math.PI) * 900 : 0;
+    let mask = 0;
+    for (let c = 0; c < channels; c++) {
+      next[c] = Math.round(qrs * (1 - c * 0.1) + 40 * Math.sin(f / 300 + c) + (rand() - 0.5) * 12);
+      const d = next[c] - last[c];
+      if (d < -127 || d > 127 || f === 0) mask |= 1 << c;
+    }
+    if (mask) {
+      out[o++] = 0x80;
+      out[o++] = mask;
+    }
+    for (let c = 0; c < channels; c++) {
+      if (mask & (1 << c)) {
+        out[o++] = next[c] & 0xff;
+        out[o++] = (next[c] >> 8) & 0xff;
+      } else {
+        out[o++] = (next[c] - last[c]) & 0xff;
+      }
+      last[c] = next[c];
+    }
+  }
+  const file = out.subarray(0, o + 20);
+  const view = new DataView(file.buffer, file.byteOffset, file.length);
+  view.setUint32(o, Math.round(minutes * 60), true);
+  view.setUint16(o + 4, er3DataChecksum(file.subarray(0, o)), true);
+  view.setUint32(o + 16, ER3_FILE_MAGIC, true);
+  return file;
+}
+
+/** Ventilator monitor file: a `VTMScaleFileHead` and 0.5 Hz points. */
+export function syntheticVentFile(options: { seed?: number; hours?: number } = {}) {
+  const { seed = 1, hours = 8 } = options;
+  const rand = xorshift(seed * 2654435761);
+  const count = Math.round((hours * 3600) / 2);
+  const out = new Uint8Array(VENT_FILE_HEAD_SIZE + count * VENT_MONITOR_POINT_SIZE);
+  const view = new DataView(out.buffer);
+  out.set([0x01, 0x02]);
+  for (let i = 0; i < count; i++) {
+    const at = VENT_FILE_HEAD_SIZE + i * VENT_MONITOR_POINT_SIZE;
+    VENT_MONITOR_FIELDS.forEach((_, f) =>
+      view.setInt16(at + f * 2, Math.round(50 + f * 10 + (rand() - 0.5) * 20), true)
+    );
+  }
+  return out;
+}
@@ -0,0 +1,127 @@
+// Archive sink on the local disk: `<root>/<deviceId>/<startTime>.o2na`,
+// plus `<startTime>.o2cs` column streams for raw recordings. Each file is
+// written to a temp name and renamed into place, so a crash or power cut
+// at the dock never leaves a half-written night that a later sync would
+// take for a complete one.
+
+import { closeSync, openSync, unlinkSync, writeSync } from "node:fs";
+import { mkdir, open, readdir, rename, writeFile } from "node:fs/promises";
+import { join } from "node:path";
+
+import {
+  mergeNightSketches,
+  NIGHT_ARCHIVE_PREAMBLE,
+  NightArchiveHeader,
+  nightArchiveHeaderSize,
+  readNightArchiveHeader,
+} from "@ios-app/viatom-o2ring/src/NightArchive";
+
+import { ArchiveSink } from "./Gateway";
+
+export class FsArchive implements ArchiveSink {
+  private readonly dirs = new Map<string, Promise<unknown>>();
+
+  constructor(private readonly root: string) {}
+
+  async write(deviceId: string, startTime: number, bytes: Uint8Array) {
+    const path = join(await this.dir(deviceId), `${startTime}.o2na`);
+    const tmp = `${path}.${process.pid}.tmp`;
+    await writeFile(tmp, bytes);
+    await rename(tmp, path);
+  }
+
+  /**
+   * Open `<startTime>.<ext>` for appending, e.g. as a `ColumnStreamWriter`'s
+   * output. Writes are synchronous: the writer reuses its frame buffer as
+   * soon as `write` returns, and nothing queues up behind a slow disk, so
+   * memory stays at one frame however long the recording is.
+   */
+  async openStream(deviceId: string, startTime: number, ext = "o2cs"): Promise<ArchiveStream> {
+    const path = join(await this.dir(deviceId), `${startTime}.${ext}`);
+    const tmp = `${path}.${process.pid}.tmp`;
+    const fd = openSync(tmp, "w");
+    let open = true;
+    return {
+      path,
+      write(bytes) {
+        let at = 0;
+        while (at < bytes.length) at += writeSync(fd, bytes, at, bytes.length - at);
+      },
+      async close() {
+        if (!open) return;
+        open = false;
+        closeSync(fd);
+        await rename(tmp, path);
+      },
+      abort() {
+        if (!open) return;
+        open = false;
+        closeSync(fd);
+        unlinkSync(tmp);
+      },
+    };
+  }
+
+  /**
+   * Headers of the device's nights starting in `[fromS, toS)`. The start
+   * time is in the file name, so nights outside the range are never opened,
+   * and only the header bytes of the rest are read.
+   */
+  async headers(deviceId: string, fromS = -Infinity, toS = Infinity) {
+    const dir = join(this.root, safeName(deviceId));
+    const names = await readdir(dir).catch(() => [] as string[]);
+    const out: NightArchiveHeader[] = [];
+    for (const name of names) {
+      const m = /^(\d+)\.o2na$/.exec(name);
+      if (!m) continue;
+      const start = Number(m[1]);
+      if (start < fromS || start >= toS) continue;
+      out.push(await readHeader(join(dir, name)));
+    }
+    return out.sort((a, b) => a.startTime - b.startTime);
+  }
+
+  /** Merged SpO2 / PR distribution of a date range, from headers alone. */
+  async sketch(deviceId: string, fromS?: number, toS?: number) {
+    return mergeNightSketches(await this.headers(deviceId, fromS, toS), fromS, toS);
+  }
+
+  private async dir(deviceId: string) {
+    const dir = join(this.root, safeName(deviceId));
+    let made = this.dirs.get(dir);
+    if (!made) {
+      made = mkdir(dir, { recursive: true });
+      this.dirs.set(dir, made);
+    }
+    await made;
+    return dir;
+  }
+}
+
+export type ArchiveStream = {
+  /** Final path; the data sits under a temp name until `close`. */
+  path: string;
+  write(bytes: Uint8Array): void;
+  /** Flush and move into place. */
+  close(): Promise<void>;
+  /** Drop the partial file. */
+  abort(): void;
+};
+
+async function readHeader(path: string) {
+  const file = await open(path, "r");
+  try {
+    const preamble = new Uint8Array(NIGHT_ARCHIVE_PREAMBLE);
+    await file.read(preamble, 0, preamble.length, 0);
+    const bytes = new Uint8Array(nightArchiveHeaderSize(preamble));
+    const { bytesRead } = await file.read(bytes, 0, bytes.length, 0);
+    return readNightArchiveHeader(bytes.subarray(0, bytesRead));
+  } finally {
+    await file.close();
+  }
+}
+
+/** MACs contain ':'; keep ids usable as a single path component everywhere. */
+export function safeName(deviceId: string) {
+  return deviceId.replace(/[^A-Za-z0-9._-]/g, "_");
+}
@@ -0,0 +1,176 @@
+// Dock ingestion: every ring that shows up gets a `DeviceSession`, every
+// file it lists is pulled, decoded to columns, summarised and written to
+// the archive sink, and the ring is released once its queue drains.
+//
+// This is the app's own session/decode core (deep imports, so nothing
+// pulls in expo or the native module); only the transport and the sink
+// differ between the dock, the simulator and replay runs.
+
+import { encodeNightArchive } from "@ios-app/viatom-o2ring/src/NightArchive";
+import { decodeNightFile, summarizeNight } from "@ios-app/viatom-o2ring/src/O2Night";
+import {
+  SessionEvent,
+  SessionManager,
+  SessionOptions,
+  SessionTransport,
+} from "@ios-app/viatom-o2ring/src/Sessions";
+
+export interface ArchiveSink {
+  write(deviceId: string, startTime: number, bytes: Uint8Array): Promise<void>;
+}
+
+export type GatewayOptions = SessionOptions & {
+  /** Disconnect a ring once every file it listed has been handled. */
+  releaseWhenDrained?: boolean;
+  /** UTC offset of the rings' clocks, for VTO2Lib file heads. */
+  utcOffsetMinutes?: number;
+  log?: (line: string) => void;
+};
+
+export type GatewayStats = {
+  sessionsOpened: number;
+  sessionsDone: number;
+  nights: number;
+  /** Files that arrived without bytes (e.g. CSV-only transports). */
+  skipped: number;
+  decodeErrors: number;
+  writeErrors: number;
+  failedFiles: number;
+  fileBytes: number;
+  archiveBytes: number;
+};
+
+export class Gateway {
+  readonly manager: SessionManager;
+  readonly stats: GatewayStats = {
+    sessionsOpened: 0,
+    sessionsDone: 0,
+    nights: 0,
+    skipped: 0,
+    decodeErrors: 0,
+    writeErrors: 0,
+    failedFiles: 0,
+    fileBytes: 0,
+    archiveBytes: 0,
+  };
+
+  private readonly writes = new Set<Promise<void>>();
+  private readonly idleWaiters: (() => void)[] = [];
+  private readonly releaseWhenDrained: boolean;
+  private readonly utcOffsetMinutes?: number;
+  private readonly log: (line: string) => void;
+
+  constructor(
+    transport: SessionTransport,
+    private readonly sink: ArchiveSink,
+    options: GatewayOptions = {}
+  ) {
+    this.releaseWhenDrained = options.releaseWhenDrained ?? true;
+    this.utcOffsetMinutes = options.utcOffsetMinutes;
+    this.log = options.log ?? (() => {});
+    this.manager = new SessionManager(transport, options);
+    this.manager.addListener((e) => this.onEvent(e));
+  }
+
+  /** A ring was docked. */
+  admit(deviceId: string, model = 0) {
+    if (this.manager.get(deviceId)) return;
+    this.stats.sessionsOpened++;
+    this.manager.open(deviceId, model);
+  }
+
+  get activeSessions() {
+    return this.manager.size;
+  }
+
+  /** Resolves once no session is open and every archive write has landed. */
+  async idle() {
+    if (this.manager.size > 0) {
+      await new Promise<void>((resolve) => this.idleWaiters.push(resolve));
+    }
+    while (this.writes.size > 0) await Promise.all([...this.writes]);
+  }
+
+  async shutdown() {
+    await this.manager.closeAll();
+    while (this.writes.size > 0) await Promise.all([...this.writes]);
+    this.manager.dispose();
+  }
+
+  private onEvent(e: SessionEvent) {
+    switch (e.type) {
+      case "file":
+        this.ingest(e.deviceId, e.raw);
+        return;
+      case "fileFailed":
+        this.stats.failedFiles++;
+        this.log(`${e.deviceId}: ${e.name} failed${e.timedOut ? " (timeout)" : ""}`);
+        return;
+      case "drained":
+        if (!this.releaseWhenDrained) return;
+        // close() drops the session first, so no "disconnected" follows
+        this.manager
+          .close(e.deviceId)
+          .catch(() => {})
+          .then(() => this.sessionDone(e.deviceId, "released"));
+        return;
+      case "disconnected":
+        this.sessionDone(e.deviceId, "undocked");
+        return;
+      case "error":
+        this.log(`${e.deviceId}: ${e.code} ${e.message}`);
+        if (e.code === "CONNECT_FAILED") this.sessionDone(e.deviceId, "connect failed");
+        return;
+    }
+  }
+
+  private ingest(deviceId: string, raw?: Uint8Array) {
+    if (!raw) {
+      this.stats.skipped++;
+      return;
+    }
+    let archive: Uint8Array;
+    let startTime: number;
+    try {
+      const night = decodeNightFile(raw, this.utcOffsetMinutes);
+      archive = encodeNightArchive(deviceId, night, summarizeNight(night));
+      startTime = night.startTime;
+    } catch (err) {
+      this.stats.decodeErrors++;
+      this.log(`${deviceId}: ${(err as Error).message}`);
+      return;
+    }
+    this.stats.fileBytes += raw.length;
+    const write = this.sink
+      .write(deviceId, startTime, archive)
+      .then(
+        () => {
+          this.stats.nights++;
+          this.stats.archiveBytes += archive.length;
+        },
+        (err) => {
+          this.stats.writeErrors++;
+          this.log(`${deviceId}: archive write failed: ${err?.message ?? err}`);
+        }
+      )
+      .finally(() => this.writes.delete(write));
+    this.writes.add(write);
+  }
+
+  private sessionDone(deviceId: string, why: string) {
+    this.stats.sessionsDone++;
+    this.log(`${deviceId}: ${why}`);
+    if (this.manager.size > 0) return;
+    this.idleWaiters.splice(0).forEach((resolve) => resolve());
+  }
+}
+
+/** Keeps archives in memory; for load tests that should not measure the disk. */
+export class MemorySink implements ArchiveSink {
+  count = 0;
+  bytes = 0;
+  async write(_deviceId: string, _startTime: number, bytes: Uint8Array) {
+    this.count++;
+    this.bytes += bytes.length;
+  }
+}
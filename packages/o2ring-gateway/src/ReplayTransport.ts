@@ -0,0 +1,111 @@
+// Transport that serves previously pulled files from disk, laid out as
+// `<root>/<deviceId>/<fileName>`: every subdirectory is a ring, every file
+// in it a night as the ring sent it. Files are streamed in chunks with
+// progress events like a live read, optionally throttled to a link rate,
+// so the gateway runs exactly as it would at the dock.
+
+import { readdir, readFile } from "node:fs/promises";
+import { join } from "node:path";
+
+import { SessionTransport, TransportEvent } from "@ios-app/viatom-o2ring/src/Sessions";
+
+export type ReplayTransportOptions = {
+  maxConcurrent?: number;
+  chunkBytes?: number;
+  /** Per-link rate, bytes/s; 0 replays as fast as the disk allows. */
+  linkBytesPerSec?: number;
+};
+
+export class ReplayTransport implements SessionTransport {
+  readonly maxConcurrent: number;
+  private readonly chunkBytes: number;
+  private readonly linkBytesPerSec: number;
+  private readonly listeners = new Set<(e: TransportEvent) => void>();
+  /** Bumped per command so a disconnect stops an in-progress read. */
+  private readonly generation = new Map<string, number>();
+
+  constructor(private readonly root: string, options: ReplayTransportOptions = {}) {
+    this.maxConcurrent = options.maxConcurrent ?? 64;
+    this.chunkBytes = options.chunkBytes ?? 4096;
+    this.linkBytesPerSec = options.linkBytesPerSec ?? 0;
+  }
+
+  /** Ring ids found under `root`. */
+  async devices() {
+    const entries = await readdir(this.root, { withFileTypes: true });
+    return entries.filter((e) => e.isDirectory()).map((e) => e.name).sort();
+  }
+
+  subscribe(listener: (e: TransportEvent) => void) {
+    this.listeners.add(listener);
+    return () => {
+      this.listeners.delete(listener);
+    };
+  }
+
+  async connect(deviceId: string) {
+    this.generation.set(deviceId, 0);
+    setImmediate(() => this.emit({ type: "connected", deviceId }));
+    return true;
+  }
+
+  async disconnect(deviceId: string) {
+    if (!this.generation.delete(deviceId)) return true;
+    this.emit({ type: "disconnected", deviceId, reason: 0 });
+    return true;
+  }
+
+  async getInfo(deviceId: string) {
+    const generation = this.bump(deviceId);
+    const files = (await readdir(join(this.root, deviceId), { withFileTypes: true }))
+      .filter((e) => e.isFile() && !e.name.startsWith("."))
+      .map((e) => e.name)
+      .sort();
+    if (this.generation.get(deviceId) !== generation) return false;
+    this.emit({ type: "info", deviceId, files, battery: null });
+    return true;
+  }
+
+  async readFile(deviceId: string, name: string) {
+    const generation = this.bump(deviceId);
+    const raw = new Uint8Array(await readFile(join(this.root, deviceId, name)));
+    const live = () => this.generation.get(deviceId) === generation;
+    for (let sent = 0; sent < raw.length; ) {
+      sent = Math.min(raw.length, sent + this.chunkBytes);
+      if (this.linkBytesPerSec > 0) {
+        await sleep((this.chunkBytes / this.linkBytesPerSec) * 1000);
+      }
+      if (!live()) return false;
+      this.emit({
+        type: "progress",
+        deviceId,
+        progress: Math.round((sent / raw.length) * 100),
+      });
+    }
+    if (!live()) return false;
+    this.emit({
+      type: "file",
+      deviceId,
+      csv: "",
+      startTime: 0,
+      bytes: raw.length,
+      raw,
+    });
+    return true;
+  }
+
+  private bump(deviceId: string) {
+    const generation = this.generation.get(deviceId);
+    if (generation === undefined) throw new Error(`${deviceId} is not connected`);
+    this.generation.set(deviceId, generation + 1);
+    return generation + 1;
+  }
+
+  private emit(e: TransportEvent) {
+    this.listeners.forEach((l) => l(e));
+  }
+}
+
+function sleep(ms: number) {
+  return new Promise((resolve) => setTimeout(resolve, ms));
+}
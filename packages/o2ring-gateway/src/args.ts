@@ -0,0 +1,12 @@
+/** `--key value` pairs; a bare `--flag` reads as "true". */
+export function parseArgs(argv: string[]) {
+  const out: Record<string, string | undefined> = {};
+  for (let i = 0; i < argv.length; i++) {
+    const a = argv[i];
+    if (!a.startsWith("--")) throw new Error(`Unexpected argument ${a}`);
+    const next = argv[i + 1];
+    if (next === undefined || next.startsWith("--")) out[a.slice(2)] = "true";
+    else out[a.slice(2)] = argv[++i];
+  }
+  return out;
+}
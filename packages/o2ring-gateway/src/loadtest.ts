@@ -0,0 +1,111 @@
+// Sessions-per-core load test.
+//
+// Runs the gateway over `SimulatedTransport` on a virtual clock with one
+// radio slot per docked ring, so transfer time is simulated but every
+// byte is really decoded, analysed and archived (in memory). CPU time is
+// measured with `process.cpuUsage()`, and
+//
+//   sessions/core = sessions * simulated dock time / CPU time
+//
+// is how many rings transferring at `--rate` one core keeps up with. The
+// CPU figure includes the simulator's own bookkeeping, so it is a floor.
+//
+//   tsx src/loadtest.ts [--sessions 50,100,200,400] [--nights 4] [--hours 8]
+//                       [--rate 8000] [--chunk 512]
+
+import { SimulatedTransport, VirtualClock } from "@ios-app/viatom-o2ring/src/SimulatedTransport";
+
+import { syntheticO2File } from "./Fixtures";
+import { Gateway, MemorySink } from "./Gateway";
+import { parseArgs } from "./args";
+
+type LoadResult = {
+  sessions: number;
+  nights: number;
+  mb: number;
+  simulatedS: number;
+  cpuMs: number;
+  wallMs: number;
+  cpuMsPerNight: number;
+  sessionsPerCore: number;
+};
+
+async function runLoad(
+  sessions: number,
+  { nights = 4, hours = 8, rate = 8000, chunk = 512 } = {}
+): Promise<LoadResult> {
+  const clock = new VirtualClock();
+  const transport = new SimulatedTransport({
+    clock,
+    maxConcurrent: sessions,
+    linkBytesPerSec: rate,
+    radioBytesPerSec: rate * sessions,
+    chunkBytes: chunk,
+  });
+  const sink = new MemorySink();
+  const gateway = new Gateway(transport, sink, { clock, utcOffsetMinutes: 0 });
+
+  // nights differ per file index; rings share the buffers, the decode work does not
+  const files = Array.from({ length: nights }, (_, f) => {
+    const data = syntheticO2File(f + 1, hours);
+    return { name: `night-${f}`, bytes: data.length, data };
+  });
+  for (let s = 0; s < sessions; s++) transport.addDevice(`ring-${s}`, files);
+
+  const cpu = process.cpuUsage();
+  const started = performance.now();
+  for (let s = 0; s < sessions; s++) gateway.admit(`ring-${s}`);
+  await clock.run();
+  await gateway.idle();
+  const wallMs = performance.now() - started;
+  const used = process.cpuUsage(cpu);
+  const cpuMs = (used.user + used.system) / 1000;
+  gateway.manager.dispose();
+
+  const { stats } = gateway;
+  if (stats.nights !== sessions * nights) {
+    throw new Error(`expected ${sessions * nights} nights, archived ${stats.nights}`);
+  }
+  return {
+    sessions,
+    nights: stats.nights,
+    mb: stats.fileBytes / 1e6,
+    simulatedS: clock.now() / 1000,
+    cpuMs,
+    wallMs,
+    cpuMsPerNight: cpuMs / stats.nights,
+    sessionsPerCore: (sessions * clock.now()) / cpuMs,
+  };
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const counts = (args.sessions ?? "50,100,200,400").split(",").map(Number);
+  const opts = {
+    nights: Number(args.nights ?? 4),
+    hours: Number(args.hours ?? 8),
+    rate: Number(args.rate ?? 8000),
+    chunk: Number(args.chunk ?? 512),
+  };
+  await runLoad(10, opts); // warm up the JIT
+  console.log("sessions  nights     MB  simulated_s  cpu_ms  cpu_ms/night  sessions/core");
+  for (const n of counts) {
+    const r = await runLoad(n, opts);
+    console.log(
+      [
+        String(r.sessions).padStart(8),
+        String(r.nights).padStart(7),
+        r.mb.toFixed(1).padStart(6),
+        r.simulatedS.toFixed(0).padStart(12),
+        r.cpuMs.toFixed(0).padStart(7),
+        r.cpuMsPerNight.toFixed(2).padStart(13),
+        r.sessionsPerCore.toFixed(0).padStart(14),
+      ].join(" ")
+    );
+  }
+}
+
+main().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,128 @@
+// Gateway daemon entry point.
+//
+//   tsx src/main.ts --replay <dir> --out <dir> [--workers N] [--concurrency N] [--rate B/s]
+//   tsx src/main.ts --simulate <rings> --out <dir> [--nights 4] [--workers N] [--rate B/s]
+//
+// One process per worker (default: one per core). The primary splits the
+// rings across workers by index; each worker runs its own event loop and
+// session manager, so there is no shared state and no lock between them.
+// Workers report their stats to the primary, which prints the total.
+
+import cluster from "node:cluster";
+import { availableParallelism } from "node:os";
+
+import { realClock } from "@ios-app/viatom-o2ring/src/Sessions";
+import { SimulatedTransport } from "@ios-app/viatom-o2ring/src/SimulatedTransport";
+
+import { parseArgs } from "./args";
+import { syntheticO2File } from "./Fixtures";
+import { FsArchive } from "./FsArchive";
+import { Gateway, GatewayStats } from "./Gateway";
+import { ReplayTransport } from "./ReplayTransport";
+
+const args = parseArgs(process.argv.slice(2));
+
+function usage(): never {
+  console.error(
+    "usage: main.ts (--replay <dir> | --simulate <rings>) --out <dir> " +
+      "[--workers N] [--concurrency N] [--rate B/s] [--nights N] [--verbose]"
+  );
+  process.exit(2);
+}
+
+async function ringIds(): Promise<string[]> {
+  if (args.replay) return new ReplayTransport(args.replay).devices();
+  if (args.simulate) {
+    return Array.from({ length: Number(args.simulate) }, (_, i) => `ring-${i}`);
+  }
+  usage();
+}
+
+async function runWorker(ids: string[]): Promise<GatewayStats> {
+  const rate = Number(args.rate ?? 0);
+  const concurrency = Number(args.concurrency ?? 64);
+  const transport = args.replay
+    ? new ReplayTransport(args.replay, { maxConcurrent: concurrency, linkBytesPerSec: rate })
+    : new SimulatedTransport({
+        clock: realClock,
+        maxConcurrent: concurrency,
+        linkBytesPerSec: rate || 1e9,
+        radioBytesPerSec: (rate || 1e9) * concurrency,
+        chunkBytes: 4096,
+        connectMs: 0,
+        commandMs: 0,
+      });
+  if (transport instanceof SimulatedTransport) {
+    const files = Array.from({ length: Number(args.nights ?? 4) }, (_, f) => {
+      const data = syntheticO2File(f + 1);
+      return { name: `night-${f}`, bytes: data.length, data };
+    });
+    ids.forEach((id) => transport.addDevice(id, files));
+  }
+
+  const gateway = new Gateway(transport, new FsArchive(args.out!), {
+    log: args.verbose ? (line) => console.log(`[${process.pid}] ${line}`) : undefined,
+  });
+  ids.forEach((id) => gateway.admit(id));
+  await gateway.idle();
+  gateway.manager.dispose();
+  return gateway.stats;
+}
+
+async function main() {
+  if (!args.out) usage();
+  const ids = await ringIds();
+  const workers = Math.max(
+    1,
+    Math.min(ids.length, Number(args.workers ?? availableParallelism()))
+  );
+  const started = Date.now();
+
+  if (workers === 1) {
+    report(await runWorker(ids), Date.now() - started);
+    return;
+  }
+
+  const total: Partial<GatewayStats> = {};
+  let running = workers;
+  for (let w = 0; w < workers; w++) {
+    const worker = cluster.fork({ GATEWAY_SHARD: String(w), GATEWAY_SHARDS: String(workers) });
+    worker.on("message", (stats: GatewayStats) => {
+      for (const [k, v] of Object.entries(stats) as [keyof GatewayStats, number][]) {
+        total[k] = (total[k] ?? 0) + v;
+      }
+    });
+    worker.on("exit", (code) => {
+      if (code !== 0) process.exitCode = 1;
+      if (--running === 0) report(total as GatewayStats, Date.now() - started);
+    });
+  }
+}
+
+function report(stats: GatewayStats, wallMs: number) {
+  console.log(
+    `${stats.sessionsDone}/${stats.sessionsOpened} rings, ${stats.nights} nights, ` +
+      `${(stats.fileBytes / 1e6).toFixed(1)} MB in ${(wallMs / 1000).toFixed(1)} s ` +
+      `(${((stats.nights * 1000) / Math.max(1, wallMs)).toFixed(1)} nights/s); ` +
+      `failed ${stats.failedFiles}, decode errors ${stats.decodeErrors}, ` +
+      `write errors ${stats.writeErrors}, skipped ${stats.skipped}`
+  );
+  if (stats.failedFiles || stats.decodeErrors || stats.writeErrors) process.exitCode = 1;
+}
+
+if (cluster.isPrimary) {
+  main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+  });
+} else {
+  const shard = Number(process.env.GATEWAY_SHARD);
+  const shards = Number(process.env.GATEWAY_SHARDS);
+  ringIds()
+    .then((ids) => runWorker(ids.filter((_, i) => i % shards === shard)))
+    .then((stats) => process.send!(stats, () => process.exit(0)))
+    .catch((err) => {
+      console.error(err);
+      process.exit(1);
+    });
+}
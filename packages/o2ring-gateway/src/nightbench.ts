@@ -0,0 +1,188 @@
+// End-to-end scaling benchmark over synthetic nights.
+//
+// For each count, that many nights are generated (`syntheticNightFile`:
+// genuine VTO2Lib files at 4 s, VTMProductLib oximeter files at 1 s / 2 s)
+// and pushed one at a time through every stage the gateway and the app run:
+//
+//   decode   decodeNightFile
+//   analyse  summarizeNight (validity mask, ODI, sketches)
+//   store    encodeNightArchive + FsArchive.write (real files under --out)
+//   csv      encodeNightCsv
+//   index    per-ring header list + merged SpO2 / PR sketches
+//
+// Nights are streamed, so memory should stay flat as the count grows;
+// only the index is kept. Per stage it reports ms per night, allocation
+// (growth of JS heap + ArrayBuffers across each call, summed: a GC inside
+// a call hides some, so it is a floor) and the peak RSS seen right after
+// the stage ran. Generation is reported too but is not part of the
+// pipeline.
+//
+//   tsx src/nightbench.ts [--nights 1,10,100,1000,5000] [--intervals 1,2,4]
+//                         [--hours 8,24,72] [--devices 16] [--out <dir>]
+//                         [--keep] [--json]
+
+import { mkdtemp, rm } from "node:fs/promises";
+import { tmpdir } from "node:os";
+import { join } from "node:path";
+
+import { encodeNightArchive, NightArchiveHeader } from "@ios-app/viatom-o2ring/src/NightArchive";
+import { encodeNightCsv } from "@ios-app/viatom-o2ring/src/NightCsv";
+import { NightSketchSet } from "@ios-app/viatom-o2ring/src/NightSketch";
+import { decodeNightFile, nightLength, summarizeNight } from "@ios-app/viatom-o2ring/src/O2Night";
+
+import { parseArgs } from "./args";
+import { syntheticNightFile } from "./Fixtures";
+import { FsArchive } from "./FsArchive";
+
+const STAGES = ["generate", "decode", "analyse", "store", "csv", "index"] as const;
+type StageName = (typeof STAGES)[number];
+
+type StageStats = { ms: number; allocBytes: number; peakRss: number };
+
+type BenchResult = {
+  nights: number;
+  points: number;
+  fileBytes: number;
+  csvBytes: number;
+  wallMs: number;
+  stages: Record<StageName, StageStats>;
+};
+
+const heapNow = () => {
+  const m = process.memoryUsage();
+  return m.heapUsed + m.arrayBuffers;
+};
+
+async function measure<T>(stats: StageStats, fn: () => T | Promise<T>): Promise<T> {
+  const heap = heapNow();
+  const t = performance.now();
+  const out = await fn();
+  stats.ms += performance.now() - t;
+  stats.allocBytes += Math.max(0, heapNow() - heap);
+  stats.peakRss = Math.max(stats.peakRss, process.memoryUsage.rss());
+  return out;
+}
+
+type RingIndex = { headers: NightArchiveHeader[]; sketches: NightSketchSet };
+
+/** Keep `headers` sorted by start time; nights mostly arrive in order. */
+function insertHeader(headers: NightArchiveHeader[], h: NightArchiveHeader) {
+  let lo = headers.length;
+  while (lo > 0 && headers[lo - 1].startTime > h.startTime) lo--;
+  headers.splice(lo, 0, h);
+}
+
+async function runBench(
+  count: number,
+  opts: { intervals: number[]; hours: number[]; devices: number; out: string }
+): Promise<BenchResult> {
+  const stages = Object.fromEntries(
+    STAGES.map((s) => [s, { ms: 0, allocBytes: 0, peakRss: 0 }])
+  ) as Record<StageName, StageStats>;
+  const archive = new FsArchive(join(opts.out, String(count)));
+  const index = new Map<string, RingIndex>();
+  let points = 0;
+  let fileBytes = 0;
+  let csvBytes = 0;
+
+  const started = performance.now();
+  for (let i = 0; i < count; i++) {
+    const deviceId = `ring-${i % opts.devices}`;
+    const intervalS = opts.intervals[i % opts.intervals.length];
+    const hours = opts.hours[Math.floor(i / opts.intervals.length) % opts.hours.length];
+    const startTime = 1767304800 + Math.floor(i / opts.devices) * 86400;
+
+    const bytes = await measure(stages.generate, () =>
+      syntheticNightFile({ seed: i + 1, hours, intervalS, startTime })
+    );
+    fileBytes += bytes.length;
+    const night = await measure(stages.decode, () => decodeNightFile(bytes, 0));
+    points += nightLength(night);
+    const summary = await measure(stages.analyse, () => summarizeNight(night));
+    await measure(stages.store, () =>
+      archive.write(deviceId, night.startTime, encodeNightArchive(deviceId, night, summary))
+    );
+    const csv = await measure(stages.csv, () => encodeNightCsv(night));
+    csvBytes += csv.length;
+    await measure(stages.index, () => {
+      let ring = index.get(deviceId);
+      if (!ring) {
+        ring = { headers: [], sketches: new NightSketchSet() };
+        index.set(deviceId, ring);
+      }
+      insertHeader(ring.headers, {
+        deviceId,
+        startTime: night.startTime,
+        intervalS: night.intervalS,
+        count: nightLength(night),
+        summary,
+        columns: [],
+      });
+      ring.sketches.merge(summary.sketch);
+    });
+  }
+  return {
+    nights: count,
+    points,
+    fileBytes,
+    csvBytes,
+    wallMs: performance.now() - started,
+    stages,
+  };
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const list = (v: string | undefined, d: string) => (v ?? d).split(",").map(Number);
+  const counts = list(args.nights, "1,10,100,1000,5000");
+  const opts = {
+    intervals: list(args.intervals, "1,2,4"),
+    hours: list(args.hours, "8,24,72"),
+    devices: Number(args.devices ?? 16),
+    out: args.out ?? (await mkdtemp(join(tmpdir(), "o2ring-nightbench-"))),
+  };
+
+  try {
+    await runBench(3, opts); // warm up the JIT
+    await rm(join(opts.out, "3"), { recursive: true, force: true });
+    if (!args.json) {
+      console.log(
+        "  nights  Mpoints     MB   wall_s" +
+          STAGES.map((s) => `  ${s.padStart(8)} ms/n  MB/n`).join("") +
+          "  peak_rss_MB"
+      );
+    }
+    for (const n of counts) {
+      const r = await runBench(n, opts);
+      // 5000 nights of the default mix is a couple of GB of archives
+      if (!args.keep) await rm(join(opts.out, String(n)), { recursive: true, force: true });
+      const peak = Math.max(...STAGES.map((s) => r.stages[s].peakRss));
+      if (args.json) {
+        console.log(JSON.stringify({ ...r, peakRss: peak }));
+        continue;
+      }
+      console.log(
+        [
+          String(r.nights).padStart(8),
+          (r.points / 1e6).toFixed(2).padStart(8),
+          (r.fileBytes / 1e6).toFixed(1).padStart(6),
+          (r.wallMs / 1000).toFixed(1).padStart(8),
+          ...STAGES.map((s) =>
+            [
+              (r.stages[s].ms / r.nights).toFixed(2).padStart(13),
+              (r.stages[s].allocBytes / r.nights / 1e6).toFixed(2).padStart(5),
+            ].join(" ")
+          ),
+          (peak / 1e6).toFixed(0).padStart(12),
+        ].join(" ")
+      );
+    }
+  } finally {
+    if (!args.keep && !args.out) await rm(opts.out, { recursive: true, force: true });
+  }
+}
+
+main().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
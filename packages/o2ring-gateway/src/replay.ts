@@ -0,0 +1,97 @@
+// Replay packet captures from the app (`.o2rc`, see
+// viatom-o2ring/src/Capture.ts) through the same decoders and analysis the
+// app runs, on any Node host.
+//
+//   tsx src/replay.ts --capture <file|dir>[,<file|dir>...] [--speed 1|max]
+//                     [--rounds N] [--json]
+//
+// `--speed 1` replays at the recorded pace to reproduce a field session;
+// the default `max` replays as fast as possible and reports the best of
+// `--rounds` runs, which is what a CI regression check compares. Exits
+// non-zero if any captured file fails to decode.
+
+import { readdir, readFile, stat } from "node:fs/promises";
+import { join } from "node:path";
+
+import { decodeCapture, ReplayResult, replayThroughPipeline } from "@ios-app/viatom-o2ring/src/Capture";
+
+import { parseArgs } from "./args";
+
+const args = parseArgs(process.argv.slice(2));
+
+async function capturePaths(spec: string) {
+  const out: string[] = [];
+  for (const p of spec.split(",")) {
+    if ((await stat(p)).isDirectory()) {
+      const names = await readdir(p, { recursive: true });
+      out.push(...names.filter((n) => n.endsWith(".o2rc")).map((n) => join(p, n)).sort());
+    } else {
+      out.push(p);
+    }
+  }
+  return out;
+}
+
+async function main() {
+  if (!args.capture) {
+    console.error("usage: replay.ts --capture <file|dir>[,...] [--speed 1|max] [--rounds N] [--json]");
+    process.exit(2);
+  }
+  const speed = !args.speed || args.speed === "max" ? Infinity : Number(args.speed);
+  // at full speed the first run only warms up the JIT
+  const runs = Number.isFinite(speed) ? 1 : Math.max(1, Number(args.rounds ?? 5)) + 1;
+  let failed = 0;
+
+  for (const path of await capturePaths(args.capture)) {
+    const capture = decodeCapture(new Uint8Array(await readFile(path)));
+    let best = Infinity;
+    let result!: ReplayResult;
+    for (let r = 0; r < runs; r++) {
+      const t = performance.now();
+      result = await replayThroughPipeline(capture, { speed });
+      if (runs === 1 || r > 0) best = Math.min(best, performance.now() - t);
+    }
+    failed += result.failedFiles.length;
+
+    const report = {
+      path,
+      platform: capture.platform,
+      records: result.records,
+      trailingBytes: capture.trailingBytes,
+      realtimeSamples: result.realtimeSamples,
+      realtimeValid: result.realtimeValid,
+      files: result.files,
+      fileBytes: result.fileBytes,
+      failedFiles: result.failedFiles,
+      nights: result.summaries.map(({ name, summary }) => ({
+        name,
+        points: summary.points,
+        avgSpo2: Number(summary.avgSpo2.toFixed(2)),
+        t90S: summary.t90S,
+        odi4: Number(summary.odi4.toFixed(2)),
+      })),
+      bestMs: Number(best.toFixed(3)),
+      recordsPerSec: Math.round((result.records * 1000) / Math.max(best, 1e-3)),
+    };
+    if (args.json) {
+      console.log(JSON.stringify(report));
+    } else {
+      console.log(
+        `${path}: ${report.records} records (${report.realtimeSamples} realtime, ` +
+          `${report.realtimeValid} valid; ${report.files} files, ${report.fileBytes} B) ` +
+          `in ${report.bestMs} ms, ${report.recordsPerSec} records/s`
+      );
+      for (const n of report.nights) {
+        console.log(`  ${n.name}: ${n.points} points, SpO2 ${n.avgSpo2}, T90 ${n.t90S} s, ODI4 ${n.odi4}`);
+      }
+      for (const f of report.failedFiles) console.log(`  FAILED ${f.name}: ${f.error}`);
+      if (report.trailingBytes) console.log(`  ${report.trailingBytes} B torn tail ignored`);
+    }
+  }
+  process.exit(failed ? 1 : 0);
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
@@ -0,0 +1,179 @@
+// Memory check for the streaming raw-file decoders (viatom-o2ring
+// src/RawFiles.ts).
+//
+// Streams synthetic raw PPG and BabyO2 recordings of growing length, a
+// chunk at a time, through `PpgFileDecoder` / `BabyRecordDecoder` into a
+// `ColumnStreamWriter` appending to a real file, sampling RSS after every
+// chunk. The working set is one block, so peak RSS should not depend on
+// the recording length: the check fails (exit 1) if the longest run peaks
+// more than `--slack` MB above the shortest. It also decodes the shortest
+// PPG file in one piece and compares the output byte for byte with the
+// streamed one, so chunk boundaries can't change what is stored.
+//
+//   tsx src/rsscheck.ts [--hours 1,4,16] [--rate 200] [--chunk 4096]
+//                       [--slack 16] [--out <dir>] [--json]
+
+import { mkdtemp, readFile, rm } from "node:fs/promises";
+import { tmpdir } from "node:os";
+import { join } from "node:path";
+
+import { ColumnSink, ColumnSpec, ColumnStreamWriter } from "@ios-app/viatom-o2ring/src/ColumnStream";
+import { BabyRecordDecoder, PpgFileDecoder } from "@ios-app/viatom-o2ring/src/RawFiles";
+
+import { parseArgs } from "./args";
+import { syntheticBabyFile, syntheticPpgFile } from "./Fixtures";
+import { ArchiveStream, FsArchive } from "./FsArchive";
+
+type Kind = "ppg" | "baby";
+
+type RunResult = {
+  kind: Kind;
+  hours: number;
+  inputBytes: number;
+  outputBytes: number;
+  samples: number;
+  ms: number;
+  peakRss: number;
+};
+
+type Decoder = { push(chunk: Uint8Array): void; finish(): { count: number; trailingBytes: number } };
+
+/** A decoder whose blocks go through a `ColumnStreamWriter` to `out`. */
+function decoderFor(
+  kind: Kind,
+  deviceId: string,
+  out: (bytes: Uint8Array) => void,
+  opened: (writer: ColumnStreamWriter) => void
+): Decoder {
+  const open = (
+    head: { startTime?: number; sampleRateHz?: number; intervalS?: number },
+    columns: ColumnSpec[]
+  ): ColumnSink => {
+    const writer = new ColumnStreamWriter(
+      {
+        deviceId,
+        kind,
+        startTime: head.startTime ?? 0,
+        intervalS: head.intervalS ?? 1 / head.sampleRateHz!,
+        columns,
+      },
+      out
+    );
+    opened(writer);
+    return writer.sink;
+  };
+  return kind === "ppg" ? new PpgFileDecoder(open) : new BabyRecordDecoder(open);
+}
+
+async function run(
+  kind: Kind,
+  hours: number,
+  opts: { rate: number; chunk: number; archive: FsArchive }
+): Promise<RunResult> {
+  const deviceId = `rss-${kind}`;
+  const chunks =
+    kind === "ppg"
+      ? syntheticPpgFile({ hours, sampleRateHz: opts.rate, chunkBytes: opts.chunk })
+      : syntheticBabyFile({ hours, chunkBytes: opts.chunk });
+  const stream: ArchiveStream = await opts.archive.openStream(deviceId, hours * 3600);
+  let writer: ColumnStreamWriter | undefined;
+  const decoder = decoderFor(kind, deviceId, stream.write, (w) => (writer = w));
+
+  let inputBytes = 0;
+  let peakRss = process.memoryUsage.rss();
+  const t = performance.now();
+  try {
+    for (const chunk of chunks) {
+      decoder.push(chunk);
+      inputBytes += chunk.length;
+      peakRss = Math.max(peakRss, process.memoryUsage.rss());
+    }
+    const { count, trailingBytes } = decoder.finish();
+    if (trailingBytes) throw new Error(`${kind} ${hours} h: ${trailingBytes} B left over`);
+    await stream.close();
+    return {
+      kind,
+      hours,
+      inputBytes,
+      outputBytes: writer!.bytes,
+      samples: count,
+      ms: performance.now() - t,
+      peakRss: Math.max(peakRss, process.memoryUsage.rss()),
+    };
+  } catch (e) {
+    stream.abort();
+    throw e;
+  }
+}
+
+/** Decode the whole file in one push, keeping the output in memory. */
+function decodeWhole(kind: Kind, file: Uint8Array) {
+  const parts: Uint8Array[] = [];
+  const decoder = decoderFor(kind, `rss-${kind}`, (b) => parts.push(b.slice()), () => {});
+  decoder.push(file);
+  decoder.finish();
+  return Buffer.concat(parts);
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const hours = (args.hours ?? "1,4,16").split(",").map(Number).sort((a, b) => a - b);
+  const rate = Number(args.rate ?? 200);
+  const chunk = Number(args.chunk ?? 4096);
+  const slackMb = Number(args.slack ?? 16);
+  const out = args.out ?? (await mkdtemp(join(tmpdir(), "o2ring-rsscheck-")));
+  const archive = new FsArchive(out);
+
+  let ok = true;
+  try {
+    // warm up the JIT and the allocator before taking the baseline
+    await run("ppg", 0.1, { rate, chunk, archive });
+    await run("baby", 1, { rate, chunk, archive });
+    const baseline = process.memoryUsage.rss();
+
+    for (const kind of ["ppg", "baby"] as const) {
+      const results: RunResult[] = [];
+      for (const h of hours) {
+        const r = await run(kind, h, { rate, chunk, archive });
+        results.push(r);
+        if (args.json) {
+          console.log(JSON.stringify({ ...r, baselineRss: baseline }));
+        } else {
+          console.log(
+            `${kind.padEnd(4)} ${String(h).padStart(4)} h  ` +
+              `${(r.inputBytes / 1e6).toFixed(1).padStart(7)} MB in  ` +
+              `${(r.samples / 1e6).toFixed(2).padStart(7)} M samples  ` +
+              `${((r.inputBytes / 1e6) / (r.ms / 1000)).toFixed(0).padStart(5)} MB/s  ` +
+              `peak RSS ${(r.peakRss / 1e6).toFixed(1)} MB (+${((r.peakRss - baseline) / 1e6).toFixed(1)})`
+          );
+        }
+      }
+      const growth = (results[results.length - 1].peakRss - results[0].peakRss) / 1e6;
+      if (growth > slackMb) {
+        ok = false;
+        console.error(
+          `${kind}: peak RSS grew ${growth.toFixed(1)} MB from ${hours[0]} h to ${hours[hours.length - 1]} h (slack ${slackMb} MB)`
+        );
+      }
+    }
+
+    // chunking must not change the stored bytes
+    const parts: Uint8Array[] = [];
+    for (const c of syntheticPpgFile({ hours: hours[0], sampleRateHz: rate, chunkBytes: chunk })) parts.push(c.slice());
+    const whole = decodeWhole("ppg", Buffer.concat(parts));
+    const streamed = await readFile(join(out, "rss-ppg", `${hours[0] * 3600}.o2cs`));
+    if (!whole.equals(streamed)) {
+      ok = false;
+      console.error(`ppg ${hours[0]} h: streamed output differs from a whole-file decode`);
+    }
+  } finally {
+    if (!args.out) await rm(out, { recursive: true, force: true });
+  }
+  if (!args.json) console.log(ok ? "ok: peak RSS flat across lengths" : "FAILED");
+  process.exit(ok ? 0 : 1);
+}
+
+main().catch((err) => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,388 @@
+// Fuzz and throughput check for every wire-format decoder.
+//
+// Fuzz: each file of the committed corpus (test/fixtures/wire/<target>-*.bin,
+// written by --write-corpus from the generators in src/Fixtures.ts; real
+// files can be dropped in next to them) is mutated --fuzz times with a
+// seeded generator (bit flips, boundary bytes, truncation, splices, forged
+// length fields) and fed to its decoder, in random chunk sizes for the
+// streaming ones. A decoder may succeed or throw WireFormatError; anything
+// else is a failure and the input is saved under --crashes.
+//
+// Bench: each decoder runs over a larger synthetic input for --rounds
+// rounds of --ms, in a process of its own; the fastest call gives ns per
+// sample and MB/s, plus the mean heap growth per call (a floor, like
+// nightbench). Results are compared with --baseline; a target more than
+// --tolerance (default 10 %) slower is measured up to twice more and, if
+// still slower, fails the run.
+// --update-baseline rewrites the baseline instead, from the median of
+// three measurements. Timings only compare
+// on the machine the baseline was taken on.
+//
+//   tsx src/wirebench.ts [--only o2,er3] [--fuzz 500] [--seed 1] [--ms 300]
+//                        [--rounds 5] [--tolerance 0.1] [--baseline <file>]
+//                        [--update-baseline] [--crashes <dir>] [--json]
+//   tsx src/wirebench.ts --write-corpus
+
+import { spawnSync } from "node:child_process";
+import { mkdirSync, readdirSync, readFileSync, writeFileSync } from "node:fs";
+import { join } from "node:path";
+import { fileURLToPath } from "node:url";
+
+import { decodeCapture } from "@ios-app/viatom-o2ring/src/Capture";
+import { decodeEr3OriginFile, Er3Cable } from "@ios-app/viatom-o2ring/src/Er3Wave";
+import { decodeNightArchive, encodeNightArchive } from "@ios-app/viatom-o2ring/src/NightArchive";
+import { decodeO2File, decodeOxiFile, nightLength, summarizeNight } from "@ios-app/viatom-o2ring/src/O2Night";
+import { BabyRecordDecoder, PpgFileDecoder } from "@ios-app/viatom-o2ring/src/RawFiles";
+import { decodeVentMonitorFile, parseVentStatistics, VENT_STATISTICS_SIZE } from "@ios-app/viatom-o2ring/src/Ventilator";
+import { WireFormatError } from "@ios-app/viatom-o2ring/src/WireStruct";
+
+import { parseArgs } from "./args";
+import {
+  syntheticBabyFile,
+  syntheticEr3File,
+  syntheticNight,
+  syntheticNightFile,
+  syntheticPpgFile,
+  syntheticVentFile,
+} from "./Fixtures";
+
+const FIXTURES = fileURLToPath(new URL("../test/fixtures/", import.meta.url));
+const CORPUS_DIR = join(FIXTURES, "wire");
+const BASELINE = join(FIXTURES, "wirebench.baseline.json");
+
+type Target = {
+  name: string;
+  /** Small files for the committed corpus. */
+  corpus: () => Uint8Array[];
+  /** Input for the timing runs. */
+  bench: () => Uint8Array;
+  /** Decode `bytes` in `chunk`-byte pieces where the decoder streams; returns samples decoded. */
+  decode: (bytes: Uint8Array, chunk: number) => number;
+};
+
+function xorshift(seed: number) {
+  let x = seed >>> 0 || 1;
+  return () => {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    return (x >>> 0) / 0x100000000;
+  };
+}
+
+/** Whole file out of a chunk generator whose chunks are reused. */
+function collect(chunks: Iterable<Uint8Array>) {
+  return Buffer.concat(Array.from(chunks, (c) => Buffer.from(c)));
+}
+
+function pushChunks(push: (b: Uint8Array) => void, bytes: Uint8Array, chunk: number) {
+  for (let i = 0; i < bytes.length; i += chunk) push(bytes.subarray(i, i + chunk));
+}
+
+const TARGETS: Target[] = [
+  {
+    name: "o2",
+    corpus: () => [1, 2].map((seed) => syntheticNightFile({ seed, hours: 0.25, intervalS: 4 })),
+    bench: () => syntheticNightFile({ seed: 1, hours: 8, intervalS: 4 }),
+    decode: (bytes) => nightLength(decodeO2File(bytes, 0)),
+  },
+  {
+    name: "oxi",
+    corpus: () => [1, 2].map((seed) => syntheticNightFile({ seed, hours: 0.1, intervalS: seed })),
+    bench: () => syntheticNightFile({ seed: 1, hours: 8, intervalS: 1 }),
+    decode: (bytes) => nightLength(decodeOxiFile(bytes)),
+  },
+  {
+    name: "er3",
+    corpus: () => [
+      syntheticEr3File({ seed: 1, minutes: 0.05, cable: Er3Cable.Lead10 }),
+      syntheticEr3File({ seed: 2, minutes: 0.05, cable: Er3Cable.Lead6 }),
+    ],
+    bench: () => syntheticEr3File({ seed: 1, minutes: 10 }),
+    decode: (bytes) => decodeEr3OriginFile(bytes).samples.length,
+  },
+  {
+    name: "ppg",
+    corpus: () => [150, 200].map((sampleRateHz, i) =>
+      collect(syntheticPpgFile({ seed: i + 1, hours: 1 / 3600, sampleRateHz, marker: 7 - i * 4 }))
+    ),
+    bench: () => collect(syntheticPpgFile({ seed: 1, hours: 0.25 })),
+    decode: (bytes, chunk) => {
+      const decoder = new PpgFileDecoder(() => () => {});
+      pushChunks((b) => decoder.push(b), bytes, chunk);
+      return decoder.finish().count;
+    },
+  },
+  {
+    name: "baby",
+    corpus: () => [collect(syntheticBabyFile({ seed: 1, hours: 0.1 }))],
+    bench: () => collect(syntheticBabyFile({ seed: 1, hours: 24 })),
+    decode: (bytes, chunk) => {
+      const decoder = new BabyRecordDecoder(() => () => {}, 4096, 0);
+      pushChunks((b) => decoder.push(b), bytes, chunk);
+      return decoder.finish().count;
+    },
+  },
+  {
+    name: "vent",
+    corpus: () => [syntheticVentFile({ seed: 1, hours: 0.05 })],
+    bench: () => syntheticVentFile({ seed: 1, hours: 8 }),
+    decode: (bytes) => decodeVentMonitorFile(bytes).count,
+  },
+  {
+    name: "ventstats",
+    corpus: () => {
+      const rand = xorshift(7);
+      return [Uint8Array.from({ length: VENT_STATISTICS_SIZE }, () => Math.floor(rand() * 64))];
+    },
+    bench: () => new Uint8Array(VENT_STATISTICS_SIZE * 256).fill(3),
+    decode: (bytes) => {
+      // back-to-back records, as a statistics download for several days
+      const n = Math.max(1, Math.floor(bytes.length / VENT_STATISTICS_SIZE));
+      for (let i = 0; i < n; i++) parseVentStatistics(bytes.subarray(i * VENT_STATISTICS_SIZE));
+      return n;
+    },
+  },
+  {
+    name: "archive",
+    corpus: () => {
+      const night = syntheticNight({ seed: 1, hours: 0.25 });
+      return [encodeNightArchive("ring-1", night, summarizeNight(night))];
+    },
+    bench: () => {
+      const night = syntheticNight({ seed: 1, hours: 8 });
+      return encodeNightArchive("ring-1", night, summarizeNight(night));
+    },
+    decode: (bytes) => nightLength(decodeNightArchive(bytes).night),
+  },
+  {
+    name: "capture",
+    corpus: () => [readFileSync(join(FIXTURES, "session.o2rc"))],
+    bench: () => readFileSync(join(FIXTURES, "session.o2rc")),
+    decode: (bytes) => decodeCapture(bytes).records.length,
+  },
+];
+
+// ----- fuzz -----
+
+function mutate(input: Uint8Array, rand: () => number): Uint8Array {
+  const pick = (n: number) => Math.floor(rand() * n);
+  let bytes = Uint8Array.from(input);
+  for (let round = 1 + pick(3); round > 0 && bytes.length > 0; round--) {
+    switch (pick(6)) {
+      case 0: // bit flips
+        for (let k = 1 + pick(8); k > 0; k--) bytes[pick(bytes.length)] ^= 1 << pick(8);
+        break;
+      case 1: // boundary bytes
+        bytes[pick(bytes.length)] = [0x00, 0x01, 0x7f, 0x80, 0x81, 0xff][pick(6)];
+        break;
+      case 2: // truncate
+        bytes = bytes.subarray(0, pick(bytes.length));
+        break;
+      case 3: {
+        // drop a range
+        const at = pick(bytes.length);
+        const n = pick(Math.min(64, bytes.length - at) + 1);
+        bytes = Uint8Array.from([...bytes.subarray(0, at), ...bytes.subarray(at + n)]);
+        break;
+      }
+      case 4: {
+        // duplicate a range
+        const at = pick(bytes.length);
+        const piece = bytes.subarray(at, at + 1 + pick(64));
+        bytes = Uint8Array.from([...bytes.subarray(0, at), ...piece, ...bytes.subarray(at)]);
+        break;
+      }
+      default: {
+        // forged u16 / u32 length or count
+        const at = pick(Math.max(1, bytes.length - 3));
+        const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.length);
+        const v = [0, 0xffff, 0x7fffffff, 0xffffffff, pick(1 << 20)][pick(5)];
+        if (at + 4 <= bytes.length) view.setUint32(at, v >>> 0, true);
+        else if (at + 2 <= bytes.length) view.setUint16(at, v & 0xffff, true);
+        break;
+      }
+    }
+  }
+  return bytes;
+}
+
+function readCorpus(name: string) {
+  return readdirSync(CORPUS_DIR)
+    .filter((f) => f.startsWith(`${name}-`) && f.endsWith(".bin"))
+    .sort()
+    .map((f) => ({ file: f, bytes: new Uint8Array(readFileSync(join(CORPUS_DIR, f))) }));
+}
+
+function fuzz(target: Target, iterations: number, seed: number, crashes: string) {
+  const rand = xorshift(seed * 2654435761);
+  const corpus = readCorpus(target.name);
+  if (corpus.length === 0) throw new Error(`no corpus for ${target.name}; run --write-corpus`);
+  let failures = 0;
+  let rejected = 0;
+  for (const { file, bytes } of corpus) {
+    // the unmutated file has to decode
+    target.decode(bytes, bytes.length);
+    for (let i = 0; i < iterations; i++) {
+      const input = mutate(bytes, rand);
+      const chunk = 1 + Math.floor(rand() * 600);
+      try {
+        target.decode(input, chunk);
+      } catch (err) {
+        if (err instanceof WireFormatError) {
+          rejected++;
+          continue;
+        }
+        failures++;
+        mkdirSync(crashes, { recursive: true });
+        const out = join(crashes, `${target.name}-${seed}-${i}-${file}`);
+        writeFileSync(out, input);
+        console.error(`${target.name}: ${(err as Error)?.stack ?? err}\n  input saved to ${out} (chunk ${chunk})`);
+      }
+    }
+  }
+  return { runs: corpus.length * iterations, rejected, failures };
+}
+
+// ----- bench -----
+
+type BenchResult = { nsPerSample: number; mbPerS: number; allocPerCall: number; samples: number };
+
+const heapNow = () => {
+  const m = process.memoryUsage();
+  return m.heapUsed + m.arrayBuffers;
+};
+
+/**
+ * Fastest single call over `rounds` rounds of at least `ms` each: the
+ * minimum is what survives scheduler and GC noise on a shared box.
+ */
+function bench(target: Target, ms: number, rounds: number): BenchResult {
+  const bytes = target.bench();
+  const samples = target.decode(bytes, 4096); // warm up
+  let best = Infinity;
+  let alloc = 0;
+  let calls = 0;
+  for (let r = 0; r < rounds; r++) {
+    const until = performance.now() + ms;
+    while (performance.now() < until) {
+      const heap = heapNow();
+      const t = performance.now();
+      target.decode(bytes, 4096);
+      best = Math.min(best, performance.now() - t);
+      alloc += Math.max(0, heapNow() - heap);
+      calls++;
+    }
+  }
+  return {
+    nsPerSample: (best * 1e6) / samples,
+    mbPerS: bytes.length / 1e3 / best,
+    allocPerCall: alloc / calls,
+    samples,
+  };
+}
+
+/**
+ * `bench` in a fresh process: one run's JIT tier-up luck, or state left by
+ * the targets before it, must not carry over into the next measurement.
+ */
+function benchIsolated(target: Target, ms: number, rounds: number): BenchResult {
+  const child = spawnSync(
+    process.execPath,
+    [...process.execArgv, process.argv[1], "--bench-one", target.name, "--ms", String(ms), "--rounds", String(rounds)],
+    { encoding: "utf8" }
+  );
+  if (child.status !== 0) throw new Error(`bench ${target.name} failed:\n${child.stderr}`);
+  return JSON.parse(child.stdout);
+}
+
+function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const only = args.only?.split(",");
+  const targets = TARGETS.filter((t) => !only || only.includes(t.name));
+
+  if (args["bench-one"]) {
+    const t = TARGETS.find((t) => t.name === args["bench-one"])!;
+    console.log(JSON.stringify(bench(t, Number(args.ms), Number(args.rounds))));
+    return 0;
+  }
+
+  if (args["write-corpus"]) {
+    mkdirSync(CORPUS_DIR, { recursive: true });
+    for (const t of targets) {
+      t.corpus().forEach((bytes, i) => writeFileSync(join(CORPUS_DIR, `${t.name}-${i + 1}.bin`), bytes));
+    }
+    console.log(`corpus written to ${CORPUS_DIR}`);
+    return 0;
+  }
+
+  const iterations = Number(args.fuzz ?? 500);
+  const seed = Number(args.seed ?? 1);
+  const ms = Number(args.ms ?? 300);
+  const rounds = Number(args.rounds ?? 5);
+  const tolerance = Number(args.tolerance ?? 0.1);
+  const baselinePath = args.baseline ?? BASELINE;
+  const crashes = args.crashes ?? "wirebench-crashes";
+  let baseline: Record<string, BenchResult> = {};
+  try {
+    baseline = JSON.parse(readFileSync(baselinePath, "utf8"));
+  } catch {
+    if (!args["update-baseline"]) console.error(`no baseline at ${baselinePath}`);
+  }
+
+  let failed = false;
+  const results: Record<string, BenchResult> = {};
+  if (!args.json) {
+    console.log("  target   fuzz_runs  rejected  crashes   ns/sample  base_ns     MB/s  alloc_KB/call");
+  }
+  // Timing before fuzzing, and out of process, so the mangled inputs
+  // cannot deoptimise the decoders being timed.
+  const benched = targets.map((t) => {
+    let b = benchIsolated(t, ms, rounds);
+    if (args["update-baseline"]) {
+      // median of three, so one lucky run does not become the bar
+      const runs = [b, benchIsolated(t, ms, rounds), benchIsolated(t, ms, rounds)];
+      b = runs.sort((x, y) => x.nsPerSample - y.nsPerSample)[1];
+    }
+    const base = baseline[t.name]?.nsPerSample;
+    const over = (r: BenchResult) => base !== undefined && r.nsPerSample > base * (1 + tolerance);
+    // measure again, up to twice, before calling it a regression
+    for (let retry = 0; retry < 2 && over(b); retry++) {
+      const again = benchIsolated(t, ms, rounds);
+      if (again.nsPerSample < b.nsPerSample) b = again;
+    }
+    results[t.name] = b;
+    return { b, base, slower: over(b) };
+  });
+
+  targets.forEach((t, i) => {
+    const { b, base, slower } = benched[i];
+    const f = iterations > 0 ? fuzz(t, iterations, seed, crashes) : { runs: 0, rejected: 0, failures: 0 };
+    if (f.failures > 0 || (slower && !args["update-baseline"])) failed = true;
+    if (args.json) {
+      console.log(JSON.stringify({ target: t.name, ...f, ...b, baselineNsPerSample: base, regressed: slower }));
+      return;
+    }
+    console.log(
+      [
+        t.name.padStart(8),
+        String(f.runs).padStart(11),
+        String(f.rejected).padStart(9),
+        String(f.failures).padStart(8),
+        b.nsPerSample.toFixed(2).padStart(11),
+        (base === undefined ? "-" : base.toFixed(2)).padStart(8),
+        b.mbPerS.toFixed(0).padStart(8),
+        (b.allocPerCall / 1e3).toFixed(1).padStart(14),
+        slower ? `  SLOWER by ${((b.nsPerSample / base! - 1) * 100).toFixed(0)} %` : "",
+      ].join(" ")
+    );
+  });
+
+  if (args["update-baseline"]) {
+    writeFileSync(baselinePath, JSON.stringify({ ...baseline, ...results }, null, 2) + "\n");
+    console.log(`baseline written to ${baselinePath}`);
+  }
+  return failed ? 1 : 0;
+}
+
+process.exit(main());
@@ -0,0 +1,41 @@
+import assert from "node:assert/strict";
+import { readFileSync } from "node:fs";
+import { test } from "node:test";
+
+import { decodeCapture, replayThroughPipeline } from "@ios-app/viatom-o2ring/src/Capture";
+
+import { buildSessionCapture, CAPTURE_START_MS } from "./fixtures/mkcapture";
+
+const fixture = new Uint8Array(readFileSync(new URL("./fixtures/session.o2rc", import.meta.url)));
+
+test("committed capture matches its generator", () => {
+  // regenerate with `tsx test/fixtures/mkcapture.ts` after a deliberate format change
+  assert.deepEqual(fixture, buildSessionCapture());
+});
+
+test("capture replays through the decoders and analysis", async () => {
+  const capture = decodeCapture(fixture);
+  assert.equal(capture.platform, "android");
+  assert.equal(capture.baseEpochMs, CAPTURE_START_MS);
+  assert.equal(capture.trailingBytes, 0);
+
+  const r = await replayThroughPipeline(capture);
+  assert.equal(r.records, 123);
+  assert.equal(r.realtimeSamples, 120);
+  // ten probe-off samples; the 300 bpm one only fails PR
+  assert.equal(r.realtimeValid, 110);
+  assert.equal(r.files, 3);
+  assert.deepEqual(
+    r.summaries.map((s) => [s.name, s.summary.points, s.summary.durationS]),
+    [
+      ["20260101220000", 150, 600],
+      ["20260101221320.oxi", 300, 300],
+    ]
+  );
+  for (const { summary } of r.summaries) {
+    assert.ok(summary.avgSpo2 > 90 && summary.avgSpo2 < 100);
+    assert.ok(summary.avgPr > 40 && summary.avgPr < 120);
+  }
+  assert.deepEqual(r.failedFiles.map((f) => f.name), ["20260101230000"]);
+  assert.match(r.failedFiles[0].error, /VTO2Object: size/);
+});
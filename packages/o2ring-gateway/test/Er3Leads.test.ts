@@ -0,0 +1,72 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  decodeEr3Leads,
+  decodeEr3LeadsAsync,
+  Er3Lead,
+  er3LeadStateFromElectrodes,
+} from "@ios-app/viatom-o2ring/src/Er3Leads";
+import {
+  Er3Cable,
+  decodeEr3OriginFile,
+} from "@ios-app/viatom-o2ring/src/Er3Wave";
+import { syntheticEr3File } from "../src/Fixtures";
+
+test("leads match a one-piece decode across slices", async () => {
+  for (const cable of [Er3Cable.Lead10, Er3Cable.Lead6, Er3Cable.Lead3]) {
+    const file = syntheticEr3File({ seed: 3, minutes: 2, cable });
+    const { channels, samples, checksumOk } = decodeEr3OriginFile(file);
+    const set = decodeEr3Leads(file, { scale: 1 });
+    const frames = samples.length / channels;
+
+    assert.equal(set.samplesPerLead, frames);
+    assert.equal(set.checksumOk, checksumOk);
+    for (const f of [0, 1, 8191, frames - 1]) {
+      const a = samples[f * channels];
+      const b = samples[f * channels + 1];
+      assert.equal(set.leads[Er3Lead.I]![f], a);
+      assert.equal(set.leads[Er3Lead.II]![f], b);
+      assert.equal(set.leads[Er3Lead.III]![f], b - a);
+      assert.equal(set.leads[Er3Lead.aVR]![f], -(a + b) / 2);
+    }
+    assert.equal(set.leads[Er3Lead.V1] === null, cable === Er3Cable.Lead3);
+    assert.equal(set.leads[Er3Lead.V6] === null, cable !== Er3Cable.Lead10);
+
+    const async = await decodeEr3LeadsAsync(file, { scale: 1, sliceMs: 0 });
+    assert.deepEqual(async.leads, set.leads);
+  }
+});
+
+test("a partial frame at the end of the body is not a sample", () => {
+  // VTMER3FileHead, one 4-channel delta frame and two bytes of the next
+  const file = new Uint8Array(10 + 6 + 20);
+  file.set([0x01, 0x00, Er3Cable.Lead6]);
+  file.set([0x01, 0x02, 0x03, 0x04, 0x01, 0x01], 10);
+  new DataView(file.buffer).setUint32(file.length - 4, 0xa55a0438, true);
+
+  const set = decodeEr3Leads(file, { scale: 0.5 });
+  assert.equal(set.samplesPerLead, 1);
+  assert.deepEqual([...set.leads[Er3Lead.V2]!], [2]);
+  assert.deepEqual([...set.leads[Er3Lead.aVF]!], [0.75]);
+});
+
+test("lead-off segments come from the recorded lead states", () => {
+  const file = syntheticEr3File({ seed: 5, minutes: 1, cable: Er3Cable.Lead6 });
+  const leadOff = er3LeadStateFromElectrodes(Er3Cable.Lead6, 1 << 4); // V1
+  const set = decodeEr3Leads(file, {
+    leadStates: [
+      { offset: 0, leadState: er3LeadStateFromElectrodes(Er3Cable.Lead6, 0) },
+      { offset: 1000, leadState: leadOff },
+      { offset: 4000, leadState: 0 },
+    ],
+  });
+
+  assert.deepEqual(set.leadOff[Er3Lead.V1], [{ start: 1000, end: 4000 }]);
+  assert.deepEqual(set.leadOff[Er3Lead.II], []);
+  // not on a 6-lead cable: off throughout
+  assert.deepEqual(set.leadOff[Er3Lead.V3], [
+    { start: 0, end: 4000 },
+  ]);
+  assert.deepEqual(decodeEr3Leads(file).leadOff[Er3Lead.V1], []);
+});
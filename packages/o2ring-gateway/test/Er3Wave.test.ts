@@ -0,0 +1,115 @@
+// Vectors worked by hand through the SDK's own decoder state machine
+// (`VTMUnCompress_Alg_ECG` / `VTMUnCompress_Multichannel_Alg_ECG` in
+// VTMProductLib's VTMCompress.o), not through the decoder under test.
+
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  decodeEr3OriginFile,
+  decodeEr3RealWave,
+  Er3Cable,
+  Er3Compression,
+  er3DataChecksum,
+  er3MaxSamples,
+  Er3WaveDecoder,
+} from "@ios-app/viatom-o2ring/src/Er3Wave";
+import { WireFormatError } from "@ios-app/viatom-o2ring/src/WireStruct";
+
+// 4 channels: two delta frames, then an escape frame with channels 0 and 2
+// raw (mask 0b0101).
+const FOUR_CHANNEL = Uint8Array.from([
+  0x01, 0x02, 0x03, 0x04,
+  0x7f, 0x81, 0xff, 0x10, // +127, -127, -1, +16: no escapes with 4 channels
+  0x80, 0x05, 0x34, 0x12, 0x05, 0xcd, 0xab, 0xfd,
+]);
+const FOUR_CHANNEL_SAMPLES = [
+  1, 2, 3, 4,
+  128, -125, 2, 20,
+  0x1234, -120, 0xabcd - 0x10000, 17,
+];
+
+function decodeChunked(
+  bytes: Uint8Array,
+  channels: number,
+  chunk: number,
+  compression = Er3Compression.Differential
+) {
+  const decoder = new Er3WaveDecoder(channels, compression);
+  const out: number[] = [];
+  for (let i = 0; i < bytes.length; i += chunk) {
+    const part = bytes.subarray(i, i + chunk);
+    const buf = new Int16Array(er3MaxSamples(part.length, compression, channels));
+    const n = decoder.decode(part, buf);
+    out.push(...buf.subarray(0, n));
+  }
+  return out;
+}
+
+/** VTMER3FileHead (10) | body | VTMER3FileTail (20). */
+function originFile(cable: Er3Cable, body: Uint8Array) {
+  const out = new Uint8Array(10 + body.length + 20);
+  out.set([0x01, 0x00, cable]);
+  out.set(body, 10);
+  const v = new DataView(out.buffer);
+  const tailAt = out.length - 20;
+  v.setUint32(tailAt, 30, true); // recoring_time
+  v.setUint16(tailAt + 4, er3DataChecksum(out.subarray(0, tailAt)), true);
+  v.setUint32(tailAt + 16, 0xa55a0438, true);
+  return out;
+}
+
+test("multichannel frames decode in any chunking", () => {
+  for (const chunk of [1, 2, 3, 5, FOUR_CHANNEL.length]) {
+    assert.deepEqual(decodeChunked(FOUR_CHANNEL, 4, chunk), FOUR_CHANNEL_SAMPLES);
+  }
+});
+
+test("0x80 mid-frame drops the partial frame but keeps its deltas", () => {
+  const bytes = Uint8Array.from([0x01, 0x02, 0x80, 0x00, 0x01, 0x01, 0x01, 0x01]);
+  assert.deepEqual(decodeChunked(bytes, 4, 3), [2, 3, 1, 1]);
+});
+
+test("a raw escape frame may hold 0x80 as a delta", () => {
+  const bytes = Uint8Array.from([0x80, 0x01, 0x00, 0x01, 0x80, 0x80, 0x02]);
+  // ch0 raw 256, ch1..ch3 deltas -128, -128, +2
+  assert.deepEqual(decodeChunked(bytes, 4, 1), [256, -128, -128, 2]);
+});
+
+test("one channel uses the extended-delta escapes", () => {
+  const bytes = Uint8Array.from([0x80, 0x34, 0x12, 0x7f, 0x01, 0x81, 0x02, 0xff]);
+  for (const chunk of [1, 2, bytes.length]) {
+    assert.deepEqual(decodeChunked(bytes, 1, chunk), [4660, 4788, 4659, 4658]);
+  }
+});
+
+test("realtime wave honours the wave_info compression bits", () => {
+  assert.deepEqual([...decodeEr3RealWave(0x10, FOUR_CHANNEL, Er3Cable.Lead6)], FOUR_CHANNEL_SAMPLES);
+  const raw = Uint8Array.from([0x01, 0x00, 0xff, 0xff, 0x00, 0x80, 0x10, 0x00]);
+  assert.deepEqual([...decodeEr3RealWave(0x00, raw, Er3Cable.Lead6)], [1, -1, -32768, 16]);
+});
+
+test("origin file decodes with the cable's channel count", () => {
+  const file = originFile(Er3Cable.Lead6, FOUR_CHANNEL);
+  const { head, tail, channels, checksumOk, samples } = decodeEr3OriginFile(file);
+  assert.equal(head.cable, Er3Cable.Lead6);
+  assert.equal(channels, 4);
+  assert.equal(tail.recordingTime, 30);
+  assert.equal(checksumOk, true);
+  assert.deepEqual([...samples], FOUR_CHANNEL_SAMPLES);
+
+  const eight = decodeEr3OriginFile(originFile(Er3Cable.Lead10, FOUR_CHANNEL.subarray(0, 8)));
+  assert.equal(eight.channels, 8);
+  assert.deepEqual([...eight.samples], [1, 2, 3, 4, 127, -127, -1, 16]);
+
+  const stored = decodeEr3OriginFile(originFile(Er3Cable.Lead6, FOUR_CHANNEL), Er3Compression.None);
+  assert.equal(stored.samples.length, FOUR_CHANNEL.length / 2);
+  assert.equal(stored.samples[0], 0x0201);
+
+  const bad = file.slice();
+  bad[bad.length - 1] = 0;
+  assert.throws(() => decodeEr3OriginFile(bad), WireFormatError);
+  const flipped = file.slice();
+  flipped[12] ^= 1;
+  assert.equal(decodeEr3OriginFile(flipped).checksumOk, false);
+});
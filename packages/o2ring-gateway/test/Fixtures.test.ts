@@ -0,0 +1,33 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  decodeNightFile,
+  OXI_FILE_MAGIC,
+  OXI_FILE_TYPE,
+  readO2FileHead,
+} from "@ios-app/viatom-o2ring/src/O2Night";
+
+import { syntheticNight, syntheticNightFile, syntheticO2File } from "../src/Fixtures";
+
+test("4 s fixtures are O2Ring history files", () => {
+  for (const bytes of [syntheticO2File(3, 1), syntheticNightFile({ hours: 1 })]) {
+    const head = readO2FileHead(bytes);
+    assert.equal(head.size, bytes.length);
+    assert.equal(head.mode, 0);
+    assert.equal((bytes.length - 40) % 5, 0);
+  }
+  const night = syntheticNight({ hours: 1 });
+  assert.deepEqual(decodeNightFile(syntheticNightFile({ hours: 1 }), 0), night);
+});
+
+test("1 s and 2 s fixtures are VTMProductLib oximeter files", () => {
+  for (const intervalS of [1, 2]) {
+    const bytes = syntheticNightFile({ hours: 1, intervalS });
+    const view = new DataView(bytes.buffer, bytes.byteOffset);
+    assert.equal(bytes[1], OXI_FILE_TYPE);
+    assert.equal(view.getUint32(bytes.length - 48 + 4, true), OXI_FILE_MAGIC);
+    assert.equal(OXI_FILE_MAGIC, 0xda5a1248);
+    assert.deepEqual(decodeNightFile(bytes), syntheticNight({ hours: 1, intervalS }));
+  }
+});
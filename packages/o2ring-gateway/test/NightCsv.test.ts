@@ -0,0 +1,57 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import { exportNightCsv, NIGHT_CSV_HEADER } from "@ios-app/viatom-o2ring/src/NightCsv";
+import { decodeO2File, O2Night } from "@ios-app/viatom-o2ring/src/O2Night";
+
+import { syntheticNight, syntheticNightFile } from "../src/Fixtures";
+
+/**
+ * convertOxyFileToCsv (ViatomModule.kt) line for line: 4 s grid over the
+ * record time, legacy row guard, "\n" after every row, then trimEnd().
+ */
+function nativeCsv(night: O2Night, recordingTime: number, utcOffsetMinutes: number) {
+  const n = night.spo2.length;
+  const header = NIGHT_CSV_HEADER;
+  if (n === 0 || recordingTime <= 0) return header;
+  const totalPoints = Math.max(Math.floor(recordingTime / 4), 1);
+  const pad = (v: number) => String(v).padStart(2, "0");
+  const abs = Math.abs(utcOffsetMinutes);
+  const zone =
+    utcOffsetMinutes === 0
+      ? "Z"
+      : `${utcOffsetMinutes < 0 ? "-" : "+"}${pad(Math.floor(abs / 60))}:${pad(abs % 60)}`;
+  let sb = header + "\n";
+  for (let idx = 0; idx < totalPoints; idx++) {
+    const percent = totalPoints > 1 ? idx / (totalPoints - 1) : 0;
+    const i = Math.min(Math.max(Math.round((n - 1) * percent), 0), n - 1);
+    const spo2 = night.spo2[i];
+    const pr = night.pr[i];
+    if ((spo2 >= 1 && spo2 <= 149) || (pr >= 1 && pr <= 349)) {
+      const d = new Date((night.startTime + idx * 4 + utcOffsetMinutes * 60) * 1000);
+      const ts =
+        `${d.getUTCFullYear()}-${pad(d.getUTCMonth() + 1)}-${pad(d.getUTCDate())}` +
+        `T${pad(d.getUTCHours())}:${pad(d.getUTCMinutes())}:${pad(d.getUTCSeconds())}${zone}`;
+      sb += `${ts},${spo2},${pr},${night.motion[i]},${night.spo2Mark[i] ? 1 : 0},${night.prMark[i] ? 1 : 0}\n`;
+    }
+  }
+  return sb.trimEnd();
+}
+
+test("CSV of an O2Ring night equals the native exporter's", () => {
+  const night = decodeO2File(syntheticNightFile({ hours: 2, dropouts: 2 }), 0);
+  const n = night.spo2.length;
+  for (const offset of [0, 330, -300]) {
+    const csv = exportNightCsv(night, offset);
+    assert.equal(csv, nativeCsv(night, n * 4, offset));
+    assert.ok(!csv.endsWith("\n"));
+  }
+});
+
+test("a night without rows is the bare header", () => {
+  const night = syntheticNight({ hours: 0.1 });
+  night.spo2.fill(0);
+  night.pr.fill(0);
+  assert.equal(exportNightCsv(night), NIGHT_CSV_HEADER);
+  assert.equal(exportNightCsv(night), nativeCsv(night, night.spo2.length * 4, 0));
+});
@@ -0,0 +1,109 @@
+// History files built byte by byte from the documented layouts, not with
+// the encoders under test, so a wrong offset or constant shows up here.
+
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  decodeNightFile,
+  decodeO2File,
+  decodeOxiFile,
+  encodeO2File,
+  encodeOxiFile,
+} from "@ios-app/viatom-o2ring/src/O2Night";
+import { WireFormatError } from "@ios-app/viatom-o2ring/src/WireStruct";
+
+/** O2Ring history file: 40-byte head, then spo2 u8 | hr u16 | motion u8 | marks u8. */
+function o2File(points: [number, number, number, number][]) {
+  const out = new Uint8Array(40 + points.length * 5);
+  const v = new DataView(out.buffer);
+  v.setUint8(0, 3); // file version
+  v.setUint8(1, 0); // sleep mode
+  v.setUint16(2, 2026, true);
+  v.setUint8(4, 3); // month
+  v.setUint8(5, 14);
+  v.setUint8(6, 23);
+  v.setUint8(7, 5);
+  v.setUint8(8, 30);
+  v.setUint32(9, out.length, true);
+  v.setUint16(13, points.length * 4, true); // record time
+  points.forEach(([spo2, hr, motion, marks], i) => {
+    const p = 40 + i * 5;
+    v.setUint8(p, spo2);
+    v.setUint16(p + 1, hr, true);
+    v.setUint8(p + 3, motion);
+    v.setUint8(p + 4, marks);
+  });
+  return out;
+}
+
+/** VTMOxiFileHead (10) | VTMOxiPoint (5) × n | VTMOxiFileTail (48). */
+function oxiFile(points: [number, number, number][], interval: number) {
+  const tailAt = 10 + points.length * 5;
+  const out = new Uint8Array(tailAt + 48);
+  const v = new DataView(out.buffer);
+  v.setUint8(0, 1);
+  v.setUint8(1, 0x03); // Oxi
+  points.forEach(([spo2, pr, motion], i) => out.set([spo2, pr, motion, 0, 1], 10 + i * 5));
+  v.setUint32(tailAt + 4, 0xda5a1248, true);
+  v.setUint32(tailAt + 8, 1767304800, true);
+  v.setUint32(tailAt + 12, points.length, true);
+  v.setUint8(tailAt + 16, interval);
+  return out;
+}
+
+test("O2Ring history file decodes from the head layout", () => {
+  const bytes = o2File([
+    [97, 61, 0, 0],
+    [88, 300, 12, 0x80],
+    [255, 255, 0, 0x40],
+  ]);
+  const night = decodeO2File(bytes, 60);
+  assert.equal(night.startTime, Date.UTC(2026, 2, 14, 22, 5, 30) / 1000);
+  assert.equal(night.intervalS, 4);
+  assert.deepEqual([...night.spo2], [97, 88, 255]);
+  assert.deepEqual([...night.pr], [61, 300, 255]);
+  assert.deepEqual([...night.motion], [0, 12, 0]);
+  assert.deepEqual([...night.spo2Mark], [0, 1, 0]);
+  assert.deepEqual([...night.prMark], [0, 0, 1]);
+  assert.deepEqual(decodeNightFile(bytes, 60), night);
+});
+
+test("encodeO2File writes what decodeO2File reads", () => {
+  const night = decodeO2File(o2File([[95, 260, 3, 0x80], [94, 70, 0, 0]]), 0);
+  const bytes = encodeO2File(night);
+  assert.deepEqual(decodeO2File(bytes, 0), night);
+  assert.equal(bytes[0], 3);
+  assert.equal(bytes[1], 0);
+  assert.equal(new DataView(bytes.buffer).getUint32(9, true), bytes.length);
+});
+
+test("arbitrary bytes are not an O2Ring file", () => {
+  const junk = new Uint8Array(4000).map((_, i) => (i * 37 + 11) & 0xff);
+  assert.throws(() => decodeNightFile(junk, 0), WireFormatError);
+  assert.throws(() => decodeO2File(new Uint8Array(12)), WireFormatError);
+
+  const bad = o2File([[97, 61, 0, 0]]);
+  bad[1] = 0x03; // BabyO2 S3 operation mode
+  assert.throws(() => decodeO2File(bad, 0), /mode/);
+  const torn = o2File([[97, 61, 0, 0], [97, 61, 0, 0]]).subarray(0, 47);
+  assert.throws(() => decodeO2File(torn, 0), /size/);
+});
+
+test("oximeter file decodes from the tail layout", () => {
+  const bytes = oxiFile([[96, 58, 2], [0, 0, 0]], 2);
+  const night = decodeNightFile(bytes);
+  assert.equal(night.startTime, 1767304800);
+  assert.equal(night.intervalS, 2);
+  assert.deepEqual([...night.pr], [58, 0]);
+  assert.deepEqual([...night.prMark], [1, 1]);
+
+  const wrongType = bytes.slice();
+  wrongType[1] = 0x01;
+  assert.throws(() => decodeOxiFile(wrongType), /file_type/);
+
+  const encoded = encodeOxiFile(night);
+  assert.equal(encoded[1], 0x03);
+  assert.equal(new DataView(encoded.buffer).getUint32(encoded.length - 44, true), 0xda5a1248);
+  assert.deepEqual(decodeOxiFile(encoded), night);
+});
@@ -0,0 +1,87 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import { ColumnStreamWriter, decodeColumnStream } from "@ios-app/viatom-o2ring/src/ColumnStream";
+import { BabyRecordDecoder } from "@ios-app/viatom-o2ring/src/RawFiles";
+import { WireFormatError } from "@ios-app/viatom-o2ring/src/WireStruct";
+
+/**
+ * BabyO2 S3 file from VTO2Def.h: `VTO2FileHead_t` (13) | 4-byte
+ * `VTO2SleepPointData_t`s | `VTO2SleepFileTail_t` (27 + 40).
+ */
+function s3File(points: [number, number, number, number][], operationMode = 0x03) {
+  const tailAt = 13 + points.length * 4;
+  const out = new Uint8Array(tailAt + 67);
+  const v = new DataView(out.buffer);
+  v.setUint8(0, 1);
+  v.setUint8(1, operationMode);
+  v.setUint16(2, 2026, true);
+  v.setUint8(4, 1);
+  v.setUint8(5, 2);
+  v.setUint8(6, 21);
+  v.setUint8(7, 30);
+  v.setUint8(8, 0);
+  v.setUint32(9, out.length, true);
+  points.forEach((p, i) => out.set(p, 13 + i * 4));
+  v.setUint16(tailAt, points.length * 4, true); // record_time
+  v.setUint8(tailAt + 4, 96); // average_spo2
+  v.setUint8(tailAt + 5, 89); // lowest_spo2
+  v.setUint16(tailAt + 17, 118, true); // average_hr
+  v.setUint32(tailAt + 27, 1767303000, true); // report.start_timestamp
+  v.setUint8(tailAt + 51, 3); // report.wake_count
+  return out;
+}
+
+function decode(file: Uint8Array, chunk: number) {
+  const parts: Uint8Array[] = [];
+  const decoder = new BabyRecordDecoder(
+    (head, columns) =>
+      new ColumnStreamWriter(
+        { deviceId: "s3", kind: "baby", startTime: head.startTime, intervalS: head.intervalS, columns },
+        (b) => parts.push(b.slice())
+      ).sink,
+    2,
+    0
+  );
+  for (let i = 0; i < file.length; i += chunk) decoder.push(file.subarray(i, i + chunk));
+  const result = decoder.finish();
+  return { ...result, stream: decodeColumnStream(Buffer.concat(parts)) };
+}
+
+const points: [number, number, number, number][] = [
+  [97, 118, 0x05, 0x21], // motion 5, quiet 1, sleep_state 2
+  [89, 131, 0xc0, 0x00], // remind_hr + remind_spo2
+  [96, 120, 0x3f, 0xf4],
+];
+
+test("BabyO2 S3 file decodes in any chunking", () => {
+  const file = s3File(points);
+  for (const chunk of [1, 3, 5, 13, 70, file.length]) {
+    const { head, tail, count, trailingBytes, stream } = decode(file, chunk);
+    assert.equal(head.startTime, Date.UTC(2026, 0, 2, 21, 30, 0) / 1000);
+    assert.equal(head.intervalS, 4);
+    assert.equal(count, 3);
+    assert.equal(trailingBytes, 0);
+    assert.equal(stream.count, 3);
+    const c = stream.columns;
+    assert.deepEqual([...c.spo2], [97, 89, 96]);
+    assert.deepEqual([...c.pr], [118, 131, 120]);
+    assert.deepEqual([...c.motion], [5, 0, 63]);
+    assert.deepEqual([...c.remind_hr], [0, 1, 0]);
+    assert.deepEqual([...c.remind_spo2], [0, 1, 0]);
+    assert.deepEqual([...c.quiet], [1, 0, 4]);
+    assert.deepEqual([...c.sleep_state], [2, 0, 15]);
+    assert.equal(tail.record_time, 12);
+    assert.equal(tail.average_spo2, 96);
+    assert.equal(tail.lowest_spo2, 89);
+    assert.equal(tail.average_hr, 118);
+    assert.equal(tail.start_timestamp, 1767303000);
+    assert.equal(tail.wake_count, 3);
+  }
+});
+
+test("BabyO2 S3 decoder rejects other files", () => {
+  assert.throws(() => decode(s3File(points, 0x00), 64), /operation_mode/);
+  const noTail = s3File(points).subarray(0, 13 + 12 + 10);
+  assert.throws(() => decode(noTail, 64), WireFormatError);
+});
@@ -0,0 +1,126 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  SessionEvent,
+  SessionManager,
+  SessionTransport,
+  TransportEvent,
+} from "@ios-app/viatom-o2ring/src/Sessions";
+import { VirtualClock } from "@ios-app/viatom-o2ring/src/SimulatedTransport";
+
+const CONNECT_MS = 1000;
+const CONNECT_TIMEOUT_MS = 30000;
+
+/**
+ * The native SDKs' shape: one link per model. A connect takes the link;
+ * a ring whose connect was taken over never comes up and is closed after
+ * the native CONNECTING timeout. Commands for a ring that lost the link
+ * swap it back in first.
+ */
+class OneLinkPerModel implements SessionTransport {
+  readonly maxConcurrent = 1;
+  readonly attached = new Map<number, string>();
+  readonly models = new Map<string, number>();
+  connectsInFlight = 0;
+  maxConnectsInFlight = 0;
+  private readonly listeners = new Set<(e: TransportEvent) => void>();
+
+  constructor(private readonly clock: VirtualClock) {}
+
+  async connect(deviceId: string, model: number) {
+    this.models.set(deviceId, model);
+    this.attached.set(model, deviceId);
+    this.connectsInFlight++;
+    this.maxConnectsInFlight = Math.max(this.maxConnectsInFlight, this.connectsInFlight);
+    this.clock.setTimeout(() => {
+      if (this.attached.get(model) === deviceId) {
+        this.connectsInFlight--;
+        this.emit({ type: "connected", deviceId });
+        return;
+      }
+      this.clock.setTimeout(() => {
+        this.connectsInFlight--;
+        this.emit({ type: "error", deviceId, code: "CONNECT_TIMEOUT", message: "" });
+        this.emit({ type: "disconnected", deviceId });
+      }, CONNECT_TIMEOUT_MS - CONNECT_MS);
+    }, CONNECT_MS);
+    return true;
+  }
+
+  async disconnect() {
+    return true;
+  }
+
+  async getInfo(deviceId: string) {
+    this.swapIn(deviceId);
+    this.clock.setTimeout(() => {
+      this.emit({ type: "info", deviceId, files: [`${deviceId}.dat`] });
+    }, 100);
+    return true;
+  }
+
+  async readFile(deviceId: string, name: string) {
+    this.swapIn(deviceId);
+    this.clock.setTimeout(() => {
+      this.emit({ type: "file", deviceId, csv: name, startTime: 0, bytes: 10 });
+    }, 500);
+    return true;
+  }
+
+  subscribe(listener: (e: TransportEvent) => void) {
+    this.listeners.add(listener);
+    return () => {
+      this.listeners.delete(listener);
+    };
+  }
+
+  private swapIn(deviceId: string) {
+    this.attached.set(this.models.get(deviceId)!, deviceId);
+  }
+
+  private emit(e: TransportEvent) {
+    this.listeners.forEach((l) => l(e));
+  }
+}
+
+test("same-model rings connect one at a time on a one-slot transport", async () => {
+  const clock = new VirtualClock();
+  const transport = new OneLinkPerModel(clock);
+  const manager = new SessionManager(transport, { clock });
+  const events: SessionEvent[] = [];
+  manager.addListener((e) => events.push(e));
+
+  const a = manager.open("A", 7);
+  const b = manager.open("B", 7);
+  await clock.run(5 * CONNECT_TIMEOUT_MS);
+
+  assert.equal(transport.maxConnectsInFlight, 1);
+  assert.deepEqual(
+    events.filter((e) => e.type === "disconnected" || e.type === "error"),
+    []
+  );
+  assert.equal(a.state, "ready");
+  assert.equal(b.state, "ready");
+  assert.equal(a.stats.files, 1);
+  assert.equal(b.stats.files, 1);
+  // B connected only once A was up, well inside A's connect timeout
+  assert.ok(clock.now() < CONNECT_TIMEOUT_MS);
+  manager.dispose();
+});
+
+test("a ring closed before its turn never reaches the transport", async () => {
+  const clock = new VirtualClock();
+  const transport = new OneLinkPerModel(clock);
+  const manager = new SessionManager(transport, { clock });
+
+  const a = manager.open("A", 7);
+  manager.open("B", 7);
+  await manager.close("B");
+  await clock.run(5 * CONNECT_TIMEOUT_MS);
+
+  assert.equal(transport.models.has("B"), false);
+  assert.equal(a.state, "ready");
+  assert.equal(a.stats.files, 1);
+  manager.dispose();
+});
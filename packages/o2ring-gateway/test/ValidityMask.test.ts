@@ -0,0 +1,38 @@
+import assert from "node:assert/strict";
+import { test } from "node:test";
+
+import {
+  buildValidityMask,
+  INVALID_PR_RANGE,
+  INVALID_PROBE_OFF,
+  isValid,
+  journalValidityMask,
+} from "@ios-app/viatom-o2ring/src/ValidityMask";
+
+const valid = (bits: Uint32Array, n: number) => Array.from({ length: n }, (_, i) => isValid(bits, i));
+
+test("pulse rates above 255 are range-checked, not wrapped", () => {
+  // 316 & 0xff is 60, which would pass the table
+  const pr = Uint16Array.from([60, 300, 316, 0]);
+  const spo2 = Uint8Array.from([95, 95, 95, 95]);
+  const mask = buildValidityMask({ spo2, pr });
+  assert.deepEqual(valid(mask.pr, 4), [true, false, false, false]);
+  assert.equal(mask.reasons[2] & INVALID_PR_RANGE, INVALID_PR_RANGE);
+  assert.deepEqual(valid(buildValidityMask({ spo2, pr }, { prMax: 320 }).pr, 4), [
+    true,
+    true,
+    true,
+    false,
+  ]);
+});
+
+test("journal flags reject probe-off readings", () => {
+  const mask = journalValidityMask({
+    spo2: [95, 95, 96],
+    pr: [60, 60, 61],
+    motion: [0, 0, 0],
+    flags: [1, 0, 1],
+  });
+  assert.deepEqual(valid(mask.spo2, 3), [true, false, true]);
+  assert.equal(mask.reasons[1], INVALID_PROBE_OFF);
+});
@@ -0,0 +1,45 @@
+// Writes session.o2rc, the capture replay.test.ts replays: two minutes of
+// realtime samples (a probe-off stretch and a 300 bpm reading among them)
+// and three history files as a ring would deliver them.
+//
+//   tsx test/fixtures/mkcapture.ts
+
+import { writeFileSync } from "node:fs";
+
+import { CaptureWriter } from "@ios-app/viatom-o2ring/src/Capture";
+import { encodeO2File, encodeOxiFile } from "@ios-app/viatom-o2ring/src/O2Night";
+
+import { syntheticNight } from "../../src/Fixtures";
+
+export const CAPTURE_START_MS = 1767304800000;
+
+export function buildSessionCapture() {
+  const w = new CaptureWriter(CAPTURE_START_MS, "android");
+  for (let i = 0; i < 120; i++) {
+    w.realtime(i * 1000, {
+      spo2: 95 + (i % 3),
+      pr: i === 60 ? 300 : 62 + (i % 5),
+      pi: 25,
+      motion: 0,
+      battery: 80,
+      probeOn: i < 30 || i >= 40,
+    });
+  }
+  const o2 = syntheticNight({ seed: 7, hours: 1 / 6, startTime: 1767301200, dropouts: 0 });
+  const oxi = syntheticNight({
+    seed: 8,
+    hours: 1 / 12,
+    intervalS: 1,
+    startTime: 1767302000,
+    dropouts: 0,
+  });
+  w.file(121000, "20260101220000", encodeO2File(o2));
+  w.file(122000, "20260101221320.oxi", encodeOxiFile(oxi));
+  // a transfer cut off partway: must be rejected, not summarised
+  w.file(123000, "20260101230000", encodeO2File(o2).subarray(0, 40 + 7 * 5 + 2));
+  return w.finish();
+}
+
+if (process.argv[1]?.endsWith("mkcapture.ts")) {
+  writeFileSync(new URL("./session.o2rc", import.meta.url), buildSessionCapture());
+}
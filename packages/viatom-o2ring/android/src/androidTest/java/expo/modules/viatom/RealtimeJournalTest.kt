@@ -0,0 +1,53 @@
+package expo.modules.viatom
+
+import android.os.SystemClock
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import java.io.File
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+@RunWith(AndroidJUnit4::class)
+class RealtimeJournalTest {
+  private lateinit var dir: File
+
+  @Before
+  fun setUp() {
+    dir = File(InstrumentationRegistry.getInstrumentation().targetContext.cacheDir, "journal-test")
+    dir.deleteRecursively()
+  }
+
+  @After
+  fun tearDown() {
+    dir.deleteRecursively()
+  }
+
+  @Test
+  fun singleReadingCommitsWithinInterval() {
+    val intervalMs = 300L
+    val journal =
+            RealtimeJournal(dir, RealtimeJournal.Options(commitRecords = 64, commitIntervalMs = intervalMs))
+    try {
+      val start = SystemClock.elapsedRealtime()
+      assertTrue(journal.append(start, 95, 60, 25, 0, 80, RealtimeJournal.FLAG_PROBE_ON))
+      // No flush(): the interval alone has to get it to disk
+      while (journal.stats().committed == 0L && SystemClock.elapsedRealtime() - start < 10 * intervalMs) {
+        Thread.sleep(10)
+      }
+      val waited = SystemClock.elapsedRealtime() - start
+      assertEquals(1L, journal.stats().committed)
+      // Interval plus one fsync, not a whole batch's worth of readings
+      assertTrue("committed after $waited ms", waited < intervalMs + 1_000)
+      val columns = journal.read()
+      assertEquals(1, columns.t.size)
+      assertEquals(95, columns.spo2[0])
+      assertEquals(60, columns.pr[0])
+    } finally {
+      journal.close()
+    }
+  }
+}
@@ -0,0 +1,66 @@
+package expo.modules.viatom
+
+import android.app.NotificationChannel
+import android.app.NotificationManager
+import android.content.Context
+import android.os.Build
+import androidx.core.app.NotificationCompat
+import androidx.core.app.NotificationManagerCompat
+
+/**
+ * Local notifications for [DesatAlarm], posted straight from the thread that
+ * evaluated the sample. One notification per ring and alarm kind: a raise
+ * replaces it, a clear removes it.
+ */
+internal object AlarmNotifier {
+  private const val CHANNEL_ID = "o2ring.alarms"
+
+  @Volatile private var channelReady = false
+
+  /** @return false when the user has notifications turned off for the app */
+  fun show(context: Context, mac: String, kind: DesatAlarm.Kind, value: Int, nadir: Int): Boolean {
+    val manager = NotificationManagerCompat.from(context)
+    if (!manager.areNotificationsEnabled()) return false
+    ensureChannel(context)
+    val text =
+            when (kind) {
+              DesatAlarm.Kind.SPO2_LOW -> "Blood oxygen low: $value% (lowest $nadir%)"
+              DesatAlarm.Kind.PR_LOW -> "Pulse rate low: $value bpm (lowest $nadir bpm)"
+              DesatAlarm.Kind.PR_HIGH -> "Pulse rate high: $value bpm (highest $nadir bpm)"
+            }
+    val notification =
+            NotificationCompat.Builder(context, CHANNEL_ID)
+                    .setSmallIcon(context.applicationInfo.icon)
+                    .setContentTitle("O2Ring alarm")
+                    .setContentText(text)
+                    .setCategory(NotificationCompat.CATEGORY_ALARM)
+                    .setPriority(NotificationCompat.PRIORITY_MAX)
+                    .setAutoCancel(true)
+                    .build()
+    try {
+      manager.notify(idFor(mac, kind), notification)
+    } catch (e: SecurityException) {
+      // POST_NOTIFICATIONS revoked between the check and the post
+      return false
+    }
+    return true
+  }
+
+  fun cancel(context: Context, mac: String, kind: DesatAlarm.Kind) {
+    NotificationManagerCompat.from(context).cancel(idFor(mac, kind))
+  }
+
+  private fun idFor(mac: String, kind: DesatAlarm.Kind) = mac.hashCode() * 31 + kind.ordinal
+
+  private fun ensureChannel(context: Context) {
+    if (channelReady || Build.VERSION.SDK_INT < Build.VERSION_CODES.O) return
+    val channel =
+            NotificationChannel(CHANNEL_ID, "Oximeter alarms", NotificationManager.IMPORTANCE_HIGH)
+                    .apply {
+                      description = "Low blood oxygen and abnormal pulse rate from the ring"
+                      enableVibration(true)
+                    }
+    context.getSystemService(NotificationManager::class.java).createNotificationChannel(channel)
+    channelReady = true
+  }
+}
@@ -0,0 +1,147 @@
+package expo.modules.viatom
+
+/**
+ * Desaturation / pulse-rate alarms for one ring, evaluated on every realtime
+ * sample on the thread that delivered it (the LiveEventBus background
+ * executor), so an alarm never waits on the JS thread.
+ *
+ * Each alarm is a small state machine over valid samples:
+ * - raised once the value has stayed past its threshold for [Config.onsetMs];
+ * - cleared once it has stayed back inside threshold ± hysteresis for
+ *   [Config.clearMs]; values between the two bands keep the current state.
+ *
+ * Samples with the probe off, out-of-range values or motion above
+ * [Config.motionMax] are artifacts: they neither start, advance nor clear an
+ * alarm. A gap of artifacts longer than [Config.maxGapMs] drops a pending
+ * onset, since the breach can no longer be shown to be continuous. Work per
+ * sample is constant and allocation-free.
+ */
+internal class DesatAlarm {
+  data class Config(
+          /** Raise below this SpO2 (%); 0 disables. */
+          val spo2Low: Int = 88,
+          val spo2Hysteresis: Int = 2,
+          /** Raise below / above these pulse rates (bpm); 0 disables. */
+          val prLow: Int = 40,
+          val prHigh: Int = 130,
+          val prHysteresis: Int = 5,
+          val onsetMs: Long = 10_000,
+          val clearMs: Long = 5_000,
+          val motionMax: Int = 40,
+          val maxGapMs: Long = 15_000
+  )
+
+  enum class Kind(val wire: String) {
+    SPO2_LOW("spo2Low"),
+    PR_LOW("prLow"),
+    PR_HIGH("prHigh")
+  }
+
+  fun interface Listener {
+    /**
+     * @param nadir worst value of the episode so far
+     * @param durationMs time since the episode's first breaching sample
+     */
+    fun onAlarm(kind: Kind, raised: Boolean, value: Int, nadir: Int, durationMs: Long)
+  }
+
+  private class Track {
+    var active = false
+    var breachSince = -1L
+    var okSince = -1L
+    var lastValid = -1L
+    var nadir = 0
+  }
+
+  private val tracks = Array(Kind.values().size) { Track() }
+
+  @Synchronized
+  fun onSample(
+          config: Config,
+          nowMs: Long,
+          spo2: Int,
+          pr: Int,
+          motion: Int,
+          probeOn: Boolean,
+          listener: Listener
+  ) {
+    val artifact = !probeOn || motion > config.motionMax
+    val spo2Ok = !artifact && spo2 in 1..100
+    val prOk = !artifact && pr in 1..350
+    if (config.spo2Low > 0) {
+      track(Kind.SPO2_LOW, config, nowMs, spo2Ok, spo2, spo2 < config.spo2Low,
+              spo2 >= config.spo2Low + config.spo2Hysteresis, listener)
+    }
+    if (config.prLow > 0) {
+      track(Kind.PR_LOW, config, nowMs, prOk, pr, pr < config.prLow,
+              pr >= config.prLow + config.prHysteresis, listener)
+    }
+    if (config.prHigh > 0) {
+      track(Kind.PR_HIGH, config, nowMs, prOk, pr, pr > config.prHigh,
+              pr <= config.prHigh - config.prHysteresis, listener)
+    }
+  }
+
+  /** Forget every alarm, raised or pending, without reporting it cleared. */
+  @Synchronized
+  fun reset() {
+    tracks.forEach {
+      it.active = false
+      it.breachSince = -1L
+      it.okSince = -1L
+      it.lastValid = -1L
+    }
+  }
+
+  private fun track(
+          kind: Kind,
+          config: Config,
+          now: Long,
+          valid: Boolean,
+          value: Int,
+          breach: Boolean,
+          recovered: Boolean,
+          listener: Listener
+  ) {
+    val t = tracks[kind.ordinal]
+    if (!valid) {
+      if (t.lastValid >= 0 && now - t.lastValid > config.maxGapMs) {
+        if (!t.active) t.breachSince = -1L
+        t.okSince = -1L
+      }
+      return
+    }
+    t.lastValid = now
+    val lower = kind != Kind.PR_HIGH
+    if (!t.active) {
+      if (!breach) {
+        t.breachSince = -1L
+        return
+      }
+      if (t.breachSince < 0) {
+        t.breachSince = now
+        t.nadir = value
+      } else if (if (lower) value < t.nadir else value > t.nadir) {
+        t.nadir = value
+      }
+      if (now - t.breachSince >= config.onsetMs) {
+        t.active = true
+        t.okSince = -1L
+        listener.onAlarm(kind, true, value, t.nadir, now - t.breachSince)
+      }
+      return
+    }
+    if (breach && (if (lower) value < t.nadir else value > t.nadir)) t.nadir = value
+    if (!recovered) {
+      t.okSince = -1L
+      return
+    }
+    if (t.okSince < 0) t.okSince = now
+    if (now - t.okSince >= config.clearMs) {
+      t.active = false
+      listener.onAlarm(kind, false, value, t.nadir, now - t.breachSince)
+      t.breachSince = -1L
+      t.okSince = -1L
+    }
+  }
+}
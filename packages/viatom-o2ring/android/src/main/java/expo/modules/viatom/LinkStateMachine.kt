@@ -0,0 +1,162 @@
+package expo.modules.viatom
+
+import android.os.Handler
+import android.os.SystemClock
+
+/**
+ * Bring-up of one ring: connecting → services → info → realtime → syncing.
+ *
+ * Each state owns one command with a timeout and an attempt budget. Entering
+ * a state issues its command; the matching SDK event moves the machine on, a
+ * timeout re-issues the command until the budget is spent, then [Step.onExhausted]
+ * decides what happens. Only transitions are reported, never the retries in
+ * between, and the elapsed time since connect is attached so time-to-first-
+ * sample and time-to-first-file come straight out of the event stream.
+ *
+ * Thread-safe: SDK events arrive on both the main and the background delivery
+ * executors; timers run on [handler].
+ */
+internal class LinkStateMachine(
+        private val handler: Handler,
+        private val onTransition: (Transition) -> Unit
+) {
+  enum class State(val wire: String) {
+    CONNECTING("connecting"),
+    SERVICES("services"),
+    INFO("info"),
+    REALTIME("realtime"),
+    SYNCING("syncing"),
+    DISCONNECTED("disconnected")
+  }
+
+  class Step(
+          val timeoutMs: Long,
+          val attempts: Int,
+          /** Called with the attempt number, 1 on entry. */
+          val action: (Int) -> Unit,
+          val onExhausted: () -> Unit
+  )
+
+  data class Transition(
+          val from: State,
+          val to: State,
+          /** ms since [start]. */
+          val elapsedMs: Long,
+          /** Attempts the state that was left needed. */
+          val attempts: Int,
+          val reason: String?
+  )
+
+  private val steps = HashMap<State, Step>()
+
+  @Volatile
+  var state = State.DISCONNECTED
+    private set
+
+  private var attempt = 0
+  private var startedAt = 0L
+  private var timeout: Runnable? = null
+
+  /** ms from connect to the first realtime sample / first history file, -1 until seen. */
+  @Volatile var firstSampleMs = -1L
+    private set
+  @Volatile var firstFileMs = -1L
+    private set
+
+  fun configure(state: State, step: Step): LinkStateMachine {
+    steps[state] = step
+    return this
+  }
+
+  /** A connect was issued: restart the clock and the metrics. */
+  @Synchronized
+  fun start() {
+    startedAt = SystemClock.elapsedRealtime()
+    firstSampleMs = -1L
+    firstFileMs = -1L
+    moveTo(State.CONNECTING, null)
+  }
+
+  /** The SDK reported what [expected] was waiting for; ignored in any other state. */
+  @Synchronized
+  fun advance(expected: State, to: State, reason: String? = null): Boolean {
+    if (state != expected) return false
+    moveTo(to, reason)
+    return true
+  }
+
+  /** Re-issue the current command now, e.g. when the ring signals it can answer. */
+  @Synchronized
+  fun nudge(expected: State) {
+    if (state != expected) return
+    val step = steps[state] ?: return
+    if (attempt >= step.attempts) return
+    attempt++
+    arm(step)
+    step.action(attempt)
+  }
+
+  /** Cheap check for hot paths (every realtime sample). */
+  fun awaitingSample() = state == State.REALTIME
+
+  @Synchronized
+  fun sampleArrived() {
+    if (firstSampleMs < 0) firstSampleMs = elapsed()
+    advance(State.REALTIME, State.SYNCING)
+  }
+
+  /** @return ms since connect if this is the first file of the connection, else -1 */
+  @Synchronized
+  fun fileArrived(): Long {
+    if (firstFileMs >= 0 || state == State.DISCONNECTED) return -1L
+    firstFileMs = elapsed()
+    return firstFileMs
+  }
+
+  @Synchronized
+  fun stop(reason: String?) {
+    if (state != State.DISCONNECTED) moveTo(State.DISCONNECTED, reason)
+  }
+
+  private fun moveTo(to: State, reason: String?) {
+    disarm()
+    val from = state
+    val took = attempt
+    state = to
+    attempt = 0
+    if (from != to) onTransition(Transition(from, to, elapsed(), took, reason))
+    val step = steps[to] ?: return
+    attempt = 1
+    arm(step)
+    step.action(attempt)
+  }
+
+  private fun arm(step: Step) {
+    disarm()
+    val expected = state
+    val task = Runnable { onTimeout(expected) }
+    timeout = task
+    handler.postDelayed(task, step.timeoutMs)
+  }
+
+  private fun disarm() {
+    timeout?.let { handler.removeCallbacks(it) }
+    timeout = null
+  }
+
+  @Synchronized
+  private fun onTimeout(expected: State) {
+    if (state != expected) return
+    timeout = null
+    val step = steps[state] ?: return
+    if (attempt < step.attempts) {
+      attempt++
+      arm(step)
+      step.action(attempt)
+    } else {
+      step.onExhausted()
+    }
+  }
+
+  private fun elapsed() = SystemClock.elapsedRealtime() - startedAt
+}
@@ -0,0 +1,126 @@
+package expo.modules.viatom
+
+import android.os.SystemClock
+import java.io.BufferedOutputStream
+import java.io.Closeable
+import java.io.File
+import java.io.FileOutputStream
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Field / debug capture of what one ring sent, for replay off-device (see
+ * src/Capture.ts). Append-only, little-endian, same layout as
+ * PacketCapture.swift:
+ * ```
+ * header  16 B: magic "O2RC" u32 | version u8 | platform u8 | u16 0 | baseEpochMs i64
+ * record  12 B: t u32 (ms since open) | kind u8 | u8 0 | u16 0 | length u32
+ *               | payload
+ * REALTIME  8 B: spo2 u8 | pr u16 | pi u8 (tenths) | motion u8 | battery u8
+ *               | flags u8 (bit 0 probe on) | u8 0 | original packet
+ * FILE        : name length u8 | name UTF-8 | file bytes as read
+ * ```
+ * The SDK fields are stored because Lepu hands out parsed [RtParam]s only,
+ * so the original packet is empty here. Every record is flushed to the
+ * kernel as it is written, so a crash loses at most the record in flight;
+ * a reader stops at a torn tail. A capture stops growing at [maxBytes].
+ */
+internal class PacketCapture(val file: File, private val maxBytes: Long = 64L shl 20) : Closeable {
+  private val baseMono = SystemClock.elapsedRealtime()
+  private val out: BufferedOutputStream
+  private val head = ByteBuffer.allocate(RECORD_HEADER + REALTIME_FIELDS).order(ByteOrder.LITTLE_ENDIAN)
+  private var size = 0L
+  private var closed = false
+
+  var dropped = 0
+    private set
+
+  init {
+    file.parentFile?.mkdirs()
+    out = BufferedOutputStream(FileOutputStream(file), 64 * 1024)
+    val h = ByteBuffer.allocate(FILE_HEADER).order(ByteOrder.LITTLE_ENDIAN)
+    h.putInt(MAGIC).put(VERSION.toByte()).put(PLATFORM_ANDROID.toByte()).putShort(0)
+    h.putLong(System.currentTimeMillis())
+    out.write(h.array())
+    out.flush()
+    size = FILE_HEADER.toLong()
+  }
+
+  @Synchronized
+  fun realtime(
+          monoMs: Long,
+          spo2: Int,
+          pr: Int,
+          piTenths: Int,
+          motion: Int,
+          battery: Int,
+          flags: Int,
+          original: ByteArray? = null
+  ) {
+    val raw = original ?: EMPTY
+    if (!begin(monoMs, KIND_REALTIME, REALTIME_FIELDS + raw.size)) return
+    head.put(spo2.coerceIn(0, 255).toByte())
+    head.putShort(pr.coerceIn(0, 0xffff).toShort())
+    head.put(piTenths.coerceIn(0, 255).toByte())
+    head.put(motion.coerceIn(0, 255).toByte())
+    head.put(battery.coerceIn(0, 255).toByte())
+    head.put(flags.toByte())
+    head.put(0)
+    write(raw)
+  }
+
+  @Synchronized
+  fun file(monoMs: Long, name: String, bytes: ByteArray) {
+    val encoded = name.toByteArray(Charsets.UTF_8).let { if (it.size > 255) it.copyOf(255) else it }
+    if (!begin(monoMs, KIND_FILE, 1 + encoded.size + bytes.size)) return
+    head.put(encoded.size.toByte())
+    write(encoded, bytes)
+  }
+
+  private fun begin(monoMs: Long, kind: Int, length: Int): Boolean {
+    if (closed || size + RECORD_HEADER + length > maxBytes) {
+      dropped++
+      return false
+    }
+    head.clear()
+    head.putInt((monoMs - baseMono).coerceIn(0L, 0xffffffffL).toInt())
+    head.put(kind.toByte()).put(0).putShort(0)
+    head.putInt(length)
+    return true
+  }
+
+  private fun write(vararg payload: ByteArray) {
+    try {
+      out.write(head.array(), 0, head.position())
+      payload.forEach { out.write(it) }
+      out.flush()
+      size += head.position() + payload.sumOf { it.size }
+    } catch (e: IOException) {
+      // the record may be half written; anything after it would misparse
+      dropped++
+      close()
+    }
+  }
+
+  @Synchronized
+  override fun close() {
+    if (closed) return
+    closed = true
+    try {
+      out.close()
+    } catch (e: IOException) {}
+  }
+
+  companion object {
+    const val MAGIC = 0x4352324f // "O2RC" read as u32 LE
+    const val VERSION = 1
+    const val PLATFORM_ANDROID = 1
+    const val KIND_REALTIME = 1
+    const val KIND_FILE = 2
+    private const val FILE_HEADER = 16
+    private const val RECORD_HEADER = 12
+    private const val REALTIME_FIELDS = 8
+    private val EMPTY = ByteArray(0)
+  }
+}
@@ -0,0 +1,487 @@
+package expo.modules.viatom
+
+import android.os.SystemClock
+import java.io.Closeable
+import java.io.File
+import java.io.IOException
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.channels.FileChannel
+import java.util.Locale
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.locks.ReentrantLock
+import java.util.zip.CRC32
+import kotlin.concurrent.withLock
+
+/**
+ * Append-only journal of one ring's realtime readings, as a backup to the
+ * device's own file for overnight capture.
+ *
+ * Layout: `<dir>/<seq>.o2rj` segments, each a 32-byte header followed by
+ * fixed 16-byte records (little-endian):
+ *
+ *   header: "O2RJ" | version u8 | record size u8 | u16 0 | base epoch ms i64
+ *           | base monotonic ms i64 | seq u32 | crc32 of the preceding 28 bytes
+ *   record: t u32 (monotonic ms since the segment base) | spo2 u8 | pi u8
+ *           (tenths) | pr u16 | motion u8 | battery u8 | flags u8 | u8 0
+ *           | crc32 of the preceding 12 bytes
+ *
+ * Group commit: [append] only copies the reading into a fixed staging buffer
+ * under a short lock and never touches the disk, so it is safe on the BLE
+ * delivery thread. One committer thread swaps the buffer out, encodes it,
+ * writes it and fsyncs once for the whole batch, when [Options.commitRecords]
+ * readings are waiting or the oldest has waited [Options.commitIntervalMs].
+ * Memory is the two staging buffers plus one encode buffer; when the disk
+ * falls a whole buffer behind, new readings are dropped and counted rather
+ * than blocking the caller.
+ *
+ * A segment rotates at [Options.segmentBytes]; the oldest are deleted past
+ * [Options.maxSegments]. On open, the last segment is scanned and cut back to
+ * its last record with a valid CRC, so a crash mid-write costs at most the
+ * batch that was in flight. New data always starts a new segment.
+ */
+internal class RealtimeJournal(private val dir: File, private val options: Options = Options()) :
+        Closeable {
+  class Options(
+          val segmentBytes: Long = 1L shl 20,
+          val maxSegments: Int = 16,
+          val commitRecords: Int = 64,
+          val commitIntervalMs: Long = 1_000,
+          val bufferRecords: Int = 4_096
+  )
+
+  class Stats(
+          val appended: Long,
+          val committed: Long,
+          val dropped: Long,
+          /** Readings lost to a failed write; the next batch starts a new segment. */
+          val lost: Long,
+          val fsyncs: Long,
+          val segments: Int,
+          val recoveredRecords: Long,
+          val truncatedBytes: Long
+  )
+
+  /** Decoded readings, oldest first; `t` is epoch ms. */
+  class Columns(
+          val t: LongArray,
+          val spo2: IntArray,
+          val pr: IntArray,
+          val pi: IntArray,
+          val motion: IntArray,
+          val battery: IntArray,
+          val flags: IntArray
+  )
+
+  /** Staged readings: monotonic ms plus the record's packed fields. */
+  private class Stage(capacity: Int) {
+    val mono = LongArray(capacity)
+    val a = IntArray(capacity) // spo2 | pi << 8 | pr << 16
+    val b = IntArray(capacity) // motion | battery << 8 | flags << 16
+    var size = 0
+  }
+
+  private val lock = ReentrantLock()
+  private val wake = lock.newCondition()
+  private val committedCond = lock.newCondition()
+  private var active = Stage(options.bufferRecords)
+  private var spare = Stage(options.bufferRecords)
+  private var firstPendingAt = 0L
+  private var flushRequested = false
+  private var closing = false
+
+  // Counters are written under [lock]
+  private var appended = 0L
+  private var committed = 0L
+  private var dropped = 0L
+  private var lost = 0L
+  private var fsyncs = 0L
+  private var recoveredRecords = 0L
+  private var truncatedBytes = 0L
+
+  // Committer-thread state
+  private val encode =
+          ByteBuffer.allocate(options.bufferRecords * RECORD_BYTES).order(ByteOrder.LITTLE_ENDIAN)
+  private val crc = CRC32()
+  private var seq = 0
+  private var channel: FileChannel? = null
+  private var segmentSize = 0L
+  private var baseMono = 0L
+
+  private val committer = Thread(::commitLoop, "o2ring-journal-${dir.name}")
+
+  init {
+    dir.mkdirs()
+    recover()
+    committer.isDaemon = true
+    committer.start()
+  }
+
+  /**
+   * Stage one reading; returns false if it was dropped because the committer
+   * is a full buffer behind. Never blocks on I/O.
+   */
+  fun append(
+          monoMs: Long,
+          spo2: Int,
+          pr: Int,
+          piTenths: Int,
+          motion: Int,
+          battery: Int,
+          flags: Int
+  ): Boolean =
+          lock.withLock {
+            stage(monoMs, spo2, pr, piTenths, motion, battery, flags) || run {
+              dropped++
+              false
+            }
+          }
+
+  /** Caller holds [lock]. */
+  private fun stage(
+          monoMs: Long,
+          spo2: Int,
+          pr: Int,
+          piTenths: Int,
+          motion: Int,
+          battery: Int,
+          flags: Int
+  ): Boolean {
+    val stage = active
+    if (closing || stage.size == stage.mono.size) return false
+    val i = stage.size++
+    stage.mono[i] = monoMs
+    stage.a[i] = u8(spo2) or (u8(piTenths) shl 8) or ((pr and 0xffff) shl 16)
+    stage.b[i] = u8(motion) or (u8(battery) shl 8) or (u8(flags) shl 16)
+    appended++
+    if (i == 0) {
+      // Start the committer's interval clock
+      firstPendingAt = SystemClock.elapsedRealtime()
+      wake.signal()
+    } else if (stage.size >= options.commitRecords) {
+      wake.signal()
+    }
+    return true
+  }
+
+  /** Commit everything staged so far and wait until it is on disk. */
+  fun flush() {
+    lock.withLock {
+      val target = appended
+      flushRequested = true
+      wake.signal()
+      while (committed + lost < target && committer.isAlive) committedCond.await()
+    }
+  }
+
+  fun stats(): Stats =
+          lock.withLock {
+            Stats(
+                    appended,
+                    committed,
+                    dropped,
+                    lost,
+                    fsyncs,
+                    segmentFiles().size,
+                    recoveredRecords,
+                    truncatedBytes
+            )
+          }
+
+  /** Committed readings at or after [sinceEpochMs], across every segment. */
+  fun read(sinceEpochMs: Long = 0L): Columns {
+    var t = LongArray(1024)
+    var fields = LongArray(1024)
+    var n = 0
+    val header = ByteBuffer.allocate(HEADER_BYTES).order(ByteOrder.LITTLE_ENDIAN)
+    val chunk = ByteBuffer.allocate(READ_CHUNK).order(ByteOrder.LITTLE_ENDIAN)
+    val check = CRC32()
+    for (file in segmentFiles()) {
+      // Rotation may delete the oldest segment under us
+      val raf = runCatching { RandomAccessFile(file, "r") }.getOrNull() ?: continue
+      raf.use {
+        val ch = raf.channel
+        header.clear()
+        if (ch.read(header, 0) < HEADER_BYTES || !validHeader(header, check)) return@use
+        val baseEpoch = header.getLong(8)
+        scan(ch, chunk, check) { buf, at ->
+          val epoch = baseEpoch + (buf.getInt(at).toLong() and 0xffffffffL)
+          if (epoch >= sinceEpochMs) {
+            if (n == t.size) {
+              t = t.copyOf(n * 2)
+              fields = fields.copyOf(n * 2)
+            }
+            t[n] = epoch
+            fields[n++] = buf.getLong(at + 4)
+          }
+        }
+      }
+    }
+    return Columns(
+            t.copyOf(n),
+            IntArray(n) { (fields[it] and 0xff).toInt() },
+            IntArray(n) { ((fields[it] shr 16) and 0xffff).toInt() },
+            IntArray(n) { ((fields[it] shr 8) and 0xff).toInt() },
+            IntArray(n) { ((fields[it] shr 32) and 0xff).toInt() },
+            IntArray(n) { ((fields[it] shr 40) and 0xff).toInt() },
+            IntArray(n) { ((fields[it] shr 48) and 0xff).toInt() }
+    )
+  }
+
+  /** Commit what is staged, stop the committer and close the segment. */
+  override fun close() {
+    lock.withLock {
+      closing = true
+      wake.signal()
+    }
+    committer.join()
+  }
+
+  private fun commitLoop() {
+    try {
+      while (true) {
+        val batch =
+                lock.withLock {
+                  while (!closing && !flushRequested && !due()) {
+                    if (active.size == 0) {
+                      wake.await()
+                    } else {
+                      val waitMs =
+                              firstPendingAt + options.commitIntervalMs -
+                                      SystemClock.elapsedRealtime()
+                      if (waitMs > 0) wake.await(waitMs, TimeUnit.MILLISECONDS)
+                    }
+                  }
+                  flushRequested = false
+                  if (active.size == 0) {
+                    committedCond.signalAll()
+                    if (closing) return
+                    null
+                  } else {
+                    val full = active
+                    active = spare
+                    spare = full
+                    full
+                  }
+                }
+                        ?: continue
+        val ok =
+                try {
+                  write(batch)
+                  true
+                } catch (e: IOException) {
+                  runCatching { channel?.close() }
+                  channel = null
+                  false
+                }
+        lock.withLock {
+          if (ok) {
+            committed += batch.size
+            fsyncs++
+          } else {
+            lost += batch.size
+          }
+          batch.size = 0
+          committedCond.signalAll()
+        }
+      }
+    } finally {
+      runCatching { channel?.close() }
+      channel = null
+      lock.withLock {
+        closing = true
+        committedCond.signalAll()
+      }
+    }
+  }
+
+  private fun due() =
+          active.size >= options.commitRecords ||
+                  (active.size > 0 &&
+                          SystemClock.elapsedRealtime() - firstPendingAt >= options.commitIntervalMs)
+
+  /** Encode [stage] into segments (rotating as needed) and fsync each touched one. */
+  private fun write(stage: Stage) {
+    var i = 0
+    while (i < stage.size) {
+      val ch = channel?.takeIf { fits(stage.mono[i]) } ?: rotate(stage.mono[i])
+      encode.clear()
+      while (i < stage.size && encode.remaining() >= RECORD_BYTES && fits(stage.mono[i])) {
+        val start = encode.position()
+        encode.putInt((stage.mono[i] - baseMono).toInt())
+        encode.putInt(stage.a[i])
+        encode.putInt(stage.b[i])
+        crc.reset()
+        crc.update(encode.array(), start, 12)
+        encode.putInt(crc.value.toInt())
+        segmentSize += RECORD_BYTES
+        i++
+      }
+      encode.flip()
+      while (encode.hasRemaining()) ch.write(encode)
+      ch.force(false)
+    }
+  }
+
+  /** [mono] still belongs in the open segment: room left and t fits in u32. */
+  private fun fits(mono: Long) =
+          segmentSize + RECORD_BYTES <= options.segmentBytes && mono - baseMono in 0..0xffffffffL
+
+  private fun rotate(firstMono: Long): FileChannel {
+    channel?.let {
+      it.force(false)
+      it.close()
+    }
+    seq++
+    baseMono = firstMono
+    val baseEpoch = System.currentTimeMillis() - (SystemClock.elapsedRealtime() - firstMono)
+    val header = ByteBuffer.allocate(HEADER_BYTES).order(ByteOrder.LITTLE_ENDIAN)
+    header.putInt(MAGIC).put(VERSION).put(RECORD_BYTES.toByte()).putShort(0)
+    header.putLong(baseEpoch).putLong(firstMono).putInt(seq)
+    crc.reset()
+    crc.update(header.array(), 0, HEADER_BYTES - 4)
+    header.putInt(crc.value.toInt())
+    header.flip()
+    val ch = RandomAccessFile(File(dir, segmentName(seq)), "rw").channel
+    while (header.hasRemaining()) ch.write(header)
+    channel = ch
+    segmentSize = HEADER_BYTES.toLong()
+    val files = segmentFiles()
+    files.take(maxOf(0, files.size - options.maxSegments)).forEach { it.delete() }
+    return ch
+  }
+
+  /** Cut the newest segment back to its last valid record. */
+  private fun recover() {
+    val files = segmentFiles()
+    seq = files.lastOrNull()?.let { seqOf(it) } ?: 0
+    val last = files.lastOrNull() ?: return
+    val header = ByteBuffer.allocate(HEADER_BYTES).order(ByteOrder.LITTLE_ENDIAN)
+    RandomAccessFile(last, "rw").use { raf ->
+      val ch = raf.channel
+      val size = ch.size()
+      if (ch.read(header, 0) < HEADER_BYTES || !validHeader(header, crc)) {
+        truncatedBytes += size
+        raf.close()
+        last.delete()
+        return
+      }
+      val pos = scan(ch, encode, crc) { _, _ -> recoveredRecords++ }
+      if (pos < size) {
+        truncatedBytes += size - pos
+        ch.truncate(pos)
+        ch.force(true)
+      }
+    }
+  }
+
+  /**
+   * Visit records from the header on, stopping at the first short or corrupt
+   * one. [chunk] is reused; returns the offset just past the last good record.
+   */
+  private inline fun scan(
+          ch: FileChannel,
+          chunk: ByteBuffer,
+          check: CRC32,
+          visit: (ByteBuffer, Int) -> Unit
+  ): Long {
+    var pos = HEADER_BYTES.toLong()
+    while (true) {
+      chunk.clear()
+      val got = ch.read(chunk, pos)
+      var at = 0
+      while (at + RECORD_BYTES <= got) {
+        check.reset()
+        check.update(chunk.array(), at, 12)
+        if (check.value.toInt() != chunk.getInt(at + 12)) return pos + at
+        visit(chunk, at)
+        at += RECORD_BYTES
+      }
+      pos += at
+      if (got < chunk.capacity()) return pos
+    }
+  }
+
+  private fun segmentFiles(): List<File> =
+          (dir.listFiles { f -> f.name.endsWith(SUFFIX) } ?: emptyArray()).sortedBy { seqOf(it) }
+
+  companion object {
+    const val HEADER_BYTES = 32
+    const val RECORD_BYTES = 16
+    private const val READ_CHUNK = 4_096 * RECORD_BYTES
+    private const val MAGIC = 0x4a52324f // "O2RJ" read as u32 LE
+    private const val VERSION: Byte = 1
+    private const val SUFFIX = ".o2rj"
+
+    /** Flag bits. */
+    const val FLAG_PROBE_ON = 1
+
+    private fun u8(v: Int) = v.coerceIn(0, 255)
+
+    private fun segmentName(seq: Int) = String.format(Locale.ROOT, "%08d%s", seq, SUFFIX)
+
+    private fun seqOf(file: File) = file.name.removeSuffix(SUFFIX).toIntOrNull() ?: 0
+
+    private fun validHeader(header: ByteBuffer, crc: CRC32): Boolean {
+      if (header.getInt(0) != MAGIC || header.get(4) != VERSION) return false
+      if (header.get(5).toInt() != RECORD_BYTES) return false
+      crc.reset()
+      crc.update(header.array(), 0, HEADER_BYTES - 4)
+      return crc.value.toInt() == header.getInt(HEADER_BYTES - 4)
+    }
+
+
+    class BenchResult(
+            val commitRecords: Int,
+            val records: Int,
+            val fsyncs: Long,
+            val wallMs: Double,
+            val recordsPerSec: Double,
+            val meanBatch: Double,
+            val dropped: Long
+    )
+
+    /**
+     * Group-commit throughput: [records] readings appended as fast as the
+     * caller can, committed at least every [commitRecords]. Small batches are
+     * bound by fsync latency; the mean batch shows how much the committer
+     * coalesced on its own while an fsync was in flight.
+     */
+    fun benchmark(scratch: File, records: Int, commitRecords: Int): BenchResult {
+      scratch.deleteRecursively()
+      val journal =
+              RealtimeJournal(
+                      scratch,
+                      Options(
+                              segmentBytes = 8L shl 20,
+                              maxSegments = Int.MAX_VALUE,
+                              commitRecords = commitRecords,
+                              commitIntervalMs = 60_000
+                      )
+              )
+      val start = System.nanoTime()
+      val mono = SystemClock.elapsedRealtime()
+      for (i in 0 until records) {
+        // Staging buffer full: back off instead of measuring drops
+        while (!journal.lock.withLock { journal.stage(mono + i, 95, 60, 25, 0, 80, FLAG_PROBE_ON) }) {
+          Thread.yield()
+        }
+      }
+      journal.flush()
+      val wallMs = (System.nanoTime() - start) / 1e6
+      val stats = journal.stats()
+      journal.close()
+      scratch.deleteRecursively()
+      return BenchResult(
+              commitRecords,
+              records,
+              stats.fsyncs,
+              wallMs,
+              records * 1000.0 / wallMs,
+              records.toDouble() / maxOf(1L, stats.fsyncs),
+              stats.dropped
+      )
+    }
+  }
+}
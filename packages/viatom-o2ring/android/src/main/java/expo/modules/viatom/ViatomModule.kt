@@ -3,14 +3,19 @@ package expo.modules.viatom
 import android.Manifest
 import android.app.Activity
 import android.bluetooth.BluetoothDevice
+import android.content.Context
+import android.content.pm.ApplicationInfo
 import android.content.pm.PackageManager
+import android.os.Build
 import android.os.Handler
 import android.os.Looper
+import android.os.SystemClock
 import android.util.Log
 import androidx.core.app.ActivityCompat
 import androidx.core.content.ContextCompat
 import androidx.lifecycle.Observer
 import com.jeremyliao.liveeventbus.LiveEventBus
+import com.jeremyliao.liveeventbus.core.Delivery
 import com.jeremyliao.liveeventbus.utils.AppUtils
 import com.lepu.blepro.constants.Ble
 import com.lepu.blepro.event.EventMsgConst
@@ -25,6 +30,9 @@ import expo.modules.kotlin.events.EventEmitter
 import expo.modules.kotlin.exception.CodedException
 import expo.modules.kotlin.modules.Module
 import expo.modules.kotlin.modules.ModuleDefinition
+import java.io.File
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.Executor
 import kotlin.math.roundToInt
 
 class ViatomModule : Module() {
@@ -36,12 +44,61 @@ class ViatomModule : Module() {
   // Remember any scanned devices by MAC
   private val foundDevices = mutableMapOf<String, Bluetooth>()
 
-  private var connectedModel: Int? = null
-  private var connectedMac: String? = null
+  // One session per ring, by MAC. The SDK keeps a single interface per model,
+  // so rings of the same model take turns on it: a command for a ring that is
+  // not attached swaps it in (disconnect the current one, connect this one) and
+  // runs once the ring is ready. src/Sessions.ts schedules commands fairly.
+  private val sessions = ConcurrentHashMap<String, DeviceSession>()
+
+  // model -> MAC of the session currently attached to the SDK
+  private val attached = ConcurrentHashMap<Int, String>()
+
+  // model -> session to connect once the ring being swapped out has disconnected
+  private val swapping = ConcurrentHashMap<Int, DeviceSession>()
+
+  // Ring used when JS does not pass a MAC (single-device callers)
+  @Volatile private var defaultMac: String? = null
 
   // Keep references so observers can be removed cleanly
   private val liveObservers = mutableListOf<LiveObserver<*>>()
 
+  // Link state machine timers
+  private val mainHandler = Handler(Looper.getMainLooper())
+
+  // Realtime journals by MAC, opened on a ring's first sample while journaling is on
+  @Volatile private var journaling = false
+  private val journals = ConcurrentHashMap<String, RealtimeJournal>()
+  // Held while a journal is opened, so one directory never has two open at once
+  private val journalOpen = Any()
+
+  // Packet captures by MAC, one file per ring per capture session (see PacketCapture)
+  @Volatile private var capturing = false
+  private val captures = ConcurrentHashMap<String, PacketCapture>()
+
+  // Alarm thresholds shared by every ring; null while alarms are off
+  @Volatile private var alarmConfig: DesatAlarm.Config? = null
+
+  // While alarms are armed, keep realtime flowing without JS: ask any syncing
+  // ring that is idle and has not sent a sample for ALARM_SAMPLE_MS.
+  private val alarmPump =
+          object : Runnable {
+            override fun run() {
+              if (alarmConfig == null) return
+              val now = SystemClock.elapsedRealtime()
+              sessions.values.forEach {
+                if (it.link.state == LinkStateMachine.State.SYNCING &&
+                                it.ready &&
+                                !it.reading &&
+                                attached[it.model] == it.mac &&
+                                now - it.lastSampleAt >= ALARM_SAMPLE_MS
+                ) {
+                  BleServiceHelper.BleServiceHelper.oxyGetRtParam(it.model)
+                }
+              }
+              mainHandler.postDelayed(this, ALARM_SAMPLE_MS)
+            }
+          }
+
   override fun definition() = ModuleDefinition {
     Name("Viatom")
 
@@ -49,11 +106,14 @@ class ViatomModule : Module() {
             "onDeviceFound", // { mac, name, model }
             "onConnected", // { mac, model }
             "onDisconnected", // { mac?, model?, reason? }
-            "onRealtime", // { spo2, pr, pi, motion, ts }
-            "onInfo", // { battery, state, files }
-            "onHistoryFile", // { csv, startTime }
-            "onReadProgress", // { progress }
-            "onError" // { code, message }
+            "onServiceReady", // { mac }
+            "onLinkState", // { mac, state, from, elapsedMs, attempts, reason?, firstSampleMs? }
+            "onRealtime", // { mac, spo2, pr, pi, motion, ts }
+            "onInfo", // { mac, battery, state, files }
+            "onHistoryFile", // { mac, csv, startTime, bytes, firstFileMs? }
+            "onReadProgress", // { mac, progress, ts }
+            "onAlarm", // { mac, kind, raised, value, nadir, durationMs, latencyMs, notified, ts }
+            "onError" // { mac?, code, message }
     )
 
     OnStartObserving { emitter = appContext.eventEmitter(this@ViatomModule) }
@@ -61,7 +121,12 @@ class ViatomModule : Module() {
       emitter = null
       clearObservers()
     }
-    OnDestroy { clearObservers() }
+    OnDestroy {
+      mainHandler.removeCallbacks(alarmPump)
+      closeJournals()
+      closeCaptures()
+      clearObservers()
+    }
 
     // ------------- BASIC FUNCTIONS EXPOSED TO JS -------------
 
@@ -95,6 +160,7 @@ class ViatomModule : Module() {
       ensureServiceInitialized()
       subscribeIfNeeded()
       foundDevices.clear()
+      ViatomTrace.instant("scan.start")
       BleServiceHelper.BleServiceHelper.startScan()
       true
     }
@@ -105,65 +171,211 @@ class ViatomModule : Module() {
       true
     }
 
-    // 5) Connect by MAC + model
+    // 5) Connect by MAC + model (opens a session; several rings can be open)
     AsyncFunction("connect") { mac: String, _: Int ->
       ensureServiceInitialized()
       subscribeIfNeeded()
 
-      val act = appContext.activityProvider?.currentActivity ?: throw CodedException("NO_ACTIVITY")
+      if (appContext.activityProvider?.currentActivity == null) throw CodedException("NO_ACTIVITY")
       val bt = foundDevices[mac] ?: throw CodedException("DEVICE_NOT_FOUND")
 
-      BleServiceHelper.BleServiceHelper.setInterfaces(bt.model)
-      BleServiceHelper.BleServiceHelper.connect(act.applicationContext, bt.model, bt.device)
-
-      connectedModel = bt.model
-      connectedMac = mac
+      val session =
+              sessions.getOrPut(mac) {
+                DeviceSession(mac, bt).also {
+                  it.link = linkFor(it)
+                  it.alarmListener = alarmListenerFor(it)
+                }
+              }
+      defaultMac = mac
+      if (session.link.state == LinkStateMachine.State.DISCONNECTED) session.link.start()
+      attach(session)
 
       true
     }
 
-    // 6) Disconnect current device
-    AsyncFunction("disconnect") {
-      val model = connectedModel
-      if (model != null) {
-        BleServiceHelper.BleServiceHelper.disconnect(model, false)
-      } else {
-        BleServiceHelper.BleServiceHelper.disconnect(false)
+    // 6) Disconnect one ring (or the default one) and close its session
+    AsyncFunction("disconnect") { mac: String? ->
+      val session = (mac ?: defaultMac)?.let { sessions.remove(it) }
+      if (session == null) {
+        if (mac == null) BleServiceHelper.BleServiceHelper.disconnect(false)
+        return@AsyncFunction true
+      }
+      if (defaultMac == session.mac) defaultMac = null
+      session.pending.clear()
+      session.link.stop("closed")
+      if (attached.remove(session.model, session.mac)) {
+        BleServiceHelper.BleServiceHelper.disconnect(session.model, false)
       }
       true
     }
 
     // 7) Start realtime param stream (SpO2, PR, PI, motion)
-    AsyncFunction("startRealtime") {
-      val model = connectedModel ?: throw CodedException("NO_DEVICE_CONNECTED")
+    AsyncFunction("startRealtime") { mac: String? ->
+      runCommand(mac) { BleServiceHelper.BleServiceHelper.oxyGetRtParam(it.model) }
+      true
+    }
 
-      BleServiceHelper.BleServiceHelper.oxyGetRtParam(model)
+    AsyncFunction("stopRealtime") { _: String? ->
+      // For Oxy devices stopping realtime is usually handled by the SDK.
       true
     }
 
-    AsyncFunction("stopRealtime") {
-      val model = connectedModel
-      if (model != null) {
-        // For Oxy devices stopping realtime is usually handled by the SDK.
+    // 8) Explicitly fetch device info (includes file list) after connecting
+    AsyncFunction("getInfo") { mac: String? ->
+      runCommand(mac) { requestInfo(it) }
+      true
+    }
+
+    // 9) Read one history file by name (you get filenames from onInfo.files)
+    AsyncFunction("readHistoryFile") { filename: String, mac: String? ->
+      runCommand(mac) {
+        it.readSpan = ViatomTrace.begin()
+        it.reading = true
+        it.readName = filename
+        BleServiceHelper.BleServiceHelper.oxyReadFile(it.model, filename)
       }
       true
     }
 
-    // 8) Explicitly fetch device info (includes file list) after connecting
-    AsyncFunction("getInfo") {
-      val model = connectedModel ?: throw CodedException("NO_DEVICE_CONNECTED")
+    // Arm (or with null, disarm) the native alarms; see DesatAlarm. Resolves
+    // false when the app may not post notifications, so JS can explain why.
+    AsyncFunction("setAlarmConfig") { config: Map<String, Any?>? ->
+      mainHandler.removeCallbacks(alarmPump)
+      alarmConfig = config?.let { parseAlarmConfig(it) }
+      if (alarmConfig == null) {
+        sessions.values.forEach { it.alarm.reset() }
+        return@AsyncFunction true
+      }
+      mainHandler.post(alarmPump)
+      val act = appContext.activityProvider?.currentActivity
+      if (act != null &&
+                      Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU &&
+                      ContextCompat.checkSelfPermission(act, Manifest.permission.POST_NOTIFICATIONS) !=
+                              PackageManager.PERMISSION_GRANTED
+      ) {
+        ActivityCompat.requestPermissions(
+                act,
+                arrayOf(Manifest.permission.POST_NOTIFICATIONS),
+                1235
+        )
+        return@AsyncFunction false
+      }
+      true
+    }
 
-      requestInfo(model)
+    // Record every realtime sample to a crash-safe per-ring journal (see RealtimeJournal)
+    AsyncFunction("setJournaling") { enabled: Boolean ->
+      journaling = enabled
+      if (!enabled) closeJournals()
       true
     }
 
-    // 9) Read one history file by name (you get filenames from onInfo.files)
-    AsyncFunction("readHistoryFile") { filename: String ->
-      val model = connectedModel ?: throw CodedException("NO_DEVICE_CONNECTED")
+    // Committed journal readings for one ring, as columns; t is epoch ms
+    AsyncFunction("readJournal") { mac: String, sinceMs: Double? ->
+      val context = appContext.reactContext ?: throw CodedException("NO_APPLICATION")
+      val since = sinceMs?.toLong() ?: 0L
+      // Read through the live journal while the ring streams; a temporary one
+      // would run recovery against the file the live one is appending to
+      val c =
+              synchronized(journalOpen) {
+                journals[mac]?.let {
+                  it.flush()
+                  it.read(since)
+                }
+                        ?: RealtimeJournal(journalDir(context, mac)).use { it.read(since) }
+              }
+      mapOf(
+              "t" to c.t.map { it.toDouble() },
+              "spo2" to c.spo2.toList(),
+              "pr" to c.pr.toList(),
+              "pi" to c.pi.toList(),
+              "motion" to c.motion.toList(),
+              "battery" to c.battery.toList(),
+              "flags" to c.flags.toList()
+      )
+    }
+
+    AsyncFunction("getJournalStats") {
+      journals.map { (mac, journal) ->
+        val s = journal.stats()
+        mapOf(
+                "mac" to mac,
+                "appended" to s.appended.toDouble(),
+                "committed" to s.committed.toDouble(),
+                "dropped" to s.dropped.toDouble(),
+                "lost" to s.lost.toDouble(),
+                "fsyncs" to s.fsyncs.toDouble(),
+                "segments" to s.segments,
+                "recoveredRecords" to s.recoveredRecords.toDouble(),
+                "truncatedBytes" to s.truncatedBytes.toDouble()
+        )
+      }
+    }
+
+    // Group-commit throughput on this device's storage, one run per batch size
+    AsyncFunction("benchmarkJournal") { records: Int ->
+      val context = appContext.reactContext ?: throw CodedException("NO_APPLICATION")
+      JOURNAL_BENCH_BATCHES.map {
+        val r = RealtimeJournal.benchmark(File(context.cacheDir, "o2ring-journal-bench"), records, it)
+        mapOf(
+                "commitRecords" to r.commitRecords,
+                "records" to r.records,
+                "fsyncs" to r.fsyncs.toDouble(),
+                "wallMs" to r.wallMs,
+                "recordsPerSec" to r.recordsPerSec,
+                "meanBatch" to r.meanBatch
+        )
+      }
+    }
 
-      BleServiceHelper.BleServiceHelper.oxyReadFile(model, filename)
+    // Record what the rings send for replay off-device (src/Capture.ts);
+    // turning it off closes the files
+    AsyncFunction("setCapture") { enabled: Boolean ->
+      capturing = enabled
+      if (!enabled) closeCaptures()
       true
     }
+
+    // Capture files on disk, oldest first
+    AsyncFunction("listCaptures") {
+      val context = appContext.reactContext ?: throw CodedException("NO_APPLICATION")
+      File(context.filesDir, "o2ring-capture")
+              .walkTopDown()
+              .filter { it.isFile && it.name.endsWith(".o2rc") }
+              .sortedBy { it.name }
+              .map {
+                mapOf(
+                        "mac" to it.parentFile?.name?.replace('-', ':'),
+                        "path" to it.absolutePath,
+                        "bytes" to it.length().toDouble()
+                )
+              }
+              .toList()
+    }
+
+    // Open sessions, for the multi-device manager
+    AsyncFunction("getSessions") {
+      sessions.values.map {
+        mapOf(
+                "mac" to it.mac,
+                "model" to it.model,
+                "attached" to (attached[it.model] == it.mac),
+                "ready" to it.ready,
+                "pending" to it.pending.size,
+                "state" to it.link.state.wire,
+                "firstSampleMs" to it.link.firstSampleMs.takeIf { ms -> ms >= 0 },
+                "firstFileMs" to it.link.firstFileMs.takeIf { ms -> ms >= 0 }
+        )
+      }
+    }
+
+    // 10) Native pipeline tracing (see ViatomTrace / src/Trace.ts)
+    AsyncFunction("setTracing") { enabled: Boolean ->
+      ViatomTrace.enabled = enabled
+      true
+    }
+
+    AsyncFunction("drainTrace") { ViatomTrace.drain() }
   }
 
   // --------------------------------
@@ -175,6 +387,7 @@ class ViatomModule : Module() {
       val device: BluetoothDevice = bt.device
       val mac = device.address ?: return@addObserver
       foundDevices[mac] = bt
+      ViatomTrace.instant("scan.deviceFound")
 
       emitter?.emit(
               "onDeviceFound",
@@ -196,11 +409,23 @@ class ViatomModule : Module() {
       }
     }
 
-    // Device is ready to receive commands; trigger info fetch so history downloads can start.
-    addObserver("com.lepu.ble.device.ready", Any::class.java) {
-      val model = connectedModel
-      if (model != null) {
-        requestInfo(model)
+    // Device is ready to receive commands. The SDK reports link-up, service
+    // discovery and interface init as this one event, so a new ring goes from
+    // connecting straight to info. A ring swapped back in resumes its bring-up
+    // (if any) and runs what was queued while it was detached.
+    addObserver("com.lepu.ble.device.ready", Any::class.java) { data ->
+      val session = sessionFor(data as? Int) ?: return@addObserver
+      ViatomTrace.end("connect", session.connectSpan)
+      session.connectSpan = 0L
+      session.connecting = false
+      session.ready = true
+      emit(session, "onServiceReady", emptyMap())
+      if (!session.link.advance(LinkStateMachine.State.CONNECTING, LinkStateMachine.State.INFO)) {
+        session.link.nudge(session.link.state)
+      }
+      while (session.ready) {
+        val command = session.pending.pollFirst() ?: break
+        command(session)
       }
     }
   }
@@ -214,16 +439,59 @@ class ViatomModule : Module() {
       val data = evt.data as? Array<*>
       Log.d("ViatomModule", "EventOxySyncDeviceInfo model=$model data=${data?.joinToString()}")
 
-      // When the SDK says "SetTIME"/ready, request full device info
-      if (model == connectedModel) {
-        requestInfo(model)
-      }
+      // The ring has synced its clock and answers info now; re-ask at once
+      // instead of waiting out the info timeout.
+      sessionFor(model)?.link?.nudge(LinkStateMachine.State.INFO)
     }
 
     // 1. Real-time param data (SpO2, PR, PI, motion)
-    addObserver(InterfaceEvent.Oxy.EventOxyRtParamData, InterfaceEvent::class.java) { evt ->
+    addObserver(
+            InterfaceEvent.Oxy.EventOxyRtParamData,
+            InterfaceEvent::class.java,
+            Delivery.background()
+    ) { evt ->
       val d = evt.data as RtParam
-      emitter?.emit(
+      val session = sessionFor(evt.model) ?: return@addObserver
+      session.lastSampleAt = SystemClock.elapsedRealtime()
+      if (session.link.awaitingSample()) session.link.sampleArrived()
+      // Alarms first: the JS emit below may queue behind a busy bridge
+      alarmConfig?.let {
+        session.alarm.onSample(
+                it,
+                session.lastSampleAt,
+                d.spo2,
+                d.pr,
+                d.vector,
+                d.state == 1,
+                session.alarmListener
+        )
+      }
+      if (journaling) {
+        journalFor(session.mac)
+                ?.append(
+                        session.lastSampleAt,
+                        d.spo2,
+                        d.pr,
+                        (d.pi * 10).roundToInt(),
+                        d.vector,
+                        d.battery,
+                        if (d.state == 1) RealtimeJournal.FLAG_PROBE_ON else 0
+                )
+      }
+      if (capturing) {
+        captureFor(session.mac)
+                ?.realtime(
+                        session.lastSampleAt,
+                        d.spo2,
+                        d.pr,
+                        (d.pi * 10).roundToInt(),
+                        d.vector,
+                        d.battery,
+                        if (d.state == 1) RealtimeJournal.FLAG_PROBE_ON else 0
+                )
+      }
+      emit(
+              session,
               "onRealtime",
               mapOf(
                       "spo2" to d.spo2,
@@ -238,6 +506,9 @@ class ViatomModule : Module() {
     // 2. Device info (battery, state, file list)
     addObserver(InterfaceEvent.Oxy.EventOxyInfo, InterfaceEvent::class.java) { evt ->
       val info = evt.data as DeviceInfo
+      val session = sessionFor(evt.model) ?: return@addObserver
+      ViatomTrace.end("getInfo", session.infoSpan)
+      session.infoSpan = 0L
       // Trim any whitespace so file names match what the device expects when requesting downloads.
       val list = info.fileList.split(",").map { it.trim() }.filter { it.isNotBlank() }
 
@@ -257,48 +528,108 @@ class ViatomModule : Module() {
               "EventOxyInfo batteryValue=${info.batteryValue} batteryState=${info.batteryState} state=${info.curState} files=${list.size}"
       )
 
-      emitter?.emit("onInfo", payload)
-
-      // Optional: auto start realtime after info
-      val model = connectedModel
-      if (model != null) {
-        BleServiceHelper.BleServiceHelper.oxyGetRtParam(model)
-      }
+      emit(session, "onInfo", payload)
+      session.link.advance(LinkStateMachine.State.INFO, LinkStateMachine.State.REALTIME)
     }
 
     // 3. Read file progress
-    addObserver(InterfaceEvent.Oxy.EventOxyReadingFileProgress, InterfaceEvent::class.java) { evt ->
+    addObserver(
+            InterfaceEvent.Oxy.EventOxyReadingFileProgress,
+            InterfaceEvent::class.java,
+            Delivery.background()
+    ) { evt ->
       val progress = evt.data as Int
-      emitter?.emit("onReadProgress", mapOf("progress" to progress))
+      val session = sessionFor(evt.model) ?: return@addObserver
+      emit(
+              session,
+              "onReadProgress",
+              mapOf("progress" to progress, "ts" to System.currentTimeMillis().toDouble())
+      )
     }
 
-    // 4. Read file complete
-    addObserver(InterfaceEvent.Oxy.EventOxyReadFileComplete, InterfaceEvent::class.java) { evt ->
+    // 4. Read file complete (CSV conversion runs on the LiveEventBus background thread)
+    addObserver(
+            InterfaceEvent.Oxy.EventOxyReadFileComplete,
+            InterfaceEvent::class.java,
+            Delivery.background()
+    ) { evt ->
       val file = evt.data as OxyFile
-      val csv = convertOxyFileToCsv(file)
+      val session = sessionFor(evt.model) ?: return@addObserver
+      ViatomTrace.end("readFile", session.readSpan)
+      session.readSpan = 0L
+      session.reading = false
+      if (capturing) {
+        captureFor(session.mac)
+                ?.file(
+                        SystemClock.elapsedRealtime(),
+                        session.readName ?: file.startTime.toString(),
+                        file.bytes ?: ByteArray(0)
+                )
+      }
+      val csv = ViatomTrace.span("decode") { convertOxyFileToCsv(file) }
+      val firstFileMs = session.link.fileArrived()
 
-      emitter?.emit("onHistoryFile", mapOf("csv" to csv, "startTime" to file.startTime))
+      emit(
+              session,
+              "onHistoryFile",
+              mapOf(
+                      "csv" to csv,
+                      "startTime" to file.startTime,
+                      "bytes" to (file.bytes?.size ?: 0),
+                      "firstFileMs" to firstFileMs.takeIf { it >= 0 }
+              )
+      )
     }
 
     // 5. Read file error
-    addObserver(InterfaceEvent.Oxy.EventOxyReadFileError, InterfaceEvent::class.java) { evt ->
+    addObserver(
+            InterfaceEvent.Oxy.EventOxyReadFileError,
+            InterfaceEvent::class.java,
+            Delivery.background()
+    ) { evt ->
       val failed = evt.data as Boolean
       if (failed) {
-        emitter?.emit(
+        val session = sessionFor(evt.model) ?: return@addObserver
+        ViatomTrace.end("readFile.error", session.readSpan)
+        session.readSpan = 0L
+        session.reading = false
+        emit(
+                session,
                 "onError",
                 mapOf("code" to "READ_FILE_ERROR", "message" to "Failed to read history file")
         )
       }
     }
 
-    // 6. Disconnect reason
+    // 6. Disconnect reason. The event carries no model, so ask the SDK which
+    // interface dropped. A ring swapped out for another keeps its session.
     addObserver(EventMsgConst.Ble.EventBleDeviceDisconnectReason, Int::class.java) { reason ->
-      emitter?.emit(
-              "onDisconnected",
-              mapOf("reason" to reason, "mac" to connectedMac, "model" to connectedModel)
-      )
-      connectedModel = null
-      connectedMac = null
+      ViatomTrace.instant("disconnect")
+      for ((model, next) in swapping) {
+        if (BleServiceHelper.BleServiceHelper.getConnectState(model) == Ble.State.CONNECTED) continue
+        swapping.remove(model, next)
+        if (attached[model] == next.mac) connectNow(next)
+        return@addObserver
+      }
+      val dropped =
+              sessions.values.filter {
+                (it.ready || it.connecting) &&
+                        BleServiceHelper.BleServiceHelper.getConnectState(it.model) !=
+                                Ble.State.CONNECTED
+              }
+      if (dropped.isEmpty()) {
+        emitter?.emit("onDisconnected", mapOf("reason" to reason))
+      }
+      dropped.forEach { session ->
+        session.link.stop("link lost")
+        sessions.remove(session.mac, session)
+        attached.remove(session.model, session.mac)
+        if (defaultMac == session.mac) defaultMac = null
+        emitter?.emit(
+                "onDisconnected",
+                mapOf("reason" to reason, "mac" to session.mac, "model" to session.model)
+        )
+      }
     }
   }
 
@@ -376,6 +707,9 @@ class ViatomModule : Module() {
 
     // LiveEventBus needs Application set explicitly (we removed reflection fallback)
     AppUtils.init(app)
+    // Per-post logging builds strings on the SDK's realtime path; keep it to debug builds.
+    LiveEventBus.config()
+            .enableLogger((app.applicationInfo.flags and ApplicationInfo.FLAG_DEBUGGABLE) != 0)
 
     BleServiceHelper.BleServiceHelper.initService(app)
     serviceInitialized = true
@@ -396,7 +730,9 @@ class ViatomModule : Module() {
                   Manifest.permission.ACCESS_COARSE_LOCATION
           )
 
-  private fun requestInfo(model: Int) {
+  private fun requestInfo(session: DeviceSession) {
+    val model = session.model
+    if (session.infoSpan == 0L) session.infoSpan = ViatomTrace.begin()
     try {
       BleServiceHelper.BleServiceHelper.oxyGetInfo(model)
     } catch (e: Exception) {
@@ -409,10 +745,258 @@ class ViatomModule : Module() {
     }
   }
 
-  private fun <T> addObserver(key: String, clazz: Class<T>, block: (T) -> Unit) {
+  /**
+   * Session an SDK event belongs to: the ring attached for [model], or the only
+   * attached ring when the event does not say.
+   */
+  private fun sessionFor(model: Int?): DeviceSession? {
+    val mac = if (model != null) attached[model] else attached.values.singleOrNull()
+    return mac?.let { sessions[it] }
+  }
+
+  /** Run [command] on the ring once it owns the SDK, attaching it if needed. */
+  private fun runCommand(mac: String?, command: (DeviceSession) -> Unit) {
+    val session =
+            (mac ?: defaultMac)?.let { sessions[it] } ?: throw CodedException("NO_DEVICE_CONNECTED")
+    if (session.ready && attached[session.model] == session.mac) {
+      command(session)
+      return
+    }
+    session.pending.addLast(command)
+    attach(session)
+  }
+
+  private fun attach(session: DeviceSession) {
+    val model = session.model
+    val current = attached.put(model, session.mac)
+    if (current == session.mac && (session.ready || session.connecting || swapping[model] == session)) {
+      return
+    }
+    session.ready = false
+    if (current != null && current != session.mac) {
+      sessions[current]?.ready = false
+      swapping[model] = session
+      BleServiceHelper.BleServiceHelper.disconnect(model, false)
+      return
+    }
+    connectNow(session)
+  }
+
+  private fun connectNow(session: DeviceSession) {
+    val context =
+            appContext.reactContext?.applicationContext
+                    ?: appContext.activityProvider?.currentActivity?.applicationContext
+                            ?: throw CodedException("NO_APPLICATION")
+    session.connecting = true
+    session.connectSpan = ViatomTrace.begin()
+    BleServiceHelper.BleServiceHelper.setInterfaces(session.model)
+    BleServiceHelper.BleServiceHelper.connect(context, session.model, session.bt.device)
+  }
+
+  /**
+   * Bring-up policy for one ring. Commands only go out while the ring owns the
+   * SDK; a ring swapped out mid bring-up is nudged again on its next ready.
+   */
+  private fun linkFor(session: DeviceSession): LinkStateMachine {
+    val owns = { attached[session.model] == session.mac && session.ready }
+    return LinkStateMachine(mainHandler) { t ->
+              ViatomTrace.instant("link.${t.to.wire}")
+              val payload =
+                      mutableMapOf<String, Any?>(
+                              "state" to t.to.wire,
+                              "from" to t.from.wire,
+                              "elapsedMs" to t.elapsedMs,
+                              "attempts" to t.attempts,
+                              "reason" to t.reason
+                      )
+              if (t.to == LinkStateMachine.State.SYNCING && session.link.firstSampleMs >= 0) {
+                payload["firstSampleMs"] = session.link.firstSampleMs
+              }
+              emit(session, "onLinkState", payload)
+            }
+            .configure(
+                    LinkStateMachine.State.CONNECTING,
+                    LinkStateMachine.Step(
+                            CONNECT_TIMEOUT_MS,
+                            2,
+                            { attempt ->
+                              if (attempt > 1 && attached[session.model] == session.mac) {
+                                connectNow(session)
+                              }
+                            },
+                            {
+                              emit(
+                                      session,
+                                      "onError",
+                                      mapOf(
+                                              "code" to "CONNECT_TIMEOUT",
+                                              "message" to "Ring did not become ready"
+                                      )
+                              )
+                              closeSession(session, "connect timeout")
+                            }
+                    )
+            )
+            .configure(
+                    LinkStateMachine.State.INFO,
+                    LinkStateMachine.Step(
+                            INFO_TIMEOUT_MS,
+                            3,
+                            { if (owns()) requestInfo(session) },
+                            {
+                              emit(
+                                      session,
+                                      "onError",
+                                      mapOf("code" to "INFO_TIMEOUT", "message" to "No device info")
+                              )
+                              session.link.advance(
+                                      LinkStateMachine.State.INFO,
+                                      LinkStateMachine.State.REALTIME,
+                                      "info timeout"
+                              )
+                            }
+                    )
+            )
+            .configure(
+                    LinkStateMachine.State.REALTIME,
+                    LinkStateMachine.Step(
+                            REALTIME_TIMEOUT_MS,
+                            3,
+                            { if (owns()) BleServiceHelper.BleServiceHelper.oxyGetRtParam(session.model) },
+                            {
+                              emit(
+                                      session,
+                                      "onError",
+                                      mapOf(
+                                              "code" to "REALTIME_TIMEOUT",
+                                              "message" to "No realtime sample"
+                                      )
+                              )
+                              session.link.advance(
+                                      LinkStateMachine.State.REALTIME,
+                                      LinkStateMachine.State.SYNCING,
+                                      "realtime timeout"
+                              )
+                            }
+                    )
+            )
+  }
+
+  /**
+   * Runs on the realtime delivery thread. The notification is posted before
+   * anything is sent to JS; latencyMs is measured from the sample's arrival.
+   */
+  private fun alarmListenerFor(session: DeviceSession) =
+          DesatAlarm.Listener { kind, raised, value, nadir, durationMs ->
+            val span = ViatomTrace.begin()
+            val context = appContext.reactContext?.applicationContext
+            var notified = false
+            if (context != null) {
+              if (raised) {
+                notified = AlarmNotifier.show(context, session.mac, kind, value, nadir)
+              } else {
+                AlarmNotifier.cancel(context, session.mac, kind)
+              }
+            }
+            ViatomTrace.end("alarm.${kind.wire}", span)
+            emit(
+                    session,
+                    "onAlarm",
+                    mapOf(
+                            "kind" to kind.wire,
+                            "raised" to raised,
+                            "value" to value,
+                            "nadir" to nadir,
+                            "durationMs" to durationMs,
+                            "latencyMs" to SystemClock.elapsedRealtime() - session.lastSampleAt,
+                            "notified" to notified,
+                            "ts" to System.currentTimeMillis()
+                    )
+            )
+          }
+
+  private fun journalFor(mac: String): RealtimeJournal? {
+    journals[mac]?.let {
+      return it
+    }
+    val context = appContext.reactContext ?: return null
+    // Waits out a readJournal that has the same directory open
+    return synchronized(journalOpen) {
+      journals.getOrPut(mac) { RealtimeJournal(journalDir(context, mac)) }
+    }
+  }
+
+  private fun journalDir(context: Context, mac: String) =
+          File(context.filesDir, "o2ring-journal/${mac.replace(':', '-')}")
+
+  private fun closeJournals() {
+    journals.keys.forEach { mac -> journals.remove(mac)?.close() }
+  }
+
+  private fun captureFor(mac: String): PacketCapture? {
+    captures[mac]?.let {
+      return it
+    }
+    val context = appContext.reactContext ?: return null
+    return captures.computeIfAbsent(mac) {
+      val dir = File(context.filesDir, "o2ring-capture/${mac.replace(':', '-')}")
+      // a capture that cannot be opened must not take the realtime path down with it
+      runCatching { PacketCapture(File(dir, "${System.currentTimeMillis()}.o2rc")) }.getOrNull()
+    }
+  }
+
+  private fun closeCaptures() {
+    captures.keys.forEach { mac -> captures.remove(mac)?.close() }
+  }
+
+  private fun parseAlarmConfig(map: Map<String, Any?>): DesatAlarm.Config {
+    val defaults = DesatAlarm.Config()
+    fun int(key: String, fallback: Int) = (map[key] as? Number)?.toInt() ?: fallback
+    fun ms(key: String, fallback: Long) = (map[key] as? Number)?.toLong() ?: fallback
+    return DesatAlarm.Config(
+            spo2Low = int("spo2Low", defaults.spo2Low),
+            spo2Hysteresis = int("spo2Hysteresis", defaults.spo2Hysteresis),
+            prLow = int("prLow", defaults.prLow),
+            prHigh = int("prHigh", defaults.prHigh),
+            prHysteresis = int("prHysteresis", defaults.prHysteresis),
+            onsetMs = ms("onsetMs", defaults.onsetMs),
+            clearMs = ms("clearMs", defaults.clearMs),
+            motionMax = int("motionMax", defaults.motionMax),
+            maxGapMs = ms("maxGapMs", defaults.maxGapMs)
+    )
+  }
+
+  /** Give up on a ring: release the SDK interface and report it gone. */
+  private fun closeSession(session: DeviceSession, reason: String) {
+    session.link.stop(reason)
+    sessions.remove(session.mac, session)
+    session.pending.clear()
+    if (defaultMac == session.mac) defaultMac = null
+    if (attached.remove(session.model, session.mac)) {
+      BleServiceHelper.BleServiceHelper.disconnect(session.model, false)
+    }
+    emitter?.emit("onDisconnected", mapOf("mac" to session.mac, "model" to session.model))
+  }
+
+  /** Emit an event tagged with the session's MAC. */
+  private fun emit(session: DeviceSession, name: String, payload: Map<String, Any?>) {
+    emitter?.emit(name, payload + ("mac" to session.mac))
+  }
+
+  /**
+   * Subscribe to an SDK event. Handlers that only emit to JS (or do heavy
+   * decoding) should pass [Delivery.background] so they stay off the UI thread;
+   * the serial executor keeps their relative order.
+   */
+  private fun <T> addObserver(
+          key: String,
+          clazz: Class<T>,
+          executor: Executor = Delivery.main(),
+          block: (T) -> Unit
+  ) {
     val observer = Observer<T> { block(it) }
     runOnMain {
-      LiveEventBus.get(key, clazz).observeForever(observer)
+      LiveEventBus.get(key, clazz).observeForever(observer, executor)
       liveObservers.add(LiveObserver(key, clazz, observer))
     }
   }
@@ -428,12 +1012,48 @@ class ViatomModule : Module() {
     }
   }
 
+  private class DeviceSession(val mac: String, val bt: Bluetooth) {
+    val model: Int
+      get() = bt.model
+
+    lateinit var link: LinkStateMachine
+
+    val alarm = DesatAlarm()
+    lateinit var alarmListener: DesatAlarm.Listener
+
+    // elapsedRealtime of the last realtime sample
+    @Volatile var lastSampleAt = 0L
+    // A history file read is in flight; realtime requests would interleave with it
+    @Volatile var reading = false
+    // Name of the file being read, for captures
+    @Volatile var readName: String? = null
+
+    @Volatile var ready = false
+    @Volatile var connecting = false
+
+    // Commands issued while the ring was not attached; run on device ready
+    val pending = java.util.concurrent.ConcurrentLinkedDeque<(DeviceSession) -> Unit>()
+
+    // Open trace spans (ViatomTrace.begin() timestamps, 0 when not tracing)
+    @Volatile var connectSpan = 0L
+    @Volatile var infoSpan = 0L
+    @Volatile var readSpan = 0L
+  }
+
   private data class LiveObserver<T>(
           val key: String,
           val clazz: Class<T>,
           val observer: Observer<T>
   )
 
+  private companion object {
+    const val CONNECT_TIMEOUT_MS = 15_000L
+    const val INFO_TIMEOUT_MS = 4_000L
+    const val REALTIME_TIMEOUT_MS = 2_500L
+    const val ALARM_SAMPLE_MS = 1_000L
+    val JOURNAL_BENCH_BATCHES = listOf(1, 8, 64, 512)
+  }
+
   private fun runOnMain(block: () -> Unit) {
     if (Looper.myLooper() == Looper.getMainLooper()) {
       block()
@@ -0,0 +1,81 @@
+package expo.modules.viatom
+
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Fixed-size span ring for native pipeline tracing.
+ *
+ * Writers claim a slot with one atomic increment and fill plain arrays, so
+ * recording never locks or allocates. A span that is overwritten while being
+ * drained is simply lost; this is a diagnostics buffer, not a log.
+ */
+object ViatomTrace {
+  private const val CAPACITY = 2048 // power of two
+  private const val MASK = CAPACITY - 1
+
+  @Volatile var enabled = false
+
+  private val cursor = AtomicInteger(0)
+  private val names = arrayOfNulls<String>(CAPACITY)
+  private val cats = arrayOfNulls<String>(CAPACITY)
+  private val startNs = LongArray(CAPACITY)
+  private val durNs = LongArray(CAPACITY)
+  private val tids = LongArray(CAPACITY)
+
+  // Offset that turns System.nanoTime() into epoch microseconds, so native
+  // spans line up with the JS ring in the exported trace.
+  private val epochOffsetUs = System.currentTimeMillis() * 1000L - System.nanoTime() / 1000L
+
+  /** Start time for [end], or 0 when tracing is off. */
+  fun begin(): Long = if (enabled) System.nanoTime() else 0L
+
+  fun end(name: String, start: Long, cat: String = "native") {
+    if (start == 0L || !enabled) return
+    record(name, cat, start, System.nanoTime() - start)
+  }
+
+  fun instant(name: String, cat: String = "native") {
+    if (!enabled) return
+    record(name, cat, System.nanoTime(), 0L)
+  }
+
+  inline fun <T> span(name: String, cat: String = "native", block: () -> T): T {
+    val start = begin()
+    try {
+      return block()
+    } finally {
+      end(name, start, cat)
+    }
+  }
+
+  private fun record(name: String, cat: String, start: Long, dur: Long) {
+    val slot = cursor.getAndIncrement() and MASK
+    names[slot] = name
+    cats[slot] = cat
+    startNs[slot] = start
+    durNs[slot] = dur
+    tids[slot] = Thread.currentThread().id
+  }
+
+  /** Snapshot and clear the ring, oldest first. */
+  fun drain(): List<Map<String, Any>> {
+    val end = cursor.getAndSet(0)
+    val count = minOf(end, CAPACITY)
+    val out = ArrayList<Map<String, Any>>(count)
+    for (i in 0 until count) {
+      val slot = (end - count + i) and MASK
+      val name = names[slot] ?: continue
+      out.add(
+              mapOf(
+                      "name" to name,
+                      "cat" to (cats[slot] ?: "native"),
+                      "ts" to (epochOffsetUs + startNs[slot] / 1000L).toDouble(),
+                      "dur" to (durNs[slot] / 1000L).toDouble(),
+                      "tid" to tids[slot].toDouble()
+              )
+      )
+      names[slot] = null
+    }
+    return out
+  }
+}
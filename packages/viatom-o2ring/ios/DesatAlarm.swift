@@ -0,0 +1,205 @@
+import Foundation
+import UserNotifications
+
+/// Desaturation / pulse-rate alarms for one ring, evaluated on every realtime
+/// sample inside the VTO2Lib delegate callback, so an alarm never waits on
+/// the JS thread.
+///
+/// Each alarm is a small state machine over valid samples: raised once the
+/// value has stayed past its threshold for `onsetMs`, cleared once it has
+/// stayed back inside threshold ± hysteresis for `clearMs`; values between the
+/// two bands keep the current state. Samples with the probe off, out-of-range
+/// values or motion above `motionMax` are artifacts and neither start, advance
+/// nor clear an alarm; a run of them longer than `maxGapMs` drops a pending
+/// onset. Work per sample is constant and allocation-free.
+final class DesatAlarm {
+  struct Config {
+    /// Raise below this SpO2 (%); 0 disables.
+    var spo2Low = 88
+    var spo2Hysteresis = 2
+    /// Raise below / above these pulse rates (bpm); 0 disables.
+    var prLow = 40
+    var prHigh = 130
+    var prHysteresis = 5
+    var onsetMs = 10_000
+    var clearMs = 5_000
+    var motionMax = 40
+    var maxGapMs = 15_000
+
+    init() {}
+
+    /// Keys as in src/Viatom.ts `AlarmConfig`; missing keys keep their default.
+    init(_ map: [String: Any]) {
+      func int(_ key: String, _ fallback: Int) -> Int {
+        (map[key] as? NSNumber)?.intValue ?? fallback
+      }
+      spo2Low = int("spo2Low", spo2Low)
+      spo2Hysteresis = int("spo2Hysteresis", spo2Hysteresis)
+      prLow = int("prLow", prLow)
+      prHigh = int("prHigh", prHigh)
+      prHysteresis = int("prHysteresis", prHysteresis)
+      onsetMs = int("onsetMs", onsetMs)
+      clearMs = int("clearMs", clearMs)
+      motionMax = int("motionMax", motionMax)
+      maxGapMs = int("maxGapMs", maxGapMs)
+    }
+  }
+
+  enum Kind: Int, CaseIterable {
+    case spo2Low, prLow, prHigh
+
+    var wire: String {
+      switch self {
+      case .spo2Low: return "spo2Low"
+      case .prLow: return "prLow"
+      case .prHigh: return "prHigh"
+      }
+    }
+  }
+
+  struct Event {
+    let kind: Kind
+    let raised: Bool
+    let value: Int
+    /// Worst value of the episode so far.
+    let nadir: Int
+    /// ms since the episode's first breaching sample.
+    let durationMs: Int
+  }
+
+  private struct Track {
+    var active = false
+    var breachSince = -1
+    var okSince = -1
+    var lastValid = -1
+    var nadir = 0
+  }
+
+  private var tracks = [Track](repeating: Track(), count: Kind.allCases.count)
+
+  func onSample(_ config: Config, nowMs: Int, spo2: Int, pr: Int, motion: Int, probeOn: Bool,
+                _ fire: (Event) -> Void) {
+    let artifact = !probeOn || motion > config.motionMax
+    let spo2Ok = !artifact && (1...100).contains(spo2)
+    let prOk = !artifact && (1...350).contains(pr)
+    if config.spo2Low > 0 {
+      track(.spo2Low, config, nowMs, spo2Ok, spo2, spo2 < config.spo2Low,
+            spo2 >= config.spo2Low + config.spo2Hysteresis, fire)
+    }
+    if config.prLow > 0 {
+      track(.prLow, config, nowMs, prOk, pr, pr < config.prLow,
+            pr >= config.prLow + config.prHysteresis, fire)
+    }
+    if config.prHigh > 0 {
+      track(.prHigh, config, nowMs, prOk, pr, pr > config.prHigh,
+            pr <= config.prHigh - config.prHysteresis, fire)
+    }
+  }
+
+  /// Forget every alarm, raised or pending, without reporting it cleared.
+  func reset() {
+    tracks = [Track](repeating: Track(), count: Kind.allCases.count)
+  }
+
+  private func track(_ kind: Kind, _ config: Config, _ now: Int, _ valid: Bool, _ value: Int,
+                     _ breach: Bool, _ recovered: Bool, _ fire: (Event) -> Void) {
+    var t = tracks[kind.rawValue]
+    defer { tracks[kind.rawValue] = t }
+    guard valid else {
+      if t.lastValid >= 0 && now - t.lastValid > config.maxGapMs {
+        if !t.active { t.breachSince = -1 }
+        t.okSince = -1
+      }
+      return
+    }
+    t.lastValid = now
+    let worse: (Int, Int) -> Bool = kind == .prHigh ? { $0 > $1 } : { $0 < $1 }
+    if !t.active {
+      guard breach else {
+        t.breachSince = -1
+        return
+      }
+      if t.breachSince < 0 {
+        t.breachSince = now
+        t.nadir = value
+      } else if worse(value, t.nadir) {
+        t.nadir = value
+      }
+      if now - t.breachSince >= config.onsetMs {
+        t.active = true
+        t.okSince = -1
+        fire(Event(kind: kind, raised: true, value: value, nadir: t.nadir, durationMs: now - t.breachSince))
+      }
+      return
+    }
+    if breach && worse(value, t.nadir) { t.nadir = value }
+    guard recovered else {
+      t.okSince = -1
+      return
+    }
+    if t.okSince < 0 { t.okSince = now }
+    if now - t.okSince >= config.clearMs {
+      t.active = false
+      fire(Event(kind: kind, raised: false, value: value, nadir: t.nadir, durationMs: now - t.breachSince))
+      t.breachSince = -1
+      t.okSince = -1
+    }
+  }
+}
+
+/// Local notifications for `DesatAlarm`: one per ring and alarm kind; a raise
+/// replaces it, a clear removes it. Delivered in the foreground too.
+final class AlarmNotifier: NSObject, UNUserNotificationCenterDelegate {
+  static let shared = AlarmNotifier()
+
+  private static let category = "o2ring.alarm"
+
+  func requestAuthorization() async -> Bool {
+    let center = UNUserNotificationCenter.current()
+    if center.delegate == nil {
+      center.delegate = self
+    }
+    return (try? await center.requestAuthorization(options: [.alert, .sound])) ?? false
+  }
+
+  func show(mac: String, _ event: DesatAlarm.Event) {
+    let content = UNMutableNotificationContent()
+    content.title = "O2Ring alarm"
+    switch event.kind {
+    case .spo2Low:
+      content.body = "Blood oxygen low: \(event.value)% (lowest \(event.nadir)%)"
+    case .prLow:
+      content.body = "Pulse rate low: \(event.value) bpm (lowest \(event.nadir) bpm)"
+    case .prHigh:
+      content.body = "Pulse rate high: \(event.value) bpm (highest \(event.nadir) bpm)"
+    }
+    content.sound = .default
+    content.categoryIdentifier = Self.category
+    if #available(iOS 15.0, *) {
+      content.interruptionLevel = .timeSensitive
+    }
+    let request = UNNotificationRequest(identifier: id(mac, event.kind), content: content, trigger: nil)
+    UNUserNotificationCenter.current().add(request)
+  }
+
+  func cancel(mac: String, _ kind: DesatAlarm.Kind) {
+    let center = UNUserNotificationCenter.current()
+    center.removeDeliveredNotifications(withIdentifiers: [id(mac, kind)])
+  }
+
+  func userNotificationCenter(_ center: UNUserNotificationCenter,
+                              willPresent notification: UNNotification,
+                              withCompletionHandler completionHandler: @escaping (UNNotificationPresentationOptions) -> Void) {
+    if notification.request.content.categoryIdentifier != Self.category {
+      completionHandler([])
+    } else if #available(iOS 14.0, *) {
+      completionHandler([.banner, .sound])
+    } else {
+      completionHandler([.alert, .sound])
+    }
+  }
+
+  private func id(_ mac: String, _ kind: DesatAlarm.Kind) -> String {
+    "\(Self.category).\(mac).\(kind.wire)"
+  }
+}
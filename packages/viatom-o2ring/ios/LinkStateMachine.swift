@@ -0,0 +1,141 @@
+import Foundation
+
+/// Bring-up of one ring: connecting → services → info → realtime → syncing.
+///
+/// Each state owns one command with a timeout and an attempt budget. Entering
+/// a state issues its command; the matching delegate callback moves the
+/// machine on, a timeout re-issues the command until the budget is spent, then
+/// `Step.onExhausted` decides what happens. Only transitions are reported,
+/// with the time since connect, so time-to-first-sample and time-to-first-file
+/// are read off the event stream rather than hidden behind retries.
+///
+/// Runs on the main actor with everything else in `ViatomManager`.
+@MainActor
+final class LinkStateMachine {
+  enum State: String {
+    case connecting, services, info, realtime, syncing, disconnected
+  }
+
+  struct Step {
+    let timeout: TimeInterval
+    let attempts: Int
+    /// Called with the attempt number, 1 on entry.
+    let action: (Int) -> Void
+    let onExhausted: () -> Void
+  }
+
+  struct Transition {
+    let from: State
+    let to: State
+    /// ms since `start()`.
+    let elapsedMs: Int
+    /// Attempts the state that was left needed.
+    let attempts: Int
+    let reason: String?
+  }
+
+  private(set) var state: State = .disconnected
+  /// ms from connect to the first realtime sample / first history file.
+  private(set) var firstSampleMs: Int?
+  private(set) var firstFileMs: Int?
+
+  var onTransition: ((Transition) -> Void)?
+
+  private var steps: [State: Step] = [:]
+  private var attempt = 0
+  private var startedAt: UInt64 = 0
+  private var timeout: DispatchWorkItem?
+  /// Bumped per timer so one that already fired cannot act after a re-arm.
+  private var timerGeneration = 0
+
+  func configure(_ state: State, _ step: Step) {
+    steps[state] = step
+  }
+
+  /// A connect was issued: restart the clock and the metrics.
+  func start() {
+    startedAt = DispatchTime.now().uptimeNanoseconds
+    firstSampleMs = nil
+    firstFileMs = nil
+    move(to: .connecting, reason: nil)
+  }
+
+  /// The device reported what `expected` was waiting for; ignored in any other state.
+  @discardableResult
+  func advance(from expected: State, to: State, reason: String? = nil) -> Bool {
+    guard state == expected else { return false }
+    move(to: to, reason: reason)
+    return true
+  }
+
+  /// Re-issue the current command now instead of waiting out its timeout.
+  func nudge(_ expected: State) {
+    guard state == expected, let step = steps[state], attempt < step.attempts else { return }
+    attempt += 1
+    arm(step)
+    step.action(attempt)
+  }
+
+  func sampleArrived() {
+    guard state == .realtime else { return }
+    if firstSampleMs == nil { firstSampleMs = elapsedMs() }
+    move(to: .syncing, reason: nil)
+  }
+
+  /// ms since connect if this is the first file of the connection.
+  func fileArrived() -> Int? {
+    guard firstFileMs == nil, state != .disconnected else { return nil }
+    firstFileMs = elapsedMs()
+    return firstFileMs
+  }
+
+  func stop(reason: String?) {
+    if state != .disconnected {
+      move(to: .disconnected, reason: reason)
+    }
+  }
+
+  private func move(to next: State, reason: String?) {
+    timeout?.cancel()
+    timeout = nil
+    timerGeneration += 1
+    let from = state
+    let took = attempt
+    state = next
+    attempt = 0
+    if from != next {
+      onTransition?(Transition(from: from, to: next, elapsedMs: elapsedMs(), attempts: took, reason: reason))
+    }
+    guard let step = steps[next] else { return }
+    attempt = 1
+    arm(step)
+    step.action(attempt)
+  }
+
+  private func arm(_ step: Step) {
+    timeout?.cancel()
+    timerGeneration += 1
+    let generation = timerGeneration
+    let item = DispatchWorkItem { [weak self] in
+      Task { @MainActor in self?.onTimeout(generation) }
+    }
+    timeout = item
+    DispatchQueue.main.asyncAfter(deadline: .now() + step.timeout, execute: item)
+  }
+
+  private func onTimeout(_ generation: Int) {
+    guard generation == timerGeneration, timeout != nil, let step = steps[state] else { return }
+    timeout = nil
+    if attempt < step.attempts {
+      attempt += 1
+      arm(step)
+      step.action(attempt)
+    } else {
+      step.onExhausted()
+    }
+  }
+
+  private func elapsedMs() -> Int {
+    Int((DispatchTime.now().uptimeNanoseconds &- startedAt) / 1_000_000)
+  }
+}
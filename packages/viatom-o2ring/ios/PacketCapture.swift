@@ -0,0 +1,137 @@
+import Foundation
+
+/// Field / debug capture of what one ring sent, for replay off-device (see
+/// src/Capture.ts). Append-only, little-endian, same layout as the Android
+/// module's PacketCapture.kt:
+///
+///     header  16 B: "O2RC" | version u8 | platform u8 | u16 0 | base epoch ms i64
+///     record  12 B: t u32 (ms since open) | kind u8 | u8 0 | u16 0 | length u32
+///                   | payload
+///     REALTIME 8 B: spo2 u8 | pr u16 | pi u8 (tenths) | motion u8 | battery u8
+///                   | flags u8 (bit 0 probe on) | u8 0 | original packet
+///     FILE        : name length u8 | name UTF-8 | file bytes as read
+///
+/// VTO2Lib hands over the original packet with `realDataCallBackWithData:
+/// originalData:`, so iOS captures carry it after the parsed fields. Each
+/// record is one write(2), so a crash loses at most the record in flight
+/// and a reader stops at a torn tail. Used from the delegate callbacks on
+/// the main actor only; a capture stops growing at `maxBytes`.
+final class PacketCapture {
+  static let kindRealtime: UInt8 = 1
+  static let kindFile: UInt8 = 2
+  private static let magic: UInt32 = 0x4352324f // "O2RC" read as u32 LE
+  private static let version: UInt8 = 1
+  private static let platformIOS: UInt8 = 2
+  private static let headerBytes = 16
+  private static let recordHeaderBytes = 12
+  private static let realtimeFieldBytes = 8
+
+  let url: URL
+  private let maxBytes: Int
+  private let baseMono = RealtimeJournal.monotonicMs()
+  private var fd: Int32
+  private var size = 0
+  private(set) var dropped = 0
+
+  init?(url: URL, maxBytes: Int = 64 << 20) {
+    self.url = url
+    self.maxBytes = maxBytes
+    try? FileManager.default.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+    fd = open(url.path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+    guard fd >= 0 else { return nil }
+    var header = [UInt8](repeating: 0, count: Self.headerBytes)
+    Self.put32(&header, 0, Self.magic)
+    header[4] = Self.version
+    header[5] = Self.platformIOS
+    let epoch = UInt64(bitPattern: Int64(Date().timeIntervalSince1970 * 1000))
+    Self.put32(&header, 8, UInt32(truncatingIfNeeded: epoch))
+    Self.put32(&header, 12, UInt32(truncatingIfNeeded: epoch >> 32))
+    guard Self.writeAll(fd, header) else {
+      Darwin.close(fd)
+      return nil
+    }
+    size = header.count
+  }
+
+  deinit {
+    close()
+  }
+
+  func realtime(monoMs: Int64, spo2: Int, pr: Int, piTenths: Int, motion: Int, battery: Int, flags: Int,
+                original: Data?) {
+    let raw = original ?? Data()
+    guard var record = begin(monoMs, Self.kindRealtime, Self.realtimeFieldBytes + raw.count) else { return }
+    record.append(Self.u8(spo2))
+    let prValue = UInt16(min(max(pr, 0), 0xffff))
+    record.append(UInt8(truncatingIfNeeded: prValue))
+    record.append(UInt8(truncatingIfNeeded: prValue >> 8))
+    record.append(Self.u8(piTenths))
+    record.append(Self.u8(motion))
+    record.append(Self.u8(battery))
+    record.append(UInt8(truncatingIfNeeded: flags))
+    record.append(0)
+    record.append(contentsOf: raw)
+    commit(record)
+  }
+
+  func file(monoMs: Int64, name: String, bytes: Data) {
+    let encoded = Array(name.utf8.prefix(255))
+    guard var record = begin(monoMs, Self.kindFile, 1 + encoded.count + bytes.count) else { return }
+    record.append(UInt8(encoded.count))
+    record.append(contentsOf: encoded)
+    record.append(contentsOf: bytes)
+    commit(record)
+  }
+
+  func close() {
+    if fd >= 0 {
+      Darwin.close(fd)
+      fd = -1
+    }
+  }
+
+  private func begin(_ monoMs: Int64, _ kind: UInt8, _ length: Int) -> [UInt8]? {
+    guard fd >= 0, size + Self.recordHeaderBytes + length <= maxBytes else {
+      dropped += 1
+      return nil
+    }
+    var record = [UInt8](repeating: 0, count: Self.recordHeaderBytes)
+    record.reserveCapacity(Self.recordHeaderBytes + length)
+    Self.put32(&record, 0, UInt32(min(max(monoMs - baseMono, 0), Int64(UInt32.max))))
+    record[4] = kind
+    Self.put32(&record, 8, UInt32(length))
+    return record
+  }
+
+  private func commit(_ record: [UInt8]) {
+    if Self.writeAll(fd, record) {
+      size += record.count
+    } else {
+      // the record may be half written; anything after it would misparse
+      dropped += 1
+      close()
+    }
+  }
+
+  private static func writeAll(_ fd: Int32, _ bytes: [UInt8]) -> Bool {
+    var done = 0
+    while done < bytes.count {
+      let n = bytes.withUnsafeBytes { Darwin.write(fd, $0.baseAddress! + done, bytes.count - done) }
+      if n < 0 {
+        if errno == EINTR { continue }
+        return false
+      }
+      done += n
+    }
+    return true
+  }
+
+  private static func u8(_ v: Int) -> UInt8 { UInt8(min(max(v, 0), 255)) }
+
+  private static func put32(_ b: inout [UInt8], _ at: Int, _ v: UInt32) {
+    b[at] = UInt8(truncatingIfNeeded: v)
+    b[at + 1] = UInt8(truncatingIfNeeded: v >> 8)
+    b[at + 2] = UInt8(truncatingIfNeeded: v >> 16)
+    b[at + 3] = UInt8(truncatingIfNeeded: v >> 24)
+  }
+}
@@ -0,0 +1,476 @@
+import Foundation
+
+/// Append-only journal of one ring's realtime readings, as a backup to the
+/// device's own file for overnight capture. Same on-disk format as the
+/// Android module's RealtimeJournal.kt:
+///
+///     <dir>/<seq>.o2rj, each a 32-byte header then fixed 16-byte records (LE)
+///     header: "O2RJ" | version u8 | record size u8 | u16 0 | base epoch ms i64
+///             | base monotonic ms i64 | seq u32 | crc32 of the preceding 28 bytes
+///     record: t u32 (monotonic ms since the segment base) | spo2 u8 | pi u8
+///             (tenths) | pr u16 | motion u8 | battery u8 | flags u8 | u8 0
+///             | crc32 of the preceding 12 bytes
+///
+/// Group commit: `append` copies the reading into a fixed staging buffer under
+/// a short lock and never touches the disk, so it is safe in the delegate
+/// callback. One committer thread swaps the buffer out, encodes it, writes it
+/// and fsyncs once for the whole batch, when `commitRecords` readings are
+/// waiting or the oldest has waited `commitInterval`. Memory is two staging
+/// buffers and one encode buffer; when the disk falls a whole buffer behind,
+/// new readings are dropped and counted rather than blocking the caller.
+///
+/// On open the newest segment is cut back to its last record with a valid
+/// CRC, so a crash mid-write costs at most the batch in flight.
+final class RealtimeJournal: @unchecked Sendable {
+  struct Options {
+    var segmentBytes = 1 << 20
+    var maxSegments = 16
+    var commitRecords = 64
+    var commitInterval: TimeInterval = 1
+    var bufferRecords = 4_096
+  }
+
+  struct Stats {
+    var appended = 0
+    var committed = 0
+    var dropped = 0
+    /// Readings lost to a failed write; the next batch starts a new segment.
+    var lost = 0
+    var fsyncs = 0
+    var recoveredRecords = 0
+    var truncatedBytes = 0
+  }
+
+  /// Decoded readings, oldest first; `t` is epoch ms.
+  struct Columns {
+    var t: [Int64] = []
+    var spo2: [Int] = []
+    var pr: [Int] = []
+    var pi: [Int] = []
+    var motion: [Int] = []
+    var battery: [Int] = []
+    var flags: [Int] = []
+  }
+
+  static let headerBytes = 32
+  static let recordBytes = 16
+  static let flagProbeOn = 1
+  private static let magic: UInt32 = 0x4a52324f // "O2RJ" read as u32 LE
+  private static let version: UInt8 = 1
+  private static let suffix = ".o2rj"
+  private static let readChunk = 4_096 * recordBytes
+
+  /// Staged readings: monotonic ms plus the record's packed fields.
+  private struct Stage {
+    var mono: [Int64]
+    var a: [UInt32] // spo2 | pi << 8 | pr << 16
+    var b: [UInt32] // motion | battery << 8 | flags << 16
+    var size = 0
+
+    init(_ capacity: Int) {
+      mono = [Int64](repeating: 0, count: capacity)
+      a = [UInt32](repeating: 0, count: capacity)
+      b = [UInt32](repeating: 0, count: capacity)
+    }
+  }
+
+  private let dir: URL
+  private let options: Options
+  private let cond = NSCondition()
+  private var active: Stage
+  private var spare: Stage
+  private var firstPendingAt: TimeInterval = 0
+  private var flushRequested = false
+  private var closing = false
+  private var committerDone = false
+  private var counters = Stats()
+
+  // Committer-thread state
+  private var encode: [UInt8]
+  private var seq = 0
+  private var fd: Int32 = -1
+  private var segmentSize = 0
+  private var baseMono: Int64 = 0
+
+  init(dir: URL, options: Options = Options()) {
+    self.dir = dir
+    self.options = options
+    active = Stage(options.bufferRecords)
+    spare = Stage(options.bufferRecords)
+    encode = [UInt8](repeating: 0, count: options.bufferRecords * Self.recordBytes)
+    try? FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+    recover()
+    let thread = Thread { [self] in commitLoop() }
+    thread.name = "o2ring-journal"
+    thread.qualityOfService = .utility
+    thread.start()
+  }
+
+  /// Monotonic ms that keep counting while the device sleeps.
+  static func monotonicMs() -> Int64 {
+    Int64(clock_gettime_nsec_np(CLOCK_MONOTONIC) / 1_000_000)
+  }
+
+  /// Stage one reading; false if it was dropped because the committer is a
+  /// full buffer behind. Never blocks on I/O.
+  @discardableResult
+  func append(monoMs: Int64, spo2: Int, pr: Int, piTenths: Int, motion: Int, battery: Int, flags: Int) -> Bool {
+    cond.lock()
+    defer { cond.unlock() }
+    if stage(monoMs, spo2, pr, piTenths, motion, battery, flags) { return true }
+    counters.dropped += 1
+    return false
+  }
+
+  /// Commit everything staged so far and wait until it is on disk.
+  func flush() {
+    cond.lock()
+    defer { cond.unlock() }
+    let target = counters.appended
+    flushRequested = true
+    cond.broadcast()
+    while counters.committed + counters.lost < target && !committerDone {
+      cond.wait()
+    }
+  }
+
+  func stats() -> Stats {
+    cond.lock()
+    defer { cond.unlock() }
+    return counters
+  }
+
+  var segmentCount: Int { segmentFiles().count }
+
+  /// Commit what is staged, stop the committer and close the segment.
+  func close() {
+    cond.lock()
+    closing = true
+    cond.broadcast()
+    while !committerDone { cond.wait() }
+    cond.unlock()
+  }
+
+  /// Committed readings at or after `sinceEpochMs`, across every segment.
+  func read(sinceEpochMs: Int64 = 0) -> Columns {
+    var out = Columns()
+    var chunk = [UInt8](repeating: 0, count: Self.readChunk)
+    for url in segmentFiles() {
+      // Rotation may delete the oldest segment under us
+      let rfd = open(url.path, O_RDONLY)
+      guard rfd >= 0 else { continue }
+      defer { Darwin.close(rfd) }
+      var header = [UInt8](repeating: 0, count: Self.headerBytes)
+      guard pread(rfd, &header, Self.headerBytes, 0) == Self.headerBytes, Self.validHeader(header) else { continue }
+      let baseEpoch = Self.i64(header, 8)
+      _ = Self.scan(rfd, &chunk) { buf, at in
+        let epoch = baseEpoch + Int64(Self.u32(buf, at))
+        guard epoch >= sinceEpochMs else { return }
+        out.t.append(epoch)
+        out.spo2.append(Int(buf[at + 4]))
+        out.pi.append(Int(buf[at + 5]))
+        out.pr.append(Int(buf[at + 6]) | Int(buf[at + 7]) << 8)
+        out.motion.append(Int(buf[at + 8]))
+        out.battery.append(Int(buf[at + 9]))
+        out.flags.append(Int(buf[at + 10]))
+      }
+    }
+    return out
+  }
+
+  // MARK: - Staging
+
+  /// Caller holds `cond`.
+  private func stage(_ monoMs: Int64, _ spo2: Int, _ pr: Int, _ piTenths: Int, _ motion: Int, _ battery: Int, _ flags: Int) -> Bool {
+    guard !closing, active.size < active.mono.count else { return false }
+    let i = active.size
+    active.size += 1
+    active.mono[i] = monoMs
+    active.a[i] = Self.u8(spo2) | Self.u8(piTenths) << 8 | UInt32(pr & 0xffff) << 16
+    active.b[i] = Self.u8(motion) | Self.u8(battery) << 8 | Self.u8(flags) << 16
+    counters.appended += 1
+    if i == 0 {
+      // Start the committer's interval clock
+      firstPendingAt = ProcessInfo.processInfo.systemUptime
+      cond.broadcast()
+    } else if active.size >= options.commitRecords {
+      cond.broadcast()
+    }
+    return true
+  }
+
+  private func due() -> Bool {
+    active.size >= options.commitRecords ||
+      (active.size > 0 && ProcessInfo.processInfo.systemUptime - firstPendingAt >= options.commitInterval)
+  }
+
+  // MARK: - Committer
+
+  private func commitLoop() {
+    while true {
+      cond.lock()
+      while !closing && !flushRequested && !due() {
+        if active.size == 0 {
+          cond.wait()
+        } else {
+          _ = cond.wait(until: Date(timeIntervalSinceNow: firstPendingAt + options.commitInterval - ProcessInfo.processInfo.systemUptime))
+        }
+      }
+      flushRequested = false
+      if active.size == 0 {
+        cond.broadcast()
+        if closing {
+          if fd >= 0 { Darwin.close(fd) }
+          fd = -1
+          committerDone = true
+          cond.unlock()
+          return
+        }
+        cond.unlock()
+        continue
+      }
+      swap(&active, &spare)
+      cond.unlock()
+
+      let ok = write(spare)
+      if !ok, fd >= 0 {
+        Darwin.close(fd)
+        fd = -1
+      }
+
+      cond.lock()
+      if ok {
+        counters.committed += spare.size
+        counters.fsyncs += 1
+      } else {
+        counters.lost += spare.size
+      }
+      spare.size = 0
+      cond.broadcast()
+      cond.unlock()
+    }
+  }
+
+  /// Encode `stage` into segments (rotating as needed) and fsync each touched one.
+  private func write(_ stage: Stage) -> Bool {
+    var i = 0
+    while i < stage.size {
+      if fd < 0 || !fits(stage.mono[i]) {
+        guard rotate(stage.mono[i]) else { return false }
+      }
+      var n = 0
+      while i < stage.size, n + Self.recordBytes <= encode.count, fits(stage.mono[i]) {
+        Self.put32(&encode, n, UInt32(truncatingIfNeeded: stage.mono[i] - baseMono))
+        Self.put32(&encode, n + 4, stage.a[i])
+        Self.put32(&encode, n + 8, stage.b[i])
+        Self.put32(&encode, n + 12, CRC32.checksum(encode, n, 12))
+        n += Self.recordBytes
+        segmentSize += Self.recordBytes
+        i += 1
+      }
+      guard Self.writeAll(fd, encode, n), fsync(fd) == 0 else { return false }
+    }
+    return true
+  }
+
+  /// `mono` still belongs in the open segment: room left and t fits in u32.
+  private func fits(_ mono: Int64) -> Bool {
+    let t = mono - baseMono
+    return segmentSize + Self.recordBytes <= options.segmentBytes && t >= 0 && t <= Int64(UInt32.max)
+  }
+
+  private func rotate(_ firstMono: Int64) -> Bool {
+    if fd >= 0 {
+      fsync(fd)
+      Darwin.close(fd)
+      fd = -1
+    }
+    seq += 1
+    baseMono = firstMono
+    let baseEpoch = Int64(Date().timeIntervalSince1970 * 1000) - (Self.monotonicMs() - firstMono)
+    var header = [UInt8](repeating: 0, count: Self.headerBytes)
+    Self.put32(&header, 0, Self.magic)
+    header[4] = Self.version
+    header[5] = UInt8(Self.recordBytes)
+    Self.put64(&header, 8, baseEpoch)
+    Self.put64(&header, 16, firstMono)
+    Self.put32(&header, 24, UInt32(seq))
+    Self.put32(&header, 28, CRC32.checksum(header, 0, Self.headerBytes - 4))
+    let path = dir.appendingPathComponent(String(format: "%08d%@", seq, Self.suffix)).path
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+    guard fd >= 0, Self.writeAll(fd, header, header.count) else { return false }
+    segmentSize = Self.headerBytes
+    let files = segmentFiles()
+    files.prefix(max(0, files.count - options.maxSegments)).forEach {
+      try? FileManager.default.removeItem(at: $0)
+    }
+    return true
+  }
+
+  /// Cut the newest segment back to its last valid record.
+  private func recover() {
+    let files = segmentFiles()
+    seq = files.last.map(Self.seqOf) ?? 0
+    guard let last = files.last else { return }
+    let rfd = open(last.path, O_RDWR)
+    guard rfd >= 0 else { return }
+    defer { Darwin.close(rfd) }
+    var st = stat()
+    fstat(rfd, &st)
+    let size = Int(st.st_size)
+    var header = [UInt8](repeating: 0, count: Self.headerBytes)
+    guard pread(rfd, &header, Self.headerBytes, 0) == Self.headerBytes, Self.validHeader(header) else {
+      counters.truncatedBytes += size
+      try? FileManager.default.removeItem(at: last)
+      return
+    }
+    var recovered = 0
+    let end = Self.scan(rfd, &encode) { _, _ in recovered += 1 }
+    counters.recoveredRecords = recovered
+    if end < size {
+      counters.truncatedBytes += size - end
+      ftruncate(rfd, off_t(end))
+      fsync(rfd)
+    }
+  }
+
+  private func segmentFiles() -> [URL] {
+    let names = (try? FileManager.default.contentsOfDirectory(atPath: dir.path)) ?? []
+    return names
+      .filter { $0.hasSuffix(Self.suffix) }
+      .map { dir.appendingPathComponent($0) }
+      .sorted { Self.seqOf($0) < Self.seqOf($1) }
+  }
+
+  // MARK: - Encoding
+
+  /// Visit records from the header on, stopping at the first short or corrupt
+  /// one; returns the offset just past the last good record.
+  private static func scan(_ fd: Int32, _ chunk: inout [UInt8], _ visit: ([UInt8], Int) -> Void) -> Int {
+    var pos = headerBytes
+    while true {
+      let got = chunk.withUnsafeMutableBytes { pread(fd, $0.baseAddress, $0.count, off_t(pos)) }
+      var at = 0
+      while at + recordBytes <= got {
+        guard CRC32.checksum(chunk, at, 12) == u32(chunk, at + 12) else { return pos + at }
+        visit(chunk, at)
+        at += recordBytes
+      }
+      pos += at
+      if got < chunk.count { return pos }
+    }
+  }
+
+  private static func validHeader(_ header: [UInt8]) -> Bool {
+    u32(header, 0) == magic && header[4] == version && Int(header[5]) == recordBytes &&
+      CRC32.checksum(header, 0, headerBytes - 4) == u32(header, headerBytes - 4)
+  }
+
+  private static func seqOf(_ url: URL) -> Int {
+    Int(url.lastPathComponent.dropLast(suffix.count)) ?? 0
+  }
+
+  private static func writeAll(_ fd: Int32, _ bytes: [UInt8], _ count: Int) -> Bool {
+    var done = 0
+    while done < count {
+      let n = bytes.withUnsafeBytes { Darwin.write(fd, $0.baseAddress! + done, count - done) }
+      if n < 0 {
+        if errno == EINTR { continue }
+        return false
+      }
+      done += n
+    }
+    return true
+  }
+
+  private static func u8(_ v: Int) -> UInt32 { UInt32(min(max(v, 0), 255)) }
+
+  private static func u32(_ b: [UInt8], _ at: Int) -> UInt32 {
+    UInt32(b[at]) | UInt32(b[at + 1]) << 8 | UInt32(b[at + 2]) << 16 | UInt32(b[at + 3]) << 24
+  }
+
+  private static func i64(_ b: [UInt8], _ at: Int) -> Int64 {
+    Int64(bitPattern: UInt64(u32(b, at)) | UInt64(u32(b, at + 4)) << 32)
+  }
+
+  private static func put32(_ b: inout [UInt8], _ at: Int, _ v: UInt32) {
+    b[at] = UInt8(truncatingIfNeeded: v)
+    b[at + 1] = UInt8(truncatingIfNeeded: v >> 8)
+    b[at + 2] = UInt8(truncatingIfNeeded: v >> 16)
+    b[at + 3] = UInt8(truncatingIfNeeded: v >> 24)
+  }
+
+  private static func put64(_ b: inout [UInt8], _ at: Int, _ v: Int64) {
+    put32(&b, at, UInt32(truncatingIfNeeded: v))
+    put32(&b, at + 4, UInt32(truncatingIfNeeded: v >> 32))
+  }
+
+  // MARK: - Benchmark
+
+  struct BenchResult {
+    let commitRecords: Int
+    let records: Int
+    let fsyncs: Int
+    let wallMs: Double
+    let recordsPerSec: Double
+    let meanBatch: Double
+  }
+
+  /// Group-commit throughput: `records` readings appended as fast as the
+  /// caller can, committed at least every `commitRecords`. Small batches are
+  /// bound by fsync latency; the mean batch shows how much the committer
+  /// coalesced on its own while an fsync was in flight.
+  static func benchmark(scratch: URL, records: Int, commitRecords: Int) -> BenchResult {
+    try? FileManager.default.removeItem(at: scratch)
+    var options = Options()
+    options.segmentBytes = 8 << 20
+    options.maxSegments = .max
+    options.commitRecords = commitRecords
+    options.commitInterval = 60
+    let journal = RealtimeJournal(dir: scratch, options: options)
+    let start = DispatchTime.now().uptimeNanoseconds
+    let mono = monotonicMs()
+    for i in 0..<records {
+      // Staging buffer full: back off instead of measuring drops
+      while true {
+        journal.cond.lock()
+        let staged = journal.stage(mono + Int64(i), 95, 60, 25, 0, 80, flagProbeOn)
+        journal.cond.unlock()
+        if staged { break }
+        sched_yield()
+      }
+    }
+    journal.flush()
+    let wallMs = Double(DispatchTime.now().uptimeNanoseconds - start) / 1e6
+    let stats = journal.stats()
+    journal.close()
+    try? FileManager.default.removeItem(at: scratch)
+    return BenchResult(
+      commitRecords: commitRecords,
+      records: records,
+      fsyncs: stats.fsyncs,
+      wallMs: wallMs,
+      recordsPerSec: Double(records) * 1000 / wallMs,
+      meanBatch: Double(records) / Double(max(1, stats.fsyncs))
+    )
+  }
+}
+
+/// IEEE CRC-32, as java.util.zip.CRC32 computes it on Android.
+enum CRC32 {
+  private static let table: [UInt32] = (0..<256).map { n -> UInt32 in
+    var c = UInt32(n)
+    for _ in 0..<8 {
+      c = c & 1 != 0 ? 0xedb88320 ^ (c >> 1) : c >> 1
+    }
+    return c
+  }
+
+  static func checksum(_ bytes: [UInt8], _ from: Int, _ count: Int) -> UInt32 {
+    var c: UInt32 = 0xffffffff
+    for i in from..<(from + count) {
+      c = table[Int((c ^ UInt32(bytes[i])) & 0xff)] ^ (c >> 8)
+    }
+    return c ^ 0xffffffff
+  }
+}
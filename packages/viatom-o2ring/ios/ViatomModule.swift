@@ -13,6 +13,36 @@ private struct DiscoveredDevice {
   let model: Int
 }
 
+/// One connected ring. CoreBluetooth keeps every session's link open; the
+/// shared `VTO2Communicate` points at one of them at a time.
+private final class PeripheralSession {
+  let peripheral: CBPeripheral
+  let model: Int
+  /// Started by `connect`; carries the bring-up from the pending connect.
+  let link: LinkStateMachine
+  var isServiceReady = false
+  var bootstrapped = false
+  /// Commands issued while another ring held the communicator.
+  var pending: [(VTO2Communicate) -> Void] = []
+  // Open trace spans (`ViatomTrace.begin()` timestamps, 0 when not tracing)
+  var serviceSpan: UInt64 = 0
+  var infoSpan: UInt64 = 0
+  var readSpan: UInt64 = 0
+  let alarm = DesatAlarm()
+  /// Uptime (ns) of the last realtime sample.
+  var lastSampleAt: UInt64 = 0
+  /// Name of the file being read, for captures.
+  var readName: String?
+
+  init(peripheral: CBPeripheral, model: Int, link: LinkStateMachine) {
+    self.peripheral = peripheral
+    self.model = model
+    self.link = link
+  }
+
+  var mac: String { peripheral.identifier.uuidString }
+}
+
 @MainActor
 final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDelegate {
   typealias EventSink = (String, [String: Any]) -> Void
@@ -29,11 +59,29 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     "o2 ring",
   ]
   private var isScanning = false
-  private var isServiceReady = false
-  private var connectedPeripheral: CBPeripheral?
-  private var connectedIdentifier: UUID?
-  private var connectedModel: Int?
-  private var pendingConnectModels: [UUID: Int] = [:]
+  // Connected rings by identifier. `VTO2Communicate` is a singleton bound to
+  // one peripheral, so sessions take turns on it: a command for a ring that
+  // is not attached waits until the in-flight command finishes, then the
+  // communicator is re-pointed at that ring. src/Sessions.ts keeps the
+  // per-ring queues fair; this only serialises the shared parser.
+  private var sessions: [UUID: PeripheralSession] = [:]
+  private var attachedIdentifier: UUID?
+  /// A transfer or info request is in flight on the communicator.
+  private var communicatorBusy = false
+  /// Ring used when JS does not pass an identifier (single-device callers).
+  private var defaultIdentifier: UUID?
+  private var pendingConnects: [UUID: (model: Int, span: UInt64, link: LinkStateMachine)] = [:]
+  /// Alarm thresholds shared by every ring; nil while alarms are off.
+  private var alarmConfig: DesatAlarm.Config?
+  private var alarmPump: Timer?
+  private var alarmNotificationsAllowed = false
+  /// Realtime journals by identifier, opened on a ring's first sample while journaling is on.
+  private var journaling = false
+  private var journals: [String: RealtimeJournal] = [:]
+  /// Packet captures by identifier, one file per ring per capture session.
+  private var capturing = false
+  private var captures: [String: PacketCapture] = [:]
+  private let trace = ViatomTrace.shared
   private lazy var isoFormatter: ISO8601DateFormatter = {
     let formatter = ISO8601DateFormatter()
     formatter.formatOptions = [.withInternetDateTime]
@@ -72,6 +120,7 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
   func scan() async throws -> Bool {
     try await ensurePoweredOn()
     discoveredDevices.removeAll()
+    trace.instant("scan.start")
 
     central?.scanForPeripherals(
       withServices: nil,
@@ -91,7 +140,6 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
 
   func connect(mac: String, model: Int) throws -> Bool {
     ensureCentral()
-    isServiceReady = false
 
     guard let identifier = UUID(uuidString: mac) else {
       throw ViatomException(code: "INVALID_DEVICE", description: "Invalid device identifier")
@@ -103,28 +151,46 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
       throw ViatomException(code: "DEVICE_NOT_FOUND", description: "Unable to find peripheral with identifier \(mac)")
     }
 
-    pendingConnectModels[identifier] = model
+    if let existing = pendingConnects[identifier] {
+      existing.link.stop(reason: "reconnect")
+    }
+    let link = makeLink(mac: mac)
+    link.configure(.connecting, LinkStateMachine.Step(
+      timeout: Self.connectTimeout,
+      attempts: 2,
+      action: { [weak self] attempt in
+        // CoreBluetooth connects never time out on their own; re-issuing is harmless
+        if attempt > 1 { self?.central?.connect(target, options: nil) }
+      },
+      onExhausted: { [weak self, weak link] in
+        guard let self = self else { return }
+        self.pendingConnects[identifier] = nil
+        self.central?.cancelPeripheralConnection(target)
+        self.sendError(code: "CONNECT_TIMEOUT", message: "Ring did not connect", mac: mac)
+        link?.stop(reason: "connect timeout")
+      }
+    ))
+    pendingConnects[identifier] = (model, trace.begin(), link)
+    defaultIdentifier = identifier
     central?.connect(target, options: nil)
+    link.start()
     discoveredDevices[identifier] = DiscoveredDevice(peripheral: target, name: target.name ?? "O2Ring", model: model)
     return true
   }
 
-  func disconnect() -> Bool {
-    if let peripheral = connectedPeripheral {
-      central?.cancelPeripheralConnection(peripheral)
+  func disconnect(mac: String?) -> Bool {
+    guard let identifier = resolveIdentifier(mac), let session = sessions[identifier] else {
+      return true
     }
-    cleanupConnection()
+    central?.cancelPeripheralConnection(session.peripheral)
+    removeSession(identifier, reason: "closed")
     return true
   }
 
-  func startRealtime() throws -> Bool {
-    guard connectedPeripheral != nil else {
-      throw ViatomException(code: "NO_DEVICE_CONNECTED", description: "No active O2Ring connection")
-    }
-    guard isServiceReady, let communicator = communicator else {
-      throw ViatomException(code: "SERVICE_NOT_READY", description: "Service not ready yet")
-    }
-    communicator.beginGetRealData()
+  func startRealtime(mac: String?) throws -> Bool {
+    let session = try requireSession(mac)
+    // Realtime replies are not tracked as busy: a missed reply must not stall other rings.
+    run(on: session, busy: false) { $0.beginGetRealData() }
     return true
   }
 
@@ -132,29 +198,159 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     return true
   }
 
-  func getInfo() throws -> Bool {
-    guard connectedPeripheral != nil else {
-      throw ViatomException(code: "NO_DEVICE_CONNECTED", description: "No active O2Ring connection")
+  func getInfo(mac: String?) throws -> Bool {
+    let session = try requireSession(mac)
+    run(on: session, busy: true) { [weak self] communicator in
+      self?.beginInfoSpan(session)
+      communicator.beginGetInfo()
     }
-    guard isServiceReady, let communicator = communicator else {
-      throw ViatomException(code: "SERVICE_NOT_READY", description: "Service not ready yet")
+    return true
+  }
+
+  func readHistory(fileName: String, mac: String?) throws -> Bool {
+    let session = try requireSession(mac)
+    run(on: session, busy: true) { [weak self] communicator in
+      session.readSpan = self?.trace.begin() ?? 0
+      session.readName = fileName
+      communicator.beginReadFile(withFileName: fileName)
+      self?.emit("onReadProgress", ["mac": session.mac, "progress": 0, "ts": Date().timeIntervalSince1970 * 1000])
     }
-    communicator.beginGetInfo()
     return true
   }
 
-  func readHistory(fileName: String) throws -> Bool {
-    guard connectedPeripheral != nil else {
-      throw ViatomException(code: "NO_DEVICE_CONNECTED", description: "No active O2Ring connection")
+  /// Arm (or with nil, disarm) the native alarms. Returns false when the
+  /// user has not allowed notifications, so JS can explain why.
+  func setAlarmConfig(_ map: [String: Any]?) async -> Bool {
+    alarmPump?.invalidate()
+    alarmPump = nil
+    guard let map = map else {
+      alarmConfig = nil
+      sessions.values.forEach { $0.alarm.reset() }
+      return true
+    }
+    alarmConfig = DesatAlarm.Config(map)
+    alarmPump = Timer.scheduledTimer(withTimeInterval: Self.alarmSampleInterval, repeats: true) { [weak self] _ in
+      Task { @MainActor in self?.pumpRealtime() }
     }
-    guard isServiceReady, let communicator = communicator else {
-      throw ViatomException(code: "SERVICE_NOT_READY", description: "Service not ready yet")
+    alarmNotificationsAllowed = await AlarmNotifier.shared.requestAuthorization()
+    return alarmNotificationsAllowed
+  }
+
+  func setJournaling(_ enabled: Bool) -> Bool {
+    journaling = enabled
+    if !enabled {
+      closeJournals()
     }
-    communicator.beginReadFile(withFileName: fileName)
-    emit("onReadProgress", ["progress": 0])
     return true
   }
 
+  /// The ring's open journal while it streams, or nil.
+  func openJournal(for mac: String) -> RealtimeJournal? {
+    return journals[mac]
+  }
+
+  /// Read what an earlier run left behind through a transient journal.
+  /// Runs on the main actor, like the realtime path that opens the live
+  /// journal, so the two are never open on the same directory at once.
+  func readClosedJournal(_ mac: String, sinceEpochMs: Int64) -> RealtimeJournal.Columns {
+    let journal = RealtimeJournal(dir: Self.journalDir(mac))
+    defer { journal.close() }
+    return journal.read(sinceEpochMs: sinceEpochMs)
+  }
+
+  func journalStats() -> [[String: Any]] {
+    return journals.map { mac, journal in
+      let s = journal.stats()
+      return [
+        "mac": mac,
+        "appended": s.appended,
+        "committed": s.committed,
+        "dropped": s.dropped,
+        "lost": s.lost,
+        "fsyncs": s.fsyncs,
+        "segments": journal.segmentCount,
+        "recoveredRecords": s.recoveredRecords,
+        "truncatedBytes": s.truncatedBytes
+      ]
+    }
+  }
+
+  func closeJournals() {
+    let open = journals.values
+    journals.removeAll()
+    // close() waits for the final fsync; keep it off the main thread
+    DispatchQueue.global(qos: .utility).async {
+      open.forEach { $0.close() }
+    }
+  }
+
+  /// Record what the rings send for replay off-device (src/Capture.ts);
+  /// turning it off closes the files.
+  func setCapture(_ enabled: Bool) -> Bool {
+    capturing = enabled
+    if !enabled {
+      captures.values.forEach { $0.close() }
+      captures.removeAll()
+    }
+    return true
+  }
+
+  /// Capture files on disk, oldest first.
+  func listCaptures() -> [[String: Any]] {
+    let root = Self.captureRoot()
+    let fm = FileManager.default
+    let rings = (try? fm.contentsOfDirectory(at: root, includingPropertiesForKeys: nil)) ?? []
+    return rings.flatMap { ring -> [[String: Any]] in
+      let files = (try? fm.contentsOfDirectory(at: ring, includingPropertiesForKeys: [.fileSizeKey])) ?? []
+      return files.filter { $0.pathExtension == "o2rc" }.map { file in
+        [
+          "mac": ring.lastPathComponent,
+          "path": file.path,
+          "bytes": (try? file.resourceValues(forKeys: [.fileSizeKey]).fileSize) ?? 0
+        ]
+      }
+    }
+    .sorted { ($0["path"] as? String ?? "") < ($1["path"] as? String ?? "") }
+  }
+
+  private func capture(for mac: String) -> PacketCapture? {
+    if let open = captures[mac] {
+      return open
+    }
+    let name = "\(Int64(Date().timeIntervalSince1970 * 1000)).o2rc"
+    let url = Self.captureRoot().appendingPathComponent(mac, isDirectory: true).appendingPathComponent(name)
+    let opened = PacketCapture(url: url)
+    captures[mac] = opened
+    return opened
+  }
+
+  private static func captureRoot() -> URL {
+    let support = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask)[0]
+    return support.appendingPathComponent("o2ring-capture", isDirectory: true)
+  }
+
+  private static func journalDir(_ mac: String) -> URL {
+    let support = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask)[0]
+    return support.appendingPathComponent("o2ring-journal", isDirectory: true)
+      .appendingPathComponent(mac, isDirectory: true)
+  }
+
+  func listSessions() -> [[String: Any]] {
+    return sessions.values.map { session in
+      var entry: [String: Any] = [
+        "mac": session.mac,
+        "model": session.model,
+        "attached": session.peripheral.identifier == attachedIdentifier,
+        "ready": session.isServiceReady,
+        "pending": session.pending.count,
+        "state": session.link.state.rawValue
+      ]
+      entry["firstSampleMs"] = session.link.firstSampleMs
+      entry["firstFileMs"] = session.link.firstFileMs
+      return entry
+    }
+  }
+
   // MARK: - CBCentralManagerDelegate
 
   func centralManagerDidUpdateState(_ central: CBCentralManager) {
@@ -195,6 +391,7 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
       model: model
     )
 
+    trace.instant("scan.deviceFound")
     emit("onDeviceFound", [
       "mac": peripheral.identifier.uuidString,
       "name": name,
@@ -203,36 +400,46 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
   }
 
   func centralManager(_ central: CBCentralManager, didConnect peripheral: CBPeripheral) {
-    connectedPeripheral = peripheral
-    connectedIdentifier = peripheral.identifier
-    connectedModel = pendingConnectModels[peripheral.identifier] ?? discoveredDevices[peripheral.identifier]?.model
-    pendingConnectModels[peripheral.identifier] = nil
-
-    let util = VTO2Communicate.sharedInstance()
-    util.delegate = self
-    util.a5Delegate = nil
-    util.timeout = 10000
-    util.peripheral = peripheral
-    communicator = util
+    let identifier = peripheral.identifier
+    let pending = pendingConnects.removeValue(forKey: identifier)
+    let model = pending?.model ?? discoveredDevices[identifier]?.model ?? 0
+    trace.end("connect", pending?.span ?? 0)
+
+    let link = pending?.link ?? makeLink(mac: identifier.uuidString)
+    let session = PeripheralSession(peripheral: peripheral, model: model, link: link)
+    sessions[identifier] = session
+    configureBringUp(session)
+    if link.state == .disconnected {
+      link.start()
+    }
+    link.advance(from: .connecting, to: .services)
 
     emit("onConnected", [
-      "mac": peripheral.identifier.uuidString,
-      "model": connectedModel ?? 0
+      "mac": session.mac,
+      "model": model
     ])
+
+    // Attach right away unless another ring is mid-command; a new ring
+    // otherwise gets the communicator when it is next free.
+    if !communicatorBusy {
+      attach(session)
+    }
   }
 
   func centralManager(_ central: CBCentralManager, didFailToConnect peripheral: CBPeripheral, error: Error?) {
-    sendError(code: "CONNECT_FAILED", message: error?.localizedDescription ?? "Failed to connect to device")
+    pendingConnects.removeValue(forKey: peripheral.identifier)?.link.stop(reason: "connect failed")
+    sendError(
+      code: "CONNECT_FAILED",
+      message: error?.localizedDescription ?? "Failed to connect to device",
+      mac: peripheral.identifier.uuidString
+    )
   }
 
   func centralManager(_ central: CBCentralManager, didDisconnectPeripheral peripheral: CBPeripheral, error: Error?) {
-    let wasCurrent = connectedIdentifier == peripheral.identifier
-    let modelValue = wasCurrent ? (connectedModel ?? discoveredDevices[peripheral.identifier]?.model ?? 0) : (discoveredDevices[peripheral.identifier]?.model ?? 0)
-
-    if wasCurrent {
-      cleanupConnection()
-    }
+    let modelValue = sessions[peripheral.identifier]?.model ?? discoveredDevices[peripheral.identifier]?.model ?? 0
+    removeSession(peripheral.identifier, reason: "link lost")
 
+    trace.instant("disconnect")
     let nsError = error as NSError?
     emit("onDisconnected", [
       "mac": peripheral.identifier.uuidString,
@@ -245,21 +452,35 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
 
   @objc(serviceDeployed:)
   func serviceDeployed(_ completed: Bool) {
+    guard let session = attachedSession else { return }
+    trace.end("serviceDeployed", session.serviceSpan)
+    session.serviceSpan = 0
     guard completed else {
-      sendError(code: "SERVICE_INIT_FAILED", message: "Failed to initialise device services")
+      sendError(code: "SERVICE_INIT_FAILED", message: "Failed to initialise device services", mac: session.mac)
       return
     }
-    isServiceReady = true
-    bootstrapAfterServiceReady()
+    session.isServiceReady = true
     emit("onServiceReady", [
-      "mac": connectedIdentifier?.uuidString ?? ""
+      "mac": session.mac
     ])
+    session.bootstrapped = true
+    // A ring re-attached mid bring-up re-asks for what it was waiting on
+    if !session.link.advance(from: .services, to: .info) && session.pending.isEmpty {
+      session.link.nudge(session.link.state)
+    }
+    runPending(session)
   }
 
   @objc(getInfoWithResultData:)
   func getInfo(withResultData infoData: Data!) {
+    let mac = attachedSession?.mac
+    if let session = attachedSession {
+      trace.end("getInfo", session.infoSpan)
+      session.infoSpan = 0
+    }
+    defer { commandFinished() }
     guard let infoData = infoData else {
-      sendError(code: "INFO_ERROR", message: "Device info response was empty")
+      sendError(code: "INFO_ERROR", message: "Device info response was empty", mac: mac)
       return
     }
     let info = VTO2Parser.parseO2Info(with: infoData)
@@ -274,28 +495,84 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     let batteryState = parseInteger(from: info.curBatState)
 
     emit("onInfo", [
+      "mac": mac,
       "battery": battery,
       "state": state,
       "batteryState": batteryState,
       "files": files
     ])
+    attachedSession?.link.advance(from: .info, to: .realtime)
   }
 
   @objc(postCurrentReadProgress:)
   func postCurrentReadProgress(_ progress: Double) {
     let normalized = progress <= 1.0 ? progress * 100.0 : progress
     let percent = max(0, min(100, Int(normalized.rounded())))
-    emit("onReadProgress", ["progress": percent])
+    emit("onReadProgress", ["mac": attachedSession?.mac, "progress": percent, "ts": Date().timeIntervalSince1970 * 1000])
   }
 
   @objc(realDataCallBackWithData:)
   func realDataCallBack(with data: Data!) {
+    handleRealData(data, original: nil)
+  }
+
+  @objc(realDataCallBackWithData:originalData:)
+  func realDataCallBack(with data: Data!, originalData: Data!) {
+    handleRealData(data, original: originalData)
+  }
+
+  private func handleRealData(_ data: Data?, original: Data?) {
     guard let data = data else {
       return
     }
+    let received = DispatchTime.now().uptimeNanoseconds
     let realData = VTO2Parser.parseO2RealObject(with: data)
+    if let session = attachedSession {
+      session.lastSampleAt = received
+      session.link.sampleArrived()
+      // Alarms first: the JS emit below may queue behind a busy bridge
+      if let config = alarmConfig {
+        session.alarm.onSample(
+          config,
+          nowMs: Int(received / 1_000_000),
+          spo2: Int(realData.spo2),
+          pr: Int(realData.hr),
+          motion: Int(realData.vector),
+          probeOn: realData.leadState == 1
+        ) { alarmFired(session, $0) }
+      }
+      if journaling {
+        let journal = journals[session.mac] ?? {
+          let opened = RealtimeJournal(dir: Self.journalDir(session.mac))
+          journals[session.mac] = opened
+          return opened
+        }()
+        journal.append(
+          monoMs: RealtimeJournal.monotonicMs(),
+          spo2: Int(realData.spo2),
+          pr: Int(realData.hr),
+          piTenths: Int(realData.pi),
+          motion: Int(realData.vector),
+          battery: Int(realData.battery),
+          flags: realData.leadState == 1 ? RealtimeJournal.flagProbeOn : 0
+        )
+      }
+      if capturing {
+        capture(for: session.mac)?.realtime(
+          monoMs: RealtimeJournal.monotonicMs(),
+          spo2: Int(realData.spo2),
+          pr: Int(realData.hr),
+          piTenths: Int(realData.pi),
+          motion: Int(realData.vector),
+          battery: Int(realData.battery),
+          flags: realData.leadState == 1 ? RealtimeJournal.flagProbeOn : 0,
+          original: original
+        )
+      }
+    }
 
     emit("onRealtime", [
+      "mac": attachedSession?.mac,
       "spo2": Int(realData.spo2),
       "pr": Int(realData.hr),
       "pi": Int(realData.pi),
@@ -304,42 +581,55 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     ])
   }
 
-  @objc(realDataCallBackWithData:originalData:)
-  func realDataCallBack(with data: Data!, originalData: Data!) {
-    realDataCallBack(with: data)
-  }
-
   @objc(readCompleteWithData:)
   func readComplete(with data: VTFileToRead!) {
+    let mac = attachedSession?.mac
+    if let session = attachedSession {
+      trace.end("readFile", session.readSpan)
+      session.readSpan = 0
+    }
+    defer { commandFinished() }
     guard let file = data else {
-      sendError(code: "READ_FILE_ERROR", message: "History file response was empty")
+      sendError(code: "READ_FILE_ERROR", message: "History file response was empty", mac: mac)
       return
     }
 
     guard file.enLoadResult == VTFileLoadResultSuccess else {
-      sendError(code: "READ_FILE_ERROR", message: "Failed to read history file (code: \(file.enLoadResult.rawValue))")
+      sendError(code: "READ_FILE_ERROR", message: "Failed to read history file (code: \(file.enLoadResult.rawValue))", mac: mac)
       return
     }
 
     guard let buffer = file.fileData as Data? else {
-      sendError(code: "READ_FILE_ERROR", message: "History file buffer missing")
+      sendError(code: "READ_FILE_ERROR", message: "History file buffer missing", mac: mac)
       return
     }
 
+    if capturing, let session = attachedSession {
+      capture(for: session.mac)?.file(
+        monoMs: RealtimeJournal.monotonicMs(),
+        name: session.readName ?? "unnamed",
+        bytes: buffer
+      )
+    }
+
     do {
-      let result = try convertHistoryFile(buffer)
+      let result = try trace.span("decode") { try convertHistoryFile(buffer) }
       emit("onHistoryFile", [
+        "mac": mac,
         "csv": result.csv,
-        "startTime": result.startTime
+        "startTime": result.startTime,
+        "bytes": buffer.count,
+        "firstFileMs": attachedSession?.link.fileArrived()
       ])
     } catch {
-      sendError(code: "READ_FILE_ERROR", message: error.localizedDescription)
+      sendError(code: "READ_FILE_ERROR", message: error.localizedDescription, mac: mac)
     }
   }
 
   @objc(writeDataErrorCode:)
   func writeDataErrorCode(_ errorCode: Int) {
-    sendError(code: "COMMAND_FAILED", message: "Command failed with code \(errorCode)")
+    sendError(code: "COMMAND_FAILED", message: "Command failed with code \(errorCode)", mac: attachedSession?.mac)
+    commandFinished()
   }
 
   // MARK: - Helpers
@@ -350,22 +640,262 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     }
   }
 
-  private func bootstrapAfterServiceReady() {
-    guard connectedPeripheral != nil, let communicator = communicator else {
+  // MARK: - Alarms
+
+  private static let alarmSampleInterval: TimeInterval = 1
+
+  /// While alarms are armed, keep realtime flowing without JS: ask the
+  /// attached ring for a sample when it is idle and has not sent one for a
+  /// second. Only the attached ring streams; the others are mid-transfer or
+  /// waiting for their turn on the communicator.
+  private func pumpRealtime() {
+    guard alarmConfig != nil, !communicatorBusy, let session = attachedSession,
+          session.link.state == .syncing else { return }
+    let idleNs = DispatchTime.now().uptimeNanoseconds &- session.lastSampleAt
+    guard idleNs >= UInt64(Self.alarmSampleInterval * 1e9) else { return }
+    reissue(on: session, busy: false) { $0.beginGetRealData() }
+  }
+
+  /// Runs inside the realtime delegate callback. The notification is posted
+  /// before anything is sent to JS; latencyMs is measured from the sample's arrival.
+  private func alarmFired(_ session: PeripheralSession, _ event: DesatAlarm.Event) {
+    let span = trace.begin()
+    if event.raised {
+      AlarmNotifier.shared.show(mac: session.mac, event)
+    } else {
+      AlarmNotifier.shared.cancel(mac: session.mac, event.kind)
+    }
+    trace.end("alarm.\(event.kind.wire)", span)
+    emit("onAlarm", [
+      "mac": session.mac,
+      "kind": event.kind.wire,
+      "raised": event.raised,
+      "value": event.value,
+      "nadir": event.nadir,
+      "durationMs": event.durationMs,
+      "latencyMs": Int((DispatchTime.now().uptimeNanoseconds &- session.lastSampleAt) / 1_000_000),
+      "notified": event.raised && alarmNotificationsAllowed,
+      "ts": Int(Date().timeIntervalSince1970 * 1000)
+    ])
+  }
+
+  // MARK: - Link bring-up
+
+  private static let connectTimeout: TimeInterval = 15
+  private static let servicesTimeout: TimeInterval = 10
+  private static let infoTimeout: TimeInterval = 4
+  private static let realtimeTimeout: TimeInterval = 2.5
+
+  private func makeLink(mac: String) -> LinkStateMachine {
+    let link = LinkStateMachine()
+    link.onTransition = { [weak self, weak link] t in
+      guard let self = self else { return }
+      self.trace.instant("link.\(t.to.rawValue)")
+      var payload: [String: Any?] = [
+        "mac": mac,
+        "state": t.to.rawValue,
+        "from": t.from.rawValue,
+        "elapsedMs": t.elapsedMs,
+        "attempts": t.attempts,
+        "reason": t.reason
+      ]
+      if t.to == .syncing {
+        payload["firstSampleMs"] = link?.firstSampleMs
+      }
+      self.emit("onLinkState", payload)
+    }
+    return link
+  }
+
+  /// services → info → realtime → syncing, one command each. Info and
+  /// realtime used to be fired together on service-ready; the second write
+  /// raced the first on the communicator and JS papered over it by polling.
+  private func configureBringUp(_ session: PeripheralSession) {
+    // The session owns its link, so the steps can never outlive it
+    let link = session.link
+    link.configure(.services, LinkStateMachine.Step(
+      timeout: Self.servicesTimeout,
+      attempts: 2,
+      action: { [weak self, unowned session] attempt in
+        // Re-pointing the communicator rediscovers services
+        guard attempt > 1, let self = self,
+              self.attachedIdentifier == session.peripheral.identifier else { return }
+        self.attach(session)
+      },
+      onExhausted: { [weak self, unowned session] in
+        guard let self = self else { return }
+        // Still queued behind another ring's transfer: keep waiting, silently
+        guard self.attachedIdentifier == session.peripheral.identifier else {
+          session.link.advance(from: .services, to: .services)
+          return
+        }
+        self.sendError(code: "SERVICE_TIMEOUT", message: "Device services not ready", mac: session.mac)
+        self.central?.cancelPeripheralConnection(session.peripheral)
+      }
+    ))
+    link.configure(.info, LinkStateMachine.Step(
+      timeout: Self.infoTimeout,
+      attempts: 3,
+      action: { [weak self, unowned session] attempt in
+        guard let self = self else { return }
+        if attempt == 1 {
+          self.run(on: session, busy: true) { communicator in
+            self.beginInfoSpan(session)
+            communicator.beginGetInfo()
+          }
+        } else {
+          self.reissue(on: session, busy: true) { $0.beginGetInfo() }
+        }
+      },
+      onExhausted: { [weak self, unowned session] in
+        self?.sendError(code: "INFO_TIMEOUT", message: "No device info", mac: session.mac)
+        session.link.advance(from: .info, to: .realtime, reason: "info timeout")
+      }
+    ))
+    link.configure(.realtime, LinkStateMachine.Step(
+      timeout: Self.realtimeTimeout,
+      attempts: 3,
+      action: { [weak self, unowned session] attempt in
+        guard let self = self else { return }
+        if attempt == 1 {
+          self.run(on: session, busy: false) { $0.beginGetRealData() }
+        } else {
+          self.reissue(on: session, busy: false) { $0.beginGetRealData() }
+        }
+      },
+      onExhausted: { [weak self, unowned session] in
+        self?.sendError(code: "REALTIME_TIMEOUT", message: "No realtime sample", mac: session.mac)
+        session.link.advance(from: .realtime, to: .syncing, reason: "realtime timeout")
+      }
+    ))
+  }
+
+  /// Retry of a command that was already sent: only while `session` still
+  /// holds the communicator, never queued behind another ring.
+  private func reissue(on session: PeripheralSession, busy: Bool, _ command: (VTO2Communicate) -> Void) {
+    guard let communicator = communicator,
+          attachedIdentifier == session.peripheral.identifier,
+          session.isServiceReady else { return }
+    if busy {
+      communicatorBusy = true
+    }
+    command(communicator)
+  }
+
+  private func beginInfoSpan(_ session: PeripheralSession) {
+    if session.infoSpan == 0 {
+      session.infoSpan = trace.begin()
+    }
+  }
+
+  // MARK: - Sessions
+
+  private var attachedSession: PeripheralSession? {
+    guard let identifier = attachedIdentifier else { return nil }
+    return sessions[identifier]
+  }
+
+  private func resolveIdentifier(_ mac: String?) -> UUID? {
+    if let mac = mac {
+      return UUID(uuidString: mac)
+    }
+    return defaultIdentifier ?? (sessions.count == 1 ? sessions.keys.first : nil)
+  }
+
+  private func requireSession(_ mac: String?) throws -> PeripheralSession {
+    guard let identifier = resolveIdentifier(mac), let session = sessions[identifier] else {
+      throw ViatomException(code: "NO_DEVICE_CONNECTED", description: "No active O2Ring connection")
+    }
+    return session
+  }
+
+  /// Run `command` on the communicator for `session`, now if it is attached
+  /// and idle, otherwise once the communicator has switched to it.
+  private func run(on session: PeripheralSession, busy: Bool, _ command: @escaping (VTO2Communicate) -> Void) {
+    let wrapped: (VTO2Communicate) -> Void = { [weak self] communicator in
+      if busy {
+        self?.communicatorBusy = true
+      }
+      command(communicator)
+    }
+    if let communicator = communicator,
+       attachedIdentifier == session.peripheral.identifier,
+       session.isServiceReady,
+       !communicatorBusy {
+      wrapped(communicator)
       return
     }
-    communicator.beginGetInfo()
-    communicator.beginGetRealData()
+    session.pending.append(wrapped)
+    if !communicatorBusy && attachedIdentifier != session.peripheral.identifier {
+      attach(session)
+    }
   }
 
-  private func cleanupConnection() {
-    connectedPeripheral = nil
-    connectedIdentifier = nil
-    connectedModel = nil
-    isServiceReady = false
-    communicator?.delegate = nil
-    communicator?.a5Delegate = nil
-    communicator = nil
+  /// Point the shared communicator at `session`; services are rediscovered and
+  /// `serviceDeployed` runs its pending commands.
+  private func attach(_ session: PeripheralSession) {
+    attachedIdentifier = session.peripheral.identifier
+    session.isServiceReady = false
+    session.serviceSpan = trace.begin()
+
+    let util = VTO2Communicate.sharedInstance()
+    util.delegate = self
+    util.a5Delegate = nil
+    util.timeout = 10000
+    util.peripheral = session.peripheral
+    communicator = util
+  }
+
+  private func runPending(_ session: PeripheralSession) {
+    guard let communicator = communicator else { return }
+    while !communicatorBusy, session.isServiceReady, !session.pending.isEmpty {
+      session.pending.removeFirst()(communicator)
+    }
+  }
+
+  /// The in-flight command finished: keep serving the attached ring, or hand
+  /// the communicator to the next ring with work waiting.
+  private func commandFinished() {
+    communicatorBusy = false
+    if let session = attachedSession, session.isServiceReady, !session.pending.isEmpty {
+      runPending(session)
+      return
+    }
+    attachNextWaiting()
+  }
+
+  private func attachNextWaiting() {
+    guard !communicatorBusy else { return }
+    // Rings with queued commands, and new rings that have not been set up yet
+    let waiting = sessions.values
+      .filter { !$0.pending.isEmpty || !$0.bootstrapped }
+      .sorted { $0.mac < $1.mac }
+    guard !waiting.isEmpty else { return }
+    // Next ring after the attached one, so rings take turns
+    let current = attachedSession?.mac ?? ""
+    let next = waiting.first { $0.mac > current } ?? waiting[0]
+    if next.peripheral.identifier == attachedIdentifier {
+      runPending(next)
+    } else {
+      attach(next)
+    }
+  }
+
+  private func removeSession(_ identifier: UUID, reason: String) {
+    pendingConnects.removeValue(forKey: identifier)?.link.stop(reason: reason)
+    guard let session = sessions.removeValue(forKey: identifier) else { return }
+    session.link.stop(reason: reason)
+    if defaultIdentifier == identifier {
+      defaultIdentifier = nil
+    }
+    if attachedIdentifier == identifier {
+      attachedIdentifier = nil
+      communicatorBusy = false
+      communicator?.delegate = nil
+      communicator?.a5Delegate = nil
+      communicator = nil
+      attachNextWaiting()
+    }
   }
 
   private func ensurePoweredOn() async throws {
@@ -543,8 +1073,8 @@ final class ViatomManager: NSObject, CBCentralManagerDelegate, VTO2CommunicateDe
     sink(name, body)
   }
 
-  private func sendError(code: String, message: String) {
-    emit("onError", ["code": code, "message": message])
+  private func sendError(code: String, message: String, mac: String? = nil) {
+    emit("onError", ["mac": mac, "code": code, "message": message])
   }
 }
 
@@ -575,10 +1105,12 @@ public final class ViatomModule: Module {
       "onConnected",
       "onDisconnected",
       "onServiceReady",
+      "onLinkState",
       "onRealtime",
       "onInfo",
       "onHistoryFile",
       "onReadProgress",
+      "onAlarm",
       "onError"
     )
 
@@ -630,33 +1162,122 @@ public final class ViatomModule: Module {
       }
     }
 
-    AsyncFunction("disconnect") {
+    AsyncFunction("disconnect") { (mac: String?) in
       return await self.withManager { manager in
-        manager.disconnect()
+        manager.disconnect(mac: mac)
       }
     }
 
-    AsyncFunction("startRealtime") {
+    AsyncFunction("startRealtime") { (mac: String?) in
       return try await self.withManager { manager in
-        try manager.startRealtime()
+        try manager.startRealtime(mac: mac)
       }
     }
 
-    AsyncFunction("stopRealtime") {
+    AsyncFunction("stopRealtime") { (_: String?) in
       return await self.withManager { manager in
         manager.stopRealtime()
       }
     }
 
-    AsyncFunction("getInfo") {
+    AsyncFunction("getInfo") { (mac: String?) in
       return try await self.withManager { manager in
-        try manager.getInfo()
+        try manager.getInfo(mac: mac)
       }
     }
 
-    AsyncFunction("readHistoryFile") { (fileName: String) in
+    AsyncFunction("readHistoryFile") { (fileName: String, mac: String?) in
       return try await self.withManager { manager in
-        try manager.readHistory(fileName: fileName)
+        try manager.readHistory(fileName: fileName, mac: mac)
+      }
+    }
+
+    AsyncFunction("setAlarmConfig") { (config: [String: Any]?) in
+      return await self.withManager { manager in
+        await manager.setAlarmConfig(config)
+      }
+    }
+
+    AsyncFunction("setJournaling") { (enabled: Bool) in
+      return await self.withManager { manager in
+        manager.setJournaling(enabled)
+      }
+    }
+
+    // Disk work runs here, off the main actor
+    AsyncFunction("readJournal") { (mac: String, sinceMs: Double?) -> [String: Any] in
+      let since = Int64(sinceMs ?? 0)
+      let c: RealtimeJournal.Columns
+      if let live = await self.withManager({ manager in manager.openJournal(for: mac) }) {
+        live.flush()
+        c = live.read(sinceEpochMs: since)
+      } else {
+        c = await self.withManager { manager in
+          manager.openJournal(for: mac)?.read(sinceEpochMs: since) ??
+            manager.readClosedJournal(mac, sinceEpochMs: since)
+        }
+      }
+      return [
+        "t": c.t.map { Double($0) },
+        "spo2": c.spo2,
+        "pr": c.pr,
+        "pi": c.pi,
+        "motion": c.motion,
+        "battery": c.battery,
+        "flags": c.flags
+      ]
+    }
+
+    AsyncFunction("getJournalStats") {
+      return await self.withManager { manager in
+        manager.journalStats()
+      }
+    }
+
+    // Group-commit throughput on this device's storage, one run per batch size
+    AsyncFunction("benchmarkJournal") { (records: Int) -> [[String: Any]] in
+      let scratch = FileManager.default.temporaryDirectory.appendingPathComponent("o2ring-journal-bench")
+      return [1, 8, 64, 512].map { batch in
+        let r = RealtimeJournal.benchmark(scratch: scratch, records: records, commitRecords: batch)
+        return [
+          "commitRecords": r.commitRecords,
+          "records": r.records,
+          "fsyncs": r.fsyncs,
+          "wallMs": r.wallMs,
+          "recordsPerSec": r.recordsPerSec,
+          "meanBatch": r.meanBatch
+        ]
+      }
+    }
+
+    AsyncFunction("setCapture") { (enabled: Bool) in
+      return await self.withManager { manager in
+        manager.setCapture(enabled)
+      }
+    }
+
+    AsyncFunction("listCaptures") {
+      return await self.withManager { manager in
+        manager.listCaptures()
+      }
+    }
+
+    AsyncFunction("getSessions") {
+      return await self.withManager { manager in
+        manager.listSessions()
+      }
+    }
+
+    AsyncFunction("setTracing") { (enabled: Bool) in
+      return await MainActor.run {
+        ViatomTrace.shared.enabled = enabled
+        return true
+      }
+    }
+
+    AsyncFunction("drainTrace") {
+      return await MainActor.run {
+        ViatomTrace.shared.drain()
       }
     }
   }
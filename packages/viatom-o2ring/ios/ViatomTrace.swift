@@ -0,0 +1,79 @@
+import Foundation
+
+/// Fixed-size span ring for native pipeline tracing.
+///
+/// Everything in `ViatomManager` runs on the main actor, so the ring needs no
+/// locking: recording is a few array stores into preallocated storage.
+@MainActor
+final class ViatomTrace {
+  static let shared = ViatomTrace()
+
+  private static let capacity = 2048 // power of two
+  private static let mask = capacity - 1
+
+  var enabled = false
+
+  private var cursor = 0
+  private var names = [String?](repeating: nil, count: ViatomTrace.capacity)
+  private var cats = [String](repeating: "", count: ViatomTrace.capacity)
+  private var startNs = [UInt64](repeating: 0, count: ViatomTrace.capacity)
+  private var durNs = [UInt64](repeating: 0, count: ViatomTrace.capacity)
+
+  // Turns uptime nanoseconds into epoch microseconds so native spans line up
+  // with the JS ring in the exported trace.
+  private let epochOffsetUs =
+    Date().timeIntervalSince1970 * 1_000_000 - Double(DispatchTime.now().uptimeNanoseconds) / 1000
+
+  /// Start time for `end`, or 0 when tracing is off.
+  func begin() -> UInt64 {
+    enabled ? DispatchTime.now().uptimeNanoseconds : 0
+  }
+
+  func end(_ name: String, _ start: UInt64, cat: String = "native") {
+    guard enabled, start != 0 else { return }
+    let now = DispatchTime.now().uptimeNanoseconds
+    record(name, cat, start, now &- start)
+  }
+
+  func instant(_ name: String, cat: String = "native") {
+    guard enabled else { return }
+    record(name, cat, DispatchTime.now().uptimeNanoseconds, 0)
+  }
+
+  func span<T>(_ name: String, cat: String = "native", _ block: () throws -> T) rethrows -> T {
+    let start = begin()
+    defer { end(name, start, cat: cat) }
+    return try block()
+  }
+
+  private func record(_ name: String, _ cat: String, _ start: UInt64, _ dur: UInt64) {
+    let slot = cursor & Self.mask
+    cursor &+= 1
+    names[slot] = name
+    cats[slot] = cat
+    startNs[slot] = start
+    durNs[slot] = dur
+  }
+
+  /// Snapshot and clear the ring, oldest first.
+  func drain() -> [[String: Any]] {
+    let end = cursor
+    let count = min(end, Self.capacity)
+    var out: [[String: Any]] = []
+    out.reserveCapacity(count)
+    for i in 0..<count {
+      let slot = (end - count + i) & Self.mask
+      guard let name = names[slot] else { continue }
+      out.append([
+        "name": name,
+        "cat": cats[slot],
+        "ts": epochOffsetUs + Double(startNs[slot]) / 1000,
+        "dur": Double(durNs[slot]) / 1000,
+        "tid": 1
+      ])
+      names[slot] = nil
+    }
+    cursor = 0
+    return out
+  }
+}
@@ -20,6 +20,8 @@ function addBluetoothPermissions(config) {
       "android.permission.BLUETOOTH_ADVERTISE",
       "android.permission.ACCESS_COARSE_LOCATION",
       "android.permission.ACCESS_FINE_LOCATION",
+      // Native SpO2 / pulse-rate alarms (Android 13+)
+      "android.permission.POST_NOTIFICATIONS",
     ];
 
     manifest["uses-permission"] = manifest["uses-permission"] || [];
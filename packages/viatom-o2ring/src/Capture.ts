@@ -0,0 +1,280 @@
+// Packet captures from the native modules (PacketCapture.kt / .swift) and a
+// driver that replays them through the same decoders and analysis the app
+// runs, at the recorded pace or as fast as possible. A capture taken in the
+// field reproduces on any Node host, and a fixed capture replayed at full
+// speed is a deterministic performance regression test.
+//
+//   header  16 B: "O2RC" | version u8 | platform u8 | u16 0 | base epoch ms i64
+//   record  12 B: t u32 (ms since open) | kind u8 | u8 0 | u16 0 | length u32
+//                 | payload
+//   REALTIME 8 B: spo2 u8 | pr u16 | pi u8 (tenths) | motion u8 | battery u8
+//                 | flags u8 (bit 0 probe on) | u8 0 | original packet
+//   FILE        : name length u8 | name UTF-8 | file bytes as read
+//
+// Realtime records keep the SDK's parsed fields: Lepu only hands out
+// parsed objects, and VTO2Lib's packet layout is private. iOS captures
+// append the original packet for inspection.
+
+import { decodeNightFile, nightLength, NightSummary, O2Night, summarizeNight } from "./O2Night";
+import { realClock, SessionClock } from "./Sessions";
+import { buildValidityMask, countValid } from "./ValidityMask";
+import { WireFormatError } from "./WireStruct";
+
+export const CAPTURE_MAGIC = 0x4352324f; // "O2RC" read as u32 LE
+export const CAPTURE_VERSION = 1;
+const HEADER = 16;
+const RECORD_HEADER = 12;
+const REALTIME_FIELDS = 8;
+const KIND_REALTIME = 1;
+const KIND_FILE = 2;
+
+export type CapturePlatform = "android" | "ios" | "unknown";
+
+export type CaptureRecord =
+  | {
+      kind: "realtime";
+      /** ms since the capture was opened. */
+      t: number;
+      spo2: number;
+      pr: number;
+      /** Perfusion index in tenths. */
+      pi: number;
+      motion: number;
+      battery: number;
+      probeOn: boolean;
+      /** Packet as received; empty on Android. */
+      original: Uint8Array;
+    }
+  | { kind: "file"; t: number; name: string; bytes: Uint8Array };
+
+/** Fields of a realtime record as `CaptureWriter` takes them. */
+export type CaptureSample = {
+  spo2: number;
+  pr: number;
+  pi?: number;
+  motion?: number;
+  battery?: number;
+  probeOn?: boolean;
+};
+
+export type Capture = {
+  platform: CapturePlatform;
+  baseEpochMs: number;
+  records: CaptureRecord[];
+  /** Bytes after the last complete record (a torn tail or an unknown kind). */
+  trailingBytes: number;
+};
+
+/** Payloads are views into `bytes`, not copies. */
+export function decodeCapture(bytes: Uint8Array): Capture {
+  if (bytes.length < HEADER) throw new WireFormatError("Capture: truncated");
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getUint32(0, true) !== CAPTURE_MAGIC) throw new WireFormatError("Capture: bad magic");
+  const version = view.getUint8(4);
+  if (version !== CAPTURE_VERSION) {
+    throw new WireFormatError(`Capture: unsupported version ${version}`);
+  }
+  const platform: CapturePlatform =
+    view.getUint8(5) === 1 ? "android" : view.getUint8(5) === 2 ? "ios" : "unknown";
+  const baseEpochMs = view.getUint32(8, true) + view.getInt32(12, true) * 0x100000000;
+
+  const records: CaptureRecord[] = [];
+  let at = HEADER;
+  while (at + RECORD_HEADER <= bytes.length) {
+    const t = view.getUint32(at, true);
+    const kind = view.getUint8(at + 4);
+    const length = view.getUint32(at + 8, true);
+    const start = at + RECORD_HEADER;
+    const end = start + length;
+    if (end > bytes.length) break;
+    if (kind === KIND_REALTIME && length >= REALTIME_FIELDS) {
+      records.push({
+        kind: "realtime",
+        t,
+        spo2: bytes[start],
+        pr: view.getUint16(start + 1, true),
+        pi: bytes[start + 3],
+        motion: bytes[start + 4],
+        battery: bytes[start + 5],
+        probeOn: (bytes[start + 6] & 1) === 1,
+        original: bytes.subarray(start + REALTIME_FIELDS, end),
+      });
+    } else if (kind === KIND_FILE && length >= 1 && 1 + bytes[start] <= length) {
+      const nameEnd = start + 1 + bytes[start];
+      records.push({
+        kind: "file",
+        t,
+        name: new TextDecoder().decode(bytes.subarray(start + 1, nameEnd)),
+        bytes: bytes.subarray(nameEnd, end),
+      });
+    } else {
+      break;
+    }
+    at = end;
+  }
+  return { platform, baseEpochMs, records, trailingBytes: bytes.length - at };
+}
+
+/** Builds captures in the native layout, for fixtures and synthetic sessions. */
+export class CaptureWriter {
+  private readonly chunks: Uint8Array[] = [];
+  private size = HEADER;
+
+  constructor(baseEpochMs: number, platform: CapturePlatform = "unknown") {
+    const head = new Uint8Array(HEADER);
+    const view = new DataView(head.buffer);
+    view.setUint32(0, CAPTURE_MAGIC, true);
+    view.setUint8(4, CAPTURE_VERSION);
+    view.setUint8(5, platform === "android" ? 1 : platform === "ios" ? 2 : 0);
+    const epoch = Math.round(baseEpochMs);
+    view.setUint32(8, epoch >>> 0, true);
+    view.setInt32(12, Math.floor(epoch / 0x100000000), true);
+    this.chunks.push(head);
+  }
+
+  realtime(t: number, s: CaptureSample, original: Uint8Array = new Uint8Array(0)) {
+    const rec = this.record(t, KIND_REALTIME, REALTIME_FIELDS + original.length);
+    const view = new DataView(rec.buffer, rec.byteOffset);
+    rec[0] = s.spo2;
+    view.setUint16(1, s.pr, true);
+    rec[3] = s.pi ?? 0;
+    rec[4] = s.motion ?? 0;
+    rec[5] = s.battery ?? 0;
+    rec[6] = s.probeOn === false ? 0 : 1;
+    rec.set(original, REALTIME_FIELDS);
+    return this;
+  }
+
+  file(t: number, name: string, bytes: Uint8Array) {
+    const encoded = new TextEncoder().encode(name).subarray(0, 255);
+    const rec = this.record(t, KIND_FILE, 1 + encoded.length + bytes.length);
+    rec[0] = encoded.length;
+    rec.set(encoded, 1);
+    rec.set(bytes, 1 + encoded.length);
+    return this;
+  }
+
+  finish(): Uint8Array {
+    const out = new Uint8Array(this.size);
+    let at = 0;
+    for (const c of this.chunks) {
+      out.set(c, at);
+      at += c.length;
+    }
+    return out;
+  }
+
+  /** Writes the record header and returns the payload to fill in. */
+  private record(t: number, kind: number, length: number) {
+    const rec = new Uint8Array(RECORD_HEADER + length);
+    const view = new DataView(rec.buffer);
+    view.setUint32(0, Math.max(0, Math.round(t)) >>> 0, true);
+    view.setUint8(4, kind);
+    view.setUint32(8, length, true);
+    this.chunks.push(rec);
+    this.size += rec.length;
+    return rec.subarray(RECORD_HEADER);
+  }
+}
+
+export type ReplaySink = {
+  realtime?(record: Extract<CaptureRecord, { kind: "realtime" }>, epochMs: number): void;
+  file?(record: Extract<CaptureRecord, { kind: "file" }>, epochMs: number): void | Promise<void>;
+};
+
+export type ReplayOptions = {
+  /** 1 replays at the recorded pace; Infinity (default) as fast as possible. */
+  speed?: number;
+  clock?: SessionClock;
+};
+
+/** Feed every record to `sink` in capture order, paced by `speed`. */
+export async function replayCapture(
+  capture: Capture,
+  sink: ReplaySink,
+  options: ReplayOptions = {}
+) {
+  const speed = options.speed ?? Infinity;
+  const clock = options.clock ?? realClock;
+  const started = clock.now();
+  for (const r of capture.records) {
+    if (Number.isFinite(speed) && speed > 0) {
+      const wait = started + r.t / speed - clock.now();
+      if (wait > 0) await new Promise<void>((resolve) => clock.setTimeout(resolve, wait));
+    }
+    const epochMs = capture.baseEpochMs + r.t;
+    if (r.kind === "realtime") sink.realtime?.(r, epochMs);
+    else await sink.file?.(r, epochMs);
+  }
+  return clock.now() - started;
+}
+
+export type ReplayResult = {
+  records: number;
+  realtimeSamples: number;
+  /** Realtime samples the validity mask keeps for SpO2. */
+  realtimeValid: number;
+  files: number;
+  fileBytes: number;
+  /** Files the decoders rejected. */
+  failedFiles: { name: string; error: string }[];
+  summaries: { name: string; summary: NightSummary }[];
+  wallMs: number;
+};
+
+/**
+ * Replay through the app's analysis path: files through `decodeNightFile`
+ * and `summarizeNight`, realtime samples through the validity mask.
+ */
+export async function replayThroughPipeline(
+  capture: Capture,
+  options: ReplayOptions = {}
+): Promise<ReplayResult> {
+  const realtime = capture.records.filter((r) => r.kind === "realtime").length;
+  const spo2 = new Uint8Array(realtime);
+  const pr = new Uint16Array(realtime);
+  const motion = new Uint8Array(realtime);
+  const probeOn = new Uint8Array(realtime);
+  let n = 0;
+  let files = 0;
+  let fileBytes = 0;
+  const failedFiles: ReplayResult["failedFiles"] = [];
+  const summaries: ReplayResult["summaries"] = [];
+
+  const wallMs = await replayCapture(
+    capture,
+    {
+      realtime(r) {
+        spo2[n] = r.spo2;
+        pr[n] = r.pr;
+        motion[n] = r.motion;
+        probeOn[n] = r.probeOn ? 1 : 0;
+        n++;
+      },
+      file(r) {
+        files++;
+        fileBytes += r.bytes.length;
+        let night: O2Night;
+        try {
+          night = decodeNightFile(r.bytes, 0);
+        } catch (e) {
+          failedFiles.push({ name: r.name, error: String((e as Error).message ?? e) });
+          return;
+        }
+        if (nightLength(night) > 0) summaries.push({ name: r.name, summary: summarizeNight(night) });
+      },
+    },
+    options
+  );
+
+  return {
+    records: capture.records.length,
+    realtimeSamples: n,
+    realtimeValid: countValid(buildValidityMask({ spo2, pr, motion, probeOn }).spo2),
+    files,
+    fileBytes,
+    failedFiles,
+    summaries,
+    wallMs,
+  };
+}
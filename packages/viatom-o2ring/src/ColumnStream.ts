@@ -0,0 +1,235 @@
+// Block-framed columnar container for signals too long to hold in memory.
+//
+//   "O2CS" | version u8 | reserved u8 | headerLen u16 LE | JSON header
+//   | frames, each starting on an 8-byte boundary:
+//     count u32 | start u32 | column blocks in header order, each padded to 8
+//
+// Same column model as NightArchive, but written a block at a time as a
+// decoder produces it, so neither side ever holds more than one block. The
+// total length is not in the header (it is unknown when the header is
+// written); readers sum the frame counts.
+
+import { ArchiveColumnType } from "./NightArchive";
+import { Column, WireFormatError } from "./WireStruct";
+
+export const COLUMN_STREAM_MAGIC = 0x5343324f; // "O2CS" read as u32 LE
+export const COLUMN_STREAM_VERSION = 1;
+/** Samples per block unless a decoder is told otherwise. */
+export const COLUMN_BLOCK_SAMPLES = 4096;
+const PREAMBLE = 8;
+const FRAME_HEADER = 8;
+const ALIGN = 8;
+
+const BYTES: Record<ArchiveColumnType, number> = { u8: 1, i16: 2, u16: 2, i32: 4, f32: 4 };
+
+type ColumnCtor = {
+  new (length: number): Column;
+  new (buffer: ArrayBufferLike, byteOffset?: number, length?: number): Column;
+};
+
+const CTOR: Record<ArchiveColumnType, ColumnCtor> = {
+  u8: Uint8Array,
+  i16: Int16Array,
+  u16: Uint16Array,
+  i32: Int32Array,
+  f32: Float32Array,
+};
+
+export type ColumnSpec = { name: string; type: ArchiveColumnType };
+
+export type ColumnStreamHeader = {
+  deviceId: string;
+  /** What the columns hold, e.g. "ppg" or "baby". */
+  kind: string;
+  startTime: number;
+  intervalS: number;
+  columns: ColumnSpec[];
+};
+
+/**
+ * Samples `[start, start + count)`. The arrays belong to the producer and
+ * are reused for the next block: a sink has to copy or write them before
+ * it returns.
+ */
+export type ColumnBlock = {
+  start: number;
+  count: number;
+  columns: Record<string, Column>;
+};
+
+export type ColumnSink = (block: ColumnBlock) => void;
+
+const align = (n: number) => (n + ALIGN - 1) & ~(ALIGN - 1);
+
+/**
+ * Fixed-capacity block of columns that a decoder fills in place and hands
+ * to `sink` whenever it is full. Allocated once; its size bounds the
+ * decoder's working set whatever the input length.
+ */
+export class ColumnBlockBuffer {
+  readonly columns: Record<string, Column> = {};
+  /** Samples filled in the current block. */
+  fill = 0;
+  /** Index of the block's first sample in the whole signal. */
+  start = 0;
+
+  constructor(
+    types: Record<string, ArchiveColumnType>,
+    readonly capacity: number,
+    private readonly sink: ColumnSink
+  ) {
+    if (capacity <= 0) throw new Error("ColumnBlockBuffer: capacity must be positive");
+    for (const name in types) this.columns[name] = new CTOR[types[name]](capacity);
+  }
+
+  get room() {
+    return this.capacity - this.fill;
+  }
+
+  /** Mark `n` more samples as written; emits the block once it is full. */
+  commit(n: number) {
+    this.fill += n;
+    if (this.fill >= this.capacity) this.flush();
+  }
+
+  /** Emit whatever is filled, full or not. */
+  flush() {
+    if (this.fill === 0) return;
+    let columns = this.columns;
+    if (this.fill < this.capacity) {
+      columns = {};
+      for (const name in this.columns) columns[name] = this.columns[name].subarray(0, this.fill);
+    }
+    this.sink({ start: this.start, count: this.fill, columns });
+    this.start += this.fill;
+    this.fill = 0;
+  }
+}
+
+/**
+ * Encodes blocks as frames and passes each to `out`, which must consume
+ * the bytes before returning (the frame buffer is reused). Use `sink` as a
+ * decoder's `ColumnSink`.
+ */
+export class ColumnStreamWriter {
+  /** Samples written so far. */
+  samples = 0;
+  /** Bytes passed to `out` so far, preamble included. */
+  bytes = 0;
+
+  private readonly types: ArchiveColumnType[];
+  private readonly names: string[];
+  private frame = new Uint8Array(0);
+
+  constructor(
+    header: ColumnStreamHeader,
+    private readonly out: (bytes: Uint8Array) => void
+  ) {
+    this.names = header.columns.map((c) => c.name);
+    this.types = header.columns.map((c) => c.type);
+    const json = new TextEncoder().encode(JSON.stringify(header));
+    if (json.length > 0xffff) throw new WireFormatError("ColumnStream: header too large");
+    const head = new Uint8Array(align(PREAMBLE + json.length));
+    const view = new DataView(head.buffer);
+    view.setUint32(0, COLUMN_STREAM_MAGIC, true);
+    view.setUint8(4, COLUMN_STREAM_VERSION);
+    view.setUint16(6, json.length, true);
+    head.set(json, PREAMBLE);
+    this.emit(head);
+  }
+
+  readonly sink: ColumnSink = (block) => {
+    let size = FRAME_HEADER;
+    for (const t of this.types) size += align(block.count * BYTES[t]);
+    if (this.frame.length < size) this.frame = new Uint8Array(size);
+    const frame = this.frame;
+    frame.fill(0, 0, size);
+    const view = new DataView(frame.buffer);
+    view.setUint32(0, block.count, true);
+    view.setUint32(4, block.start, true);
+    let at = FRAME_HEADER;
+    for (let c = 0; c < this.names.length; c++) {
+      const col = block.columns[this.names[c]];
+      if (!col || col.length < block.count) {
+        throw new Error(`ColumnStreamWriter: block has no column ${this.names[c]}`);
+      }
+      // typed arrays are host order; every target the app runs on is LE
+      const n = block.count * BYTES[this.types[c]];
+      frame.set(new Uint8Array(col.buffer, col.byteOffset, n), at);
+      at += align(n);
+    }
+    this.samples += block.count;
+    this.emit(frame.subarray(0, size));
+  };
+
+  private emit(bytes: Uint8Array) {
+    this.bytes += bytes.length;
+    this.out(bytes);
+  }
+}
+
+export function readColumnStreamHeader(bytes: Uint8Array): ColumnStreamHeader {
+  if (bytes.length < PREAMBLE) throw new WireFormatError("ColumnStream: truncated");
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getUint32(0, true) !== COLUMN_STREAM_MAGIC) {
+    throw new WireFormatError("ColumnStream: bad magic");
+  }
+  const version = view.getUint8(4);
+  if (version !== COLUMN_STREAM_VERSION) {
+    throw new WireFormatError(`ColumnStream: unsupported version ${version}`);
+  }
+  const len = view.getUint16(6, true);
+  if (PREAMBLE + len > bytes.length) throw new WireFormatError("ColumnStream: truncated header");
+  return JSON.parse(new TextDecoder().decode(bytes.subarray(PREAMBLE, PREAMBLE + len)));
+}
+
+/**
+ * Walk the frames of a whole stream in memory, calling `sink` with views
+ * into `bytes`. A torn last frame is left out and its bytes reported.
+ */
+export function forEachColumnBlock(bytes: Uint8Array, sink: ColumnSink) {
+  const header = readColumnStreamHeader(bytes);
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  let at = align(PREAMBLE + view.getUint16(6, true));
+  let samples = 0;
+  while (at + FRAME_HEADER <= bytes.length) {
+    const count = view.getUint32(at, true);
+    const start = view.getUint32(at + 4, true);
+    let p = at + FRAME_HEADER;
+    let end = p;
+    for (const c of header.columns) end += align(count * BYTES[c.type]);
+    if (end > bytes.length) break;
+    const columns: Record<string, Column> = {};
+    for (const c of header.columns) {
+      const n = count * BYTES[c.type];
+      // copy only when a column lands unaligned for its element type
+      const abs = bytes.byteOffset + p;
+      columns[c.name] =
+        abs % BYTES[c.type] === 0
+          ? new CTOR[c.type](bytes.buffer, abs, count)
+          : new CTOR[c.type](bytes.slice(p, p + n).buffer);
+      p += align(n);
+    }
+    sink({ start, count, columns });
+    samples += count;
+    at = end;
+  }
+  return { header, samples, trailingBytes: bytes.length - at };
+}
+
+/** Concatenate a whole stream into one column per name. */
+export function decodeColumnStream(bytes: Uint8Array) {
+  const blocks: ColumnBlock[] = [];
+  const { header, samples, trailingBytes } = forEachColumnBlock(bytes, (b) => blocks.push(b));
+  const columns: Record<string, Column> = {};
+  for (const c of header.columns) {
+    const col = new CTOR[c.type](samples);
+    let at = 0;
+    for (const b of blocks) {
+      col.set(b.columns[c.name] as never, at);
+      at += b.count;
+    }
+    columns[c.name] = col;
+  }
+  return { header, count: samples, columns, trailingBytes };
+}
@@ -0,0 +1,377 @@
+// 12-lead view over decoded ER3 / M-series origin files.
+//
+// `parseER3OriginFile:head:leadFragments:tail:` decodes the whole file and
+// then hands back 12 NSData lead buffers. Here the compressed body is fed
+// through `Er3WaveDecoder` one slice at a time; each slice's frames are
+// written straight into per-lead Float32Array columns in mV, so only one
+// slice of int16 samples is ever held. `decodeEr3LeadsAsync` yields to the
+// event loop between slices so a 24 h file does not stall the JS thread.
+//
+// The origin file carries no lead state. Lead-off segments come from the
+// `VTMER3LeadState` observations the caller made while recording
+// (realtime `VTMER3RunParams`, see `er3LeadStateFromElectrodes`).
+
+import {
+  Er3Cable,
+  Er3Compression,
+  er3DataChecksum,
+  Er3FileHead,
+  Er3FileTail,
+  er3MaxSamples,
+  Er3WaveDecoder,
+  ER3_FILE_HEAD_SIZE,
+  parseEr3OriginFile,
+} from "./Er3Wave";
+import { ER3_MV_PER_LSB } from "./MvConvert";
+import { WireFormatError } from "./WireStruct";
+
+/** Bit order of `VTMER3LeadState` (bit = 1 means the lead is off). */
+export enum Er3Lead {
+  I = 0,
+  II,
+  III,
+  aVR,
+  aVL,
+  aVF,
+  V1,
+  V2,
+  V3,
+  V4,
+  V5,
+  V6,
+}
+
+export const ER3_LEAD_COUNT = 12;
+export const ER3_LEAD_NAMES = [
+  "I",
+  "II",
+  "III",
+  "aVR",
+  "aVL",
+  "aVF",
+  "V1",
+  "V2",
+  "V3",
+  "V4",
+  "V5",
+  "V6",
+];
+
+/** Compressed bytes per slice; a few seconds of 8-channel data. */
+const SLICE_BYTES = 16384;
+
+// VTMER3ElectrodesState bits.
+const E_RA = 1 << 0;
+const E_LA = 1 << 1;
+const E_LL = 1 << 2;
+const E_V1 = 1 << 4;
+
+const NO_LEAD = -1;
+
+/**
+ * Which lead each recorded channel carries. Limb leads III/aVR/aVL/aVF are
+ * never stored; they are derived from I and II (Einthoven/Goldberger).
+ */
+export function er3ChannelLayout(cable: Er3Cable): number[] {
+  switch (cable) {
+    case Er3Cable.Lead10:
+      return [
+        Er3Lead.I,
+        Er3Lead.II,
+        Er3Lead.V1,
+        Er3Lead.V2,
+        Er3Lead.V3,
+        Er3Lead.V4,
+        Er3Lead.V5,
+        Er3Lead.V6,
+      ];
+    case Er3Cable.Lead6:
+    case Er3Cable.Lead6Leg:
+      return [Er3Lead.I, Er3Lead.II, Er3Lead.V1, Er3Lead.V2];
+    case Er3Cable.Lead5:
+    case Er3Cable.Lead5Leg:
+      return [Er3Lead.I, Er3Lead.II, Er3Lead.V1, NO_LEAD];
+    case Er3Cable.Lead3:
+    case Er3Cable.Lead3Temp:
+    case Er3Cable.Lead4Leg:
+      return [Er3Lead.I, Er3Lead.II, NO_LEAD, NO_LEAD];
+    default:
+      throw new WireFormatError(
+        `er3ChannelLayout: unsupported cable 0x${cable.toString(16)}`
+      );
+  }
+}
+
+/**
+ * Electrode-off bits (`VTMER3RunParams.electrodes_state`) to lead-off bits,
+ * like `VTMBLEParser parseCable:state:`. Leads the cable does not carry are
+ * reported off.
+ */
+export function er3LeadStateFromElectrodes(
+  cable: Er3Cable,
+  electrodes: number
+): number {
+  const layout = er3ChannelLayout(cable);
+  let state = 0;
+
+  const iOff = (electrodes & (E_RA | E_LA)) !== 0;
+  const iiOff = (electrodes & (E_RA | E_LL)) !== 0;
+  if (iOff) state |= 1 << Er3Lead.I;
+  if (iiOff) state |= 1 << Er3Lead.II;
+  if (iOff || iiOff) {
+    state |=
+      (1 << Er3Lead.III) |
+      (1 << Er3Lead.aVR) |
+      (1 << Er3Lead.aVL) |
+      (1 << Er3Lead.aVF);
+  }
+
+  // Chest leads reference the Wilson terminal, so any limb electrode off
+  // takes them down too.
+  const wilsonOff = (electrodes & (E_RA | E_LA | E_LL)) !== 0;
+  for (let v = 0; v < 6; v++) {
+    const lead = Er3Lead.V1 + v;
+    if (
+      !layout.includes(lead) ||
+      wilsonOff ||
+      (electrodes & (E_V1 << v)) !== 0
+    ) {
+      state |= 1 << lead;
+    }
+  }
+  return state;
+}
+
+export type Er3LeadStateSample = {
+  /** Sample offset from the start of the recording. */
+  offset: number;
+  /** `VTMER3LeadState.value` effective from `offset` onward. */
+  leadState: number;
+};
+
+/** Half-open `[start, end)` sample range. */
+export type Er3Segment = { start: number; end: number };
+
+/**
+ * Turn a time-ordered list of lead-state observations into lead-off
+ * segments per lead.
+ */
+export function er3LeadOffSegments(
+  states: Er3LeadStateSample[],
+  totalSamples: number
+): Er3Segment[][] {
+  const segments: Er3Segment[][] = [];
+  const openAt = new Int32Array(ER3_LEAD_COUNT).fill(-1);
+  for (let l = 0; l < ER3_LEAD_COUNT; l++) segments.push([]);
+
+  for (const { offset, leadState } of states) {
+    const at = Math.min(Math.max(offset, 0), totalSamples);
+    for (let l = 0; l < ER3_LEAD_COUNT; l++) {
+      const off = (leadState >> l) & 1;
+      if (off && openAt[l] < 0) {
+        openAt[l] = at;
+      } else if (!off && openAt[l] >= 0) {
+        if (at > openAt[l]) segments[l].push({ start: openAt[l], end: at });
+        openAt[l] = -1;
+      }
+    }
+  }
+  for (let l = 0; l < ER3_LEAD_COUNT; l++) {
+    if (openAt[l] >= 0 && totalSamples > openAt[l]) {
+      segments[l].push({ start: openAt[l], end: totalSamples });
+    }
+  }
+  return segments;
+}
+
+export type Er3LeadSet = {
+  cable: Er3Cable;
+  samplesPerLead: number;
+  /** Indexed by `Er3Lead`; null for leads the cable does not carry. */
+  leads: (Float32Array | null)[];
+  /** Indexed by `Er3Lead`, from `Er3LeadOptions.leadStates`. */
+  leadOff: Er3Segment[][];
+  checksumOk: boolean;
+  recordingTime: number;
+};
+
+export type Er3LeadOptions = {
+  /** mV per LSB. */
+  scale?: number;
+  /** See `decodeEr3OriginFile`. */
+  compression?: Er3Compression;
+  /** Lead-state observations made while the file was recorded. */
+  leadStates?: Er3LeadStateSample[];
+};
+
+type Job = {
+  body: Uint8Array;
+  /** Next body byte to decode. */
+  offset: number;
+  decoder: Er3WaveDecoder;
+  /** One slice of interleaved samples, plus a partial frame carried over. */
+  scratch: Int16Array;
+  carry: number;
+  channels: number;
+  /** Stored channel index per lead, or NO_LEAD. */
+  channelOf: Int32Array;
+  scale: number;
+  leads: (Float32Array | null)[];
+  /** Frames written to `leads` so far. */
+  frames: number;
+  checksum: number;
+  head: Er3FileHead;
+  tail: Er3FileTail;
+  leadStates: Er3LeadStateSample[];
+};
+
+function startLeads(
+  file: Uint8Array,
+  {
+    scale = ER3_MV_PER_LSB,
+    compression = Er3Compression.Differential,
+    leadStates = [],
+  }: Er3LeadOptions
+): Job {
+  const { head, tail, channels, body } = parseEr3OriginFile(file);
+  const layout = er3ChannelLayout(head.cable);
+  // Upper bound; trimmed to the decoded frame count at the end.
+  const maxFrames = Math.floor(
+    er3MaxSamples(body.length, compression, channels) / channels
+  );
+
+  const channelOf = new Int32Array(ER3_LEAD_COUNT).fill(NO_LEAD);
+  layout.forEach((lead, ch) => {
+    if (lead !== NO_LEAD) channelOf[lead] = ch;
+  });
+  const hasLimbs =
+    channelOf[Er3Lead.I] !== NO_LEAD && channelOf[Er3Lead.II] !== NO_LEAD;
+
+  const leads: (Float32Array | null)[] = [];
+  for (let lead = 0; lead < ER3_LEAD_COUNT; lead++) {
+    const derived = lead >= Er3Lead.III && lead <= Er3Lead.aVF;
+    leads.push(
+      (derived ? hasLimbs : channelOf[lead] !== NO_LEAD)
+        ? new Float32Array(maxFrames)
+        : null
+    );
+  }
+
+  return {
+    body,
+    offset: 0,
+    decoder: new Er3WaveDecoder(channels, compression),
+    scratch: new Int16Array(
+      er3MaxSamples(SLICE_BYTES, compression, channels) + channels - 1
+    ),
+    carry: 0,
+    channels,
+    channelOf,
+    scale,
+    leads,
+    frames: 0,
+    checksum: er3DataChecksum(file.subarray(0, ER3_FILE_HEAD_SIZE)),
+    head,
+    tail,
+    leadStates,
+  };
+}
+
+/** Decode the next slice of the body into the lead columns. */
+function runSlice(job: Job) {
+  const { body, channels, scratch } = job;
+  const end = Math.min(job.offset + SLICE_BYTES, body.length);
+  const chunk = body.subarray(job.offset, end);
+  job.offset = end;
+  job.checksum += er3DataChecksum(chunk);
+
+  const n = job.carry + job.decoder.decode(chunk, scratch, job.carry);
+  const frames = Math.floor(n / channels);
+  for (let lead = 0; lead < ER3_LEAD_COUNT; lead++) {
+    if (job.leads[lead]) fillLead(job, lead, frames);
+  }
+  job.frames += frames;
+  job.carry = n - frames * channels;
+  scratch.copyWithin(0, frames * channels, n);
+}
+
+function fillLead(job: Job, lead: number, frames: number) {
+  const { scratch, channels, channelOf, scale } = job;
+  const out = job.leads[lead]!;
+  const end = job.frames + frames;
+
+  if (lead < Er3Lead.III || lead > Er3Lead.aVF) {
+    let i = channelOf[lead];
+    for (let s = job.frames; s < end; s++, i += channels) {
+      out[s] = scratch[i] * scale;
+    }
+    return;
+  }
+
+  // Derived limb leads from I and II.
+  let i1 = channelOf[Er3Lead.I];
+  let i2 = channelOf[Er3Lead.II];
+  for (let s = job.frames; s < end; s++, i1 += channels, i2 += channels) {
+    const a = scratch[i1];
+    const b = scratch[i2];
+    let v: number;
+    switch (lead) {
+      case Er3Lead.III:
+        v = b - a;
+        break;
+      case Er3Lead.aVR:
+        v = -(a + b) / 2;
+        break;
+      case Er3Lead.aVL:
+        v = a - b / 2;
+        break;
+      default:
+        v = b - a / 2;
+        break;
+    }
+    out[s] = v * scale;
+  }
+}
+
+function finishLeads(job: Job): Er3LeadSet {
+  return {
+    cable: job.head.cable,
+    samplesPerLead: job.frames,
+    leads: job.leads.map((l) => l && l.subarray(0, job.frames)),
+    leadOff: er3LeadOffSegments(job.leadStates, job.frames),
+    checksumOk: (job.checksum & 0xffff) === job.tail.dataCrc,
+    recordingTime: job.tail.recordingTime,
+  };
+}
+
+/**
+ * Decode an ER3 origin file into 12 mV lead columns in one synchronous pass.
+ */
+export function decodeEr3Leads(
+  file: Uint8Array,
+  options: Er3LeadOptions = {}
+): Er3LeadSet {
+  const job = startLeads(file, options);
+  while (job.offset < job.body.length) runSlice(job);
+  return finishLeads(job);
+}
+
+/**
+ * Same as `decodeEr3Leads` but yields to the event loop every `sliceMs` so
+ * large Holter files don't block rendering or BLE callbacks.
+ */
+export async function decodeEr3LeadsAsync(
+  file: Uint8Array,
+  { sliceMs = 8, ...options }: Er3LeadOptions & { sliceMs?: number } = {}
+): Promise<Er3LeadSet> {
+  const job = startLeads(file, options);
+  let deadline = Date.now() + sliceMs;
+  while (job.offset < job.body.length) {
+    runSlice(job);
+    if (Date.now() >= deadline) {
+      await new Promise((resolve) => setTimeout(resolve, 0));
+      deadline = Date.now() + sliceMs;
+    }
+  }
+  return finishLeads(job);
+}
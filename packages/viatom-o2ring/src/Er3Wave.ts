@@ -0,0 +1,438 @@
+// Portable decoder for Viatom ER3 / M-series waveforms.
+//
+// Mirrors what VTMBLEParser's `parseER3WaveData:withCable:` and
+// `parseER3OriginFile:` do inside the closed iOS framework, so the same
+// files can be decoded on Android or on a Linux box running Node. The
+// escape scheme is read off the framework's own decoder (VTMCompress.o in
+// VTMProductLib.xcframework: `VTMUnCompress_Alg_ECG` for one channel,
+// `VTMUnCompress_Multichannel_Alg_ECG` for the 4 / 8 channel ER3 streams);
+// test/Er3Wave.test.ts in o2ring-gateway holds vectors worked through it.
+
+import { VTMER3FileHead, VTMER3FileTail } from "./WireFormats";
+import { WireFormatError } from "./WireStruct";
+
+// ----- Wire constants (VTMBLEStruct.h / VTMBLEEnum.h) -----
+
+export const ER3_FILE_HEAD_SIZE = VTMER3FileHead.size;
+export const ER3_FILE_TAIL_SIZE = VTMER3FileTail.size;
+export const ER3_FILE_MAGIC = 0xa55a0438;
+
+/** VTMER3Cable */
+export enum Er3Cable {
+  Lead10 = 0x00,
+  Lead6 = 0x01,
+  Lead5 = 0x02,
+  Lead3 = 0x03,
+  Lead3Temp = 0x04,
+  Lead4Leg = 0x05,
+  Lead5Leg = 0x06,
+  Lead6Leg = 0x07,
+  Unidentified = 0xff,
+}
+
+/** Compression type stored in bits 4–7 of `VTMER3Waveform.wave_info`. */
+export enum Er3Compression {
+  None = 0,
+  Differential = 1,
+}
+
+export type Er3WaveInfo = {
+  sampleRateHz: number;
+  compression: Er3Compression;
+};
+
+export type Er3FileHead = {
+  fileVersion: number;
+  type: number;
+  cable: Er3Cable;
+};
+
+export type Er3FileTail = {
+  recordingTime: number;
+  dataCrc: number;
+  magic: number;
+};
+
+// Escape bytes used by the Viatom differential scheme. Any other byte is a
+// signed delta against the previous sample of the same channel.
+//
+// One channel: 0x80 is followed by the raw LE sample, 0x7f / 0x81 extend
+// the delta by one more byte.
+//
+// Several channels: samples come in frames of one per channel. 0x80 at a
+// delta position starts a new frame (dropping a partial one) whose next
+// byte is a bitmask: channel i is a raw LE sample if bit i is set, a
+// one-byte delta otherwise. 0x7f and 0x81 are plain deltas. Only whole
+// frames are output.
+const ESC_ORIGINAL = 0x80;
+const ESC_POSITIVE = 0x7f; // delta = 127 + next byte
+const ESC_NEGATIVE = 0x81; // delta = -127 - next byte
+const DELTA_LIMIT = 127;
+
+const STAGE_DELTA = 0;
+const STAGE_ORIGINAL_LO = 1;
+const STAGE_ORIGINAL_HI = 2;
+const STAGE_POSITIVE = 3;
+const STAGE_NEGATIVE = 4;
+// Multichannel escape frame (`mUncompressStep` 17 / 18 / 19 in the SDK).
+const STAGE_MASK = 17;
+const STAGE_FRAME = 18;
+const STAGE_FRAME_HI = 19;
+
+const SAMPLE_RATES = [250, 125, 62.5];
+
+/**
+ * Split `wave_info` into sample rate and compression type.
+ */
+export function parseEr3WaveInfo(waveInfo: number): Er3WaveInfo {
+  const rate = SAMPLE_RATES[waveInfo & 0x0f];
+  if (rate == null) {
+    throw new WireFormatError(
+      `parseEr3WaveInfo: unknown sample rate ${waveInfo & 0x0f}`
+    );
+  }
+  return { sampleRateHz: rate, compression: (waveInfo >> 4) & 0x0f };
+}
+
+/**
+ * Number of interleaved channels the device records for a given cable.
+ * 10-lead cables carry 8 channels, every other cable carries 4 (the SDK
+ * tests `cable_type == 0`).
+ */
+export function er3ChannelCount(cable: Er3Cable): number {
+  if (cable === Er3Cable.Lead10) return 8;
+  if (cable >= Er3Cable.Lead6 && cable <= Er3Cable.Lead6Leg) return 4;
+  throw new WireFormatError(
+    `er3ChannelCount: unsupported cable 0x${cable.toString(16)}`
+  );
+}
+
+/**
+ * Upper bound on the samples produced from `byteLength` input bytes, so
+ * callers can size the output buffer once. With several channels a call
+ * can also complete a frame carried over from the previous chunk.
+ */
+export function er3MaxSamples(
+  byteLength: number,
+  compression: Er3Compression,
+  channels = 1
+) {
+  return compression === Er3Compression.None
+    ? Math.ceil(byteLength / 2)
+    : byteLength + channels - 1;
+}
+
+/**
+ * Streaming ER3 waveform decoder.
+ *
+ * Feed arbitrary chunks (BLE packets, file reads) through `decode`; escape
+ * sequences split across chunk boundaries are carried over. Output is
+ * interleaved int16 in channel order, the same layout as an uncompressed
+ * `wave_data` block.
+ */
+export class Er3WaveDecoder {
+  readonly channels: number;
+  readonly compression: Er3Compression;
+
+  private readonly last: Int16Array;
+  private readonly frame: Int16Array;
+  private stage = STAGE_DELTA;
+  private pendingLo = 0;
+  private mask = 0;
+  private channel = 0;
+
+  constructor(channels: number, compression: Er3Compression) {
+    if (channels <= 0) {
+      throw new Error("Er3WaveDecoder: channel count must be positive");
+    }
+    if (
+      compression !== Er3Compression.None &&
+      compression !== Er3Compression.Differential
+    ) {
+      throw new WireFormatError(
+        `Er3WaveDecoder: unknown compression ${compression}`
+      );
+    }
+    this.channels = channels;
+    this.compression = compression;
+    this.last = new Int16Array(channels);
+    this.frame = new Int16Array(channels);
+  }
+
+  /**
+   * Decode `input` into `out` starting at `outOffset`.
+   * @returns number of samples written
+   */
+  decode(input: Uint8Array, out: Int16Array, outOffset = 0): number {
+    const needed = er3MaxSamples(
+      input.length,
+      this.compression,
+      this.channels
+    );
+    if (out.length - outOffset < needed) {
+      throw new Error("Er3WaveDecoder.decode: output buffer too small");
+    }
+    if (this.compression === Er3Compression.None) {
+      return this.decodeRaw(input, out, outOffset);
+    }
+    return this.channels === 1
+      ? this.decodeDifferential(input, out, outOffset)
+      : this.decodeFrames(input, out, outOffset);
+  }
+
+  /** Reset to the start-of-stream state (e.g. a new file). */
+  reset() {
+    this.last.fill(0);
+    this.frame.fill(0);
+    this.stage = STAGE_DELTA;
+    this.pendingLo = 0;
+    this.mask = 0;
+    this.channel = 0;
+  }
+
+  private decodeRaw(input: Uint8Array, out: Int16Array, outOffset: number) {
+    let o = outOffset;
+    let i = 0;
+    const n = input.length;
+
+    if (this.stage === STAGE_ORIGINAL_HI && n > 0) {
+      out[o++] = ((input[0] << 8) | this.pendingLo) << 16 >> 16;
+      this.stage = STAGE_DELTA;
+      i = 1;
+    }
+    // Whole samples: straight little-endian copy.
+    for (; i + 1 < n; i += 2) {
+      out[o++] = ((input[i + 1] << 8) | input[i]) << 16 >> 16;
+    }
+    if (i < n) {
+      this.pendingLo = input[i];
+      this.stage = STAGE_ORIGINAL_HI;
+    }
+    this.channel = (this.channel + (o - outOffset)) % this.channels;
+    return o - outOffset;
+  }
+
+  private decodeDifferential(
+    input: Uint8Array,
+    out: Int16Array,
+    outOffset: number
+  ) {
+    const last = this.last;
+    const channels = this.channels;
+    let stage = this.stage;
+    let lo = this.pendingLo;
+    let ch = this.channel;
+    let o = outOffset;
+
+    for (let i = 0, n = input.length; i < n; i++) {
+      const b = input[i];
+      let value: number;
+
+      switch (stage) {
+        case STAGE_DELTA:
+          if (b === ESC_ORIGINAL) {
+            stage = STAGE_ORIGINAL_LO;
+            continue;
+          }
+          if (b === ESC_POSITIVE) {
+            stage = STAGE_POSITIVE;
+            continue;
+          }
+          if (b === ESC_NEGATIVE) {
+            stage = STAGE_NEGATIVE;
+            continue;
+          }
+          value = last[ch] + ((b << 24) >> 24);
+          break;
+        case STAGE_ORIGINAL_LO:
+          lo = b;
+          stage = STAGE_ORIGINAL_HI;
+          continue;
+        case STAGE_ORIGINAL_HI:
+          value = (b << 8) | lo;
+          stage = STAGE_DELTA;
+          break;
+        case STAGE_POSITIVE:
+          value = last[ch] + DELTA_LIMIT + b;
+          stage = STAGE_DELTA;
+          break;
+        default:
+          value = last[ch] - DELTA_LIMIT - b;
+          stage = STAGE_DELTA;
+          break;
+      }
+
+      // Int16Array stores with wrap-around, matching the firmware's short math.
+      last[ch] = value;
+      out[o++] = last[ch];
+      if (++ch === channels) ch = 0;
+    }
+
+    this.stage = stage;
+    this.pendingLo = lo;
+    this.channel = ch;
+    return o - outOffset;
+  }
+
+  private decodeFrames(
+    input: Uint8Array,
+    out: Int16Array,
+    outOffset: number
+  ) {
+    const last = this.last;
+    const frame = this.frame;
+    const channels = this.channels;
+    let stage = this.stage;
+    let mask = this.mask;
+    let ch = this.channel;
+    let o = outOffset;
+
+    for (let i = 0, n = input.length; i < n; i++) {
+      const b = input[i];
+
+      switch (stage) {
+        case STAGE_DELTA:
+          if (b === ESC_ORIGINAL) {
+            stage = STAGE_MASK;
+            ch = 0;
+            continue;
+          }
+          last[ch] += (b << 24) >> 24;
+          break;
+        case STAGE_MASK:
+          mask = b;
+          stage = STAGE_FRAME;
+          continue;
+        case STAGE_FRAME:
+          if ((mask >> ch) & 1) {
+            last[ch] = b;
+            stage = STAGE_FRAME_HI;
+            continue;
+          }
+          last[ch] += (b << 24) >> 24;
+          break;
+        default:
+          last[ch] |= b << 8;
+          stage = STAGE_FRAME;
+          break;
+      }
+
+      frame[ch] = last[ch];
+      if (++ch === channels) {
+        out.set(frame, o);
+        o += channels;
+        ch = 0;
+        stage = STAGE_DELTA;
+      }
+    }
+
+    this.stage = stage;
+    this.mask = mask;
+    this.channel = ch;
+    return o - outOffset;
+  }
+}
+
+/**
+ * Decode a real-time `VTMER3Waveform` payload (the bytes after
+ * `sampling_num`) in one shot. Equivalent to `parseER3WaveData:withCable:`.
+ */
+export function decodeEr3RealWave(
+  waveInfo: number,
+  payload: Uint8Array,
+  cable: Er3Cable
+): Int16Array {
+  const { compression } = parseEr3WaveInfo(waveInfo);
+  const channels = er3ChannelCount(cable);
+  const decoder = new Er3WaveDecoder(channels, compression);
+  const out = new Int16Array(
+    er3MaxSamples(payload.length, compression, channels)
+  );
+  const written = decoder.decode(payload, out);
+  return out.subarray(0, written);
+}
+
+export function parseEr3FileHead(bytes: Uint8Array): Er3FileHead {
+  const head = VTMER3FileHead.read(bytes);
+  return {
+    fileVersion: head.file_version,
+    type: head.type,
+    cable: head.cable_type,
+  };
+}
+
+export function parseEr3FileTail(bytes: Uint8Array): Er3FileTail {
+  const tail = VTMER3FileTail.read(bytes);
+  return {
+    recordingTime: tail.recoring_time,
+    dataCrc: tail.data_crc,
+    magic: tail.magic,
+  };
+}
+
+/**
+ * 16-bit additive checksum over head + compressed wave, as stored in
+ * `VTMER3FileTail.data_crc`. VTMBLEStruct.h only says "file head + wave
+ * sum" and the SDK never checks it, so this reading of it is unconfirmed
+ * against a device file; treat a mismatch as a warning.
+ */
+export function er3DataChecksum(bytes: Uint8Array): number {
+  let sum = 0;
+  for (let i = 0, n = bytes.length; i < n; i++) sum += bytes[i];
+  return sum & 0xffff;
+}
+
+/**
+ * Check an ER3 origin file's framing and split it into head, tail and the
+ * still-compressed wave body, for callers that decode the body in pieces.
+ */
+export function parseEr3OriginFile(file: Uint8Array) {
+  if (file.length < ER3_FILE_HEAD_SIZE + ER3_FILE_TAIL_SIZE) {
+    throw new WireFormatError("parseEr3OriginFile: file too short");
+  }
+  const head = parseEr3FileHead(file);
+  const tail = parseEr3FileTail(file.subarray(file.length - ER3_FILE_TAIL_SIZE));
+  if (tail.magic !== ER3_FILE_MAGIC) {
+    throw new WireFormatError(
+      `parseEr3OriginFile: bad magic 0x${tail.magic.toString(16)}`
+    );
+  }
+
+  return {
+    head,
+    tail,
+    channels: er3ChannelCount(head.cable),
+    body: file.subarray(ER3_FILE_HEAD_SIZE, file.length - ER3_FILE_TAIL_SIZE),
+  };
+}
+
+/**
+ * Decode a whole ER3 origin file (`VTMER3FileHead` + compressed wave +
+ * `VTMER3FileTail`) into interleaved int16 samples.
+ *
+ * The file carries no compression flag (`VTMER3FileHead` past
+ * `cable_type` is reserved) and `parseER3OriginFile:` always runs the
+ * differential decoder. `compression` is for recordings whose realtime
+ * `wave_info` reported something else.
+ */
+export function decodeEr3OriginFile(
+  file: Uint8Array,
+  compression = Er3Compression.Differential
+) {
+  const { head, tail, channels, body } = parseEr3OriginFile(file);
+  const decoder = new Er3WaveDecoder(channels, compression);
+  const out = new Int16Array(
+    er3MaxSamples(body.length, compression, channels)
+  );
+  const written = decoder.decode(body, out);
+
+  return {
+    head,
+    tail,
+    channels,
+    checksumOk:
+      er3DataChecksum(file.subarray(0, file.length - ER3_FILE_TAIL_SIZE)) ===
+      tail.dataCrc,
+    samples: out.subarray(0, written),
+  };
+}
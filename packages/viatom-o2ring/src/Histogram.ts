@@ -0,0 +1,141 @@
+// HDR-style log-linear histogram for integer measurements.
+//
+// Values below 2^subBucketBits are counted exactly; above that every power
+// of two is split into 2^subBucketBits linear sub-buckets, which bounds the
+// relative error to 1 / 2^subBucketBits (about 3% with the default 5 bits)
+// while keeping the bucket array small enough to persist as JSON.
+
+export type HistogramSnapshot = {
+  subBucketBits: number;
+  maxValue: number;
+  /** Sparse `[bucketIndex, count]` pairs. */
+  buckets: [number, number][];
+  count: number;
+  sum: number;
+  min: number;
+  max: number;
+};
+
+export class LogHistogram {
+  readonly subBucketBits: number;
+  readonly maxValue: number;
+
+  private readonly subCount: number;
+  private readonly counts: Uint32Array;
+  private total = 0;
+  private sum = 0;
+  private minSeen = Infinity;
+  private maxSeen = 0;
+
+  constructor(maxValue: number, subBucketBits = 5) {
+    if (maxValue < 1 || subBucketBits < 1 || subBucketBits > 10) {
+      throw new Error("LogHistogram: invalid range");
+    }
+    this.maxValue = Math.floor(maxValue);
+    this.subBucketBits = subBucketBits;
+    this.subCount = 1 << subBucketBits;
+    this.counts = new Uint32Array(this.indexOf(this.maxValue) + 1);
+  }
+
+  private indexOf(value: number) {
+    const s = this.subCount;
+    if (value < s) return value;
+    const exp = Math.floor(Math.log2(value)) - this.subBucketBits;
+    return s + exp * s + (Math.floor(value / 2 ** exp) - s);
+  }
+
+  /** Smallest value that lands in bucket `index`. */
+  private lowerBound(index: number) {
+    const s = this.subCount;
+    if (index < s) return index;
+    const exp = Math.floor((index - s) / s);
+    return (s + ((index - s) % s)) * 2 ** exp;
+  }
+
+  /** Record `value` (clamped to `[0, maxValue]`, rounded to an integer). */
+  record(value: number, count = 1) {
+    if (!Number.isFinite(value)) return;
+    const v = Math.min(Math.max(Math.round(value), 0), this.maxValue);
+    this.counts[this.indexOf(v)] += count;
+    this.total += count;
+    this.sum += v * count;
+    if (v < this.minSeen) this.minSeen = v;
+    if (v > this.maxSeen) this.maxSeen = v;
+  }
+
+  get count() {
+    return this.total;
+  }
+
+  get mean() {
+    return this.total ? this.sum / this.total : 0;
+  }
+
+  get min() {
+    return this.total ? this.minSeen : 0;
+  }
+
+  get max() {
+    return this.maxSeen;
+  }
+
+  /** Value at quantile `q` in [0, 1], reported as its bucket's lower bound. */
+  quantile(q: number) {
+    if (this.total === 0) return 0;
+    const rank = Math.max(1, Math.ceil(Math.min(Math.max(q, 0), 1) * this.total));
+    let seen = 0;
+    for (let i = 0; i < this.counts.length; i++) {
+      seen += this.counts[i];
+      if (seen >= rank) {
+        return Math.min(Math.max(this.lowerBound(i), this.min), this.max);
+      }
+    }
+    return this.max;
+  }
+
+  merge(other: LogHistogram) {
+    if (
+      other.subBucketBits !== this.subBucketBits ||
+      other.maxValue !== this.maxValue
+    ) {
+      throw new Error("LogHistogram.merge: incompatible layouts");
+    }
+    for (let i = 0; i < other.counts.length; i++) {
+      this.counts[i] += other.counts[i];
+    }
+    this.total += other.total;
+    this.sum += other.sum;
+    if (other.total) {
+      this.minSeen = Math.min(this.minSeen, other.minSeen);
+      this.maxSeen = Math.max(this.maxSeen, other.maxSeen);
+    }
+  }
+
+  snapshot(): HistogramSnapshot {
+    const buckets: [number, number][] = [];
+    this.counts.forEach((c, i) => {
+      if (c > 0) buckets.push([i, c]);
+    });
+    return {
+      subBucketBits: this.subBucketBits,
+      maxValue: this.maxValue,
+      buckets,
+      count: this.total,
+      sum: this.sum,
+      min: this.min,
+      max: this.max,
+    };
+  }
+
+  static fromSnapshot(s: HistogramSnapshot) {
+    const h = new LogHistogram(s.maxValue, s.subBucketBits);
+    for (const [i, c] of s.buckets) {
+      if (i >= 0 && i < h.counts.length) h.counts[i] = c;
+    }
+    h.total = s.count;
+    h.sum = s.sum;
+    h.minSeen = s.count ? s.min : Infinity;
+    h.maxSeen = s.max;
+    return h;
+  }
+}
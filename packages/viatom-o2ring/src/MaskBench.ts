@@ -0,0 +1,102 @@
+// Cost of the validity stage against the legacy CSV row guard
+// (`spo2 in 1..149 || pr in 1..349`, one branch per row, no motion or
+// mark awareness) on synthetic columns with realistic dropout and motion.
+// Each variant runs `rounds` times over the same columns; times are the
+// best round, in ms.
+
+import { buildValidityMask, countValid, maskRuns } from "./ValidityMask";
+
+export type MaskBenchResult = {
+  samples: number;
+  /** Rows the legacy guard keeps. */
+  legacyKept: number;
+  legacyMs: number;
+  validSpo2: number;
+  validPr: number;
+  /** Valid + invalid runs of the SpO2 mask. */
+  runs: number;
+  maskMs: number;
+  runsMs: number;
+  maskSamplesPerSec: number;
+};
+
+function syntheticColumns(n: number) {
+  const spo2 = new Uint8Array(n);
+  const pr = new Uint8Array(n);
+  const motion = new Uint8Array(n);
+  const spo2Mark = new Uint8Array(n);
+  const prMark = new Uint8Array(n);
+  let x = 0x9e3779b9;
+  const rand = () => {
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    return (x >>> 0) / 0x100000000;
+  };
+  let off = 0;
+  let moving = 0;
+  for (let i = 0; i < n; i++) {
+    // probe-off stretches of a few minutes, motion bursts of ~20 samples
+    if (off === 0 && rand() < 0.0005) off = 30 + Math.floor(rand() * 120);
+    if (moving === 0 && rand() < 0.005) moving = 5 + Math.floor(rand() * 30);
+    if (off > 0) {
+      off--;
+      spo2[i] = 0xff;
+      pr[i] = 0xff;
+      continue;
+    }
+    spo2[i] = 90 + Math.floor(rand() * 9);
+    pr[i] = 55 + Math.floor(rand() * 30);
+    if (moving > 0) {
+      moving--;
+      motion[i] = 41 + Math.floor(rand() * 20);
+    }
+    spo2Mark[i] = spo2[i] < 91 ? 1 : 0;
+  }
+  return { spo2, pr, motion, spo2Mark, prMark };
+}
+
+function best(rounds: number, fn: () => void) {
+  let min = Infinity;
+  for (let r = 0; r < rounds; r++) {
+    const t = performance.now();
+    fn();
+    min = Math.min(min, performance.now() - t);
+  }
+  return min;
+}
+
+export function runMaskBenchmark(samples = 1_000_000, rounds = 5): MaskBenchResult {
+  const cols = syntheticColumns(samples);
+
+  let legacyKept = 0;
+  const legacyMs = best(rounds, () => {
+    legacyKept = 0;
+    for (let i = 0; i < samples; i++) {
+      const s = cols.spo2[i];
+      const p = cols.pr[i];
+      if ((s >= 1 && s <= 149) || (p >= 1 && p <= 349)) legacyKept++;
+    }
+  });
+
+  let mask = buildValidityMask(cols);
+  const maskMs = best(rounds, () => {
+    mask = buildValidityMask(cols);
+  });
+  let runs = maskRuns(mask.spo2, mask.length);
+  const runsMs = best(rounds, () => {
+    runs = maskRuns(mask.spo2, mask.length);
+  });
+
+  return {
+    samples,
+    legacyKept,
+    legacyMs,
+    validSpo2: countValid(mask.spo2),
+    validPr: countValid(mask.pr),
+    runs: runs.ends.length,
+    maskMs,
+    runsMs,
+    maskSamplesPerSec: maskMs > 0 ? (samples * 1000) / maskMs : 0,
+  };
+}
@@ -0,0 +1,108 @@
+// Bulk ADC → mV conversion for Viatom ECG / BP waveforms.
+//
+// VTMBLEParser converts one short at a time and returns NSArrays of boxed
+// NSNumbers. These helpers convert whole spans into caller-owned
+// Float32Arrays instead, so a night of ECG is one typed-array pass rather
+// than millions of small objects.
+
+/** `VTMBLEParser mVFromShort:` (ER1 / ER2 / DuoEK). */
+export const ECG_MV_PER_LSB = (1.0035 * 1800) / (4096 * 178.74);
+/** `VTMBLEParser er3MvFromShort:` (ER3 / M-series). */
+export const ER3_MV_PER_LSB = 0.00244;
+/** `VTMBLEParser bpMvFromShort:` (BP2 / BP2W ECG). */
+export const BP_MV_PER_LSB = 0.003098;
+
+/** Bytes per stored point. */
+const POINT_SIZE = 2;
+
+const LITTLE_ENDIAN_HOST =
+  new Uint8Array(new Uint16Array([1]).buffer)[0] === 1;
+
+export function mvFromShort(n: number) {
+  return n * ECG_MV_PER_LSB;
+}
+
+export function er3MvFromShort(n: number) {
+  return n * ER3_MV_PER_LSB;
+}
+
+export function bpMvFromShort(n: number) {
+  return n * BP_MV_PER_LSB;
+}
+
+/**
+ * `dst[dstOffset + i] = src[i] * scale` for every element of `src`.
+ * @returns number of values written
+ */
+export function int16ToMv(
+  src: Int16Array,
+  dst: Float32Array,
+  scale: number,
+  dstOffset = 0
+): number {
+  const n = src.length;
+  if (dst.length - dstOffset < n) {
+    throw new Error("int16ToMv: output buffer too small");
+  }
+  // Unrolled by four; JS engines don't expose SIMD, but this keeps the loop
+  // overhead down and lets the JIT keep everything in registers.
+  let i = 0;
+  let o = dstOffset;
+  for (const end = n - (n & 3); i < end; i += 4, o += 4) {
+    dst[o] = src[i] * scale;
+    dst[o + 1] = src[i + 1] * scale;
+    dst[o + 2] = src[i + 2] * scale;
+    dst[o + 3] = src[i + 3] * scale;
+  }
+  for (; i < n; i++, o++) dst[o] = src[i] * scale;
+  return n;
+}
+
+/**
+ * View little-endian int16 point bytes as an Int16Array. Zero-copy when the
+ * bytes are 2-byte aligned on a little-endian host, otherwise a copy.
+ */
+export function pointsView(bytes: Uint8Array): Int16Array {
+  const count = Math.floor(bytes.length / POINT_SIZE);
+  if (LITTLE_ENDIAN_HOST && (bytes.byteOffset & 1) === 0) {
+    return new Int16Array(bytes.buffer, bytes.byteOffset, count);
+  }
+  const out = new Int16Array(count);
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.length);
+  for (let i = 0; i < count; i++) out[i] = view.getInt16(i * POINT_SIZE, true);
+  return out;
+}
+
+/** Number of points `parsePointsInto` will write for `bytes`. */
+export function pointCount(bytes: Uint8Array) {
+  return Math.floor(bytes.length / POINT_SIZE);
+}
+
+/**
+ * Buffer-writing counterpart of `parsePoints:` / `parseBPPoints:`: decode
+ * LE int16 point bytes and write them to `out` in mV.
+ * @returns number of points written
+ */
+export function parsePointsInto(
+  bytes: Uint8Array,
+  out: Float32Array,
+  scale = ECG_MV_PER_LSB,
+  outOffset = 0
+): number {
+  return int16ToMv(pointsView(bytes), out, scale, outOffset);
+}
+
+/** Allocating convenience wrapper around `parsePointsInto`. */
+export function parsePoints(bytes: Uint8Array, scale = ECG_MV_PER_LSB) {
+  const out = new Float32Array(pointCount(bytes));
+  parsePointsInto(bytes, out, scale);
+  return out;
+}
+
+export function parseBPPointsInto(
+  bytes: Uint8Array,
+  out: Float32Array,
+  outOffset = 0
+): number {
+  return parsePointsInto(bytes, out, BP_MV_PER_LSB, outOffset);
+}
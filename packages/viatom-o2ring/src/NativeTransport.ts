@@ -0,0 +1,61 @@
+// `SessionTransport` over the native Viatom module. Both SDKs run one
+// command at a time, so `maxConcurrent` is 1 and the native side swaps the
+// ring that owns the SDK when the scheduler moves to another session.
+// Connects take that slot too, so a second ring of the same model is not
+// handed to the SDK (and its connect timer does not start) while the first
+// is still coming up. The native link state machine fetches info on
+// connect, so sessions don't.
+
+import {
+  addDisconnectedListener,
+  addErrorListener,
+  addHistoryFileListener,
+  addInfoListener,
+  addReadProgressListener,
+  addServiceReadyListener,
+  connect,
+  disconnect,
+  getInfo,
+  readHistoryFile,
+} from "./Viatom";
+import { SessionTransport, TransportEvent } from "./Sessions";
+
+export const nativeTransport: SessionTransport = {
+  maxConcurrent: 1,
+  infoOnConnect: true,
+  connect: (deviceId, model) => connect(deviceId, model),
+  disconnect: (deviceId) => disconnect(deviceId),
+  getInfo: (deviceId) => getInfo(deviceId),
+  readFile: (deviceId, name) => readHistoryFile(name, deviceId),
+  subscribe(listener: (e: TransportEvent) => void) {
+    const subs = [
+      addServiceReadyListener((e) => {
+        if (e.mac) listener({ type: "connected", deviceId: e.mac });
+      }),
+      addDisconnectedListener((e) => {
+        if (e.mac) listener({ type: "disconnected", deviceId: e.mac, reason: e.reason });
+      }),
+      addInfoListener((e) => {
+        if (e.mac) listener({ type: "info", deviceId: e.mac, files: e.files, battery: e.battery });
+      }),
+      addReadProgressListener((e) => {
+        if (e.mac) listener({ type: "progress", deviceId: e.mac, progress: e.progress });
+      }),
+      addHistoryFileListener((e) => {
+        if (e.mac) {
+          listener({
+            type: "file",
+            deviceId: e.mac,
+            csv: e.csv,
+            startTime: e.startTime,
+            bytes: e.bytes,
+          });
+        }
+      }),
+      addErrorListener((e) => {
+        if (e.mac) listener({ type: "error", deviceId: e.mac, code: e.code, message: e.message });
+      }),
+    ];
+    return () => subs.forEach((s) => s.remove());
+  },
+};
@@ -0,0 +1,188 @@
+// Columnar container for one decoded night.
+//
+//   "O2NA" | version u8 | reserved u8 | headerLen u16 LE | JSON header
+//   | column blocks, each starting on an 8-byte boundary
+//
+// The header lists every column's name, element type and byte length in
+// block order, plus the night's summary, so a reader can list a whole
+// archive directory from headers alone and map a single column without
+// touching the others. Column data is little-endian typed-array bytes.
+
+import { NightSketchSet } from "./NightSketch";
+import { nightLength, NightSummary, O2Night } from "./O2Night";
+import { WireFormatError } from "./WireStruct";
+
+export const NIGHT_ARCHIVE_MAGIC = 0x414e324f; // "O2NA" read as u32 LE
+export const NIGHT_ARCHIVE_VERSION = 1;
+const PREAMBLE = 8;
+const ALIGN = 8;
+
+const NIGHT_COLUMNS = ["spo2", "pr", "motion", "spo2Mark", "prMark"] as const;
+
+export type ArchiveColumnType = "u8" | "i16" | "u16" | "i32" | "f32";
+
+/** `pr` is u16; archives written before it was widened store u8. */
+const COLUMN_TYPE: Record<(typeof NIGHT_COLUMNS)[number], ArchiveColumnType> = {
+  spo2: "u8",
+  pr: "u16",
+  motion: "u8",
+  spo2Mark: "u8",
+  prMark: "u8",
+};
+
+export type NightArchiveHeader = {
+  deviceId: string;
+  startTime: number;
+  intervalS: number;
+  count: number;
+  summary?: NightSummary;
+  columns: { name: string; type: ArchiveColumnType; byteLength: number }[];
+};
+
+export type NightArchive = {
+  header: NightArchiveHeader;
+  night: O2Night;
+};
+
+const align = (n: number) => (n + ALIGN - 1) & ~(ALIGN - 1);
+
+export function encodeNightArchive(
+  deviceId: string,
+  night: O2Night,
+  summary?: NightSummary
+): Uint8Array {
+  const count = nightLength(night);
+  const header: NightArchiveHeader = {
+    deviceId,
+    startTime: night.startTime,
+    intervalS: night.intervalS,
+    count,
+    summary,
+    columns: NIGHT_COLUMNS.map((name) => ({
+      name,
+      type: COLUMN_TYPE[name],
+      byteLength: night[name].byteLength,
+    })),
+  };
+  const json = new TextEncoder().encode(JSON.stringify(header));
+  if (json.length > 0xffff) throw new WireFormatError("NightArchive: header too large");
+
+  let size = align(PREAMBLE + json.length);
+  const offsets = NIGHT_COLUMNS.map((name) => {
+    const at = size;
+    size = align(size + night[name].byteLength);
+    return at;
+  });
+
+  const out = new Uint8Array(size);
+  const view = new DataView(out.buffer);
+  view.setUint32(0, NIGHT_ARCHIVE_MAGIC, true);
+  view.setUint8(4, NIGHT_ARCHIVE_VERSION);
+  view.setUint16(6, json.length, true);
+  out.set(json, PREAMBLE);
+  // typed arrays are host order; every target the app runs on is LE
+  NIGHT_COLUMNS.forEach((name, i) => {
+    const col = night[name];
+    out.set(new Uint8Array(col.buffer, col.byteOffset, col.byteLength), offsets[i]);
+  });
+  return out;
+}
+
+/** Header only; cheap enough to scan a directory of archives. */
+export function readNightArchiveHeader(bytes: Uint8Array): NightArchiveHeader {
+  if (bytes.length < PREAMBLE) throw new WireFormatError("NightArchive: truncated");
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  if (view.getUint32(0, true) !== NIGHT_ARCHIVE_MAGIC) {
+    throw new WireFormatError("NightArchive: bad magic");
+  }
+  const version = view.getUint8(4);
+  if (version !== NIGHT_ARCHIVE_VERSION) {
+    throw new WireFormatError(`NightArchive: unsupported version ${version}`);
+  }
+  const len = view.getUint16(6, true);
+  if (PREAMBLE + len > bytes.length) throw new WireFormatError("NightArchive: truncated header");
+  let header: NightArchiveHeader;
+  try {
+    header = JSON.parse(new TextDecoder().decode(bytes.subarray(PREAMBLE, PREAMBLE + len)));
+  } catch {
+    throw new WireFormatError("NightArchive: header is not JSON");
+  }
+  const columnsOk =
+    Array.isArray(header?.columns) &&
+    header.columns.every((c) => Number.isInteger(c?.byteLength) && c.byteLength >= 0);
+  if (!columnsOk) throw new WireFormatError("NightArchive: bad column list");
+  return header;
+}
+
+/** Bytes to read from the front of an archive to get its header length. */
+export const NIGHT_ARCHIVE_PREAMBLE = PREAMBLE;
+
+/** Total header size given the first `NIGHT_ARCHIVE_PREAMBLE` bytes. */
+export function nightArchiveHeaderSize(preamble: Uint8Array) {
+  if (preamble.length < PREAMBLE) throw new WireFormatError("NightArchive: truncated");
+  return PREAMBLE + (preamble[6] | (preamble[7] << 8));
+}
+
+/**
+ * Merge the SpO2 / PR sketches of every night starting in `[fromS, toS)`
+ * (epoch seconds). Works on headers only; nights without a sketch are
+ * skipped.
+ */
+export function mergeNightSketches(
+  headers: Iterable<NightArchiveHeader>,
+  fromS = -Infinity,
+  toS = Infinity
+): NightSketchSet {
+  const set = new NightSketchSet();
+  for (const h of headers) {
+    if (h.startTime >= fromS && h.startTime < toS) set.merge(h.summary?.sketch);
+  }
+  return set;
+}
+
+/**
+ * Columns are views into `bytes`, not copies, except a u8 `pr` from an
+ * older archive (widened) or a u16 one that lands unaligned.
+ */
+export function decodeNightArchive(bytes: Uint8Array): NightArchive {
+  const header = readNightArchiveHeader(bytes);
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const columns: Record<string, Uint8Array | Uint16Array> = {};
+  let at = align(PREAMBLE + view.getUint16(6, true));
+  for (const c of header.columns) {
+    if (at + c.byteLength > bytes.length) {
+      throw new WireFormatError(`NightArchive: column ${c.name} truncated`);
+    }
+    const raw = bytes.subarray(at, at + c.byteLength);
+    if (c.name === "pr") {
+      if (c.type === "u8") columns.pr = Uint16Array.from(raw);
+      else if (c.type === "u16") {
+        columns.pr =
+          raw.byteOffset % 2 === 0
+            ? new Uint16Array(raw.buffer, raw.byteOffset, raw.length >>> 1)
+            : new Uint16Array(raw.slice().buffer);
+      }
+    } else if (c.type === "u8") {
+      columns[c.name] = raw;
+    }
+    at = align(at + c.byteLength);
+  }
+  for (const name of NIGHT_COLUMNS) {
+    if (!columns[name]) throw new WireFormatError(`NightArchive: missing column ${name}`);
+    if (columns[name].length !== columns.spo2?.length) {
+      throw new WireFormatError(`NightArchive: column ${name} length differs`);
+    }
+  }
+  return {
+    header,
+    night: {
+      startTime: header.startTime,
+      intervalS: header.intervalS,
+      spo2: columns.spo2 as Uint8Array,
+      pr: columns.pr as Uint16Array,
+      motion: columns.motion as Uint8Array,
+      spo2Mark: columns.spo2Mark as Uint8Array,
+      prMark: columns.prMark as Uint8Array,
+    },
+  };
+}
@@ -0,0 +1,100 @@
+// The CSV the app uploads, built from night columns: same columns, row
+// guard and ISO 8601 timestamp format as the native exporters
+// (convertOxyFileToCsv / convertHistoryFile). Those append "\n" after
+// every row and then trim, so their output is the header and each row
+// preceded by "\n", with no trailing newline (a night without rows is the
+// bare header); this writes exactly that. They also resample the night
+// onto a 4 s grid over the head's record time, which for an O2Ring file
+// (4 s points) picks every point, so there the rows are the same; for
+// 1 s / 2 s oximeter nights this keeps every point instead.
+//
+// Written straight into an ASCII byte buffer sized for the worst case:
+// the timestamp is formatted once per minute and only the seconds are
+// patched per row, and values come from a 0–255 digit table, so a row
+// costs a handful of byte copies and no string allocation.
+
+import { nightLength, O2Night } from "./O2Night";
+
+export const NIGHT_CSV_HEADER = "Time,Oxygen Level,Pulse Rate,Motion,O2 Reminder,PR Reminder";
+
+const pad2 = (n: number) => (n < 10 ? "0" + n : String(n));
+
+function offsetSuffix(minutes: number) {
+  if (minutes === 0) return "Z";
+  const abs = Math.abs(minutes);
+  return `${minutes < 0 ? "-" : "+"}${pad2(Math.floor(abs / 60))}:${pad2(abs % 60)}`;
+}
+
+const ascii = (s: string) => Uint8Array.from(s, (c) => c.charCodeAt(0));
+
+/** `DIGITS[v]` is `v` in decimal, for 0..255. */
+const DIGITS = Array.from({ length: 256 }, (_, v) => ascii(String(v)));
+
+/** "YYYY-MM-DDTHH:MM:" */
+const PREFIX = 17;
+/** Timestamp (prefix + "SS" + "+HH:MM") + 5 separators + 3 + 5 + 3 digits + 2 flags + newline. */
+const MAX_ROW = PREFIX + 2 + 6 + 5 + 11 + 2 + 1;
+
+/**
+ * UTF-8 (all ASCII) CSV, ready to write or upload. `utcOffsetMinutes` is the
+ * zone the timestamps are written in (default UTC).
+ */
+export function encodeNightCsv(night: O2Night, utcOffsetMinutes = 0): Uint8Array {
+  const n = nightLength(night);
+  const header = ascii(NIGHT_CSV_HEADER);
+  const suffix = ascii(offsetSuffix(utcOffsetMinutes));
+  const out = new Uint8Array(header.length + n * MAX_ROW);
+  out.set(header);
+  let at = header.length;
+  const prefix = new Uint8Array(PREFIX);
+  let minuteKey = -1;
+
+  for (let i = 0; i < n; i++) {
+    const s = night.spo2[i];
+    const p = night.pr[i];
+    // legacy guard: keep a row if either value looks like a reading
+    if (!((s >= 1 && s <= 149) || (p >= 1 && p <= 349))) continue;
+    const local = night.startTime + i * night.intervalS + utcOffsetMinutes * 60;
+    const minute = Math.floor(local / 60);
+    if (minute !== minuteKey) {
+      minuteKey = minute;
+      const d = new Date(minute * 60000);
+      prefix.set(
+        ascii(
+          `${d.getUTCFullYear()}-${pad2(d.getUTCMonth() + 1)}-${pad2(d.getUTCDate())}` +
+            `T${pad2(d.getUTCHours())}:${pad2(d.getUTCMinutes())}:`
+        )
+      );
+    }
+    const sec = local - minute * 60;
+    // row separator, never a terminator: see the note at the top
+    out[at++] = 0x0a;
+    out.set(prefix, at);
+    at += PREFIX;
+    out[at++] = 0x30 + ((sec / 10) | 0);
+    out[at++] = 0x30 + (sec % 10);
+    out.set(suffix, at);
+    at += suffix.length;
+    out[at++] = 0x2c;
+    out.set(DIGITS[s], at);
+    at += DIGITS[s].length;
+    out[at++] = 0x2c;
+    // PR is 16-bit; anything past the table is rare enough to format
+    const pd = p < 256 ? DIGITS[p] : ascii(String(p));
+    out.set(pd, at);
+    at += pd.length;
+    out[at++] = 0x2c;
+    const m = night.motion[i];
+    out.set(DIGITS[m], at);
+    at += DIGITS[m].length;
+    out[at++] = 0x2c;
+    out[at++] = night.spo2Mark[i] ? 0x31 : 0x30;
+    out[at++] = 0x2c;
+    out[at++] = night.prMark[i] ? 0x31 : 0x30;
+  }
+  return out.subarray(0, at);
+}
+
+export function exportNightCsv(night: O2Night, utcOffsetMinutes = 0): string {
+  return new TextDecoder().decode(encodeNightCsv(night, utcOffsetMinutes));
+}
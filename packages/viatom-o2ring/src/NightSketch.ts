@@ -0,0 +1,141 @@
+// Mergeable per-night distributions of SpO2 and pulse rate.
+//
+// Both values are small integers (SpO2 0–100 %, PR 0–350 bpm), so a sketch
+// is simply one exact bin per value holding the seconds spent at it. A
+// night's sketch is built in the summary pass and stored in its archive
+// header; any range of nights then merges in O(bins) from headers alone,
+// and percentiles and time-below-threshold come out exact, not estimated.
+// Weighting by seconds rather than samples keeps 1 s, 2 s and 4 s nights
+// comparable after a merge.
+
+export const SPO2_SKETCH_BINS = 101;
+export const PR_SKETCH_BINS = 351;
+
+/** JSON form: `seconds[i]` is the time spent at value `lo + i`; zero tails are trimmed. */
+export type BinSketch = {
+  lo: number;
+  seconds: number[];
+};
+
+export type NightSketches = {
+  spo2: BinSketch;
+  pr: BinSketch;
+};
+
+export class ValueSketch {
+  readonly bins: Float64Array;
+  private totalS = 0;
+
+  constructor(binCount: number) {
+    this.bins = new Float64Array(binCount);
+  }
+
+  /** Values outside `[0, binCount)` are ignored. */
+  add(value: number, seconds: number) {
+    if (value < 0 || value >= this.bins.length) return;
+    this.bins[value] += seconds;
+    this.totalS += seconds;
+  }
+
+  /** Seconds recorded over all values. */
+  get totalSeconds() {
+    return this.totalS;
+  }
+
+  merge(other: ValueSketch | BinSketch) {
+    if (other instanceof ValueSketch) {
+      if (other.bins.length !== this.bins.length) {
+        throw new Error("ValueSketch.merge: incompatible bin counts");
+      }
+      for (let i = 0; i < other.bins.length; i++) this.bins[i] += other.bins[i];
+      this.totalS += other.totalS;
+      return this;
+    }
+    const { lo, seconds } = other;
+    if (lo < 0 || lo + seconds.length > this.bins.length) {
+      throw new Error("ValueSketch.merge: sketch out of range");
+    }
+    for (let i = 0; i < seconds.length; i++) {
+      this.bins[lo + i] += seconds[i];
+      this.totalS += seconds[i];
+    }
+    return this;
+  }
+
+  /** Smallest value with at least fraction `q` of the time at or below it. */
+  quantile(q: number) {
+    if (this.totalS === 0) return 0;
+    const rank = Math.min(Math.max(q, 0), 1) * this.totalS;
+    let seen = 0;
+    for (let v = 0; v < this.bins.length; v++) {
+      seen += this.bins[v];
+      if (seen > 0 && seen >= rank) return v;
+    }
+    return this.bins.length - 1;
+  }
+
+  /** Seconds spent strictly below `threshold`. */
+  timeBelow(threshold: number) {
+    let s = 0;
+    const end = Math.min(Math.max(Math.ceil(threshold), 0), this.bins.length);
+    for (let v = 0; v < end; v++) s += this.bins[v];
+    return s;
+  }
+
+  /**
+   * Time-below curve over the whole range: `out[v]` is the seconds spent
+   * strictly below `v`, so `out[90]` is T90. One pass.
+   */
+  timeBelowCurve() {
+    const out = new Float64Array(this.bins.length + 1);
+    for (let v = 0; v < this.bins.length; v++) out[v + 1] = out[v] + this.bins[v];
+    return out;
+  }
+
+  toJSON(): BinSketch {
+    let lo = 0;
+    let hi = this.bins.length;
+    while (lo < hi && this.bins[lo] === 0) lo++;
+    while (hi > lo && this.bins[hi - 1] === 0) hi--;
+    return { lo, seconds: Array.from(this.bins.subarray(lo, hi)) };
+  }
+
+  static from(binCount: number, sketch: BinSketch) {
+    return new ValueSketch(binCount).merge(sketch);
+  }
+}
+
+export type SketchPercentiles = {
+  p1: number;
+  p5: number;
+  p50: number;
+  p95: number;
+};
+
+export function sketchPercentiles(sketch: ValueSketch): SketchPercentiles {
+  return {
+    p1: sketch.quantile(0.01),
+    p5: sketch.quantile(0.05),
+    p50: sketch.quantile(0.5),
+    p95: sketch.quantile(0.95),
+  };
+}
+
+/** Merged SpO2 / PR distributions of several nights. */
+export class NightSketchSet {
+  readonly spo2 = new ValueSketch(SPO2_SKETCH_BINS);
+  readonly pr = new ValueSketch(PR_SKETCH_BINS);
+  nights = 0;
+
+  merge(sketches: NightSketches | undefined) {
+    if (!sketches) return this;
+    this.spo2.merge(sketches.spo2);
+    this.pr.merge(sketches.pr);
+    this.nights++;
+    return this;
+  }
+
+  toJSON(): NightSketches {
+    return { spo2: this.spo2.toJSON(), pr: this.pr.toJSON() };
+  }
+}
@@ -0,0 +1,355 @@
+// O2Ring history files as columns, plus a one-pass night summary.
+//
+// Two layouts reach us: the O2Ring history file that VTO2Lib parses into
+// `VTO2Object` (40-byte head + 5-byte `VTO2WaveObject` points every 4 s)
+// and the VTMProductLib oximeter file (`VTMOxiFileHead` + 5-byte
+// `VTMOxiPoint` + `VTMOxiFileTail`, interval in the tail). Both decode to
+// the same `O2Night` columns, which is what analysis and the night archive
+// consume; nothing here builds per-point objects or CSV.
+
+import {
+  VTMOxiFileHead,
+  VTMOxiFileTail,
+  VTMOxiPoint,
+  VTO2ObjectHead,
+  VTO2WavePoint,
+} from "./WireFormats";
+import { NightSketches, PR_SKETCH_BINS, SPO2_SKETCH_BINS, ValueSketch } from "./NightSketch";
+import { buildValidityMask, ValidityMask } from "./ValidityMask";
+import { WireFormatError } from "./WireStruct";
+
+/** O2Ring history files store one point every 4 s. */
+export const O2_FILE_INTERVAL_S = 4;
+/** `VTO2Object.fileVer` written by current O2Ring firmware. */
+export const O2_FILE_VERSION = 3;
+/** `VTO2Object.mode`: 0 sleep, 1 monitor. */
+export const O2_MODE_SLEEP = 0;
+export const O2_MODE_MONITOR = 1;
+/** `VTMOxiFileTail.magic` */
+export const OXI_FILE_MAGIC = 0xda5a1248;
+/** `VTMOxiFileHead.file_type` of an oximetry file. */
+export const OXI_FILE_TYPE = 0x03;
+
+export type O2Night = {
+  /** Epoch seconds of the first point. */
+  startTime: number;
+  intervalS: number;
+  spo2: Uint8Array;
+  /** bpm; 16-bit in O2Ring files, so not capped at 255. */
+  pr: Uint16Array;
+  motion: Uint8Array;
+  /** Device reminder / mark flags, 0 or 1 per point. */
+  spo2Mark: Uint8Array;
+  prMark: Uint8Array;
+};
+
+export function nightLength(night: O2Night) {
+  return night.spo2.length;
+}
+
+/**
+ * Check an O2Ring history head against the bytes it came with; throws a
+ * `WireFormatError` for anything that is not one (there is no magic, so
+ * the mode, clock fields and `size` have to agree instead).
+ */
+export function readO2FileHead(bytes: Uint8Array) {
+  if (bytes.length < VTO2ObjectHead.size) {
+    throw new WireFormatError(`VTO2Object: ${bytes.length} bytes is too short`);
+  }
+  const head = VTO2ObjectHead.read(bytes);
+  if (head.mode !== O2_MODE_SLEEP && head.mode !== O2_MODE_MONITOR) {
+    throw new WireFormatError(`VTO2Object: unknown mode ${head.mode}`);
+  }
+  if (
+    head.file_version === 0 ||
+    head.month < 1 ||
+    head.month > 12 ||
+    head.day < 1 ||
+    head.day > 31 ||
+    head.hour > 23 ||
+    head.minute > 59 ||
+    head.second > 59
+  ) {
+    throw new WireFormatError(
+      `VTO2Object: invalid head v${head.file_version} ` +
+        `${head.year}-${head.month}-${head.day} ${head.hour}:${head.minute}:${head.second}`
+    );
+  }
+  if (
+    head.size < VTO2ObjectHead.size ||
+    head.size > bytes.length ||
+    (head.size - VTO2ObjectHead.size) % VTO2WavePoint.size !== 0
+  ) {
+    throw new WireFormatError(`VTO2Object: size ${head.size} does not fit ${bytes.length} bytes`);
+  }
+  return head;
+}
+
+/**
+ * The head stores the ring's wall clock; `utcOffsetMinutes` says how far
+ * that clock is ahead of UTC (default: this host's zone).
+ */
+export function decodeO2File(bytes: Uint8Array, utcOffsetMinutes?: number): O2Night {
+  const head = readO2FileHead(bytes);
+  const count = (head.size - VTO2ObjectHead.size) / VTO2WavePoint.size;
+  const cols = VTO2WavePoint.columns(bytes, count, {
+    offset: VTO2ObjectHead.size,
+    only: ["spo2", "hr", "ac_v_s", "spo2_mark", "hr_mark"],
+  });
+  const wall = Date.UTC(head.year, head.month - 1, head.day, head.hour, head.minute, head.second);
+  const offset =
+    utcOffsetMinutes ??
+    -new Date(head.year, head.month - 1, head.day, head.hour, head.minute).getTimezoneOffset();
+  return {
+    startTime: Math.round(wall / 1000) - offset * 60,
+    intervalS: O2_FILE_INTERVAL_S,
+    spo2: cols.spo2 as Uint8Array,
+    pr: cols.hr as Uint16Array,
+    motion: cols.ac_v_s as Uint8Array,
+    spo2Mark: cols.spo2_mark as Uint8Array,
+    prMark: cols.hr_mark as Uint8Array,
+  };
+}
+
+export function decodeOxiFile(bytes: Uint8Array): O2Night {
+  const tailAt = bytes.length - VTMOxiFileTail.size;
+  if (tailAt < VTMOxiFileHead.size) {
+    throw new WireFormatError(`VTMOxiFile: ${bytes.length} bytes is too short`);
+  }
+  const tail = VTMOxiFileTail.read(bytes, tailAt);
+  if (tail.magic !== OXI_FILE_MAGIC) {
+    throw new WireFormatError(`VTMOxiFileTail: bad magic 0x${tail.magic.toString(16)}`);
+  }
+  const fileType = VTMOxiFileHead.get(bytes, "file_type");
+  if (fileType !== OXI_FILE_TYPE) {
+    throw new WireFormatError(`VTMOxiFileHead: file_type ${fileType} is not oximetry`);
+  }
+  const room = Math.floor((tailAt - VTMOxiFileHead.size) / VTMOxiPoint.size);
+  const count = Math.min(tail.records, room);
+  const offset = VTMOxiFileHead.size;
+  const cols = VTMOxiPoint.columns(bytes, count, {
+    offset,
+    only: ["spo2", "motion", "spo2_mark", "pr_mark"],
+  });
+  // widened to match O2Ring files
+  const pr = new Uint16Array(count);
+  VTMOxiPoint.columns(bytes, count, { offset, only: ["pr"], into: { pr } });
+  const spo2Mark = cols.spo2_mark as Uint8Array;
+  const prMark = cols.pr_mark as Uint8Array;
+  for (let i = 0; i < count; i++) {
+    spo2Mark[i] = spo2Mark[i] ? 1 : 0;
+    prMark[i] = prMark[i] ? 1 : 0;
+  }
+  return {
+    startTime: tail.timestamp,
+    intervalS: tail.interval || 1,
+    spo2: cols.spo2 as Uint8Array,
+    pr,
+    motion: cols.motion as Uint8Array,
+    spo2Mark,
+    prMark,
+  };
+}
+
+/**
+ * Inverse of `decodeOxiFile`, for simulators and fixtures: the only layout
+ * that carries a 1 s or 2 s interval. The tail's result block gets the
+ * averages and minimum; its checksum is left 0, as no decoder checks it.
+ * `VTMOxiPoint.pr` is one byte, so faster pulse rates are stored as 255.
+ */
+export function encodeOxiFile(night: O2Night, deviceModel = 0): Uint8Array {
+  const n = nightLength(night);
+  const tailAt = VTMOxiFileHead.size + n * VTMOxiPoint.size;
+  const out = new Uint8Array(tailAt + VTMOxiFileTail.size);
+  const view = new DataView(out.buffer);
+  view.setUint8(VTMOxiFileHead.offsetOf("file_version"), 1);
+  view.setUint8(VTMOxiFileHead.offsetOf("file_type"), OXI_FILE_TYPE);
+  view.setUint16(VTMOxiFileHead.offsetOf("device_model"), deviceModel, true);
+  for (let i = 0, p = VTMOxiFileHead.size; i < n; i++, p += VTMOxiPoint.size) {
+    out[p] = night.spo2[i];
+    out[p + 1] = Math.min(night.pr[i], 255);
+    out[p + 2] = night.motion[i];
+    out[p + 3] = night.spo2Mark[i];
+    out[p + 4] = night.prMark[i];
+  }
+  const summary = summarizeNight(night);
+  const at = (name: Parameters<typeof VTMOxiFileTail.offsetOf>[0]) =>
+    tailAt + VTMOxiFileTail.offsetOf(name);
+  view.setUint32(at("magic"), OXI_FILE_MAGIC, true);
+  view.setUint32(at("timestamp"), night.startTime, true);
+  view.setUint32(at("records"), n, true);
+  view.setUint8(at("interval"), night.intervalS);
+  view.setUint8(at("channel_type"), 1);
+  view.setUint8(at("channel_bytes"), VTMOxiPoint.size);
+  view.setUint8(at("average_spo2"), Math.round(summary.avgSpo2));
+  view.setUint8(at("lowest_spo2"), summary.minSpo2);
+  view.setUint8(at("average_pr"), Math.min(Math.round(summary.avgPr), 255));
+  return out;
+}
+
+/**
+ * Pick the decoder from the bytes: oximeter files end in a magic tail,
+ * anything else has to pass as an O2Ring history file.
+ */
+export function decodeNightFile(bytes: Uint8Array, utcOffsetMinutes?: number): O2Night {
+  if (
+    bytes.length >= VTMOxiFileHead.size + VTMOxiFileTail.size &&
+    VTMOxiFileTail.get(bytes, "magic", bytes.length - VTMOxiFileTail.size) === OXI_FILE_MAGIC
+  ) {
+    return decodeOxiFile(bytes);
+  }
+  return decodeO2File(bytes, utcOffsetMinutes);
+}
+
+/**
+ * Inverse of `decodeO2File`, for simulators and replay fixtures. The head's
+ * summary fields are filled from `summarizeNight`; the score is left 0.
+ */
+export function encodeO2File(night: O2Night, utcOffsetMinutes = 0): Uint8Array {
+  const n = nightLength(night);
+  const out = new Uint8Array(VTO2ObjectHead.size + n * VTO2WavePoint.size);
+  const view = new DataView(out.buffer);
+  const wall = new Date((night.startTime + utcOffsetMinutes * 60) * 1000);
+  const at = (name: Parameters<typeof VTO2ObjectHead.offsetOf>[0]) => VTO2ObjectHead.offsetOf(name);
+  const summary = summarizeNight(night);
+  const hours = (summary.validPoints * night.intervalS) / 3600;
+  view.setUint8(at("file_version"), O2_FILE_VERSION);
+  view.setUint8(at("mode"), O2_MODE_SLEEP);
+  view.setUint16(at("year"), wall.getUTCFullYear(), true);
+  view.setUint8(at("month"), wall.getUTCMonth() + 1);
+  view.setUint8(at("day"), wall.getUTCDate());
+  view.setUint8(at("hour"), wall.getUTCHours());
+  view.setUint8(at("minute"), wall.getUTCMinutes());
+  view.setUint8(at("second"), wall.getUTCSeconds());
+  view.setUint32(at("size"), out.length, true);
+  view.setUint16(at("record_time"), Math.min(summary.durationS, 0xffff), true);
+  view.setUint8(at("average_spo2"), Math.round(summary.avgSpo2));
+  view.setUint8(at("lowest_spo2"), summary.minSpo2);
+  view.setUint8(at("drops_l3"), Math.min(Math.round(summary.odi3 * hours), 255));
+  view.setUint8(at("drops_l4"), Math.min(Math.round(summary.odi4 * hours), 255));
+  view.setUint8(
+    at("t90"),
+    summary.durationS ? Math.round((100 * summary.t90S) / summary.durationS) : 0
+  );
+  for (let i = 0, p = VTO2ObjectHead.size; i < n; i++, p += VTO2WavePoint.size) {
+    out[p] = night.spo2[i];
+    view.setUint16(p + 1, night.pr[i], true);
+    out[p + 3] = night.motion[i];
+    out[p + 4] = (night.spo2Mark[i] ? 0x80 : 0) | (night.prMark[i] ? 0x40 : 0);
+  }
+  return out;
+}
+
+export type NightSummary = {
+  points: number;
+  validPoints: number;
+  durationS: number;
+  avgSpo2: number;
+  minSpo2: number;
+  /** Seconds with SpO2 below 90 %. */
+  t90S: number;
+  /** Desaturations of >= 3 % / >= 4 % below the running baseline, per hour. */
+  odi3: number;
+  odi4: number;
+  avgPr: number;
+  minPr: number;
+  maxPr: number;
+  /** Time at each SpO2 / PR value; absent in archives written before sketches. */
+  sketch?: NightSketches;
+};
+
+/** Baseline is the mean of the previous window of valid samples. */
+const BASELINE_WINDOW_S = 120;
+/** A drop must last this long to count as an event. */
+const MIN_EVENT_S = 10;
+
+/**
+ * One pass over the columns. Only samples set in `mask` count: by default
+ * that drops out-of-range values (the ring writes 0xFF / 0 for "no
+ * reading") and motion artifacts; see `buildValidityMask`.
+ */
+export function summarizeNight(
+  night: O2Night,
+  mask: ValidityMask = buildValidityMask(night)
+): NightSummary {
+  const n = nightLength(night);
+  const spo2Ok = mask.spo2;
+  const prOk = mask.pr;
+  const step = night.intervalS;
+  const window = Math.max(1, Math.round(BASELINE_WINDOW_S / step));
+  const minRun = Math.max(1, Math.ceil(MIN_EVENT_S / step));
+
+  // ring buffer of the last `window` valid SpO2 values for the baseline
+  const recent = new Uint8Array(window);
+  let recentSum = 0;
+  let recentCount = 0;
+  let recentAt = 0;
+
+  let valid = 0;
+  let spo2Sum = 0;
+  let minSpo2 = 255;
+  let below90 = 0;
+  let prSum = 0;
+  let prCount = 0;
+  let minPr = 0xffff;
+  let maxPr = 0;
+  let odi3 = 0;
+  let odi4 = 0;
+  let run3 = 0;
+  let run4 = 0;
+  const spo2Sketch = new ValueSketch(SPO2_SKETCH_BINS);
+  const prSketch = new ValueSketch(PR_SKETCH_BINS);
+
+  for (let i = 0; i < n; i++) {
+    const word = i >>> 5;
+    const bit = 1 << (i & 31);
+    const pr = night.pr[i];
+    if (prOk[word] & bit) {
+      prSum += pr;
+      prCount++;
+      if (pr < minPr) minPr = pr;
+      if (pr > maxPr) maxPr = pr;
+      prSketch.add(pr, step);
+    }
+
+    if (!(spo2Ok[word] & bit)) continue;
+    const s = night.spo2[i];
+    valid++;
+    spo2Sum += s;
+    if (s < minSpo2) minSpo2 = s;
+    if (s < 90) below90++;
+    spo2Sketch.add(s, step);
+
+    if (recentCount === window) {
+      const baseline = recentSum / recentCount;
+      run3 = s <= baseline - 3 ? run3 + 1 : 0;
+      run4 = s <= baseline - 4 ? run4 + 1 : 0;
+      if (run3 === minRun) odi3++;
+      if (run4 === minRun) odi4++;
+    }
+    // events hold the baseline still so a long desaturation is not averaged away
+    if (run3 === 0) {
+      if (recentCount === window) recentSum -= recent[recentAt];
+      else recentCount++;
+      recent[recentAt] = s;
+      recentSum += s;
+      recentAt = (recentAt + 1) % window;
+    }
+  }
+
+  const hours = (valid * step) / 3600;
+  return {
+    points: n,
+    validPoints: valid,
+    durationS: n * step,
+    avgSpo2: valid ? spo2Sum / valid : 0,
+    minSpo2: valid ? minSpo2 : 0,
+    t90S: below90 * step,
+    odi3: hours > 0 ? odi3 / hours : 0,
+    odi4: hours > 0 ? odi4 / hours : 0,
+    avgPr: prCount ? prSum / prCount : 0,
+    minPr: prCount ? minPr : 0,
+    maxPr,
+    sketch: { spo2: spo2Sketch.toJSON(), pr: prSketch.toJSON() },
+  };
+}
@@ -0,0 +1,443 @@
+// Streaming decoders for the long raw recordings: wearable-oximeter PPG
+// files (`woxi_readPPGFile:`) and BabyO2 S3 files
+// (`babyo2s3_parseFileData:completed:`).
+//
+// The SDK only takes these as one NSData and hands back whole arrays; raw
+// PPG at 200 Hz runs to tens of MB per night. These decoders take the file
+// in whatever chunks the transfer delivers, stage at most one record
+// across chunk boundaries, and fill a fixed-size `ColumnBlockBuffer` that
+// goes to a `ColumnSink` (usually a `ColumnStreamWriter`) each time it is
+// full. The working set is one block plus one record whatever the length.
+//
+// PPG file layout: `VTMOxiFileHead` | `VTMWOxiRawSampleInfo` | samples, each
+// the `VTMWOxiRawDataUint` fields selected by `marker` packed in order (IR
+// i32, red i32, motion u8), as in the realtime raw packets.
+// BabyO2 S3 layout: `VTO2FileHead_t` | `VTO2SleepPointData_t`s
+// | `VTO2SleepFileTail_t`.
+
+import {
+  COLUMN_BLOCK_SAMPLES,
+  ColumnBlockBuffer,
+  ColumnSink,
+  ColumnSpec,
+} from "./ColumnStream";
+import {
+  VTMOxiFileHead,
+  VTMWOxiRawSampleInfo,
+  VTO2FileHead,
+  VTO2SleepFileTail,
+  VTO2SleepPointData,
+} from "./WireFormats";
+import { Column, WireFormatError } from "./WireStruct";
+
+/**
+ * Splits a chunked byte stream into one head and then fixed-size records.
+ * Whole records are handed over in place; only a record (or head) split
+ * across chunks is copied, into a buffer sized for one.
+ */
+class RecordFramer {
+  private readonly pending: Uint8Array;
+  private pendingLen = 0;
+  /** 0 until the head has been read. */
+  recordSize = 0;
+
+  constructor(
+    private readonly headSize: number,
+    maxRecord: number
+  ) {
+    this.pending = new Uint8Array(Math.max(headSize, maxRecord));
+  }
+
+  /** Bytes of an incomplete record (or head) still waiting for the rest. */
+  get pendingBytes() {
+    return this.pendingLen;
+  }
+
+  push(
+    chunk: Uint8Array,
+    onHead: (head: Uint8Array) => number,
+    onRecords: (bytes: Uint8Array, offset: number, n: number) => void
+  ) {
+    let i = 0;
+    while (i < chunk.length) {
+      const want = this.recordSize || this.headSize;
+      if (this.recordSize && this.pendingLen === 0) {
+        const whole = Math.floor((chunk.length - i) / want);
+        if (whole > 0) {
+          onRecords(chunk, i, whole);
+          i += whole * want;
+          continue;
+        }
+      }
+      const take = Math.min(want - this.pendingLen, chunk.length - i);
+      this.pending.set(chunk.subarray(i, i + take), this.pendingLen);
+      this.pendingLen += take;
+      i += take;
+      if (this.pendingLen < want) break;
+      this.pendingLen = 0;
+      if (this.recordSize) {
+        onRecords(this.pending, 0, 1);
+      } else {
+        const size = onHead(this.pending.subarray(0, want));
+        if (size <= 0 || size > this.pending.length) {
+          throw new WireFormatError(`RecordFramer: bad record size ${size}`);
+        }
+        this.recordSize = size;
+      }
+    }
+  }
+}
+
+// ----- PPG -----
+
+export const PPG_FILE_HEAD_SIZE =
+  VTMOxiFileHead.size + VTMWOxiRawSampleInfo.size;
+export const PPG_MARKER_IR = 1;
+export const PPG_MARKER_RED = 2;
+export const PPG_MARKER_MOTION = 4;
+/** `VTMWOxiRawSampleInfo.sample_rate` → Hz. */
+export const PPG_SAMPLE_RATES = [150, 200];
+
+export type PpgFileHead = {
+  fileVersion: number;
+  fileType: number;
+  deviceModel: number;
+  marker: number;
+  sampleRateHz: number;
+};
+
+/** Bytes per sample for a `marker`. */
+export function ppgSampleSize(marker: number) {
+  return (
+    (marker & PPG_MARKER_IR ? 4 : 0) +
+    (marker & PPG_MARKER_RED ? 4 : 0) +
+    (marker & PPG_MARKER_MOTION ? 1 : 0)
+  );
+}
+
+/** Columns a file with this `marker` decodes to, in stream order. */
+export function ppgColumns(marker: number): ColumnSpec[] {
+  const out: ColumnSpec[] = [];
+  if (marker & PPG_MARKER_IR) out.push({ name: "ir", type: "i32" });
+  if (marker & PPG_MARKER_RED) out.push({ name: "red", type: "i32" });
+  if (marker & PPG_MARKER_MOTION) out.push({ name: "motion", type: "u8" });
+  return out;
+}
+
+export function parsePpgFileHead(bytes: Uint8Array): PpgFileHead {
+  const file = VTMOxiFileHead.read(bytes);
+  const info = VTMWOxiRawSampleInfo.read(bytes, VTMOxiFileHead.size);
+  const sampleRateHz = PPG_SAMPLE_RATES[info.sample_rate];
+  if ((info.marker & 7) === 0) {
+    throw new WireFormatError("PPG file: empty marker");
+  }
+  if (sampleRateHz == null) {
+    throw new WireFormatError(
+      `PPG file: unknown sample rate ${info.sample_rate}`
+    );
+  }
+  return {
+    fileVersion: file.file_version,
+    fileType: file.file_type,
+    deviceModel: file.device_model,
+    marker: info.marker & 7,
+    sampleRateHz,
+  };
+}
+
+export function encodePpgFileHead(
+  marker: number,
+  sampleRateHz: number,
+  deviceModel = 0
+) {
+  const out = new Uint8Array(PPG_FILE_HEAD_SIZE);
+  const view = new DataView(out.buffer);
+  view.setUint8(VTMOxiFileHead.offsetOf("file_version"), 1);
+  view.setUint16(VTMOxiFileHead.offsetOf("device_model"), deviceModel, true);
+  out[VTMOxiFileHead.size + VTMWOxiRawSampleInfo.offsetOf("marker")] = marker;
+  out[VTMOxiFileHead.size + VTMWOxiRawSampleInfo.offsetOf("sample_rate")] =
+    PPG_SAMPLE_RATES.indexOf(sampleRateHz);
+  return out;
+}
+
+/**
+ * Incremental PPG file decoder. `open` is called once the head is in, with
+ * the columns the samples will fill, and returns where blocks go.
+ */
+export class PpgFileDecoder {
+  head: PpgFileHead | null = null;
+  private readonly framer = new RecordFramer(
+    PPG_FILE_HEAD_SIZE,
+    ppgSampleSize(7)
+  );
+  private block: ColumnBlockBuffer | null = null;
+  private count = 0;
+
+  constructor(
+    private readonly open: (
+      head: PpgFileHead,
+      columns: ColumnSpec[]
+    ) => ColumnSink,
+    private readonly blockSamples = COLUMN_BLOCK_SAMPLES
+  ) {}
+
+  push(chunk: Uint8Array) {
+    this.framer.push(
+      chunk,
+      (bytes) => {
+        const head = parsePpgFileHead(bytes);
+        const columns = ppgColumns(head.marker);
+        this.head = head;
+        this.block = new ColumnBlockBuffer(
+          Object.fromEntries(columns.map((c) => [c.name, c.type])),
+          this.blockSamples,
+          this.open(head, columns)
+        );
+        return ppgSampleSize(head.marker);
+      },
+      (bytes, offset, n) => this.readSamples(bytes, offset, n)
+    );
+  }
+
+  /** Emits the last partial block. */
+  finish() {
+    if (!this.head || !this.block) {
+      throw new WireFormatError("PpgFileDecoder: missing file head");
+    }
+    this.block.flush();
+    return {
+      head: this.head,
+      count: this.count,
+      trailingBytes: this.framer.pendingBytes,
+    };
+  }
+
+  private readSamples(bytes: Uint8Array, offset: number, n: number) {
+    const block = this.block!;
+    const marker = this.head!.marker;
+    const size = this.framer.recordSize;
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    const ir = marker & PPG_MARKER_IR ? block.columns.ir : null;
+    const red = marker & PPG_MARKER_RED ? block.columns.red : null;
+    const motion = marker & PPG_MARKER_MOTION ? block.columns.motion : null;
+    const redAt = ir ? 4 : 0;
+    const motionAt = redAt + (red ? 4 : 0);
+
+    while (n > 0) {
+      const take = Math.min(n, block.room);
+      const base = block.fill;
+      for (let r = 0, p = offset; r < take; r++, p += size) {
+        if (ir) ir[base + r] = view.getInt32(p, true);
+        if (red) red[base + r] = view.getInt32(p + redAt, true);
+        if (motion) motion[base + r] = bytes[p + motionAt];
+      }
+      offset += take * size;
+      n -= take;
+      this.count += take;
+      block.commit(take);
+    }
+  }
+}
+
+// ----- BabyO2 S3 -----
+
+export const BABY_FILE_HEAD_SIZE = VTO2FileHead.size;
+export const BABY_RECORD_SIZE = VTO2SleepPointData.size;
+export const BABY_FILE_TAIL_SIZE = VTO2SleepFileTail.size;
+/** `VTO2FileHead_t.operation_mode` of an oximetry file. */
+export const BABY_OPERATION_MODE = 0x03;
+/** Points are written every 4 s, as in O2Ring history files. */
+export const BABY_INTERVAL_S = 4;
+/** One u8 column per `VTO2SleepPointData_t` field, under its C name. */
+export const BABY_COLUMNS: ColumnSpec[] = VTO2SleepPointData.fields.map(
+  (f) => ({ name: f.name, type: "u8" })
+);
+
+type BabyPointField = (typeof VTO2SleepPointData.fields)[number]["name"];
+
+export type BabyFileHead = {
+  fileVersion: number;
+  /** Epoch seconds of the first point. */
+  startTime: number;
+  intervalS: number;
+  size: number;
+};
+
+export type BabyFileTail = ReturnType<typeof VTO2SleepFileTail.read>;
+
+/**
+ * The head stores the device's wall clock; `utcOffsetMinutes` says how far
+ * that clock is ahead of UTC (default: this host's zone).
+ */
+export function parseBabyFileHead(
+  bytes: Uint8Array,
+  utcOffsetMinutes?: number
+): BabyFileHead {
+  const head = VTO2FileHead.read(bytes);
+  if (head.operation_mode !== BABY_OPERATION_MODE) {
+    throw new WireFormatError(
+      `VTO2FileHead_t: operation_mode ${head.operation_mode} is not oximetry`
+    );
+  }
+  if (
+    head.month < 1 ||
+    head.month > 12 ||
+    head.day < 1 ||
+    head.day > 31 ||
+    head.hour > 23 ||
+    head.minute > 59 ||
+    head.second > 59
+  ) {
+    throw new WireFormatError(
+      `VTO2FileHead_t: invalid date ${head.year}-${head.month}-${head.day}`
+    );
+  }
+  const { year, month, day, hour, minute, second } = head;
+  const wall = Date.UTC(year, month - 1, day, hour, minute, second);
+  const offset =
+    utcOffsetMinutes ??
+    -new Date(year, month - 1, day, hour, minute).getTimezoneOffset();
+  return {
+    fileVersion: head.file_version,
+    startTime: Math.round(wall / 1000) - offset * 60,
+    intervalS: BABY_INTERVAL_S,
+    size: head.size,
+  };
+}
+
+/** Head of a BabyO2 S3 file of `count` points, for fixtures. */
+export function encodeBabyFileHead(
+  startTime: number,
+  count: number,
+  utcOffsetMinutes = 0
+) {
+  const out = new Uint8Array(BABY_FILE_HEAD_SIZE);
+  const view = new DataView(out.buffer);
+  const wall = new Date((startTime + utcOffsetMinutes * 60) * 1000);
+  const at = VTO2FileHead.offsetOf;
+  view.setUint8(at("file_version"), 1);
+  view.setUint8(at("operation_mode"), BABY_OPERATION_MODE);
+  view.setUint16(at("year"), wall.getUTCFullYear(), true);
+  view.setUint8(at("month"), wall.getUTCMonth() + 1);
+  view.setUint8(at("day"), wall.getUTCDate());
+  view.setUint8(at("hour"), wall.getUTCHours());
+  view.setUint8(at("minute"), wall.getUTCMinutes());
+  view.setUint8(at("second"), wall.getUTCSeconds());
+  const size =
+    BABY_FILE_HEAD_SIZE + count * BABY_RECORD_SIZE + BABY_FILE_TAIL_SIZE;
+  view.setUint32(at("size"), size, true);
+  return out;
+}
+
+/** Tail with the record time and SpO2 / HR averages set, for fixtures. */
+export function encodeBabyFileTail(
+  recordTimeS: number,
+  averageSpo2 = 0,
+  averageHr = 0
+) {
+  const out = new Uint8Array(BABY_FILE_TAIL_SIZE);
+  const view = new DataView(out.buffer);
+  const at = VTO2SleepFileTail.offsetOf;
+  view.setUint16(at("record_time"), Math.min(recordTimeS, 0xffff), true);
+  view.setUint8(at("average_spo2"), averageSpo2);
+  view.setUint16(at("average_hr"), averageHr, true);
+  return out;
+}
+
+/**
+ * Incremental BabyO2 S3 decoder; see `PpgFileDecoder`. The file ends in a
+ * fixed-size tail rather than saying up front how many points it holds, so
+ * the last `BABY_FILE_TAIL_SIZE` bytes seen are held back until `finish`.
+ */
+export class BabyRecordDecoder {
+  head: BabyFileHead | null = null;
+  private readonly framer = new RecordFramer(
+    BABY_FILE_HEAD_SIZE,
+    BABY_RECORD_SIZE
+  );
+  private readonly tail = new Uint8Array(BABY_FILE_TAIL_SIZE);
+  private tailLen = 0;
+  private block: ColumnBlockBuffer | null = null;
+  private count = 0;
+
+  constructor(
+    private readonly open: (
+      head: BabyFileHead,
+      columns: ColumnSpec[]
+    ) => ColumnSink,
+    private readonly blockSamples = COLUMN_BLOCK_SAMPLES,
+    private readonly utcOffsetMinutes?: number
+  ) {}
+
+  push(chunk: Uint8Array) {
+    const total = this.tailLen + chunk.length;
+    if (total <= this.tail.length) {
+      this.tail.set(chunk, this.tailLen);
+      this.tailLen = total;
+      return;
+    }
+    // bytes that can no longer be part of the tail, oldest first
+    const release = total - this.tail.length;
+    const held = Math.min(release, this.tailLen);
+    if (held > 0) {
+      this.frame(this.tail.subarray(0, held));
+      this.tail.copyWithin(0, held, this.tailLen);
+      this.tailLen -= held;
+    }
+    this.frame(chunk.subarray(0, release - held));
+    this.tail.set(chunk.subarray(release - held), this.tailLen);
+    this.tailLen = this.tail.length;
+  }
+
+  /** Emits the last partial block and decodes the tail. */
+  finish(): {
+    head: BabyFileHead;
+    tail: BabyFileTail;
+    count: number;
+    trailingBytes: number;
+  } {
+    if (!this.head || !this.block) {
+      throw new WireFormatError("BabyRecordDecoder: missing file head");
+    }
+    if (this.tailLen < this.tail.length) {
+      throw new WireFormatError("BabyRecordDecoder: missing file tail");
+    }
+    this.block.flush();
+    return {
+      head: this.head,
+      tail: VTO2SleepFileTail.read(this.tail),
+      count: this.count,
+      trailingBytes: this.framer.pendingBytes,
+    };
+  }
+
+  private frame(bytes: Uint8Array) {
+    this.framer.push(
+      bytes,
+      (head) => {
+        this.head = parseBabyFileHead(head, this.utcOffsetMinutes);
+        this.block = new ColumnBlockBuffer(
+          Object.fromEntries(BABY_COLUMNS.map((c) => [c.name, c.type])),
+          this.blockSamples,
+          this.open(this.head, BABY_COLUMNS)
+        );
+        return BABY_RECORD_SIZE;
+      },
+      (records, offset, n) => {
+        const block = this.block!;
+        while (n > 0) {
+          const take = Math.min(n, block.room);
+          VTO2SleepPointData.columns(records, take, {
+            offset,
+            into: block.columns as Record<BabyPointField, Column>,
+            intoOffset: block.fill,
+          });
+          offset += take * BABY_RECORD_SIZE;
+          n -= take;
+          this.count += take;
+          block.commit(take);
+        }
+      }
+    );
+  }
+}
@@ -0,0 +1,87 @@
+// Aggregate throughput of `SessionManager` pulling a ward of rings over
+// `SimulatedTransport` on a virtual clock. "Simulated" numbers are transfer
+// time as the scheduler would see it; `wallMs` is what the scheduler itself
+// cost to run. `fairness` is Jain's index over per-ring throughput
+// (1 = every ring got the same share).
+
+import { SessionManager } from "./Sessions";
+import { SimulatedTransport, SimulatedTransportOptions, VirtualClock } from "./SimulatedTransport";
+
+export type SessionBenchOptions = Omit<SimulatedTransportOptions, "clock"> & {
+  devices?: number;
+  filesPerDevice?: number;
+  fileBytes?: number;
+  commandTimeoutMs?: number;
+};
+
+export type SessionBenchResult = {
+  devices: number;
+  files: number;
+  failedFiles: number;
+  retries: number;
+  bytes: number;
+  simulatedMs: number;
+  bytesPerSec: number;
+  /** Simulated ms until each ring's last file arrived. */
+  perDeviceDoneMs: number[];
+  fairness: number;
+  wallMs: number;
+};
+
+export async function runSessionBenchmark(
+  options: SessionBenchOptions = {}
+): Promise<SessionBenchResult> {
+  const {
+    devices = 8,
+    filesPerDevice = 4,
+    fileBytes = 48 * 1024,
+    commandTimeoutMs = 10000,
+    ...transportOptions
+  } = options;
+
+  const clock = new VirtualClock();
+  const transport = new SimulatedTransport({ ...transportOptions, clock });
+  const manager = new SessionManager(transport, { clock, commandTimeoutMs });
+
+  const ids: string[] = [];
+  for (let d = 0; d < devices; d++) {
+    const id = `ring-${d}`;
+    ids.push(id);
+    transport.addDevice(
+      id,
+      Array.from({ length: filesPerDevice }, (_, f) => ({
+        name: `2026010${f + 1}220000`,
+        bytes: fileBytes,
+      }))
+    );
+  }
+
+  const started = Date.now();
+  ids.forEach((id) => manager.open(id, 0));
+  await clock.run();
+  const wallMs = Date.now() - started;
+
+  const sessions = manager.all();
+  const perDeviceDoneMs = sessions.map((s) => s.stats.lastActivityAt);
+  const perDeviceRate = sessions.map((s) =>
+    s.stats.lastActivityAt > 0 ? s.stats.bytes / s.stats.lastActivityAt : 0
+  );
+  const sum = perDeviceRate.reduce((a, b) => a + b, 0);
+  const sumSq = perDeviceRate.reduce((a, b) => a + b * b, 0);
+  const bytes = sessions.reduce((a, s) => a + s.stats.bytes, 0);
+  const simulatedMs = Math.max(0, ...perDeviceDoneMs);
+  manager.dispose();
+
+  return {
+    devices,
+    files: sessions.reduce((a, s) => a + s.stats.files, 0),
+    failedFiles: sessions.reduce((a, s) => a + s.stats.failedFiles, 0),
+    retries: sessions.reduce((a, s) => a + s.stats.retries, 0),
+    bytes,
+    simulatedMs,
+    bytesPerSec: simulatedMs > 0 ? (bytes * 1000) / simulatedMs : 0,
+    perDeviceDoneMs,
+    fairness: sumSq > 0 ? (sum * sum) / (sessions.length * sumSq) : 0,
+    wallMs,
+  };
+}
@@ -0,0 +1,399 @@
+// Multi-device session manager.
+//
+// One `DeviceSession` per ring, each with its own command queue, read
+// pipeline (timeout + retry) and event stream tagged by device id. The
+// transport underneath (native SDK, simulator, replay) can only run a
+// limited number of commands at once, so a round-robin scheduler hands
+// out those slots one command per turn: a ring with 30 files waiting
+// never holds the radio while another ring with one file waits behind it.
+// Connecting is a command too: it takes its turn and holds the slot until
+// the ring is ready, because the native SDKs keep one link per model and a
+// second connect would take the link from the ring still coming up.
+//
+// Nothing here imports the native module, so the same code runs against
+// `SimulatedTransport` in a plain JS runtime.
+
+export type TransportEvent =
+  | { type: "connected"; deviceId: string }
+  | { type: "disconnected"; deviceId: string; reason?: number }
+  | { type: "info"; deviceId: string; files: string[]; battery?: number | null }
+  | { type: "progress"; deviceId: string; progress: number }
+  | {
+      type: "file";
+      deviceId: string;
+      csv: string;
+      startTime: number;
+      bytes?: number;
+      /** Undecoded file, from transports that have it (simulator, replay). */
+      raw?: Uint8Array;
+    }
+  | { type: "error"; deviceId: string; code: string; message: string };
+
+export interface SessionTransport {
+  /** Commands the transport can have in flight at the same time. */
+  readonly maxConcurrent: number;
+  /** The transport reports "info" by itself after connecting; don't ask again. */
+  readonly infoOnConnect?: boolean;
+  /**
+   * Holds a command slot until "connected" (or "disconnected"); the
+   * transport times out its own connects.
+   */
+  connect(deviceId: string, model: number): Promise<unknown>;
+  disconnect(deviceId: string): Promise<unknown>;
+  getInfo(deviceId: string): Promise<unknown>;
+  readFile(deviceId: string, name: string): Promise<unknown>;
+  subscribe(listener: (e: TransportEvent) => void): () => void;
+}
+
+export type SessionClock = {
+  now(): number;
+  setTimeout(fn: () => void, ms: number): unknown;
+  clearTimeout(handle: unknown): void;
+};
+
+export const realClock: SessionClock = {
+  now: () => Date.now(),
+  setTimeout: (fn, ms) => setTimeout(fn, ms),
+  clearTimeout: (handle) => clearTimeout(handle as ReturnType<typeof setTimeout>),
+};
+
+export type SessionState = "connecting" | "ready" | "closed";
+
+export type SessionEvent =
+  | TransportEvent
+  | { type: "fileFailed"; deviceId: string; name: string; timedOut: boolean }
+  | { type: "drained"; deviceId: string };
+
+type Command =
+  | { kind: "connect" }
+  | { kind: "info" }
+  | { kind: "read"; name: string; attempts: number };
+
+export type SessionOptions = {
+  /** No progress for this long fails the in-flight command. */
+  commandTimeoutMs?: number;
+  /** Attempts per file before it is reported as failed. */
+  maxAttempts?: number;
+  /** Queue every new file listed in an info response. */
+  autoRead?: boolean;
+  clock?: SessionClock;
+};
+
+export type SessionStats = {
+  files: number;
+  failedFiles: number;
+  bytes: number;
+  retries: number;
+  /** Clock time the last command finished, 0 if none. */
+  lastActivityAt: number;
+};
+
+export class DeviceSession {
+  state: SessionState = "connecting";
+  readonly stats: SessionStats = {
+    files: 0,
+    failedFiles: 0,
+    bytes: 0,
+    retries: 0,
+    lastActivityAt: 0,
+  };
+
+  /** @internal */ readonly queue: Command[] = [];
+  /** @internal */ inFlight: Command | null = null;
+  /** @internal */ timer: unknown = null;
+  /** Every file name ever queued, so repeated info responses do not re-read. */
+  /** @internal */ readonly seen = new Set<string>();
+  private readonly listeners = new Set<(e: SessionEvent) => void>();
+
+  constructor(
+    readonly deviceId: string,
+    readonly model: number,
+    private readonly manager: SessionManager
+  ) {}
+
+  get pending() {
+    return this.queue.length + (this.inFlight ? 1 : 0);
+  }
+
+  get currentFile() {
+    return this.inFlight?.kind === "read" ? this.inFlight.name : null;
+  }
+
+  requestInfo() {
+    if (!this.queue.some((c) => c.kind === "info")) {
+      this.queue.push({ kind: "info" });
+    }
+    this.manager.pump();
+  }
+
+  enqueueReads(names: string[]) {
+    for (const name of names) {
+      if (this.seen.has(name)) continue;
+      this.seen.add(name);
+      this.queue.push({ kind: "read", name, attempts: 0 });
+    }
+    this.manager.pump();
+  }
+
+  addListener(listener: (e: SessionEvent) => void) {
+    this.listeners.add(listener);
+    return { remove: () => this.listeners.delete(listener) };
+  }
+
+  /** @internal */
+  emit(e: SessionEvent) {
+    this.listeners.forEach((l) => l(e));
+  }
+}
+
+export class SessionManager {
+  private readonly sessions = new Map<string, DeviceSession>();
+  /** Round-robin order; `cursor` is where the next scan starts. */
+  private readonly ring: DeviceSession[] = [];
+  private cursor = 0;
+  private running = 0;
+  private readonly listeners = new Set<(e: SessionEvent) => void>();
+  private readonly unsubscribe: () => void;
+
+  private readonly commandTimeoutMs: number;
+  private readonly maxAttempts: number;
+  private readonly autoRead: boolean;
+  private readonly clock: SessionClock;
+
+  constructor(private readonly transport: SessionTransport, options: SessionOptions = {}) {
+    this.commandTimeoutMs = options.commandTimeoutMs ?? 30000;
+    this.maxAttempts = options.maxAttempts ?? 3;
+    this.autoRead = options.autoRead ?? true;
+    this.clock = options.clock ?? realClock;
+    this.unsubscribe = transport.subscribe((e) => this.onTransportEvent(e));
+  }
+
+  get size() {
+    return this.sessions.size;
+  }
+
+  get(deviceId: string) {
+    return this.sessions.get(deviceId);
+  }
+
+  all() {
+    return [...this.ring];
+  }
+
+  /**
+   * Start a ring's session; it connects when its turn comes. Returns the
+   * existing one if open.
+   */
+  open(deviceId: string, model: number) {
+    const existing = this.sessions.get(deviceId);
+    if (existing && existing.state !== "closed") return existing;
+    const session = new DeviceSession(deviceId, model, this);
+    session.queue.push({ kind: "connect" });
+    this.sessions.set(deviceId, session);
+    this.ring.push(session);
+    this.pump();
+    return session;
+  }
+
+  async close(deviceId: string) {
+    const session = this.sessions.get(deviceId);
+    if (!session) return;
+    this.drop(session);
+    await this.transport.disconnect(deviceId);
+  }
+
+  async closeAll() {
+    await Promise.all([...this.sessions.keys()].map((id) => this.close(id)));
+  }
+
+  dispose() {
+    this.unsubscribe();
+    this.ring.forEach((s) => this.clearTimer(s));
+    this.listeners.clear();
+  }
+
+  addListener(listener: (e: SessionEvent) => void) {
+    this.listeners.add(listener);
+    return { remove: () => this.listeners.delete(listener) };
+  }
+
+  /**
+   * Fill free transport slots. Each turn gives one command to the next
+   * ready session with work queued, starting after the last one served.
+   */
+  pump() {
+    let scanned = 0;
+    while (this.running < this.transport.maxConcurrent && scanned < this.ring.length) {
+      const session = this.ring[this.cursor % this.ring.length];
+      this.cursor = (this.cursor + 1) % this.ring.length;
+      scanned++;
+      if (session.inFlight || session.queue.length === 0) continue;
+      if (session.state !== "ready" && session.queue[0].kind !== "connect") continue;
+      this.start(session, session.queue.shift()!);
+      scanned = 0;
+    }
+  }
+
+  private start(session: DeviceSession, cmd: Command) {
+    session.inFlight = cmd;
+    this.running++;
+    if (cmd.kind === "connect") {
+      this.transport.connect(session.deviceId, session.model).catch((err) => {
+        if (session.inFlight !== cmd) return;
+        this.dispatch(session, {
+          type: "error",
+          deviceId: session.deviceId,
+          code: "CONNECT_FAILED",
+          message: String(err?.message ?? err),
+        });
+        this.drop(session);
+      });
+      return;
+    }
+    this.armTimer(session);
+    const issued =
+      cmd.kind === "info"
+        ? this.transport.getInfo(session.deviceId)
+        : this.transport.readFile(session.deviceId, cmd.name);
+    issued.catch((err) => {
+      if (session.inFlight !== cmd) return;
+      this.fail(session, false, String(err?.message ?? err));
+    });
+  }
+
+  private finish(session: DeviceSession) {
+    if (!session.inFlight) return;
+    session.inFlight = null;
+    session.stats.lastActivityAt = this.clock.now();
+    this.running--;
+    this.clearTimer(session);
+    if (session.queue.length === 0 && session.state === "ready") {
+      this.dispatch(session, { type: "drained", deviceId: session.deviceId });
+    }
+    this.pump();
+  }
+
+  private fail(session: DeviceSession, timedOut: boolean, message: string) {
+    const cmd = session.inFlight;
+    if (!cmd) return;
+    if (cmd.kind === "read") {
+      cmd.attempts++;
+      if (cmd.attempts < this.maxAttempts && session.state === "ready") {
+        session.stats.retries++;
+        // Back of this session's queue; other sessions still get their turn first.
+        session.queue.push(cmd);
+      } else {
+        session.stats.failedFiles++;
+        this.dispatch(session, {
+          type: "fileFailed",
+          deviceId: session.deviceId,
+          name: cmd.name,
+          timedOut,
+        });
+      }
+    }
+    this.dispatch(session, {
+      type: "error",
+      deviceId: session.deviceId,
+      code: timedOut ? "COMMAND_TIMEOUT" : "COMMAND_FAILED",
+      message,
+    });
+    this.finish(session);
+  }
+
+  private armTimer(session: DeviceSession) {
+    this.clearTimer(session);
+    session.timer = this.clock.setTimeout(() => {
+      session.timer = null;
+      this.fail(session, true, `No response within ${this.commandTimeoutMs} ms`);
+    }, this.commandTimeoutMs);
+  }
+
+  private clearTimer(session: DeviceSession) {
+    if (session.timer != null) {
+      this.clock.clearTimeout(session.timer);
+      session.timer = null;
+    }
+  }
+
+  private drop(session: DeviceSession) {
+    if (session.inFlight) {
+      session.inFlight = null;
+      this.running--;
+    }
+    this.clearTimer(session);
+    session.state = "closed";
+    session.queue.length = 0;
+    this.sessions.delete(session.deviceId);
+    const idx = this.ring.indexOf(session);
+    if (idx >= 0) {
+      this.ring.splice(idx, 1);
+      if (this.cursor > idx) this.cursor--;
+      if (this.cursor >= this.ring.length) this.cursor = 0;
+    }
+    this.pump();
+  }
+
+  private onTransportEvent(e: TransportEvent) {
+    const session = this.sessions.get(e.deviceId);
+    if (!session) return;
+    switch (e.type) {
+      case "connected": {
+        // Native re-reports ready each time a ring is swapped back onto the SDK
+        const first = session.state === "connecting";
+        session.state = "ready";
+        if (session.inFlight?.kind === "connect") {
+          session.inFlight = null;
+          this.running--;
+        }
+        this.dispatch(session, e);
+        if (first && !this.transport.infoOnConnect) session.requestInfo();
+        else this.pump();
+        return;
+      }
+      case "disconnected":
+        this.dispatch(session, e);
+        this.drop(session);
+        return;
+      case "info": {
+        this.dispatch(session, e);
+        // Native may send info unasked (on connect); it answers a queued request too
+        const queued = session.queue.findIndex((c) => c.kind === "info");
+        if (queued >= 0 && session.inFlight?.kind !== "info") session.queue.splice(queued, 1);
+        if (this.autoRead) {
+          session.queue.push(
+            ...e.files
+              .filter((name) => !session.seen.has(name))
+              .map((name) => (session.seen.add(name), { kind: "read" as const, name, attempts: 0 }))
+          );
+        }
+        if (session.inFlight?.kind === "info") this.finish(session);
+        else this.pump();
+        return;
+      }
+      case "progress":
+        if (session.inFlight) this.armTimer(session);
+        this.dispatch(session, e);
+        return;
+      case "file":
+        session.stats.files++;
+        session.stats.bytes += e.bytes ?? e.csv.length;
+        this.dispatch(session, e);
+        if (session.inFlight?.kind === "read") this.finish(session);
+        return;
+      case "error":
+        // A failed connect ends in "disconnected"; keep the slot until then
+        if (session.inFlight && session.inFlight.kind !== "connect") {
+          this.fail(session, false, e.message);
+        } else {
+          this.dispatch(session, e);
+        }
+        return;
+    }
+  }
+
+  private dispatch(session: DeviceSession, e: SessionEvent) {
+    session.emit(e);
+    this.listeners.forEach((l) => l(e));
+  }
+}
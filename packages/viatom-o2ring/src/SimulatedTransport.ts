@@ -0,0 +1,251 @@
+// In-process stand-in for the BLE stack, for exercising `SessionManager`
+// without rings. Every device has a fixed file list; reads progress in
+// chunks whose duration depends on the per-link rate and on how many
+// transfers currently share the radio. Runs on any `SessionClock`, so with
+// `VirtualClock` a whole ward's night pull simulates in milliseconds.
+
+import { SessionClock, SessionTransport, TransportEvent } from "./Sessions";
+
+/** `data`, if given, is delivered as the file's `raw` bytes. */
+export type SimulatedFile = { name: string; bytes: number; data?: Uint8Array };
+
+export type SimulatedTransportOptions = {
+  clock: SessionClock;
+  /** Commands in flight at once (the native SDKs allow one). */
+  maxConcurrent?: number;
+  /** Throughput of a single ring link, bytes/s. */
+  linkBytesPerSec?: number;
+  /** Total throughput shared by all concurrent transfers, bytes/s. */
+  radioBytesPerSec?: number;
+  chunkBytes?: number;
+  connectMs?: number;
+  /** Round trip for a non-transfer command (info). */
+  commandMs?: number;
+  /** Probability a chunk is lost and the read stalls until timeout. */
+  stallRate?: number;
+  seed?: number;
+};
+
+type Device = {
+  model: number;
+  files: SimulatedFile[];
+  connected: boolean;
+  /** Bumped on every new command so stale chunk timers stop. */
+  generation: number;
+};
+
+export class SimulatedTransport implements SessionTransport {
+  readonly maxConcurrent: number;
+
+  private readonly clock: SessionClock;
+  private readonly linkBytesPerSec: number;
+  private readonly radioBytesPerSec: number;
+  private readonly chunkBytes: number;
+  private readonly connectMs: number;
+  private readonly commandMs: number;
+  private readonly stallRate: number;
+  private rng: number;
+
+  private readonly devices = new Map<string, Device>();
+  private readonly listeners = new Set<(e: TransportEvent) => void>();
+  private activeReads = 0;
+
+  constructor(options: SimulatedTransportOptions) {
+    this.clock = options.clock;
+    this.maxConcurrent = options.maxConcurrent ?? 1;
+    this.linkBytesPerSec = options.linkBytesPerSec ?? 8000;
+    this.radioBytesPerSec = options.radioBytesPerSec ?? 40000;
+    this.chunkBytes = options.chunkBytes ?? 512;
+    this.connectMs = options.connectMs ?? 1500;
+    this.commandMs = options.commandMs ?? 120;
+    this.stallRate = options.stallRate ?? 0;
+    this.rng = (options.seed ?? 1) >>> 0 || 1;
+  }
+
+  addDevice(deviceId: string, files: SimulatedFile[], model = 0) {
+    this.devices.set(deviceId, { model, files, connected: false, generation: 0 });
+  }
+
+  subscribe(listener: (e: TransportEvent) => void) {
+    this.listeners.add(listener);
+    return () => {
+      this.listeners.delete(listener);
+    };
+  }
+
+  async connect(deviceId: string, model: number) {
+    const device = this.require(deviceId);
+    device.model = model;
+    this.clock.setTimeout(() => {
+      device.connected = true;
+      this.emit({ type: "connected", deviceId });
+    }, this.connectMs);
+    return true;
+  }
+
+  async disconnect(deviceId: string) {
+    const device = this.require(deviceId);
+    if (!device.connected) return true;
+    device.connected = false;
+    device.generation++;
+    this.emit({ type: "disconnected", deviceId, reason: 0 });
+    return true;
+  }
+
+  async getInfo(deviceId: string) {
+    const device = this.requireConnected(deviceId);
+    const generation = ++device.generation;
+    this.clock.setTimeout(() => {
+      if (device.generation !== generation) return;
+      this.emit({
+        type: "info",
+        deviceId,
+        files: device.files.map((f) => f.name),
+        battery: 80,
+      });
+    }, this.commandMs);
+    return true;
+  }
+
+  async readFile(deviceId: string, name: string) {
+    const device = this.requireConnected(deviceId);
+    const file = device.files.find((f) => f.name === name);
+    if (!file) throw new Error(`No file ${name} on ${deviceId}`);
+    const generation = ++device.generation;
+    this.activeReads++;
+    let sent = 0;
+    const done = () => {
+      this.activeReads--;
+    };
+    const step = () => {
+      if (device.generation !== generation) return done();
+      if (this.random() < this.stallRate) return done();
+      sent = Math.min(file.bytes, sent + this.chunkBytes);
+      this.emit({
+        type: "progress",
+        deviceId,
+        progress: Math.round((sent / file.bytes) * 100),
+      });
+      if (sent >= file.bytes) {
+        done();
+        this.emit({
+          type: "file",
+          deviceId,
+          csv: "",
+          startTime: 0,
+          bytes: file.bytes,
+          raw: file.data,
+        });
+        return;
+      }
+      this.clock.setTimeout(step, this.chunkMs());
+    };
+    this.clock.setTimeout(step, this.commandMs + this.chunkMs());
+    return true;
+  }
+
+  private chunkMs() {
+    const share = this.radioBytesPerSec / Math.max(1, this.activeReads);
+    return (this.chunkBytes / Math.min(this.linkBytesPerSec, share)) * 1000;
+  }
+
+  private require(deviceId: string) {
+    const device = this.devices.get(deviceId);
+    if (!device) throw new Error(`Unknown device ${deviceId}`);
+    return device;
+  }
+
+  private requireConnected(deviceId: string) {
+    const device = this.require(deviceId);
+    if (!device.connected) throw new Error(`${deviceId} is not connected`);
+    return device;
+  }
+
+  // xorshift32: deterministic stalls for reproducible runs
+  private random() {
+    let x = this.rng;
+    x ^= x << 13;
+    x ^= x >>> 17;
+    x ^= x << 5;
+    this.rng = x >>> 0;
+    return this.rng / 0x100000000;
+  }
+
+  private emit(e: TransportEvent) {
+    this.listeners.forEach((l) => l(e));
+  }
+}
+
+/**
+ * Discrete-event clock: timers run in due order (ties in scheduling order)
+ * when `run()` is called, with `now()` jumping straight to each due time.
+ */
+export class VirtualClock implements SessionClock {
+  private time = 0;
+  private seq = 0;
+  private readonly heap: { at: number; seq: number; fn: () => void }[] = [];
+  private readonly cancelled = new Set<number>();
+
+  now() {
+    return this.time;
+  }
+
+  setTimeout(fn: () => void, ms: number) {
+    const timer = { at: this.time + Math.max(0, ms), seq: this.seq++, fn };
+    this.push(timer);
+    return timer.seq;
+  }
+
+  clearTimeout(handle: unknown) {
+    if (typeof handle === "number") this.cancelled.add(handle);
+  }
+
+  /** Run timers until none are left or the clock passes `untilMs`. */
+  async run(untilMs = Infinity) {
+    while (this.heap.length && this.heap[0].at <= untilMs) {
+      const timer = this.pop();
+      if (this.cancelled.delete(timer.seq)) continue;
+      this.time = timer.at;
+      timer.fn();
+      // let promise continuations (transport calls) settle before the next timer
+      await Promise.resolve();
+    }
+  }
+
+  private less(a: { at: number; seq: number }, b: { at: number; seq: number }) {
+    return a.at < b.at || (a.at === b.at && a.seq < b.seq);
+  }
+
+  private push(item: { at: number; seq: number; fn: () => void }) {
+    const h = this.heap;
+    h.push(item);
+    let i = h.length - 1;
+    while (i > 0) {
+      const parent = (i - 1) >> 1;
+      if (!this.less(h[i], h[parent])) break;
+      [h[i], h[parent]] = [h[parent], h[i]];
+      i = parent;
+    }
+  }
+
+  private pop() {
+    const h = this.heap;
+    const top = h[0];
+    const last = h.pop()!;
+    if (h.length) {
+      h[0] = last;
+      let i = 0;
+      for (;;) {
+        const l = 2 * i + 1;
+        const r = l + 1;
+        let m = i;
+        if (l < h.length && this.less(h[l], h[m])) m = l;
+        if (r < h.length && this.less(h[r], h[m])) m = r;
+        if (m === i) break;
+        [h[i], h[m]] = [h[m], h[i]];
+        i = m;
+      }
+    }
+    return top;
+  }
+}
@@ -0,0 +1,223 @@
+// Lightweight span tracing for the sync pipeline.
+//
+// JS spans go into a fixed ring of typed arrays (no per-span allocation);
+// native spans are kept in an equivalent ring on the Kotlin / Swift side
+// and pulled with `drainTrace`. `exportChromeTrace` merges both into the
+// Chrome trace-event JSON that chrome://tracing and ui.perfetto.dev load.
+//
+// Span names and categories are interned, so they should come from a
+// small fixed set: per-event values (file names, states) go in `args`,
+// which live in the ring slot and are dropped when it is reused.
+
+const CAPACITY = 4096; // power of two
+const MASK = CAPACITY - 1;
+
+const PHASE_COMPLETE = 0;
+const PHASE_INSTANT = 1;
+const PHASE_OPEN = 2;
+
+export type NativeTraceEvent = {
+  name: string;
+  cat: string;
+  /** Epoch microseconds. */
+  ts: number;
+  /** Microseconds; 0 for instant events. */
+  dur: number;
+  tid: number;
+};
+
+export type TraceArgs = Record<string, string | number | boolean>;
+
+type ChromeTraceEvent = {
+  name: string;
+  cat: string;
+  ph: "X" | "i";
+  ts: number;
+  dur?: number;
+  pid: number;
+  tid: number;
+  s?: "t";
+  args?: TraceArgs;
+};
+
+type NativeTraceHooks = {
+  setTracing(enabled: boolean): Promise<boolean>;
+  drainTrace(): Promise<NativeTraceEvent[]>;
+};
+
+const JS_PID = 1;
+const NATIVE_PID = 2;
+const JS_TID = 1;
+
+const startUs = new Float64Array(CAPACITY);
+const durUs = new Float64Array(CAPACITY);
+const nameIds = new Int32Array(CAPACITY);
+const catIds = new Int32Array(CAPACITY);
+const phases = new Uint8Array(CAPACITY);
+const generations = new Uint32Array(CAPACITY);
+const slotArgs: (TraceArgs | undefined)[] = new Array(CAPACITY);
+
+const names: string[] = [];
+const nameIndex = new Map<string, number>();
+
+let head = 0;
+let written = 0;
+let enabled = false;
+let nativeHooks: NativeTraceHooks | null = null;
+
+// Epoch-aligned microsecond clock so JS and native timelines line up.
+const hasPerf =
+  typeof performance !== "undefined" && typeof performance.now === "function";
+const originMs = hasPerf ? Date.now() - performance.now() : 0;
+const nowUs = hasPerf
+  ? () => (originMs + performance.now()) * 1000
+  : () => Date.now() * 1000;
+
+function intern(s: string) {
+  let id = nameIndex.get(s);
+  if (id === undefined) {
+    id = names.length;
+    names.push(s);
+    nameIndex.set(s, id);
+  }
+  return id;
+}
+
+function claim(name: string, cat: string, phase: number, args?: TraceArgs) {
+  const slot = head;
+  head = (head + 1) & MASK;
+  written++;
+  startUs[slot] = nowUs();
+  durUs[slot] = 0;
+  nameIds[slot] = intern(name);
+  catIds[slot] = intern(cat);
+  phases[slot] = phase;
+  slotArgs[slot] = args;
+  generations[slot]++;
+  return slot;
+}
+
+/** Used by Viatom.ts to wire up the native ring without an import cycle. */
+export function registerNativeTrace(hooks: NativeTraceHooks) {
+  nativeHooks = hooks;
+}
+
+export function isTracingEnabled() {
+  return enabled;
+}
+
+export async function setTracingEnabled(on: boolean) {
+  enabled = on;
+  if (nativeHooks) {
+    try {
+      await nativeHooks.setTracing(on);
+    } catch (e) {
+      console.warn("Error@Trace.ts/setTracingEnabled:", e);
+    }
+  }
+}
+
+/**
+ * Open a span. Returns a token for `traceEnd`, or -1 when tracing is off.
+ */
+export function traceBegin(name: string, cat = "js", args?: TraceArgs): number {
+  if (!enabled) return -1;
+  const slot = claim(name, cat, PHASE_OPEN, args);
+  return generations[slot] * CAPACITY + slot;
+}
+
+/** Close a span opened with `traceBegin`. Stale or -1 tokens are ignored. */
+export function traceEnd(token: number) {
+  if (token < 0) return;
+  const slot = token & MASK;
+  if (generations[slot] !== Math.floor(token / CAPACITY)) return;
+  if (phases[slot] !== PHASE_OPEN) return;
+  durUs[slot] = nowUs() - startUs[slot];
+  phases[slot] = PHASE_COMPLETE;
+}
+
+export function traceInstant(name: string, cat = "js", args?: TraceArgs) {
+  if (!enabled) return;
+  claim(name, cat, PHASE_INSTANT, args);
+}
+
+/** Trace an async operation end to end, including failures. */
+export async function traceAsync<T>(
+  name: string,
+  fn: () => Promise<T>,
+  cat = "js",
+  args?: TraceArgs
+): Promise<T> {
+  const token = traceBegin(name, cat, args);
+  try {
+    return await fn();
+  } finally {
+    traceEnd(token);
+  }
+}
+
+function jsEvents(): ChromeTraceEvent[] {
+  const count = Math.min(written, CAPACITY);
+  const first = (head - count + CAPACITY) & MASK;
+  const out: ChromeTraceEvent[] = [];
+  for (let i = 0; i < count; i++) {
+    const slot = (first + i) & MASK;
+    // Spans still open at export time are dropped rather than guessed.
+    if (phases[slot] === PHASE_OPEN) continue;
+    const instant = phases[slot] === PHASE_INSTANT;
+    out.push({
+      name: names[nameIds[slot]],
+      cat: names[catIds[slot]],
+      ph: instant ? "i" : "X",
+      ts: startUs[slot],
+      ...(instant ? { s: "t" as const } : { dur: durUs[slot] }),
+      ...(slotArgs[slot] ? { args: slotArgs[slot] } : {}),
+      pid: JS_PID,
+      tid: JS_TID,
+    });
+  }
+  return out;
+}
+
+/**
+ * Drain native spans, merge with the JS ring and return Chrome trace JSON.
+ * The JS ring and the intern table are cleared afterwards.
+ */
+export async function exportChromeTrace(): Promise<string> {
+  let native: NativeTraceEvent[] = [];
+  if (nativeHooks) {
+    try {
+      native = await nativeHooks.drainTrace();
+    } catch (e) {
+      console.warn("Error@Trace.ts/exportChromeTrace:", e);
+    }
+  }
+
+  const traceEvents: ChromeTraceEvent[] = jsEvents();
+  for (const e of native) {
+    traceEvents.push({
+      name: e.name,
+      cat: e.cat,
+      ph: e.dur > 0 ? "X" : "i",
+      ts: e.ts,
+      ...(e.dur > 0 ? { dur: e.dur } : { s: "t" as const }),
+      pid: NATIVE_PID,
+      tid: e.tid,
+    });
+  }
+  traceEvents.sort((a, b) => a.ts - b.ts);
+
+  // Every slot is unreachable once `written` is 0, so the ids can go too;
+  // stale tokens from spans still open are rejected by generation.
+  head = 0;
+  written = 0;
+  slotArgs.fill(undefined);
+  names.length = 0;
+  nameIndex.clear();
+
+  return JSON.stringify({
+    traceEvents,
+    displayTimeUnit: "ms",
+    metadata: { "clock-domain": "epoch-us" },
+  });
+}
@@ -0,0 +1,224 @@
+// Which samples of a night (or a journal) are fit for analysis.
+//
+// One pass classifies every sample through 256-entry lookup tables into a
+// reason byte (range, vibration mark, motion, probe off), then packs SpO2
+// and PR validity into 32-sample bitmap words without a per-sample branch.
+// Run-length segments come from the bitmap a word at a time: all-valid and
+// all-invalid words are skipped whole, and edges inside a word are found
+// with count-trailing-zeros. Analysis reads the bitmaps; anything that
+// works per episode (gaps, usable recording time) reads the runs.
+
+export const INVALID_SPO2_RANGE = 1;
+export const INVALID_PR_RANGE = 2;
+/** The ring vibrated (SpO2 / PR reminder) on this sample. */
+export const INVALID_SPO2_MARK = 4;
+export const INVALID_PR_MARK = 8;
+export const INVALID_MOTION = 16;
+export const INVALID_PROBE_OFF = 32;
+
+export type ValidityColumns = {
+  spo2: ArrayLike<number>;
+  pr: ArrayLike<number>;
+  motion?: ArrayLike<number>;
+  spo2Mark?: ArrayLike<number>;
+  prMark?: ArrayLike<number>;
+  /**
+   * Bit 0 set while the probe is on; absent for history files. For the
+   * realtime journal use `journalValidityMask`, which passes its `flags`.
+   */
+  probeOn?: ArrayLike<number>;
+};
+
+export type ValidityOptions = {
+  spo2Min?: number;
+  spo2Max?: number;
+  prMin?: number;
+  prMax?: number;
+  /** Samples with more motion than this are artifacts (40, as for alarms). */
+  motionMax?: number;
+  /**
+   * Also reject samples the ring vibrated on. Off by default: the ring
+   * vibrates because of a breach, so dropping these would cut the nadir
+   * out of the very desaturations being measured. The reason is recorded
+   * either way.
+   */
+  dropMarked?: boolean;
+};
+
+/** Bit `i & 31` of word `i >>> 5` is set when sample `i` is valid. */
+export type ValidityBitmap = Uint32Array;
+
+export type ValidityMask = {
+  length: number;
+  spo2: ValidityBitmap;
+  pr: ValidityBitmap;
+  /** `INVALID_*` bits per sample. */
+  reasons: Uint8Array;
+};
+
+/**
+ * Alternating valid / invalid runs: run `k` covers `[ends[k-1], ends[k])`
+ * (from 0 for the first) and is valid when `k` is even and `firstValid`,
+ * or odd and not.
+ */
+export type MaskRuns = {
+  firstValid: boolean;
+  ends: Uint32Array;
+};
+
+const DEFAULTS: Required<ValidityOptions> = {
+  spo2Min: 50,
+  spo2Max: 100,
+  prMin: 25,
+  prMax: 250,
+  motionMax: 40,
+  dropMarked: false,
+};
+
+function rangeTable(min: number, max: number, reason: number) {
+  const t = new Uint8Array(256);
+  for (let v = 0; v < 256; v++) t[v] = v >= min && v <= max ? 0 : reason;
+  return t;
+}
+
+export function buildValidityMask(
+  cols: ValidityColumns,
+  options: ValidityOptions = {}
+): ValidityMask {
+  const o = { ...DEFAULTS, ...options };
+  const n = cols.spo2.length;
+  const spo2Table = rangeTable(o.spo2Min, o.spo2Max, INVALID_SPO2_RANGE);
+  const prTable = rangeTable(o.prMin, o.prMax, INVALID_PR_RANGE);
+  const motionTable = rangeTable(0, o.motionMax, INVALID_MOTION);
+  const artifact = INVALID_MOTION | INVALID_PROBE_OFF;
+  const spo2Reject = artifact | INVALID_SPO2_RANGE | (o.dropMarked ? INVALID_SPO2_MARK : 0);
+  const prReject = artifact | INVALID_PR_RANGE | (o.dropMarked ? INVALID_PR_MARK : 0);
+
+  const { spo2, pr, motion, spo2Mark, prMark, probeOn } = cols;
+  const reasons = new Uint8Array(n);
+  const words = (n + 31) >>> 5;
+  const spo2Bits = new Uint32Array(words);
+  const prBits = new Uint32Array(words);
+
+  for (let w = 0; w < words; w++) {
+    const base = w << 5;
+    const end = Math.min(base + 32, n);
+    let sw = 0;
+    let pw = 0;
+    for (let i = base; i < end; i++) {
+      // PR is 16-bit: past the table, compare instead of wrapping
+      const p = pr[i];
+      let r =
+        spo2Table[spo2[i] & 0xff] |
+        (p <= 0xff ? prTable[p] : p <= o.prMax ? 0 : INVALID_PR_RANGE);
+      if (motion) r |= motionTable[motion[i] & 0xff];
+      if (spo2Mark && spo2Mark[i]) r |= INVALID_SPO2_MARK;
+      if (prMark && prMark[i]) r |= INVALID_PR_MARK;
+      if (probeOn) r |= ((probeOn[i] & 1) ^ 1) * INVALID_PROBE_OFF;
+      reasons[i] = r;
+      const b = i - base;
+      // (x - 1) >>> 31 is 1 exactly when x is 0
+      sw |= (((r & spo2Reject) - 1) >>> 31) << b;
+      pw |= (((r & prReject) - 1) >>> 31) << b;
+    }
+    spo2Bits[w] = sw;
+    prBits[w] = pw;
+  }
+  return { length: n, spo2: spo2Bits, pr: prBits, reasons };
+}
+
+/**
+ * Mask for readings from `readJournal`: the native journal stores the
+ * ring's probe state in bit 0 of `flags` with every reading, so probe-off
+ * samples are rejected as artifacts.
+ */
+export function journalValidityMask(
+  journal: {
+    spo2: ArrayLike<number>;
+    pr: ArrayLike<number>;
+    motion: ArrayLike<number>;
+    flags: ArrayLike<number>;
+  },
+  options?: ValidityOptions
+): ValidityMask {
+  const { spo2, pr, motion, flags } = journal;
+  return buildValidityMask({ spo2, pr, motion, probeOn: flags }, options);
+}
+
+export function isValid(bits: ValidityBitmap, i: number) {
+  return ((bits[i >>> 5] >>> (i & 31)) & 1) === 1;
+}
+
+/** Number of valid samples. */
+export function countValid(bits: ValidityBitmap) {
+  let c = 0;
+  for (let w = 0; w < bits.length; w++) {
+    let x = bits[w];
+    x -= (x >>> 1) & 0x55555555;
+    x = (x & 0x33333333) + ((x >>> 2) & 0x33333333);
+    c += (Math.imul((x + (x >>> 4)) & 0x0f0f0f0f, 0x01010101) >>> 24);
+  }
+  return c;
+}
+
+/** Valid samples in both bitmaps. */
+export function intersectMasks(a: ValidityBitmap, b: ValidityBitmap): ValidityBitmap {
+  const out = new Uint32Array(Math.min(a.length, b.length));
+  for (let w = 0; w < out.length; w++) out[w] = a[w] & b[w];
+  return out;
+}
+
+export function maskRuns(bits: ValidityBitmap, length: number): MaskRuns {
+  if (length === 0) return { firstValid: false, ends: new Uint32Array(0) };
+  const firstValid = (bits[0] & 1) === 1;
+  let ends = new Uint32Array(64);
+  let count = 0;
+  let cur = firstValid ? 0xffffffff : 0;
+  const words = (length + 31) >>> 5;
+  for (let w = 0; w < words; w++) {
+    const base = w << 5;
+    const live = length - base >= 32 ? 0xffffffff : (1 << (length - base)) - 1;
+    let diff = ((bits[w] ^ cur) & live) >>> 0;
+    while (diff !== 0) {
+      const p = 31 - Math.clz32(diff & -diff);
+      if (count === ends.length) {
+        const grown = new Uint32Array(ends.length * 2);
+        grown.set(ends);
+        ends = grown;
+      }
+      ends[count++] = base + p;
+      cur = ~cur >>> 0;
+      // edges above p, relative to the new state
+      diff = p === 31 ? 0 : ((bits[w] ^ cur) & live & (0xffffffff << (p + 1))) >>> 0;
+    }
+  }
+  if (count === ends.length) {
+    const grown = new Uint32Array(count + 1);
+    grown.set(ends);
+    ends = grown;
+  }
+  ends[count++] = length;
+  return { firstValid, ends: ends.slice(0, count) };
+}
+
+export function forEachRun(
+  runs: MaskRuns,
+  fn: (start: number, end: number, valid: boolean) => void
+) {
+  let start = 0;
+  let valid = runs.firstValid;
+  for (let k = 0; k < runs.ends.length; k++) {
+    fn(start, runs.ends[k], valid);
+    start = runs.ends[k];
+    valid = !valid;
+  }
+}
+
+/** `[start, end)` pairs of the valid runs at least `minLength` samples long. */
+export function validSegments(runs: MaskRuns, minLength = 1): [number, number][] {
+  const out: [number, number][] = [];
+  forEachRun(runs, (start, end, valid) => {
+    if (valid && end - start >= minLength) out.push([start, end]);
+  });
+  return out;
+}
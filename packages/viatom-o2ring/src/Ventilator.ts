@@ -0,0 +1,374 @@
+// Ventilator (R-series) monitor and statistics files.
+//
+// `ventilator_parseMonitorData:` materialises every `VTMRMonitorData_t` as
+// a C struct and hands the whole array back at once. Here monitor bytes are
+// streamed into one Int16Array column per field, and window statistics are
+// computed in a single pass with counting histograms (every field is a
+// small bounded integer), so a night can be joined against O2Ring data
+// without building per-point objects. Breathing events are only counted in
+// the statistics records, so AHI and the other indices are per record, not
+// per window.
+
+import { VTMRMonitorPoint, VTMScaleFileHead } from "./WireFormats";
+import { WireFormatError } from "./WireStruct";
+
+// ----- Wire constants (VTMBLEStruct.h) -----
+
+export const VENT_FILE_HEAD_SIZE = VTMScaleFileHead.size;
+export const VENT_MONITOR_POINT_SIZE = VTMRMonitorPoint.size;
+/** Monitor points are stored at 0.5 Hz. */
+export const VENT_MONITOR_INTERVAL_S = 2;
+/** `VTMRStatisticsPara_t`: 12 ints */
+const VENT_PARA_SIZE = 48;
+/** `VTMRStatistict_t.item`: int[20][5] */
+const VENT_ITEM_ROWS = 20;
+const VENT_ITEM_COLS = 5;
+export const VENT_STATISTICS_SIZE =
+  VENT_FILE_HEAD_SIZE + 16 + VENT_PARA_SIZE + VENT_ITEM_ROWS * VENT_ITEM_COLS * 4;
+
+/** Field order of `VTMRMonitorData_t`. */
+export const VENT_MONITOR_FIELDS = [
+  "pressure",
+  "ipap",
+  "epap",
+  "vt",
+  "mv",
+  "leak",
+  "rr",
+  "ti",
+  "ie",
+  "spo2",
+  "pr",
+  "hr",
+] as const;
+
+export type VentMonitorField = (typeof VENT_MONITOR_FIELDS)[number];
+
+/** Largest raw value each field can take, per the header's documented range. */
+const FIELD_MAX: Record<VentMonitorField, number> = {
+  pressure: 400,
+  ipap: 400,
+  epap: 400,
+  vt: 3000,
+  mv: 600,
+  leak: 1200,
+  rr: 60,
+  ti: 40,
+  ie: 30000,
+  spo2: 100,
+  pr: 250,
+  hr: 250,
+};
+
+export type VentFileHead = { fileVersion: number; fileType: number };
+
+export type VentMonitorColumns = {
+  head: VentFileHead;
+  count: number;
+  columns: Record<VentMonitorField, Int16Array>;
+};
+
+function newColumns(capacity: number) {
+  const columns = {} as Record<VentMonitorField, Int16Array>;
+  for (const f of VENT_MONITOR_FIELDS) columns[f] = new Int16Array(capacity);
+  return columns;
+}
+
+/**
+ * Incremental monitor-file decoder. Feed chunks as they arrive from the
+ * device; partial head/point bytes are held until the rest turns up.
+ */
+export class VentMonitorDecoder {
+  private head: VentFileHead | null = null;
+  private pending = new Uint8Array(VENT_MONITOR_POINT_SIZE);
+  private pendingLen = 0;
+  private count = 0;
+  private columns: Record<VentMonitorField, Int16Array>;
+
+  constructor(expectedPoints = 4096) {
+    this.columns = newColumns(Math.max(expectedPoints, 1));
+  }
+
+  push(chunk: Uint8Array) {
+    let i = 0;
+    while (i < chunk.length) {
+      const want = this.head
+        ? VENT_MONITOR_POINT_SIZE
+        : VENT_FILE_HEAD_SIZE;
+      const take = Math.min(want - this.pendingLen, chunk.length - i);
+
+      // Whole points straight from the chunk, no staging copy.
+      if (this.head && this.pendingLen === 0 && take === want) {
+        const whole = Math.floor((chunk.length - i) / want);
+        this.readPoints(chunk, i, whole);
+        i += whole * want;
+        continue;
+      }
+
+      this.pending.set(chunk.subarray(i, i + take), this.pendingLen);
+      this.pendingLen += take;
+      i += take;
+      if (this.pendingLen < want) break;
+
+      if (this.head) {
+        this.readPoints(this.pending, 0, 1);
+      } else {
+        const head = VTMScaleFileHead.read(this.pending);
+        this.head = {
+          fileVersion: head.file_version,
+          fileType: head.file_type,
+        };
+      }
+      this.pendingLen = 0;
+    }
+  }
+
+  /** Columns trimmed to the points decoded so far. */
+  finish(): VentMonitorColumns {
+    if (!this.head) {
+      throw new WireFormatError("VentMonitorDecoder: missing file head");
+    }
+    const columns = {} as Record<VentMonitorField, Int16Array>;
+    for (const f of VENT_MONITOR_FIELDS) {
+      columns[f] = this.columns[f].subarray(0, this.count);
+    }
+    return { head: this.head, count: this.count, columns };
+  }
+
+  private readPoints(bytes: Uint8Array, offset: number, n: number) {
+    this.reserve(this.count + n);
+    VTMRMonitorPoint.columns(bytes, n, {
+      offset,
+      into: this.columns,
+      intoOffset: this.count,
+    });
+    this.count += n;
+  }
+
+  private reserve(needed: number) {
+    const capacity = this.columns.pressure.length;
+    if (needed <= capacity) return;
+    const grown = newColumns(Math.max(needed, capacity * 2));
+    for (const f of VENT_MONITOR_FIELDS) grown[f].set(this.columns[f]);
+    this.columns = grown;
+  }
+}
+
+/** One-shot decode of a complete monitor file. */
+export function decodeVentMonitorFile(bytes: Uint8Array): VentMonitorColumns {
+  const points = Math.max(
+    Math.floor((bytes.length - VENT_FILE_HEAD_SIZE) / VENT_MONITOR_POINT_SIZE),
+    0
+  );
+  const decoder = new VentMonitorDecoder(points);
+  decoder.push(bytes);
+  return decoder.finish();
+}
+
+/** Min / max / mean / median / p95, the same five values as `item[][5]`. */
+export type VentFieldSummary = {
+  min: number;
+  max: number;
+  avg: number;
+  median: number;
+  p95: number;
+  samples: number;
+};
+
+/**
+ * Summarise `fields` over points `[start, end)` in one pass. Values outside
+ * the documented range (disconnected sensor, padding) are skipped.
+ */
+export function ventWindowSummary(
+  data: VentMonitorColumns,
+  fields: VentMonitorField[] = ["pressure", "leak"],
+  start = 0,
+  end = data.count
+): Partial<Record<VentMonitorField, VentFieldSummary>> {
+  const lo = Math.max(0, start);
+  const hi = Math.min(data.count, end);
+  const hists = fields.map((f) => new Uint32Array(FIELD_MAX[f] + 1));
+  const cols = fields.map((f) => data.columns[f]);
+  const sums = new Float64Array(fields.length);
+  const counts = new Uint32Array(fields.length);
+
+  for (let i = lo; i < hi; i++) {
+    for (let f = 0; f < cols.length; f++) {
+      const v = cols[f][i];
+      if (v < 0 || v >= hists[f].length) continue;
+      hists[f][v]++;
+      sums[f] += v;
+      counts[f]++;
+    }
+  }
+
+  const out: Partial<Record<VentMonitorField, VentFieldSummary>> = {};
+  fields.forEach((field, f) => {
+    if (counts[f] === 0) return;
+    const h = hists[f];
+    out[field] = {
+      min: h.findIndex((c) => c > 0),
+      max: histLastNonZero(h),
+      avg: sums[f] / counts[f],
+      median: histQuantile(h, counts[f], 0.5),
+      p95: histQuantile(h, counts[f], 0.95),
+      samples: counts[f],
+    };
+  });
+  return out;
+}
+
+function histLastNonZero(hist: Uint32Array) {
+  for (let v = hist.length - 1; v > 0; v--) if (hist[v] > 0) return v;
+  return 0;
+}
+
+function histQuantile(hist: Uint32Array, total: number, q: number) {
+  const rank = Math.ceil(q * total);
+  let seen = 0;
+  for (let v = 0; v < hist.length; v++) {
+    seen += hist[v];
+    if (seen >= rank) return v;
+  }
+  return hist.length - 1;
+}
+
+/**
+ * Point range covering `[fromMs, toMs)` for a file that started at
+ * `startMs`, for lining a ventilator night up with an O2Ring recording.
+ */
+export function ventPointRange(
+  data: VentMonitorColumns,
+  startMs: number,
+  fromMs: number,
+  toMs: number
+) {
+  const step = VENT_MONITOR_INTERVAL_S * 1000;
+  const clamp = (i: number) => Math.min(Math.max(i, 0), data.count);
+  return {
+    start: clamp(Math.ceil((fromMs - startMs) / step)),
+    end: clamp(Math.ceil((toMs - startMs) / step)),
+  };
+}
+
+// ----- Statistics (VTMRStatistict) -----
+
+export type VentEventCounts = {
+  spont: number;
+  ahi: number;
+  ai: number;
+  hi: number;
+  oai: number;
+  cai: number;
+  rera: number;
+  sni: number;
+  pb: number;
+  takeOff: number;
+  largeLeakSeconds: number;
+};
+
+export type VentStatistics = {
+  head: VentFileHead;
+  totalSeconds: number;
+  usageDays: number;
+  moreThan4h: number;
+  meanSeconds: number;
+  counts: VentEventCounts;
+  /** `item[20][5]` keyed by monitor field (reserved rows dropped). */
+  items: Partial<Record<VentMonitorField, Int32Array>>;
+};
+
+/** Parse a `VTMRStatistict` blob (`ventilator_parseStatistictData:`). */
+export function parseVentStatistics(bytes: Uint8Array): VentStatistics {
+  if (bytes.length < VENT_STATISTICS_SIZE) {
+    throw new WireFormatError("parseVentStatistics: truncated statistics");
+  }
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.length);
+  const int = (o: number) => view.getInt32(o, true);
+
+  let o = VENT_FILE_HEAD_SIZE;
+  const totalSeconds = int(o);
+  const usageDays = int(o + 4);
+  const moreThan4h = int(o + 8);
+  const meanSeconds = int(o + 12);
+  o += 16;
+
+  const counts: VentEventCounts = {
+    spont: int(o),
+    ahi: int(o + 4),
+    ai: int(o + 8),
+    hi: int(o + 12),
+    oai: int(o + 16),
+    cai: int(o + 20),
+    rera: int(o + 24),
+    sni: int(o + 28),
+    pb: int(o + 32),
+    takeOff: int(o + 36),
+    largeLeakSeconds: int(o + 40),
+  };
+  o += VENT_PARA_SIZE;
+
+  const items: Partial<Record<VentMonitorField, Int32Array>> = {};
+  VENT_MONITOR_FIELDS.forEach((f, row) => {
+    const vals = new Int32Array(VENT_ITEM_COLS);
+    for (let c = 0; c < VENT_ITEM_COLS; c++) {
+      vals[c] = int(o + (row * VENT_ITEM_COLS + c) * 4);
+    }
+    items[f] = vals;
+  });
+
+  return {
+    head: { fileVersion: bytes[0], fileType: bytes[1] },
+    totalSeconds,
+    usageDays,
+    moreThan4h,
+    meanSeconds,
+    counts,
+    items,
+  };
+}
+
+export type VentIndices = {
+  ahi: number;
+  ai: number;
+  hi: number;
+  oai: number;
+  cai: number;
+  rera: number;
+  hours: number;
+};
+
+/**
+ * Per-hour indices over any set of statistics records (a night, a week):
+ * `index = count * 3600 / recording_time`, with AI = OAI + CAI and
+ * AHI = AI + HI as the firmware defines them.
+ *
+ * One record is the finest window. `VTMRMonitorData_t` carries no event
+ * flags and `VTMRStatisticsPara_t` only totals, so an index cannot be cut to
+ * an arbitrary time range the way `ventWindowSummary` cuts pressure and
+ * leak.
+ */
+export function ventIndices(records: VentStatistics[]): VentIndices {
+  let seconds = 0;
+  let oai = 0;
+  let cai = 0;
+  let hi = 0;
+  let rera = 0;
+  for (const r of records) {
+    seconds += r.totalSeconds;
+    oai += r.counts.oai;
+    cai += r.counts.cai;
+    hi += r.counts.hi;
+    rera += r.counts.rera;
+  }
+  const perHour = (n: number) => (seconds > 0 ? (n * 3600) / seconds : 0);
+  return {
+    ahi: perHour(oai + cai + hi),
+    ai: perHour(oai + cai),
+    hi: perHour(hi),
+    oai: perHour(oai),
+    cai: perHour(cai),
+    rera: perHour(rera),
+    hours: seconds / 3600,
+  };
+}
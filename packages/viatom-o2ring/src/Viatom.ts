@@ -1,4 +1,5 @@
 import { EventEmitter, requireNativeModule } from "expo-modules-core";
+import { NativeTraceEvent, registerNativeTrace } from "./Trace";
 
 type NativeViatomModule = {
   requestPermissions(): Promise<boolean>;
@@ -6,17 +7,77 @@ type NativeViatomModule = {
   scan(): Promise<boolean>;
   stopScan(): Promise<boolean>;
   connect(mac: string, model: number): Promise<boolean>;
-  disconnect(): Promise<boolean>;
-  startRealtime(): Promise<boolean>;
-  stopRealtime(): Promise<boolean>;
-  getInfo(): Promise<boolean>;
-  readHistoryFile(filename: string): Promise<boolean>;
+  disconnect(mac: string | null): Promise<boolean>;
+  startRealtime(mac: string | null): Promise<boolean>;
+  stopRealtime(mac: string | null): Promise<boolean>;
+  getInfo(mac: string | null): Promise<boolean>;
+  readHistoryFile(filename: string, mac: string | null): Promise<boolean>;
+  getSessions(): Promise<NativeSession[]>;
+  setAlarmConfig(config: AlarmConfig | null): Promise<boolean>;
+  setJournaling(enabled: boolean): Promise<boolean>;
+  readJournal(mac: string, sinceMs: number | null): Promise<JournalColumns>;
+  getJournalStats(): Promise<JournalStats[]>;
+  benchmarkJournal(records: number): Promise<JournalBenchResult[]>;
+  setCapture(enabled: boolean): Promise<boolean>;
+  listCaptures(): Promise<CaptureFile[]>;
+  setTracing(enabled: boolean): Promise<boolean>;
+  drainTrace(): Promise<NativeTraceEvent[]>;
 };
 
 const Native: NativeViatomModule = requireNativeModule("Viatom");
 const emitter = new EventEmitter(Native as any);
 
+registerNativeTrace({
+  setTracing: (enabled) => Native.setTracing(enabled),
+  drainTrace: () => Native.drainTrace(),
+});
+
 // ----- Types for events from Kotlin -----
+//
+// Per-device events carry the `mac` (iOS: peripheral UUID) of the ring they
+// came from, so several open sessions can share one listener.
+
+export type NativeSession = {
+  mac: string;
+  model: number;
+  /** Currently bound to the SDK's single command channel. */
+  attached: boolean;
+  ready: boolean;
+  /** Commands waiting for this ring's turn on the SDK. */
+  pending: number;
+  state: LinkState;
+  /** ms from connect to the first realtime sample / first history file. */
+  firstSampleMs?: number | null;
+  firstFileMs?: number | null;
+};
+
+/**
+ * Native bring-up of a ring. Each state issues one command with its own
+ * timeout and retry budget; "syncing" means realtime is flowing and history
+ * can be read. Android's SDK reports link-up and service discovery as one
+ * event, so its rings go from "connecting" straight to "info".
+ */
+export type LinkState =
+  | "connecting"
+  | "services"
+  | "info"
+  | "realtime"
+  | "syncing"
+  | "disconnected";
+
+/** Emitted on transitions only, never for retries within a state. */
+export type LinkStateEvent = {
+  mac?: string;
+  state: LinkState;
+  from: LinkState;
+  /** ms since the connect was issued. */
+  elapsedMs: number;
+  /** Attempts the state that was left took. */
+  attempts: number;
+  reason?: string | null;
+  /** On entering "syncing": ms from connect to the first realtime sample. */
+  firstSampleMs?: number | null;
+};
 
 export type DeviceFoundEvent = {
   mac: string;
@@ -40,6 +101,7 @@ export type ServiceReadyEvent = {
 }
 
 export type RealtimeEvent = {
+  mac?: string;
   spo2: number;
   pr: number;
   pi: number;
@@ -48,6 +110,7 @@ export type RealtimeEvent = {
 };
 
 export type InfoEvent = {
+  mac?: string;
   battery?: number | null;
   batteryState?: number | null;
   state?: number | null;
@@ -55,15 +118,119 @@ export type InfoEvent = {
 };
 
 export type HistoryFileEvent = {
+  mac?: string;
   csv: string;
   startTime: number;
+  /** Raw file size as read from the device. */
+  bytes?: number;
+  /** First file of this connection: ms since the connect was issued. */
+  firstFileMs?: number | null;
 };
 
 export type ReadProgressEvent = {
+  mac?: string;
   progress: number;
+  /** Native epoch ms when the progress callback fired. */
+  ts?: number;
+};
+
+/**
+ * Native alarm thresholds, evaluated on the BLE callback thread for every
+ * realtime sample so alarms fire with JS busy or suspended. While armed,
+ * native also keeps realtime flowing on its own (one request a second when
+ * the ring goes quiet). Omitted keys keep the defaults shown; a threshold of
+ * 0 disables that alarm.
+ */
+export type AlarmConfig = {
+  /** Raise below this SpO2 % (88), clear at spo2Low + spo2Hysteresis (2). */
+  spo2Low?: number;
+  spo2Hysteresis?: number;
+  /** Raise below / above these bpm (40 / 130); clear prHysteresis (5) inside. */
+  prLow?: number;
+  prHigh?: number;
+  prHysteresis?: number;
+  /** How long a breach must last before it is raised (10000 ms). */
+  onsetMs?: number;
+  /** How long values must be back in range before it clears (5000 ms). */
+  clearMs?: number;
+  /** Samples with more motion than this are ignored as artifacts (40). */
+  motionMax?: number;
+  /** A longer run of artifacts drops a pending onset (15000 ms). */
+  maxGapMs?: number;
+};
+
+export type AlarmKind = "spo2Low" | "prLow" | "prHigh";
+
+export type AlarmEvent = {
+  mac?: string;
+  kind: AlarmKind;
+  /** true when raised, false when cleared. */
+  raised: boolean;
+  value: number;
+  /** Worst value of the episode. */
+  nadir: number;
+  /** Since the episode's first breaching sample. */
+  durationMs: number;
+  /** From the sample's arrival in native to the notification being posted. */
+  latencyMs: number;
+  /** A local notification was posted (false when notifications are off). */
+  notified: boolean;
+  ts: number;
+};
+
+/**
+ * Realtime readings from the native journal, oldest first. Each is one
+ * 16-byte record with its own CRC; see RealtimeJournal.kt / .swift.
+ */
+export type JournalColumns = {
+  /** Epoch ms (segment wall-clock base + monotonic offset). */
+  t: number[];
+  spo2: number[];
+  pr: number[];
+  /** Perfusion index in tenths. */
+  pi: number[];
+  motion: number[];
+  battery: number[];
+  /** Bit 0: probe on. */
+  flags: number[];
+};
+
+export type JournalStats = {
+  mac: string;
+  appended: number;
+  committed: number;
+  /** Dropped because the disk fell a whole staging buffer behind. */
+  dropped: number;
+  /** Lost to a failed write. */
+  lost: number;
+  fsyncs: number;
+  segments: number;
+  /** Found intact in the newest segment when the journal was opened. */
+  recoveredRecords: number;
+  /** Torn tail cut off on open. */
+  truncatedBytes: number;
+};
+
+export type JournalBenchResult = {
+  /** Commit at least every this many readings. */
+  commitRecords: number;
+  records: number;
+  fsyncs: number;
+  wallMs: number;
+  recordsPerSec: number;
+  /** records / fsyncs: how much the committer coalesced. */
+  meanBatch: number;
+};
+
+/** A packet capture on the device; decode with `decodeCapture` (Capture.ts). */
+export type CaptureFile = {
+  mac: string;
+  path: string;
+  bytes: number;
 };
 
 export type ErrorEvent = {
+  mac?: string;
   code: string;
   message: string;
 };
@@ -90,24 +257,76 @@ export function connect(mac: string, model: number) {
   return Native.connect(mac, model);
 }
 
-export function disconnect() {
-  return Native.disconnect();
+// `mac` picks the session; without it the last connected ring is used.
+
+export function disconnect(mac?: string) {
+  return Native.disconnect(mac ?? null);
+}
+
+export function startRealtime(mac?: string) {
+  return Native.startRealtime(mac ?? null);
+}
+
+export function stopRealtime(mac?: string) {
+  return Native.stopRealtime(mac ?? null);
+}
+
+export function getInfo(mac?: string) {
+  return Native.getInfo(mac ?? null);
+}
+
+export function readHistoryFile(filename: string, mac?: string) {
+  return Native.readHistoryFile(filename, mac ?? null);
 }
 
-export function startRealtime() {
-  return Native.startRealtime();
+export function getSessions() {
+  return Native.getSessions();
 }
 
-export function stopRealtime() {
-  return Native.stopRealtime();
+/**
+ * Arm the native alarms (null disarms). Resolves false when the app may not
+ * post notifications; alarms are still evaluated and emitted as `onAlarm`.
+ */
+export function setAlarmConfig(config: AlarmConfig | null) {
+  return Native.setAlarmConfig(config);
 }
 
-export function getInfo() {
-  return Native.getInfo();
+/**
+ * Journal every realtime sample natively (append-only, fsync in batches,
+ * torn tails cut on the next open), independent of the JS thread.
+ */
+export function setJournaling(enabled: boolean) {
+  return Native.setJournaling(enabled);
 }
 
-export function readHistoryFile(filename: string) {
-  return Native.readHistoryFile(filename);
+/**
+ * Readings at or after `sinceMs` (epoch ms); includes earlier runs. Pass
+ * the result to `journalValidityMask` to drop probe-off and motion samples.
+ */
+export function readJournal(mac: string, sinceMs?: number) {
+  return Native.readJournal(mac, sinceMs ?? null);
+}
+
+export function getJournalStats() {
+  return Native.getJournalStats();
+}
+
+/** Group-commit throughput on the device's storage at batch sizes 1/8/64/512. */
+export function benchmarkJournal(records = 20000) {
+  return Native.benchmarkJournal(records);
+}
+
+/**
+ * Record every realtime sample and history file the rings send, one
+ * capture file per ring, for replay with `replayCapture` off-device.
+ * Debug / field use: captures are not rotated or pruned.
+ */
+export function setCapture(enabled: boolean) {
+  return Native.setCapture(enabled);
+}
+
+export function listCaptures() {
+  return Native.listCaptures();
 }
 
 // ----- Event listener helpers -----
@@ -134,6 +353,12 @@ export function addServiceReadyListener(
   return emitter.addListener<ServiceReadyEvent>("onServiceReady", listener);
 }
 
+export function addLinkStateListener(
+  listener: (e: LinkStateEvent) => void
+) {
+  return emitter.addListener<LinkStateEvent>("onLinkState", listener);
+}
+
 export function addRealtimeListener(listener: (e: RealtimeEvent) => void) {
   return emitter.addListener<RealtimeEvent>("onRealtime", listener);
 }
@@ -154,6 +379,10 @@ export function addReadProgressListener(
   return emitter.addListener<ReadProgressEvent>("onReadProgress", listener);
 }
 
+export function addAlarmListener(listener: (e: AlarmEvent) => void) {
+  return emitter.addListener<AlarmEvent>("onAlarm", listener);
+}
+
 export function addErrorListener(listener: (e: ErrorEvent) => void) {
   return emitter.addListener<ErrorEvent>("onError", listener);
 }
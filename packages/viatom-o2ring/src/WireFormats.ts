@@ -0,0 +1,312 @@
+// Wire struct declarations, one per packed C struct, with the C sizeof as
+// the checked size. Names and field order follow the SDK headers so a
+// diff against VTO2Def.h / VTMBLEStruct.h stays readable.
+
+import { bits, defineStruct, field, pad } from "./WireStruct";
+
+// ----- VTO2Lib (VTO2Def.h) -----
+
+/**
+ * Head of an O2Ring history file, what `parseO2ObjectWithData:` reads into
+ * `VTO2Object`. The SDK has no C struct for it; offsets match the Lepu
+ * `OxyFile` parser, which also reads `asleep_time` (15) that `VTO2Object`
+ * leaves out. `size` is the whole file, head included.
+ */
+export const VTO2ObjectHead = defineStruct(
+  "VTO2Object",
+  [
+    field("file_version", "u8"),
+    field("mode", "u8"),
+    field("year", "u16"),
+    field("month", "u8"),
+    field("day", "u8"),
+    field("hour", "u8"),
+    field("minute", "u8"),
+    field("second", "u8"),
+    field("size", "u32"),
+    field("record_time", "u16"),
+    field("asleep_time", "u16"),
+    field("average_spo2", "u8"),
+    field("lowest_spo2", "u8"),
+    field("drops_l3", "u8"),
+    field("drops_l4", "u8"),
+    field("t90", "u8"),
+    field("drop_time", "u16"),
+    field("drop_number", "u8"),
+    field("score", "u8"),
+    field("steps", "u32"),
+    pad(10),
+  ],
+  40
+);
+
+/** One `VTO2WaveObject` point of an O2Ring history file. */
+export const VTO2WavePoint = defineStruct(
+  "VTO2WaveObject",
+  [
+    field("spo2", "u8"),
+    field("hr", "u16"),
+    field("ac_v_s", "u8"),
+    bits("u8", [
+      ["reserved", 4],
+      ["invalid_mark", 1],
+      ["motion_mark", 1],
+      ["hr_mark", 1],
+      ["spo2_mark", 1],
+    ]),
+  ],
+  5
+);
+
+/** BabyO2 S3 file head (`babyo2s3_parseFileData:`). */
+export const VTO2FileHead = defineStruct(
+  "VTO2FileHead_t",
+  [
+    field("file_version", "u8"),
+    field("operation_mode", "u8"),
+    field("year", "u16"),
+    field("month", "u8"),
+    field("day", "u8"),
+    field("hour", "u8"),
+    field("minute", "u8"),
+    field("second", "u8"),
+    field("size", "u32"),
+  ],
+  13
+);
+
+export const VTO2SleepPointData = defineStruct(
+  "VTO2SleepPointData_t",
+  [
+    field("spo2", "u8"),
+    field("pr", "u8"),
+    bits("u8", [
+      ["motion", 6],
+      ["remind_hr", 1],
+      ["remind_spo2", 1],
+    ]),
+    bits("u8", [
+      ["quiet", 4],
+      ["sleep_state", 4],
+    ]),
+  ],
+  4
+);
+
+/**
+ * `VTO2SleepFileTail_t`: `VTO2SleepAnalysisResult` then `VTO2SleepReport`,
+ * flattened. The header's "16 bytes" comment on the result is stale; its
+ * packed fields add up to 27.
+ */
+export const VTO2SleepFileTail = defineStruct(
+  "VTO2SleepFileTail_t",
+  [
+    field("record_time", "u16"),
+    field("asleep_time", "u16"),
+    field("average_spo2", "u8"),
+    field("lowest_spo2", "u8"),
+    field("_3percent_drops", "u8"),
+    field("_4percent_drops", "u8"),
+    field("_90percent_duration", "u16"),
+    field("_90percent_drops", "u8"),
+    field("t90", "u8"),
+    field("o2_score", "u8"),
+    field("step_counter", "u32"),
+    field("average_hr", "u16"),
+    pad(8),
+    field("start_timestamp", "u32"),
+    field("end_timestamp", "u32"),
+    field("awake_duration", "u32"),
+    field("deep_duration", "u32"),
+    field("light_duration", "u32"),
+    field("total_duration", "u32"),
+    field("wake_count", "u8"),
+    pad(15),
+  ],
+  67
+);
+
+export const VTParameters = defineStruct(
+  "VTParameters",
+  [
+    field("record_time", "u32"),
+    field("run_state", "u8"),
+    field("sensor_state", "u8"),
+    field("spo2", "u8"),
+    field("pi", "u8"),
+    field("pr", "u16"),
+    field("flag", "u8"),
+    field("motion", "u8"),
+    field("battery_state", "u8"),
+    field("battery_percent", "u8"),
+    pad(6),
+  ],
+  20
+);
+
+// ----- VTMProductLib: ER3 / M-series -----
+
+export const VTMER3FileHead = defineStruct(
+  "VTMER3FileHead",
+  [
+    field("file_version", "u8"),
+    field("type", "u8"),
+    field("cable_type", "u8"),
+    pad(7),
+  ],
+  10
+);
+
+export const VTMER3FileTail = defineStruct(
+  "VTMER3FileTail",
+  [
+    field("recoring_time", "u32"),
+    field("data_crc", "u16"),
+    pad(10),
+    field("magic", "u32"),
+  ],
+  20
+);
+
+// ----- VTMProductLib: wearable oximeters -----
+
+export const VTMOxiFileHead = defineStruct(
+  "VTMOxiFileHead",
+  [
+    field("file_version", "u8"),
+    field("file_type", "u8"),
+    pad(6),
+    field("device_model", "u16"),
+  ],
+  10
+);
+
+export const VTMOxiPoint = defineStruct(
+  "VTMOxiPoint",
+  [
+    field("spo2", "u8"),
+    field("pr", "u8"),
+    field("motion", "u8"),
+    field("spo2_mark", "u8"),
+    field("pr_mark", "u8"),
+  ],
+  5
+);
+
+/** `VTMOxiFileTail` with its embedded `VTMWOxiResult` flattened in. */
+export const VTMOxiFileTail = defineStruct(
+  "VTMOxiFileTail",
+  [
+    field("check_sum", "u32"),
+    field("magic", "u32"),
+    field("timestamp", "u32"),
+    field("records", "u32"),
+    field("interval", "u8"),
+    field("channel_type", "u8"),
+    field("channel_bytes", "u8"),
+    pad(13),
+    field("asleep_time", "u16"),
+    field("average_spo2", "u8"),
+    field("lowest_spo2", "u8"),
+    field("percent3_drops", "u8"),
+    field("percent4_drops", "u8"),
+    field("t90", "u8"),
+    field("_90percent_time", "u16"),
+    field("_90percent_drops", "u8"),
+    field("o2_score", "u8"),
+    field("step_counter", "u32"),
+    field("average_pr", "u8"),
+  ],
+  48
+);
+
+export const VTMWOxiInfo = defineStruct(
+  "VTMWOxiInfo",
+  [
+    field("remind_switch", "u8"),
+    field("spo2_thr", "u8"),
+    field("hr_thr_low", "u8"),
+    field("hr_thr_high", "u8"),
+    field("motor", "u8"),
+    field("buzzer", "u8"),
+    field("display_mode", "u8"),
+    field("brightness", "u8"),
+    field("interval", "u8"),
+    field("timezone", "u8"),
+    pad(30),
+  ],
+  40
+);
+
+export const VTMWOxiRunParams = defineStruct(
+  "VTMWOxiRunParams",
+  [
+    field("record_time", "u32"),
+    field("run_status", "u8"),
+    field("sensor_state", "u8"),
+    field("spo2", "u8"),
+    field("pi", "u8"),
+    field("pr", "u16"),
+    field("flag", "u8"),
+    field("motion", "u8"),
+    field("battery_state", "u8"),
+    field("battery_percent", "u8"),
+    pad(6),
+  ],
+  20
+);
+
+/** Raw PPG selection: `marker` bit 0 IR, bit 1 red, bit 2 motion; `sample_rate` 0 = 150 Hz, 1 = 200 Hz. */
+export const VTMWOxiRawSampleInfo = defineStruct(
+  "VTMWOxiRawSampleInfo",
+  [field("marker", "u8"), field("sample_rate", "u8")],
+  2
+);
+
+// ----- VTMProductLib: BabyO2 / baby monitor -----
+
+export const VTMBabyRecordHead = defineStruct(
+  "VTMBabyRecordHead",
+  [
+    field("measuring_timestamp", "u32"),
+    field("recording_time", "u32"),
+    field("interval", "u8"),
+    pad(9),
+    field("crc32", "i32"),
+  ],
+  22
+);
+
+export const VTMBabyRecord = defineStruct(
+  "VTMBabyRecord_t",
+  [field("resp", "u8"), field("status", "u8"), field("temp", "i16")],
+  4
+);
+
+// ----- VTMProductLib: ventilator -----
+
+export const VTMScaleFileHead = defineStruct(
+  "VTMScaleFileHead",
+  [field("file_version", "u8"), field("file_type", "u8"), pad(8)],
+  10
+);
+
+export const VTMRMonitorPoint = defineStruct(
+  "VTMRMonitorData_t",
+  [
+    field("pressure", "i16"),
+    field("ipap", "i16"),
+    field("epap", "i16"),
+    field("vt", "i16"),
+    field("mv", "i16"),
+    field("leak", "i16"),
+    field("rr", "i16"),
+    field("ti", "i16"),
+    field("ie", "i16"),
+    field("spo2", "i16"),
+    field("pr", "i16"),
+    field("hr", "i16"),
+    pad(16),
+  ],
+  40
+);
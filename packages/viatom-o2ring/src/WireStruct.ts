@@ -0,0 +1,275 @@
+// Declarative layouts for Viatom's packed little-endian wire structs.
+//
+// Each `#pragma pack(1)` struct from VTO2Def.h / VTMBLEStruct.h is declared
+// once as a field list. `defineStruct` works out offsets, checks the total
+// against the C `sizeof` when the module loads, and precomputes one accessor
+// per field, so record reads and bulk columnar decodes are both a flat loop
+// over DataView calls with explicit endianness (host byte order never
+// matters).
+
+/**
+ * Thrown when input bytes don't match the expected layout: truncated
+ * records, bad magic, out-of-range enums. Lets callers tell a corrupt or
+ * partial transfer apart from a programming error and skip the file.
+ */
+export class WireFormatError extends Error {
+  constructor(message: string) {
+    super(message);
+    this.name = "WireFormatError";
+    // Keep `instanceof` working when classes are transpiled to ES5.
+    Object.setPrototypeOf(this, WireFormatError.prototype);
+  }
+}
+
+export type ScalarType =
+  | "u8"
+  | "i8"
+  | "u16"
+  | "i16"
+  | "u32"
+  | "i32"
+  | "i64"
+  | "f32";
+
+type BitsUnit = "u8" | "u16";
+
+export type FieldSpec<K extends string> =
+  | { kind: "scalar"; name: K; type: ScalarType }
+  | { kind: "pad"; bytes: number }
+  | { kind: "bits"; unit: BitsUnit; members: { name: K; width: number }[] };
+
+export function field<K extends string>(
+  name: K,
+  type: ScalarType
+): FieldSpec<K> {
+  return { kind: "scalar", name, type };
+}
+
+/** Reserved / unused bytes (`reserved[n]`). */
+export function pad(bytes: number): FieldSpec<never> {
+  return { kind: "pad", bytes };
+}
+
+/**
+ * A run of C bitfields sharing one storage unit, listed in declaration
+ * order. Packed LSB-first, which is what clang and gcc do on the
+ * little-endian targets the SDKs are built for.
+ */
+export function bits<K extends string>(
+  unit: BitsUnit,
+  members: [K, number][]
+): FieldSpec<K> {
+  return {
+    kind: "bits",
+    unit,
+    members: members.map(([name, width]) => ({ name, width })),
+  };
+}
+
+const SCALAR_SIZE: Record<ScalarType, number> = {
+  u8: 1,
+  i8: 1,
+  u16: 2,
+  i16: 2,
+  u32: 4,
+  i32: 4,
+  i64: 8,
+  f32: 4,
+};
+
+export type Column =
+  | Uint8Array
+  | Int8Array
+  | Uint16Array
+  | Int16Array
+  | Uint32Array
+  | Int32Array
+  | Float32Array
+  | Float64Array;
+
+const COLUMN_CTOR: Record<ScalarType, new (n: number) => Column> = {
+  u8: Uint8Array,
+  i8: Int8Array,
+  u16: Uint16Array,
+  i16: Int16Array,
+  u32: Uint32Array,
+  i32: Int32Array,
+  // int64 counters (`t_num`) fit comfortably in a double.
+  i64: Float64Array,
+  f32: Float32Array,
+};
+
+type Getter = (view: DataView, at: number) => number;
+
+function scalarGetter(type: ScalarType, offset: number): Getter {
+  switch (type) {
+    case "u8":
+      return (v, at) => v.getUint8(at + offset);
+    case "i8":
+      return (v, at) => v.getInt8(at + offset);
+    case "u16":
+      return (v, at) => v.getUint16(at + offset, true);
+    case "i16":
+      return (v, at) => v.getInt16(at + offset, true);
+    case "u32":
+      return (v, at) => v.getUint32(at + offset, true);
+    case "i32":
+      return (v, at) => v.getInt32(at + offset, true);
+    case "f32":
+      return (v, at) => v.getFloat32(at + offset, true);
+    case "i64":
+      return (v, at) =>
+        v.getInt32(at + offset + 4, true) * 0x100000000 +
+        v.getUint32(at + offset, true);
+  }
+}
+
+export type FieldLayout<K extends string> = {
+  name: K;
+  offset: number;
+  type: ScalarType;
+  /** Bit position and width for bitfield members. */
+  shift?: number;
+  width?: number;
+  get: Getter;
+};
+
+export type WireStruct<K extends string> = {
+  name: string;
+  size: number;
+  fields: FieldLayout<K>[];
+  offsetOf(name: K): number;
+  /** Decode one record at `offset`. */
+  read(bytes: Uint8Array, offset?: number): Record<K, number>;
+  /** Decode a single field of the record at `offset`. */
+  get(bytes: Uint8Array, name: K, offset?: number): number;
+  /**
+   * Decode `count` consecutive records into one typed array per field,
+   * allocating new columns or appending to `into` at `intoOffset`.
+   */
+  columns<P extends K = K>(
+    bytes: Uint8Array,
+    count: number,
+    options?: {
+      offset?: number;
+      only?: readonly P[];
+      into?: Record<P, Column>;
+      intoOffset?: number;
+    }
+  ): Record<P, Column>;
+};
+
+function viewOf(bytes: Uint8Array) {
+  return new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+}
+
+/**
+ * Lay out a packed struct and verify it against the C `sizeof`. A mismatch
+ * throws as soon as the declaring module is imported.
+ */
+export function defineStruct<K extends string>(
+  name: string,
+  specs: FieldSpec<K>[],
+  expectedSize: number
+): WireStruct<K> {
+  const fields: FieldLayout<K>[] = [];
+  let offset = 0;
+
+  for (const spec of specs) {
+    if (spec.kind === "pad") {
+      offset += spec.bytes;
+    } else if (spec.kind === "scalar") {
+      fields.push({
+        name: spec.name,
+        offset,
+        type: spec.type,
+        get: scalarGetter(spec.type, offset),
+      });
+      offset += SCALAR_SIZE[spec.type];
+    } else {
+      const unitBits = SCALAR_SIZE[spec.unit] * 8;
+      const unitGet = scalarGetter(spec.unit, offset);
+      let shift = 0;
+      for (const { name: member, width } of spec.members) {
+        if (shift + width > unitBits) {
+          throw new Error(`${name}.${member}: bitfield overflows ${spec.unit}`);
+        }
+        const s = shift;
+        const mask = (1 << width) - 1;
+        fields.push({
+          name: member,
+          offset,
+          type: spec.unit,
+          shift: s,
+          width,
+          get: (v, at) => (unitGet(v, at) >>> s) & mask,
+        });
+        shift += width;
+      }
+      offset += SCALAR_SIZE[spec.unit];
+    }
+  }
+
+  if (offset !== expectedSize) {
+    throw new Error(
+      `${name}: layout is ${offset} bytes, expected ${expectedSize}`
+    );
+  }
+
+  const size = offset;
+  const byName = new Map(fields.map((f) => [f.name, f]));
+  const lookup = (key: K) => {
+    const f = byName.get(key);
+    if (!f) throw new Error(`${name}: no field ${key}`);
+    return f;
+  };
+  const checkSpan = (bytes: Uint8Array, at: number, count: number) => {
+    if (at < 0 || at + size * count > bytes.length) {
+      throw new WireFormatError(`${name}: need ${size * count} bytes at ${at}`);
+    }
+  };
+
+  return {
+    name,
+    size,
+    fields,
+    offsetOf: (key) => lookup(key).offset,
+
+    read(bytes, at = 0) {
+      checkSpan(bytes, at, 1);
+      const view = viewOf(bytes);
+      const out = {} as Record<K, number>;
+      for (const f of fields) out[f.name] = f.get(view, at);
+      return out;
+    },
+
+    get(bytes, key, at = 0) {
+      checkSpan(bytes, at, 1);
+      return lookup(key).get(viewOf(bytes), at);
+    },
+
+    columns(bytes, count, options = {}) {
+      const { offset: at = 0, only, into, intoOffset = 0 } = options;
+      checkSpan(bytes, at, count);
+      const view = viewOf(bytes);
+      const picked = only ? only.map((k) => lookup(k)) : fields;
+      const out = (into ?? {}) as Record<string, Column>;
+
+      for (const f of picked) {
+        let col = out[f.name as string];
+        if (!col) {
+          col = new COLUMN_CTOR[f.type](count);
+          out[f.name as string] = col;
+        }
+        if (col.length - intoOffset < count) {
+          throw new Error(`${name}.${f.name}: column too small`);
+        }
+        const get = f.get;
+        for (let r = 0, p = at; r < count; r++, p += size) {
+          col[intoOffset + r] = get(view, p);
+        }
+      }
+      return out as Record<P, Column>;
+    },
+  };
+}
@@ -1 +1,22 @@
 export * from "./Viatom";
+export * from "./Er3Wave";
+export * from "./Er3Leads";
+export * from "./MvConvert";
+export * from "./Ventilator";
+export * from "./WireStruct";
+export * from "./WireFormats";
+export * from "./Trace";
+export * from "./Histogram";
+export * from "./Sessions";
+export * from "./SimulatedTransport";
+export * from "./SessionBench";
+export * from "./NativeTransport";
+export * from "./O2Night";
+export * from "./NightArchive";
+export * from "./NightSketch";
+export * from "./ValidityMask";
+export * from "./MaskBench";
+export * from "./Capture";
+export * from "./NightCsv";
+export * from "./ColumnStream";
+export * from "./RawFiles";
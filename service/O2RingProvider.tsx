@@ -13,6 +13,13 @@ import AsyncStorage from "@react-native-async-storage/async-storage";
 import { Platform } from "react-native";
 import { API_DEV, API_PROD } from "@env";
 import { uploadPendingCsvs, UploadItem } from "./History";
+import {
+  beginFileTransfer,
+  endFileTransfer,
+  recordLinkTiming,
+  recordTransferFailure,
+  recordTransferProgress,
+} from "./TransferStats";
 
 const REALTIME_STALE_TIMEOUT_MS = 5000;
 const READ_TIMEOUT_MS = 30000;
@@ -91,17 +98,16 @@ export function O2RingProvider({ children }: { children: React.ReactNode }) {
     completed: 0,
   });
   const [patientId, setPatientId] = useState<string | null>(null);
-  const infoRetryTimer = React.useRef<NodeJS.Timeout | null>(null);
   const patientIdRef = React.useRef<string | null>(null);
   const connectedDeviceRef = React.useRef<DeviceItem | null>(null);
   const serviceReadyRef = React.useRef(serviceReady);
-  const infoRetryCount = React.useRef(0);
   const intentionalDisconnectRef = React.useRef(false);
   const syncingPatientId = React.useRef<Promise<string | null> | null>(null);
   const readQueue = React.useRef<string[]>([]);
   const currentReading = React.useRef<string | null>(null);
   const readTimeout = React.useRef<NodeJS.Timeout | null>(null);
   const readAttempts = React.useRef<Map<string, number>>(new Map());
+  const readSpan = React.useRef(-1);
   const realtimeStartPromise = React.useRef<Promise<boolean> | null>(null);
   const knownDevicesRef = React.useRef<DeviceItem[]>([]);
   const autoReconnectAttempted = React.useRef(false);
@@ -181,6 +187,10 @@ const processReadQueue = useCallback(() => {
     setIsDownloadingHistory(true);
     setDownloadProgress(0);
     currentReading.current = next;
+    O2Ring.traceEnd(readSpan.current);
+    readSpan.current = O2Ring.traceBegin("readFile", "sync", { file: next });
+    const device = connectedDeviceRef.current;
+    if (device) beginFileTransfer(device, next);
 
     // Clear any old timeout before starting a new read
     if (readTimeout.current) {
@@ -196,6 +206,7 @@ const processReadQueue = useCallback(() => {
       if (stuckFile) {
         const attempts = readAttempts.current.get(stuckFile) ?? 0;
         const nextAttempts = attempts + 1;
+        recordTransferFailure(stuckFile, true, nextAttempts <= MAX_READ_RETRIES);
         if (nextAttempts <= MAX_READ_RETRIES) {
           readAttempts.current.set(stuckFile, nextAttempts);
           readQueue.current.push(stuckFile);
@@ -216,6 +227,7 @@ const processReadQueue = useCallback(() => {
       if (failed) {
         const attempts = readAttempts.current.get(failed) ?? 0;
         const nextAttempts = attempts + 1;
+        recordTransferFailure(failed, false, nextAttempts <= MAX_READ_RETRIES);
         if (nextAttempts <= MAX_READ_RETRIES) {
           readAttempts.current.set(failed, nextAttempts);
           readQueue.current.push(failed);
@@ -348,54 +360,6 @@ const processReadQueue = useCallback(() => {
     });
   }, []);
 
-  // Once connected, keep polling getInfo until native responds so history download always kicks in.
-  useEffect(() => {
-    if (!connectedDevice || !serviceReady) return;
-
-    let stopped = false;
-
-    const clearTimer = () => {
-      if (infoRetryTimer.current) {
-        clearInterval(infoRetryTimer.current);
-        infoRetryTimer.current = null;
-      }
-    };
-
-    const attempt = async (label: string) => {
-      try {
-        // Ensure patient ID is loaded so we can persist files once info arrives.
-        await syncPatientId().catch(() => null);
-        await startRealtimeStream();
-        await O2Ring.getInfo();
-      } catch (e) {
-        console.warn(`Error@O2RingProvider.tsx/getInfo (${label}): `, e);
-      }
-    };
-
-    clearTimer();
-    infoRetryCount.current = 0;
-    attempt("initial");
-
-    const timerId = setInterval(() => {
-      if (stopped || !connectedDeviceRef.current) {
-        clearTimer();
-        return;
-      }
-      infoRetryCount.current += 1;
-      if (infoRetryCount.current > 10) {
-        clearTimer();
-        return;
-      }
-      attempt(`retry ${infoRetryCount.current}`);
-    }, 4000);
-    infoRetryTimer.current = timerId;
-
-    return () => {
-      stopped = true;
-      clearTimer();
-    };
-  }, [connectedDevice, serviceReady, startRealtimeStream, syncPatientId]);
-
   const requestPermissions = useCallback(async () => {
     try {
       const granted = await O2Ring.requestPermissions();
@@ -456,35 +420,27 @@ const processReadQueue = useCallback(() => {
     return promise;
   }, []);
 
+  // Bring-up (info, then realtime, with their own timeouts and retries) runs
+  // in the native link state machine; JS only follows its transitions.
   useEffect(() => {
-    if (Platform.OS !== "ios") return;
-
-    const sub = O2Ring.addServiceReadyListener(() => {
-      serviceReadyRef.current = true;
-      setServiceReady(true);
-      startRealtimeStream();
-      syncPatientId()
-        .catch(() => null)
-        .finally(() => {
-          O2Ring.getInfo().catch((err) =>
-            console.warn(
-              "Error@O2RingProvider.tsx/getInfo (service ready): ",
-              err
-            )
-          );
-        });
+    const sub = O2Ring.addLinkStateListener((e) => {
+      const device = connectedDeviceRef.current;
+      if (!device || (e.mac && e.mac !== device.mac)) return;
+      O2Ring.traceInstant("link", "sync", { state: e.state });
+      if (e.from === "services") {
+        serviceReadyRef.current = true;
+        setServiceReady(true);
+      }
+      if (e.state === "syncing") {
+        setIosRealtimeReady(true);
+        if (typeof e.firstSampleMs === "number") {
+          recordLinkTiming(device, "firstSample", e.firstSampleMs);
+        }
+      }
     });
 
     return () => sub.remove();
-  }, [startRealtimeStream, syncPatientId]);
-
-  useEffect(() => {
-    if (Platform.OS === "ios") {
-      if (connectedDevice && serviceReady) {
-        startRealtimeStream();
-      }
-    }
-  }, [connectedDevice, serviceReady, startRealtimeStream]);
+  }, []);
 
   // -------------------
   // MARK: O2Ring
@@ -541,6 +497,7 @@ const processReadQueue = useCallback(() => {
     let subInfo: Subscription | null = null;
     let subProgress: Subscription | null = null;
     let subFile: Subscription | null = null;
+    let subAlarm: Subscription | null = null;
 
     const setup = async () => {
       try {
@@ -554,6 +511,24 @@ const processReadQueue = useCallback(() => {
         setInitializing(false);
       }
 
+      // Pipeline spans are cheap; keep them on in dev builds so a slow sync
+      // can be exported with O2Ring.exportChromeTrace().
+      if (__DEV__) {
+        O2Ring.setTracingEnabled(true);
+      }
+
+      // Alarms run natively (thresholds, hysteresis, motion gating) and post
+      // their own notifications; JS only records them.
+      subAlarm = O2Ring.addAlarmListener((alarm) => {
+        O2Ring.traceInstant("alarm", "sync", {
+          kind: alarm.kind,
+          raised: alarm.raised,
+        });
+      });
+      O2Ring.setAlarmConfig({}).catch((e) =>
+        console.warn("Error@O2RingProvider.tsx/setAlarmConfig: ", e)
+      );
+
       subRt = O2Ring.addRealtimeListener((rt) => {
         setSpo2(rt.spo2);
         setPr(rt.pr);
@@ -570,6 +545,11 @@ const processReadQueue = useCallback(() => {
           if (failed) {
             const attempts = readAttempts.current.get(failed) ?? 0;
             const nextAttempts = attempts + 1;
+            recordTransferFailure(
+              failed,
+              false,
+              nextAttempts <= MAX_READ_RETRIES
+            );
             if (nextAttempts <= MAX_READ_RETRIES) {
               readAttempts.current.set(failed, nextAttempts);
               readQueue.current.push(failed);
@@ -646,12 +626,7 @@ const processReadQueue = useCallback(() => {
       });
 
       subInfo = O2Ring.addInfoListener(async (info) => {
-        // Stop retries once we got a response
-        if (infoRetryTimer.current) {
-          clearInterval(infoRetryTimer.current);
-          infoRetryTimer.current = null;
-          infoRetryCount.current = 0;
-        }
+        O2Ring.traceInstant("onInfo", "sync");
 
         setBattery(
           (() => {
@@ -738,12 +713,14 @@ const processReadQueue = useCallback(() => {
 
         setIsDownloadingHistory(true);
         setDownloadProgress(Math.min(100, Math.max(0, progress.progress)));
+        recordTransferProgress(progress.ts);
 
         // Start a fresh "no-progress" timeout tied to the current file
         const current = currentReading.current;
         if (current) {
           readTimeout.current = setTimeout(() => {
             console.warn("Error@O2RingProvider.tsx/read timeout:", current);
+            recordTransferFailure(current, true, false);
             currentReading.current = null;
             readTimeout.current = null;
             processReadQueue();
@@ -753,6 +730,12 @@ const processReadQueue = useCallback(() => {
 
       subFile = O2Ring.addHistoryFileListener(async (file) => {
         const deviceForSave = connectedDeviceRef.current;
+        O2Ring.traceEnd(readSpan.current);
+        readSpan.current = -1;
+        endFileTransfer(true, file.bytes ?? file.csv.length);
+        if (deviceForSave && typeof file.firstFileMs === "number") {
+          recordLinkTiming(deviceForSave, "firstFile", file.firstFileMs);
+        }
 
         try {
           const patient = patientIdRef.current ?? (await syncPatientId());
@@ -760,20 +743,24 @@ const processReadQueue = useCallback(() => {
             throw new Error("No patient ID available to save history file");
           }
           const serial = deviceForSave?.name ?? "O2Ring";
-          const saved = await saveCsv(
-            file.csv,
-            file.startTime,
-            serial,
-            patient
+          const saved = await O2Ring.traceAsync(
+            "saveCsv",
+            () => saveCsv(file.csv, file.startTime, serial, patient),
+            "sync"
           );
 
           // Attempt immediate upload for newly downloaded file (best-effort; falls back to History screen auto-upload)
           if (baseURL) {
-            const uploaded = await uploadPendingCsvs({
-              patientId: patient,
-              items: saved ? [saved] : [],
-              baseURL,
-            });
+            const uploaded = await O2Ring.traceAsync(
+              "upload",
+              () =>
+                uploadPendingCsvs({
+                  patientId: patient,
+                  items: saved ? [saved] : [],
+                  baseURL,
+                }),
+              "sync"
+            );
             if (uploaded.length === 0) {
               console.warn("O2RingProvider: auto-upload skipped or failed");
             }
@@ -811,10 +798,7 @@ const processReadQueue = useCallback(() => {
       subInfo?.remove();
       subProgress?.remove();
       subFile?.remove();
-      if (infoRetryTimer.current) {
-        clearInterval(infoRetryTimer.current);
-        infoRetryTimer.current = null;
-      }
+      subAlarm?.remove();
       if (readTimeout.current) {
         clearTimeout(readTimeout.current);
         readTimeout.current = null;
@@ -831,6 +815,7 @@ const processReadQueue = useCallback(() => {
 
     setDevices([]);
     setIsScanning(true);
+    O2Ring.traceInstant("scan", "sync");
     try {
       await O2Ring.scan();
       return true;
@@ -925,9 +910,13 @@ const processReadQueue = useCallback(() => {
         }
         setIosRealtimeReady(Platform.OS === "android");
 
-        await O2Ring.connect(device.mac, device.model);
+        await O2Ring.traceAsync(
+          "connect",
+          () => O2Ring.connect(device.mac, device.model),
+          "sync"
+        );
 
-        // Mark as connected; realtime will start when onServiceReady fires
+        // Mark as connected; native brings up info and realtime on its own
         setConnectedDevice(device);
         rememberDevice(device);
 
@@ -956,11 +945,6 @@ const processReadQueue = useCallback(() => {
     }
     // Disable auto-reconnect after an explicit user disconnect.
     autoReconnectEnabled.current = false;
-    if (infoRetryTimer.current) {
-      clearInterval(infoRetryTimer.current);
-      infoRetryTimer.current = null;
-      infoRetryCount.current = 0;
-    }
     if (readTimeout.current) {
       clearTimeout(readTimeout.current);
       readTimeout.current = null;
@@ -1023,14 +1007,13 @@ const processReadQueue = useCallback(() => {
     }
     try {
       await syncPatientId().catch(() => null);
-      await startRealtimeStream();
       await O2Ring.getInfo();
       return true;
     } catch (e) {
       console.warn("Error@O2RingProvider.tsx/requestHistorySync: ", e);
       return false;
     }
-  }, [startRealtimeStream, syncPatientId]);
+  }, [syncPatientId]);
 
   // MARK: Helper
   /**
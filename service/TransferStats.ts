@@ -0,0 +1,305 @@
+import AsyncStorage from "@react-native-async-storage/async-storage";
+import { Platform } from "react-native";
+import { HistogramSnapshot, LogHistogram } from "@ios-app/viatom-o2ring";
+
+const STATS_KEY_PREFIX = "bleTransferStats:";
+const MAX_RECENT_FILES = 50;
+
+// Histogram ranges (values above are clamped into the top bucket)
+const MAX_THROUGHPUT_BPS = 1_000_000;
+const MAX_LATENCY_MS = 120_000;
+
+export type FileTransferRecord = {
+  file: string;
+  /** Epoch ms when the read was issued. */
+  startedAt: number;
+  durationMs: number;
+  bytes: number;
+  bytesPerSecond: number;
+  chunks: number;
+  retries: number;
+  timeouts: number;
+  ok: boolean;
+};
+
+export type DeviceTransferStats = {
+  mac: string;
+  name: string;
+  model: number;
+  platform: string;
+  files: number;
+  failedFiles: number;
+  bytes: number;
+  retries: number;
+  timeouts: number;
+  /** Per-file throughput, bytes/s. */
+  throughput: HistogramSnapshot;
+  /** Gap between consecutive progress callbacks, ms. */
+  chunkLatency: HistogramSnapshot;
+  /** Whole-file read time, ms. */
+  fileDuration: HistogramSnapshot;
+  /** Connect to first realtime sample, ms (native link state machine). */
+  firstSample: HistogramSnapshot;
+  /** Connect to first history file, ms. */
+  firstFile: HistogramSnapshot;
+  recent: FileTransferRecord[];
+};
+
+type DeviceRef = { mac: string; name: string; model: number };
+
+type ActiveTransfer = {
+  device: DeviceRef;
+  file: string;
+  startedAt: number;
+  lastProgressAt: number;
+  chunks: number;
+  retries: number;
+  timeouts: number;
+};
+
+type LiveStats = {
+  stats: DeviceTransferStats;
+  throughput: LogHistogram;
+  chunkLatency: LogHistogram;
+  fileDuration: LogHistogram;
+  firstSample: LogHistogram;
+  firstFile: LogHistogram;
+};
+
+const live = new Map<string, LiveStats>();
+const loading = new Map<string, Promise<LiveStats>>();
+let active: ActiveTransfer | null = null;
+// Retries/timeouts seen for a file before its final attempt starts
+const pendingRetries = new Map<string, { retries: number; timeouts: number }>();
+
+const storageKey = (mac: string) => `${STATS_KEY_PREFIX}${mac}`;
+
+const emptyStats = (device: DeviceRef): DeviceTransferStats => ({
+  mac: device.mac,
+  name: device.name,
+  model: device.model,
+  platform: Platform.OS,
+  files: 0,
+  failedFiles: 0,
+  bytes: 0,
+  retries: 0,
+  timeouts: 0,
+  throughput: new LogHistogram(MAX_THROUGHPUT_BPS).snapshot(),
+  chunkLatency: new LogHistogram(MAX_LATENCY_MS).snapshot(),
+  fileDuration: new LogHistogram(MAX_LATENCY_MS * 30).snapshot(),
+  firstSample: new LogHistogram(MAX_LATENCY_MS).snapshot(),
+  firstFile: new LogHistogram(MAX_LATENCY_MS * 30).snapshot(),
+  recent: [],
+});
+
+/**
+ * Load (or create) the live stats object for a device.
+ */
+const loadLive = (device: DeviceRef): Promise<LiveStats> => {
+  const cached = live.get(device.mac);
+  if (cached) return Promise.resolve(cached);
+  const inflight = loading.get(device.mac);
+  if (inflight) return inflight;
+
+  const promise = AsyncStorage.getItem(storageKey(device.mac))
+    .then((raw) => {
+      const stats: DeviceTransferStats = raw
+        ? { ...emptyStats(device), ...JSON.parse(raw) }
+        : emptyStats(device);
+      return stats;
+    })
+    .catch((e) => {
+      console.warn("Error@TransferStats.ts/loadLive:", e);
+      return emptyStats(device);
+    })
+    .then((stats) => {
+      const entry: LiveStats = {
+        stats,
+        throughput: LogHistogram.fromSnapshot(stats.throughput),
+        chunkLatency: LogHistogram.fromSnapshot(stats.chunkLatency),
+        fileDuration: LogHistogram.fromSnapshot(stats.fileDuration),
+        firstSample: LogHistogram.fromSnapshot(stats.firstSample),
+        firstFile: LogHistogram.fromSnapshot(stats.firstFile),
+      };
+      live.set(device.mac, entry);
+      return entry;
+    })
+    .finally(() => loading.delete(device.mac));
+
+  loading.set(device.mac, promise);
+  return promise;
+};
+
+const persist = (entry: LiveStats) => {
+  entry.stats.throughput = entry.throughput.snapshot();
+  entry.stats.chunkLatency = entry.chunkLatency.snapshot();
+  entry.stats.fileDuration = entry.fileDuration.snapshot();
+  entry.stats.firstSample = entry.firstSample.snapshot();
+  entry.stats.firstFile = entry.firstFile.snapshot();
+  AsyncStorage.setItem(
+    storageKey(entry.stats.mac),
+    JSON.stringify(entry.stats)
+  ).catch((e) => console.warn("Error@TransferStats.ts/persist:", e));
+};
+
+/**
+ * Mark the start of a history file read.
+ */
+export const beginFileTransfer = (device: DeviceRef, file: string) => {
+  const now = Date.now();
+  const carried = pendingRetries.get(file);
+  active = {
+    device,
+    file,
+    startedAt: now,
+    lastProgressAt: now,
+    chunks: 0,
+    retries: carried?.retries ?? 0,
+    timeouts: carried?.timeouts ?? 0,
+  };
+  // Warm the cache so finishing a file never waits on storage.
+  loadLive(device).catch(() => undefined);
+};
+
+/**
+ * Record a progress callback; the gap since the previous one approximates
+ * the per-chunk round trip.
+ * @param ts native timestamp (epoch ms) if the event carried one
+ */
+export const recordTransferProgress = (ts?: number) => {
+  if (!active) return;
+  const now = typeof ts === "number" && ts > 0 ? ts : Date.now();
+  const gap = now - active.lastProgressAt;
+  active.lastProgressAt = now;
+  active.chunks += 1;
+  const entry = live.get(active.device.mac);
+  entry?.chunkLatency.record(gap);
+};
+
+/**
+ * The current read failed (native error or no-progress timeout). When it
+ * will be retried, its counts carry over to the next attempt of the same
+ * file; otherwise the file is closed out as failed.
+ */
+export const recordTransferFailure = (
+  file: string,
+  timedOut: boolean,
+  willRetry: boolean
+) => {
+  const t = active && active.file === file ? active : null;
+  const retries = (t?.retries ?? 0) + (willRetry ? 1 : 0);
+  const timeouts = (t?.timeouts ?? 0) + (timedOut ? 1 : 0);
+  if (willRetry) {
+    pendingRetries.set(file, { retries, timeouts });
+    active = null;
+    return;
+  }
+  if (t) {
+    t.retries = retries;
+    t.timeouts = timeouts;
+    endFileTransfer(false);
+  }
+};
+
+/**
+ * Finish the current read and persist the device's stats.
+ * @param bytes size of the raw file as read from the device (0 if unknown)
+ */
+export const endFileTransfer = async (ok: boolean, bytes = 0) => {
+  const t = active;
+  active = null;
+  if (!t) return;
+  pendingRetries.delete(t.file);
+
+  const durationMs = Math.max(Date.now() - t.startedAt, 1);
+  const bytesPerSecond = bytes > 0 ? (bytes * 1000) / durationMs : 0;
+
+  try {
+    const entry = await loadLive(t.device);
+    const s = entry.stats;
+    s.name = t.device.name;
+    s.model = t.device.model;
+    s.platform = Platform.OS;
+    s.retries += t.retries;
+    s.timeouts += t.timeouts;
+    if (ok) {
+      s.files += 1;
+      s.bytes += bytes;
+      entry.fileDuration.record(durationMs);
+      if (bytesPerSecond > 0) entry.throughput.record(bytesPerSecond);
+    } else {
+      s.failedFiles += 1;
+    }
+    s.recent = [
+      {
+        file: t.file,
+        startedAt: t.startedAt,
+        durationMs,
+        bytes,
+        bytesPerSecond,
+        chunks: t.chunks,
+        retries: t.retries,
+        timeouts: t.timeouts,
+        ok,
+      },
+      ...s.recent,
+    ].slice(0, MAX_RECENT_FILES);
+    persist(entry);
+  } catch (e) {
+    console.warn("Error@TransferStats.ts/endFileTransfer:", e);
+  }
+};
+
+/**
+ * Record how long a connection took to deliver its first realtime sample or
+ * its first history file (ms since connect, measured natively).
+ */
+export const recordLinkTiming = async (
+  device: DeviceRef,
+  kind: "firstSample" | "firstFile",
+  ms: number
+) => {
+  try {
+    const entry = await loadLive(device);
+    entry[kind].record(ms);
+    persist(entry);
+  } catch (e) {
+    console.warn("Error@TransferStats.ts/recordLinkTiming:", e);
+  }
+};
+
+/**
+ * Stats recorded for a device, or null if nothing was ever downloaded from it.
+ */
+export const getTransferStats = async (
+  mac: string
+): Promise<DeviceTransferStats | null> => {
+  const cached = live.get(mac);
+  if (cached) {
+    persist(cached);
+    return cached.stats;
+  }
+  try {
+    const raw = await AsyncStorage.getItem(storageKey(mac));
+    return raw ? (JSON.parse(raw) as DeviceTransferStats) : null;
+  } catch (e) {
+    console.warn("Error@TransferStats.ts/getTransferStats:", e);
+    return null;
+  }
+};
+
+/**
+ * Convenience summary of a stored histogram (p50/p90/p99).
+ */
+export const summarizeHistogram = (snapshot: HistogramSnapshot) => {
+  const h = LogHistogram.fromSnapshot(snapshot);
+  return {
+    count: h.count,
+    mean: h.mean,
+    min: h.min,
+    max: h.max,
+    p50: h.quantile(0.5),
+    p90: h.quantile(0.9),
+    p99: h.quantile(0.99),
+  };
+};